@@ -0,0 +1,186 @@
+#!/bin/bash
+###############################################################################
+# MX6Eアプリ 端間転送性能測定スクリプト
+#
+# ネットワーク名前空間とvethでMX6Eアプリの前後を折り返し接続し、
+# 生成したPTテーブルを投入したうえで mx6eapp_tgen で負荷をかけ、
+# 転送性能(pps/損失/遅延)をJSON形式で1行出力する。
+# 物理NICは不要だが、root権限(ip netns/veth/tap作成)が必要。
+#
+#   [tg名前空間]                 [app名前空間]
+#    tgpr  ---- veth ----  e2epr (name_pr) -> e2etunpr
+#                                               | mx6eapp
+#    tgfp  ---- veth ----  e2efp (name_fp) <- e2etunfp
+#
+# mx6eapp_tgen は tgpr からPR側のカプセル化パケットを送信し、
+# FP側に変換されて tgfp へ戻ってきたパケットを受信して集計する。
+###############################################################################
+
+usage() {
+	cat <<EOF >&2
+Usage: mx6e_e2e.sh [ -t m46e|me6e ] [ -n ENTRIES ] [ -f FLOWS ] [ -l LEN ] [ -r PPS ]
+                   [ -d SEC ] [ -b BATCH ] [ -o KEY=VALUE ]... [ -D KEY=VALUE ]... [ -k ]
+
+  -t : table type (default m46e)
+  -n : number of enabled entries loaded into the table (default 1000, max 65536)
+  -f : number of destinations sent round robin (default ENTRIES)
+  -l : frame length without FCS (default 128)
+  -r : packets per second (default 0: as fast as possible)
+  -d : seconds to send (default 5)
+  -b : frames per sendmmsg/recvmmsg (default 32)
+  -o : extra line for the [general] section of the config file (repeatable)
+  -D : extra line for the [device] section of the config file (repeatable)
+       e.g. -D pr2fp_tx=raw
+  -k : keep the namespaces and mx6eapp after the run
+EOF
+	exit 1
+}
+
+# 引数の展開
+type=m46e
+entries=1000
+flows=
+len=128
+rate=0
+duration=5
+batch=32
+keep=no
+extra=()
+extra_dev=()
+while getopts "t:n:f:l:r:d:b:o:D:kh" opt; do
+	case $opt in
+	t) type=$OPTARG ;;
+	n) entries=$OPTARG ;;
+	f) flows=$OPTARG ;;
+	l) len=$OPTARG ;;
+	r) rate=$OPTARG ;;
+	d) duration=$OPTARG ;;
+	b) batch=$OPTARG ;;
+	o) extra+=("$OPTARG") ;;
+	D) extra_dev+=("$OPTARG") ;;
+	k) keep=yes ;;
+	*) usage ;;
+	esac
+done
+[ "$type" = m46e ] || [ "$type" = me6e ] || usage
+[ "$entries" -ge 1 ] && [ "$entries" -le 65536 ] || usage
+flows=${flows:-$entries}
+
+dir=$(cd "$(dirname "$0")" && pwd)
+app_ns=mx6e-e2e-app
+tg_ns=mx6e-e2e-tg
+name=mx6e-e2e
+work=$(mktemp -d /tmp/mx6e-e2e.XXXXXX)
+
+for bin in mx6eapp mx6ectl mx6eapp_tgen; do
+	if [ ! -x "$dir/$bin" ]; then
+		echo "$dir/$bin not found (make all mx6eapp_tgen)" >&2
+		exit 1
+	fi
+done
+if [ "$(id -u)" -ne 0 ]; then
+	echo "root privilege is required" >&2
+	exit 1
+fi
+
+app() { ip netns exec $app_ns "$@"; }
+tg() { ip netns exec $tg_ns "$@"; }
+ctl() { app "$dir/mx6ectl" -n $name "$@"; }
+
+cleanup() {
+	if [ $keep = yes ]; then
+		echo "kept: ip netns exec $app_ns $dir/mx6ectl -n $name ..., work dir $work" >&2
+		return
+	fi
+	ctl shutdown >/dev/null 2>&1
+	sleep 0.5
+	ip netns del $app_ns 2>/dev/null
+	ip netns del $tg_ns 2>/dev/null
+	rm -rf "$work"
+}
+
+# 前回の残骸を消してから名前空間とvethを作成
+ip netns del $app_ns 2>/dev/null
+ip netns del $tg_ns 2>/dev/null
+trap cleanup EXIT
+ip netns add $app_ns || exit 1
+ip netns add $tg_ns || exit 1
+app ip link set lo up
+tg ip link set lo up
+for side in pr fp; do
+	app ip link add e2e$side type veth peer name tg$side netns $tg_ns || exit 1
+	# 受信側のカーネルがND等で応答しないようにIPv6を止める(パケットソケットでは受信できる)
+	tg sysctl -qw net.ipv6.conf.tg$side.disable_ipv6=1
+	app ip link set e2e$side up
+	tg ip link set tg$side up
+done
+
+# 設定ファイル
+{
+	echo "[general]"
+	echo "process_name = $name"
+	echo "daemon = no"
+	echo "startup_script = /bin/true"
+	for line in "${extra[@]}"; do
+		echo "$line"
+	done
+	echo "[device]"
+	echo "name_fp = e2efp"
+	echo "name_pr = e2epr"
+	echo "tunnel_fp = e2etunfp"
+	echo "tunnel_pr = e2etunpr"
+	echo "ipv6_address_pr = 2001:db8:ff57:73::/64"
+	for line in "${extra_dev[@]}"; do
+		echo "$line"
+	done
+} >"$work/mx6e.conf"
+
+# PTテーブル(PR側エントリ、宛先毎にIPv4 /24 または MACアドレスを割り当てる)
+#   m46e : 2001:db8:ff57:73:0:1:<10.X.Y.5>  -> 2001:db8:ff46::/48
+#   me6e : 2001:db8:ff57:73:1:<02:00:00:00:X:Y> -> 2001:db8:ffe6::/48
+if [ $type = m46e ]; then
+	awk -v n=$entries 'BEGIN { for (i = 0; i < n; i++)
+		printf "add m46e pr - 0:1 64 10.%d.%d.0/24 2001:db8:ff46::/48 0:0:1 enable\n", int(i / 256), i % 256 }' >"$work/entry.txt"
+	first=2001:db8:ff57:73:0:1:a00:5
+	stride=256
+	fp_prefix=2001:db8:ff46::/48
+else
+	awk -v n=$entries 'BEGIN { for (i = 0; i < n; i++)
+		printf "add me6e pr - 1 64 02:00:00:00:%02x:%02x 2001:db8:ffe6::/48 1 enable\n", int(i / 256), i % 256 }' >"$work/entry.txt"
+	first=2001:db8:ff57:73:1:200:0:0
+	stride=1
+	fp_prefix=2001:db8:ffe6::/48
+fi
+
+# MX6Eアプリ起動
+app "$dir/mx6eapp" -f "$work/mx6e.conf" >"$work/mx6eapp.log" 2>&1 &
+for i in $(seq 50); do
+	ctl version $type >/dev/null 2>&1 && break
+	sleep 0.1
+done
+if ! ctl load $type "$work/entry.txt" | head -1 >&2; then
+	echo "fail to load table (see $work/mx6eapp.log)" >&2
+	exit 1
+fi
+
+# 変換後の宛先は e2efp の先(tgfp)へ。tg側はNDに応答しないので近隣を固定する
+tg_mac=$(tg cat /sys/class/net/tgfp/address)
+app ip -6 neigh replace fe80::2 lladdr $tg_mac dev e2efp nud permanent
+app ip -6 route replace $fp_prefix via fe80::2 dev e2efp
+
+# エントリの経路がトンネルデバイスに設定されるのを待つ
+for i in $(seq 100); do
+	[ -n "$(app ip -6 route show dev e2etunpr)" ] && break
+	sleep 0.1
+done
+
+# 測定
+pr_mac=$(app cat /sys/class/net/e2epr/address)
+tg "$dir/mx6eapp_tgen" -i tgpr -o tgfp -D $pr_mac -t $type -a $first -k $stride -n $flows \
+	-l $len -r $rate -d $duration -b $batch
+ret=$?
+
+ctl show stat >"$work/stat.txt" 2>&1
+[ $keep = yes ] && cat "$work/stat.txt" >&2
+
+exit $ret
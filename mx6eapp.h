@@ -13,6 +13,14 @@
 
 #   include "mx6eapp_config.h"
 #   include "mx6eapp_statistics.h"
+#   include "mx6eapp_rate.h"
+#   include "mx6eapp_drop.h"
+#   include "mx6eapp_topk.h"
+#   include "mx6eapp_miss.h"
+#   include "mx6eapp_perf.h"
+#   include "mx6eapp_route.h"
+#   include "mx6eapp_snapshot.h"
+#   include "mx6eapp_io.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -41,10 +49,32 @@ extern struct ether_addr        mac0;
 ////////////////////////////////////////////////////////////////////////////////
 // 外部構造体定義
 ////////////////////////////////////////////////////////////////////////////////
+//! ホットリスタートの引き継ぎ状態
+typedef enum {
+	MX6E_HANDOVER_NONE,								///< 引き継ぎ無し(通常起動)
+	MX6E_HANDOVER_TAKING,							///< 旧プロセスから引き継ぎ中(終了時に経路に触れない)
+	MX6E_HANDOVER_TAKEN,							///< 旧プロセスから引き継ぎ済み
+	MX6E_HANDOVER_GIVEN,							///< 新プロセスへ引き継ぎ済み(終了時に経路に触れない)
+} mx6e_handover_state_t;
+
 //! MX6Eアプリケーションハンドラ
 typedef struct {
 	mx6e_config_t                   conf;			///< 設定情報
 	mx6e_statistics_t               stat_info;		///< 統計情報
+	mx6e_rate_t                     rate;			///< レート履歴
+	mx6e_drop_ring_t                drop_fp;		///< FP側破棄パケット採取リング
+	mx6e_drop_ring_t                drop_pr;		///< PR側破棄パケット採取リング
+	mx6e_topk_t                     topk_fp;		///< FP側宛先/64別負荷集計
+	mx6e_topk_t                     topk_pr;		///< PR側宛先/64別負荷集計
+	mx6e_miss_table_t               miss_fp;		///< FP側エントリ未登録宛先集計
+	mx6e_miss_table_t               miss_pr;		///< PR側エントリ未登録宛先集計
+	mx6e_perf_t                     perf_fp;		///< FP->PR転送スレッド性能カウンタ
+	mx6e_perf_t                     perf_pr;		///< PR->FP転送スレッド性能カウンタ
+	mx6e_route_worker_t             route;			///< 経路設定ワーカ
+	mx6e_io_path_t                  io_fp2pr;		///< FP->PR転送のパケットI/O
+	mx6e_io_path_t                  io_pr2fp;		///< PR->FP転送のパケットI/O
+	mx6e_handover_state_t           handover;		///< ホットリスタートの引き継ぎ状態
+	mx6e_snapshot_t                 snapshot;		///< テーブルスナップショット保存状態
 	int                             signalfd;		///< シグナル受信用ディスクリプタ
 	sigset_t                        oldsigmask;		///< プロセス起動時のシグナルマスク
 } mx6e_handler_t;
@@ -0,0 +1,669 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_bench.c                                               */
+/* 機能概要   : エントリ検索/アドレス置換 性能測定                            */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <math.h>
+#include <malloc.h>
+#include <search.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <netinet/ip6.h>
+#include <arpa/inet.h>
+
+#include "mx6eapp_config.h"
+#include "mx6eapp_pt.h"
+#include "mx6eapp_util.h"
+#include "mx6eapp_log.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! 既定のテーブルサイズ一覧
+#define BENCH_DEFAULT_SIZES     "1000,10000,100000,1000000"
+//! 既定の測定回数
+#define BENCH_DEFAULT_OPS       1000000
+//! 既定のZipf分布の指数
+#define BENCH_DEFAULT_ZIPF      0.99
+//! 測定する宛先の最大数(測定回数がこれを超える場合は繰り返し使用する)
+#define BENCH_DST_MAX           (1 << 20)
+//! テーブルサイズ指定の最大数
+#define BENCH_SIZES_MAX         16
+//! 送信元プレフィクス(全エントリ共通、プレフィクス長を超える部分は0)
+#define BENCH_PREFIX            0x20010db8
+//! 存在しないPlaneIDの目印ビット(エントリのPlaneIDでは使用しない)
+#define BENCH_MISS_PID_BIT      (1U << 29)
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! 宛先分布
+typedef enum {
+	BENCH_DIST_UNIFORM,
+	BENCH_DIST_ZIPF,
+	BENCH_DIST_MISS,
+	BENCH_DIST_MAX,
+} bench_dist_t;
+
+//! 出力形式
+typedef enum {
+	BENCH_FORMAT_JSON,
+	BENCH_FORMAT_CSV,
+} bench_format_t;
+
+//! 測定条件
+typedef struct {
+	int                             sizes[BENCH_SIZES_MAX];	///< テーブルサイズ一覧
+	int                             size_num;		///< テーブルサイズ数
+	bool                            type[CONFIG_TYPE_ME6E + 1];	///< 測定するテーブルタイプ
+	bool                            dist[BENCH_DIST_MAX];	///< 測定する宛先分布
+	long                            ops;			///< 測定回数
+	double                          zipf;			///< Zipf分布の指数
+	uint64_t                        seed;			///< 乱数の種
+	bench_format_t                  format;			///< 出力形式
+} bench_option_t;
+
+//! 測定結果
+typedef struct {
+	const char                     *op;			///< 測定対象
+	long                            ops;			///< 実行回数
+	double                          ns;				///< 所要時間[ns]
+	long                            hits;			///< 検索成功数
+} bench_result_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部変数
+////////////////////////////////////////////////////////////////////////////////
+//! 宛先分布名
+static const char              *dist_name[BENCH_DIST_MAX] = { "uniform", "zipf", "miss" };
+//! 乱数の状態(xorshift64*)
+static uint64_t                 rand_state = 88172645463325252ULL;
+//! 最適化で測定ループが消えないように結果を書き込む
+static volatile uintptr_t       bench_sink;
+
+//! コマンドオプション構造体
+// *INDENT-OFF*
+static const struct option      options[] = {
+	{"sizes",	required_argument,	NULL, 'n'},
+	{"type",	required_argument,	NULL, 't'},
+	{"dist",	required_argument,	NULL, 'd'},
+	{"ops",		required_argument,	NULL, 'o'},
+	{"zipf",	required_argument,	NULL, 'z'},
+	{"seed",	required_argument,	NULL, 's'},
+	{"csv",		no_argument,		NULL, 'c'},
+	{"help",	no_argument,		NULL, 'h'},
+	{0, 0, 0, 0}
+};
+// *INDENT-ON*
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief コマンド凡例表示関数
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void usage(void)
+{
+	fprintf(stderr, "Usage: mx6eapp_bench [ -n SIZE[,SIZE...] ] [ -t m46e|me6e|all ] [ -d uniform|zipf|miss|all ]\n"
+			"                     [ -o OPS ] [ -z EXPONENT ] [ -s SEED ] [ -c ]\n" "\n"
+			"  -n, --sizes : table sizes (default %s, max %d)\n"
+			"  -t, --type  : table type (default all)\n"
+			"  -d, --dist  : destination distribution (default all)\n"
+			"  -o, --ops   : operations per measurement (default %d)\n"
+			"  -z, --zipf  : zipf exponent (default %.2f)\n"
+			"  -s, --seed  : random seed\n"
+			"  -c, --csv   : output CSV instead of JSON lines\n" "\n", BENCH_DEFAULT_SIZES, PT_MAX_ENTRY_NUM, BENCH_DEFAULT_OPS, BENCH_DEFAULT_ZIPF);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 乱数生成関数(xorshift64*)
+//!
+//! @return 64bit乱数
+///////////////////////////////////////////////////////////////////////////////
+static inline uint64_t bench_rand(void)
+{
+	rand_state ^= rand_state >> 12;
+	rand_state ^= rand_state << 25;
+	rand_state ^= rand_state >> 27;
+
+	return rand_state * 2685821657736338717ULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 現在時刻取得関数
+//!
+//! @return CLOCK_MONOTONICの現在時刻[ns]
+///////////////////////////////////////////////////////////////////////////////
+static inline double bench_now(void)
+{
+	struct timespec                 ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 合成エントリ生成関数
+//!
+//! k番目のエントリを生成し、内部生成項目まで作成する。
+//! プレフィクス長・PlaneID幅・IPv4 CIDRをエントリ毎に変えて混在させる。
+//! PlaneIDは k+1 に幅毎の最上位ビットを立てた値とし、エントリ間で一意にする。
+//! 全エントリの送信元プレフィクスは共通(プレフィクス長を超える部分は0)とし、
+//! PlaneIDは最短プレフィクス長より下位に収まるようにする。
+//!
+//! @param [in]  type    テーブルタイプ
+//! @param [in]  k       エントリ番号
+//! @param [in]  devices デバイス設定
+//! @param [out] entry   生成したエントリ
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static bool bench_make_entry(table_type_t type, int k, mx6e_config_devices_t * devices, mx6e_config_entry_t * entry)
+{
+	static const int                m46e_prefix[] = { 32, 48, 64 };
+	static const int                me6e_prefix[] = { 32, 40, 48 };
+	static const int                pid_width[] = { 24, 28, 32 };
+	uint32_t                        pid;
+
+	memset(entry, 0, sizeof(mx6e_config_entry_t));
+
+	pid = (uint32_t) (k + 1) | (1U << (pid_width[(k / 3) % 3] - 1));
+	snprintf(entry->src.plane_id, sizeof(entry->src.plane_id), "%x:%x", pid >> 16, pid & 0xffff);
+	snprintf(entry->des.plane_id, sizeof(entry->des.plane_id), "%x:%x", pid >> 16, pid & 0xffff);
+
+	// エントリは有効化前の状態で登録する(経路を設定しないため)
+	entry->enable = false;
+	entry->domain = DOMAIN_PR;
+	inet_pton(AF_INET6, "2001:db8:ffff::", &entry->des.prefix);
+
+	if (CONFIG_TYPE_M46E == type) {
+		int                             cidr = 24 + (k % 9);
+		entry->src.prefix_len = m46e_prefix[k % 3];
+		entry->src.in.m46e.v4cidr = cidr;
+		entry->src.in.m46e.v4addr.s_addr = htonl((uint32_t) bench_rand() & (0xffffffffU << (32 - cidr)));
+	} else {
+		entry->src.prefix_len = me6e_prefix[k % 3];
+		for (int i = 0; i < ETH_ALEN; i++) {
+			entry->src.in.me6e.hwaddr.ether_addr_octet[i] = (uint8_t) bench_rand();
+		}
+		// ローカル管理のユニキャストアドレス
+		entry->src.in.me6e.hwaddr.ether_addr_octet[0] = (entry->src.in.me6e.hwaddr.ether_addr_octet[0] & 0xfc) | 0x02;
+	}
+	entry->des.prefix_len = entry->src.prefix_len;
+
+	return make_config_entry(entry, type, devices);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 宛先アドレス生成関数
+//!
+//! エントリにヒットする宛先を生成する。entryがNULLの場合は
+//! どのエントリにもヒットしない宛先を生成する。
+//!
+//! @param [in]  type    テーブルタイプ
+//! @param [in]  entry   宛先とするエントリ(NULL:ミス)
+//! @param [out] dst     宛先アドレス
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void bench_make_dst(table_type_t type, const mx6e_config_entry_t * entry, struct in6_addr *dst)
+{
+	if (entry != NULL) {
+		// エントリのパターンに、マスクされない部分(ホスト部)を乱数で埋める
+		for (int i = 0; i < 4; i++) {
+			dst->s6_addr32[i] = entry->src.src.s6_addr32[i] | ((uint32_t) bench_rand() & ~entry->src.mask.s6_addr32[i]);
+		}
+		// プレフィクス長を超える部分は0
+		dst->s6_addr32[1] = entry->src.src.s6_addr32[1];
+	} else {
+		uint32_t                        pid = BENCH_MISS_PID_BIT | ((uint32_t) bench_rand() & 0xfffff);
+		memset(dst, 0, sizeof(struct in6_addr));
+		if (CONFIG_TYPE_M46E == type) {
+			dst->s6_addr32[2] = htonl(pid);
+			dst->s6_addr32[3] = (uint32_t) bench_rand();
+		} else {
+			dst->s6_addr16[3] = htons(pid >> 16);
+			dst->s6_addr16[4] = htons(pid & 0xffff);
+			dst->s6_addr16[5] = (uint16_t) bench_rand();
+			dst->s6_addr32[3] = (uint32_t) bench_rand();
+		}
+	}
+	dst->s6_addr32[0] = htonl(BENCH_PREFIX);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief Zipf分布の累積分布生成関数
+//!
+//! @param [in]  n      要素数
+//! @param [in]  s      指数
+//!
+//! @return 累積分布(呼び出し元でfreeすること) NULL:メモリ不足
+///////////////////////////////////////////////////////////////////////////////
+static double *bench_zipf_cdf(int n, double s)
+{
+	double                         *cdf = malloc(sizeof(double) * n);
+	double                          sum = 0;
+
+	if (cdf == NULL) {
+		return NULL;
+	}
+	for (int i = 0; i < n; i++) {
+		sum += 1.0 / pow(i + 1, s);
+		cdf[i] = sum;
+	}
+	for (int i = 0; i < n; i++) {
+		cdf[i] /= sum;
+	}
+
+	return cdf;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief Zipf分布の順位選択関数
+//!
+//! @param [in]  cdf    累積分布
+//! @param [in]  n      要素数
+//!
+//! @return 順位(0起点)
+///////////////////////////////////////////////////////////////////////////////
+static int bench_zipf_rank(const double *cdf, int n)
+{
+	double                          u = (double) (bench_rand() >> 11) / (double) (1ULL << 53);
+	int                             lo = 0;
+	int                             hi = n - 1;
+
+	while (lo < hi) {
+		int                             mid = (lo + hi) / 2;
+		if (cdf[mid] < u) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 測定結果出力関数
+//!
+//! @param [in]  opt      測定条件
+//! @param [in]  type     テーブルタイプ
+//! @param [in]  entries  テーブルのエントリ数
+//! @param [in]  dist     宛先分布
+//! @param [in]  per_entry エントリあたりのメモリ使用量[byte]
+//! @param [in]  result   測定結果
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void bench_print(const bench_option_t * opt, table_type_t type, int entries, bench_dist_t dist, double per_entry, const bench_result_t * result)
+{
+	const char                     *type_name = (CONFIG_TYPE_M46E == type) ? "m46e" : "me6e";
+	double                          ns_per_op = result->ns / result->ops;
+	double                          ops_per_sec = result->ops / (result->ns / 1e9);
+	double                          hit_ratio = (double) result->hits / result->ops;
+
+	if (BENCH_FORMAT_CSV == opt->format) {
+		printf("%s,%d,%s,%s,%ld,%.2f,%.0f,%.4f,%.1f\n", type_name, entries, dist_name[dist], result->op, result->ops, ns_per_op, ops_per_sec, hit_ratio, per_entry);
+	} else {
+		printf("{\"type\":\"%s\",\"entries\":%d,\"dist\":\"%s\",\"op\":\"%s\",\"ops\":%ld,"
+			   "\"ns_per_op\":%.2f,\"ops_per_sec\":%.0f,\"hit_ratio\":%.4f,\"bytes_per_entry\":%.1f}\n",
+			   type_name, entries, dist_name[dist], result->op, result->ops, ns_per_op, ops_per_sec, hit_ratio, per_entry);
+	}
+	fflush(stdout);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief テーブル1個分の測定関数
+//!
+//! 合成テーブルを作成し、宛先分布毎に mx6e_match_config_table と
+//! mx6e_replace_address の所要時間を測定する。
+//!
+//! @param [in]  opt      測定条件
+//! @param [in]  type     テーブルタイプ
+//! @param [in]  num      テーブルサイズ
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static bool bench_table(const bench_option_t * opt, table_type_t type, int num)
+{
+	mx6e_config_devices_t           devices;
+	mx6e_config_table_t             table;
+	mx6e_config_entry_t            *entry = NULL;
+	mx6e_config_entry_t           **match = NULL;
+	struct in6_addr                *dst = NULL;
+	struct ip6_hdr                 *hdr = NULL;
+	double                         *cdf = NULL;
+	int                            *rank = NULL;
+	int                             dst_num = (opt->ops < BENCH_DST_MAX) ? opt->ops : BENCH_DST_MAX;
+	double                          per_entry;
+	bool                            ret = false;
+
+	memset(&devices, 0, sizeof(devices));
+	memset(&table, 0, sizeof(table));
+	table.type = type;
+	pthread_mutex_init(&table.mutex, NULL);
+
+	entry = malloc(sizeof(mx6e_config_entry_t) * num);
+	match = malloc(sizeof(mx6e_config_entry_t *) * dst_num);
+	dst = malloc(sizeof(struct in6_addr) * dst_num);
+	hdr = malloc(sizeof(struct ip6_hdr) * dst_num);
+	rank = malloc(sizeof(int) * num);
+	if ((entry == NULL) || (match == NULL) || (dst == NULL) || (hdr == NULL) || (rank == NULL)) {
+		fprintf(stderr, "bench: out of memory (%d entries)\n", num);
+		goto end;
+	}
+
+	for (int k = 0; k < num; k++) {
+		if (!bench_make_entry(type, k, &devices, &entry[k])) {
+			fprintf(stderr, "bench: fail to make entry %d\n", k);
+			goto end;
+		}
+	}
+
+	// 登録によるヒープ使用量の増分をエントリあたりのメモリ使用量とする
+	size_t                          before = mallinfo2().uordblks;
+	if (num != m46e_pt_restore_config_table(&table, entry, num, &devices, false)) {
+		fprintf(stderr, "bench: fail to restore %d entries (max %d)\n", num, PT_MAX_ENTRY_NUM);
+		goto end;
+	}
+	per_entry = (double) (mallinfo2().uordblks - before) / num;
+
+	// 経路を設定せずに有効化する(転送スレッドと同じくenableなエントリのみ検索にヒットする)
+	for (int k = 0; k < num; k++) {
+		mx6e_config_entry_t             key = entry[k];
+		mx6e_config_entry_t            *found = mx6e_search_config_table(&table, &key, &devices);
+		if (found == NULL) {
+			fprintf(stderr, "bench: entry %d not found\n", k);
+			goto end;
+		}
+		found->enable = true;
+	}
+
+	// Zipf分布の人気順位はエントリ番号と無関係にする(木の位置が偏らないように)
+	for (int k = 0; k < num; k++) {
+		rank[k] = k;
+	}
+	for (int k = num - 1; k > 0; k--) {
+		int                             j = bench_rand() % (k + 1);
+		int                             t = rank[k];
+		rank[k] = rank[j];
+		rank[j] = t;
+	}
+
+	for (bench_dist_t d = 0; d < BENCH_DIST_MAX; d++) {
+		bench_result_t                  lookup = { "lookup", opt->ops, 0, 0 };
+		bench_result_t                  replace = { "replace", 0, 0, 0 };
+		double                          start;
+
+		if (!opt->dist[d]) {
+			continue;
+		}
+		if ((BENCH_DIST_ZIPF == d) && (cdf == NULL) && (NULL == (cdf = bench_zipf_cdf(num, opt->zipf)))) {
+			fprintf(stderr, "bench: out of memory (zipf)\n");
+			goto end;
+		}
+
+		// 宛先の生成(測定ループの外で行う)
+		for (int i = 0; i < dst_num; i++) {
+			switch (d) {
+			case BENCH_DIST_UNIFORM:
+				bench_make_dst(type, &entry[bench_rand() % num], &dst[i]);
+				break;
+			case BENCH_DIST_ZIPF:
+				bench_make_dst(type, &entry[rank[bench_zipf_rank(cdf, num)]], &dst[i]);
+				break;
+			default:
+				bench_make_dst(type, NULL, &dst[i]);
+				break;
+			}
+		}
+
+		// 検索
+		start = bench_now();
+		for (long i = 0, j = 0; i < opt->ops; i++) {
+			mx6e_config_entry_t            *e = mx6e_match_config_table(DOMAIN_PR, &table, &dst[j]);
+			match[j] = e;
+			lookup.hits += (e != NULL);
+			if (++j == dst_num) {
+				j = 0;
+			}
+		}
+		lookup.ns = bench_now() - start;
+		bench_print(opt, type, num, d, per_entry, &lookup);
+
+		// 置換(検索にヒットした宛先のみ)
+		long                            hit_num = 0;
+		for (int i = 0; i < dst_num; i++) {
+			if (match[i] != NULL) {
+				match[hit_num] = match[i];
+				memset(&hdr[hit_num], 0, sizeof(struct ip6_hdr));
+				hdr[hit_num].ip6_dst = dst[i];
+				hit_num++;
+			}
+		}
+		if (hit_num == 0) {
+			continue;
+		}
+		start = bench_now();
+		for (long i = 0, j = 0; i < opt->ops; i++) {
+			mx6e_replace_address(match[j], &hdr[j]);
+			if (++j == hit_num) {
+				j = 0;
+			}
+		}
+		replace.ns = bench_now() - start;
+		replace.ops = opt->ops;
+		replace.hits = opt->ops;
+		bench_sink = (uintptr_t) hdr[0].ip6_dst.s6_addr32[3];
+		bench_print(opt, type, num, d, per_entry, &replace);
+	}
+
+	ret = true;
+
+  end:
+	m46e_pt_release_config_table(&table);
+	pthread_mutex_destroy(&table.mutex);
+	free(entry);
+	free(match);
+	free(dst);
+	free(hdr);
+	free(rank);
+	free(cdf);
+
+	return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 名前一覧の解析関数
+//!
+//! "all" または "名前[,名前...]" を解析して、一致した名前のフラグを立てる。
+//!
+//! @param [in]  arg    引数文字列
+//! @param [in]  name   名前一覧
+//! @param [in]  num    名前数
+//! @param [out] flag   フラグ
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了(未知の名前)
+///////////////////////////////////////////////////////////////////////////////
+static bool parse_names(const char *arg, const char *const *name, int num, bool *flag)
+{
+	char                            buf[256];
+	char                           *save = NULL;
+
+	snprintf(buf, sizeof(buf), "%s", arg);
+	for (int i = 0; i < num; i++) {
+		flag[i] = (0 == strcmp(arg, "all"));
+	}
+	if (0 == strcmp(arg, "all")) {
+		return true;
+	}
+	for (char *p = strtok_r(buf, ",", &save); p != NULL; p = strtok_r(NULL, ",", &save)) {
+		int                             i;
+		for (i = 0; i < num; i++) {
+			if ((name[i] != NULL) && (0 == strcmp(p, name[i]))) {
+				flag[i] = true;
+				break;
+			}
+		}
+		if (i == num) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief テーブルサイズ一覧の解析関数
+//!
+//! @param [in]  arg    引数文字列("SIZE[,SIZE...]"、SIZEはK/M接尾辞可)
+//! @param [out] opt    測定条件
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static bool parse_sizes(const char *arg, bench_option_t * opt)
+{
+	char                            buf[256];
+	char                           *save = NULL;
+
+	snprintf(buf, sizeof(buf), "%s", arg);
+	opt->size_num = 0;
+	for (char *p = strtok_r(buf, ",", &save); p != NULL; p = strtok_r(NULL, ",", &save)) {
+		char                           *end;
+		long                            v = strtol(p, &end, 10);
+		if ((*end == 'k') || (*end == 'K')) {
+			v *= 1000;
+			end++;
+		} else if ((*end == 'm') || (*end == 'M')) {
+			v *= 1000000;
+			end++;
+		}
+		if ((*end != '\0') || (v <= 0) || (v > PT_MAX_ENTRY_NUM) || (opt->size_num >= BENCH_SIZES_MAX)) {
+			return false;
+		}
+		opt->sizes[opt->size_num++] = (int) v;
+	}
+
+	return (opt->size_num > 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// メイン関数
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+	static const char *const        type_name[] = { NULL, "m46e", "me6e" };
+	bench_option_t                  opt;
+	int                             option_index = 0;
+
+	memset(&opt, 0, sizeof(opt));
+	parse_sizes(BENCH_DEFAULT_SIZES, &opt);
+	opt.type[CONFIG_TYPE_M46E] = true;
+	opt.type[CONFIG_TYPE_ME6E] = true;
+	for (int d = 0; d < BENCH_DIST_MAX; d++) {
+		opt.dist[d] = true;
+	}
+	opt.ops = BENCH_DEFAULT_OPS;
+	opt.zipf = BENCH_DEFAULT_ZIPF;
+	opt.seed = (uint64_t) time(NULL);
+	opt.format = BENCH_FORMAT_JSON;
+
+	while (true) {
+		int                             c = getopt_long(argc, argv, "n:t:d:o:z:s:ch", options, &option_index);
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case 'n':
+			if (!parse_sizes(optarg, &opt)) {
+				fprintf(stderr, "invalid sizes : %s (1 - %d)\n", optarg, PT_MAX_ENTRY_NUM);
+				exit(EINVAL);
+			}
+			break;
+
+		case 't':
+			if (!parse_names(optarg, type_name, CONFIG_TYPE_ME6E + 1, opt.type)) {
+				usage();
+				exit(EINVAL);
+			}
+			break;
+
+		case 'd':
+			if (!parse_names(optarg, dist_name, BENCH_DIST_MAX, opt.dist)) {
+				usage();
+				exit(EINVAL);
+			}
+			break;
+
+		case 'o':
+			opt.ops = strtol(optarg, NULL, 10);
+			if (opt.ops <= 0) {
+				usage();
+				exit(EINVAL);
+			}
+			break;
+
+		case 'z':
+			opt.zipf = strtod(optarg, NULL);
+			break;
+
+		case 's':
+			opt.seed = strtoull(optarg, NULL, 0);
+			break;
+
+		case 'c':
+			opt.format = BENCH_FORMAT_CSV;
+			break;
+
+		case 'h':
+			usage();
+			exit(EXIT_SUCCESS);
+
+		default:
+			usage();
+			exit(EINVAL);
+		}
+	}
+
+	mx6e_initial_log(NULL, false);
+	rand_state ^= opt.seed * 0x9e3779b97f4a7c15ULL;
+	if (rand_state == 0) {
+		rand_state = 1;
+	}
+
+	if (BENCH_FORMAT_CSV == opt.format) {
+		printf("type,entries,dist,op,ops,ns_per_op,ops_per_sec,hit_ratio,bytes_per_entry\n");
+	}
+	for (table_type_t type = CONFIG_TYPE_M46E; type <= CONFIG_TYPE_ME6E; type++) {
+		if (!opt.type[type]) {
+			continue;
+		}
+		for (int i = 0; i < opt.size_num; i++) {
+			if (!bench_table(&opt, type, opt.sizes[i])) {
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+
+	return 0;
+}
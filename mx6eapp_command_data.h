@@ -23,6 +23,9 @@
 #   define CMDOPT_NUM_MAX 1
 #   define CMDOPT_LEN_MAX 256
 
+//! 一括読み込みで1メッセージに格納するレコード数
+#   define LOAD_BATCH_RECORD_NUM 64
+
 //! コマンドコード
 typedef enum {
 	MX6E_COMMAND_NONE,
@@ -57,6 +60,18 @@ typedef enum {
 
 	MX6E_SET_DEBUG_LOG,								///< 動的定義変更 デバッグログ出力設定
 	MX6E_SET_DEBUG_LOG_END,							///< 動的定義変更 デバッグログ出力設定完了
+
+	MX6E_SHOW_RATE,									///< レート履歴表示
+	MX6E_DUMP_DROPS,								///< 破棄パケット出力
+	MX6E_SHOW_TOP,									///< 宛先/64別負荷上位表示
+	MX6E_SHOW_MISSES,								///< エントリ未登録宛先表示
+	MX6E_LOAD_BATCH,								///< M46E/ME6E ENTRY 一括読み込み
+	MX6E_SYNC_M46E_ENTRY,							///< M46E ENTRY 同期(差分反映)
+	MX6E_SYNC_ME6E_ENTRY,							///< ME6E ENTRY 同期(差分反映)
+	MX6E_SHOW_M46E_VERSION,							///< M46E テーブル版数表示
+	MX6E_SHOW_ME6E_VERSION,							///< ME6E テーブル版数表示
+	MX6E_HANDOVER,									///< ホットリスタート引き継ぎ要求
+	MX6E_RELOAD_CONFIG,								///< 設定ファイル再読み込み
 	MX6E_COMMAND_MAX
 } mx6e_command_code_t;
 
@@ -68,8 +83,33 @@ typedef struct {
 	mx6e_config_entry_t             entry;
 } mx6e_entry_command_data_t;
 
+//! M46E-PT Table 表示フィルタ種別(ビットマスク)
+#   define SHOW_TABLE_FILTER_DOMAIN    0x01		///< ドメイン
+#   define SHOW_TABLE_FILTER_PLANE     0x02		///< plane_id(in/outいずれか一致)
+#   define SHOW_TABLE_FILTER_PREFIX    0x04		///< プレフィックス(IPv4/IPv6)
+#   define SHOW_TABLE_FILTER_STATE     0x08		///< 活性状態
+
+//! M46E-PT Table 表示形式
+typedef enum {
+	SHOW_TABLE_FORMAT_TABLE,						///< 罫線付き表形式
+	SHOW_TABLE_FORMAT_JSON,							///< 1エントリ1行のJSON形式
+} mx6e_show_table_format_t;
+
 //! M46E-PT Table 表示要求データ
 typedef struct {
+	unsigned int                    filter;			///< 有効なフィルタ(SHOW_TABLE_FILTER_*)
+	domain_t                        domain;			///< ドメイン
+	char                            plane_id[INET6_ADDRSTRLEN];	///< plane_id
+	int                             family;			///< プレフィックスのアドレスファミリ
+	union {
+		struct in_addr                  v4;			///< IPv4プレフィックス
+		struct in6_addr                 v6;			///< IPv6プレフィックス
+	} prefix;
+	int                             prefix_len;		///< プレフィックス長
+	bool                            enable;			///< 活性状態
+	int                             offset;			///< 表示開始位置(フィルタ適用後の0始まりの位置)
+	int                             limit;			///< 表示件数(0:全件)
+	mx6e_show_table_format_t        format;			///< 表示形式
 } mx6e_show_table_t;
 
 //! デバッグログ出力設定 受信データ
@@ -77,6 +117,33 @@ typedef struct {
 	bool                            mode;			///< デバッグログ出力設定
 } mx6e_set_debuglog_data_t;
 
+//! 統計情報表示要求データ
+typedef struct {
+	bool                            perf;			///< 性能カウンタ表示有無
+} mx6e_show_stat_data_t;
+
+//! レート履歴表示要求データ
+typedef struct {
+	int                             since;			///< 表示対象期間[sec]
+} mx6e_show_rate_data_t;
+
+//! 宛先/64別負荷上位表示要求データ
+typedef struct {
+	int                             num;			///< 表示件数
+} mx6e_show_top_data_t;
+
+//! 一括読み込み/同期要求データ
+typedef struct {
+	int                             num;			///< 後続で送信するレコード総数
+} mx6e_load_batch_data_t;
+
+//! 一括読み込みレコード(要求データの後に LOAD_BATCH_RECORD_NUM 個単位で送信する)
+typedef struct {
+	int                             line;			///< コマンドファイルの行番号
+	mx6e_command_code_t             code;			///< コマンドコード(ENTRY 追加/削除/活性化/非活性化)
+	mx6e_config_entry_t             entry;			///< エントリ
+} mx6e_load_batch_record_t;
+
 //! PTNetwork側実行コマンド 受信データ
 typedef struct {
 	char                            opt[CMDOPT_LEN_MAX];	///< コマンドオプション最大長
@@ -90,6 +157,10 @@ typedef union {
 	mx6e_entry_command_data_t       mx6e_data;		///< M46E-PT コマンドデータ
 	mx6e_show_table_t               mx6e_show;		///< M46E-PT 表示データ
 	mx6e_set_debuglog_data_t        dlog;			///< デバッグログ設定コマンドデータ
+	mx6e_show_stat_data_t           stat;			///< 統計情報表示データ
+	mx6e_show_rate_data_t           rate;			///< レート履歴表示データ
+	mx6e_show_top_data_t            top;			///< 宛先/64別負荷上位表示データ
+	mx6e_load_batch_data_t          batch;			///< 一括読み込み/同期データ
 	mx6e_exec_cmd_inet_data_t       inetcmd;		///< PTNetwork実行コマンドデータ
 } mx6e_command_request_data_t;
 
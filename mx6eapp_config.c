@@ -24,6 +24,8 @@
 #include "mx6eapp_pt.h"
 #include "mx6eapp_util.h"
 #include "mx6eapp_network.h"
+#include "mx6eapp_route.h"
+#include "mx6eapp_io.h"
 
 //! 設定ファイルを読込む場合の１行あたりの最大文字数
 #define CONFIG_LINE_MAX 256
@@ -34,6 +36,17 @@
 #define SECTION_GENERAL_DEBUG_LOG		"debug_log"
 #define SECTION_GENERAL_DAEMON			"daemon"
 #define SECTION_GENERAL_STARTUP_SCRIPT	"startup_script"
+#define SECTION_GENERAL_MISS_PREFIX_LEN	"miss_prefix_len"
+#define SECTION_GENERAL_ROUTE_AGGREGATE	"route_aggregate"
+#define SECTION_GENERAL_ROUTE_INSTALL	"route_install"
+#define SECTION_GENERAL_SNAPSHOT_FILE	"snapshot_file"
+#define SECTION_GENERAL_SNAPSHOT_INTERVAL	"snapshot_interval"
+
+//! エントリ未登録宛先の集計単位プレフィックス長 デフォルト値
+#define CONFIG_MISS_PREFIX_LEN_DEFAULT	64
+//! テーブルスナップショットの保存周期[sec] デフォルト値/最大値
+#define CONFIG_SNAPSHOT_INTERVAL_DEFAULT	60
+#define CONFIG_SNAPSHOT_INTERVAL_MAX	86400
 
 #define SECTION_DEVICE					"device"		///< device セクション名
 #define SECTION_DEVICE_NAME_PR			"name_pr"
@@ -43,6 +56,10 @@
 #define SECTION_DEVICE_IPV6_ADDRESS_PR	"ipv6_address_pr"
 #define SECTION_DEVICE_IPV6_ADDRESS_FP	"ipv6_address_fp"
 #define SECTION_DEVICE_HWADDR			"hwaddr"
+#define SECTION_DEVICE_FP2PR_RX			"fp2pr_rx"
+#define SECTION_DEVICE_FP2PR_TX			"fp2pr_tx"
+#define SECTION_DEVICE_PR2FP_RX			"pr2fp_rx"
+#define SECTION_DEVICE_PR2FP_TX			"pr2fp_tx"
 
 #define SECTION_DOMAIN					"domain"		///< ドメイン名
 #define SECTION_PLANE_ID_IN				"plane_id_in"	///< 受信PlaneID
@@ -111,6 +128,24 @@ static struct {
 };
 // *INDENT-ON*
 
+//! デバイスの存在チェックを省略するかどうか(オフライン再生用)
+static bool                     config_skip_device_check = false;
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief デバイス存在チェック省略設定関数
+//!
+//! 以降の設定ファイル読込みで、name_pr/name_fp のデバイスが
+//! 存在するかどうかのチェックを省略する(デバイスを使用しない mx6e-replay 用)。
+//!
+//! @param [in] skip    true:チェックを省略する
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_config_skip_device_check(bool skip)
+{
+	config_skip_device_check = skip;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief 設定ファイル読込み関数
 //!
@@ -206,8 +241,8 @@ mx6e_config_t                  *mx6e_config_load(mx6e_config_t *config, const ch
 	}
 	fclose(fp);
 
-	// 最後のセクションの整合性チェック
-	if (config_table[current_section].validate_func != NULL) {
+	// 最後のセクションの整合性チェック(解析エラーの結果を上書きしないこと)
+	if (result && (config_table[current_section].validate_func != NULL)) {
 		result = config_table[current_section].validate_func(config);
 		if (!result) {
 			mx6e_logging(LOG_ERR, "Section Validation Error [%s]\n", config_table[current_section].name);
@@ -241,8 +276,10 @@ static void tdaction(void *nodep)
 
 	int                             ifindex = get_domain_src_ifindex(entry->domain, mydevices);
 
-	// route削除
-	mx6e_network_del_route(AF_INET6, ifindex, &entry->src.tunnel_addr, entry->src.tunnel_prefix_len, NULL);
+	// route削除(非活性のエントリは経路を持たない)
+	if (entry->enable) {
+		mx6e_route_request(AF_INET6, ifindex, &entry->src.tunnel_addr, entry->src.tunnel_prefix_len, false);
+	}
 	free(entry);
 }
 
@@ -270,14 +307,18 @@ void mx6e_config_destruct(mx6e_config_t * config)
 
 	mydevices = &config->devices;
 
+
 	table = &config->m46e_conf_table;
+	m46e_pt_release_match_group(table);
 	tdestroy(table->root, tdaction);
 	table->num = 0;
 
 	table = &config->me6e_conf_table;
+	m46e_pt_release_match_group(table);
 	tdestroy(table->root, tdaction);
 	table->num = 0;
 
+
 	_D_(printf("%s:exit\n", __func__));
 	return;
 }
@@ -320,6 +361,11 @@ void mx6e_config_dump(const mx6e_config_t * config, int fd)
 	dprintf(fd, "%s = %s\n", SECTION_GENERAL_DEBUG_LOG, strbool[config->general.debug_log]);
 	dprintf(fd, "%s = %s\n", SECTION_GENERAL_DAEMON, strbool[config->general.daemon]);
 	dprintf(fd, "%s = %s\n", SECTION_GENERAL_STARTUP_SCRIPT, config->general.startup_script);
+	dprintf(fd, "%s = %d\n", SECTION_GENERAL_MISS_PREFIX_LEN, config->general.miss_prefix_len);
+	dprintf(fd, "%s = %s\n", SECTION_GENERAL_ROUTE_AGGREGATE, strbool[config->general.route_aggregate]);
+	dprintf(fd, "%s = %s\n", SECTION_GENERAL_ROUTE_INSTALL, strbool[config->general.route_install]);
+	dprintf(fd, "%s = %s\n", SECTION_GENERAL_SNAPSHOT_FILE, config->general.snapshot_file);
+	dprintf(fd, "%s = %d\n", SECTION_GENERAL_SNAPSHOT_INTERVAL, config->general.snapshot_interval);
 	dprintf(fd, "\n");
 
 	// 物理デバイス設定
@@ -353,12 +399,117 @@ void mx6e_config_dump(const mx6e_config_t * config, int fd)
 	dprintf(fd, "%s = %s/%d\n", SECTION_DEVICE_IPV6_ADDRESS_PR, inet_ntop(AF_INET6, &dev.ipv6_address, address, sizeof(address)), dev.ipv6_netmask);
 	dprintf(fd, "\n");
 
+	// パケットI/Oバックエンド設定
+	dprintf(fd, "%s = %s\n", SECTION_DEVICE_FP2PR_RX, mx6e_io_type_name(config->devices.fp2pr_rx));
+	dprintf(fd, "%s = %s\n", SECTION_DEVICE_FP2PR_TX, mx6e_io_type_name(config->devices.fp2pr_tx));
+	dprintf(fd, "%s = %s\n", SECTION_DEVICE_PR2FP_RX, mx6e_io_type_name(config->devices.pr2fp_rx));
+	dprintf(fd, "%s = %s\n", SECTION_DEVICE_PR2FP_TX, mx6e_io_type_name(config->devices.pr2fp_tx));
+	dprintf(fd, "\n");
+
 
 	dprintf(fd, "\n");
 
 	return;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 設定差分追加関数
+//!
+//! 変更前後の値が異なる場合に設定差分を追加する。
+//!
+//! @param [out]    diff       設定差分の格納先
+//! @param [in,out] num        格納済みの設定差分数
+//! @param [in]     max        設定差分の最大格納数
+//! @param [in]     key        設定項目名
+//! @param [in]     before     変更前の値
+//! @param [in]     after      変更後の値
+//! @param [in]     reloadable 運用中に反映可能かどうか
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void config_diff_add(mx6e_config_diff_t * diff, int *num, int max, const char *key, const char *before, const char *after, bool reloadable)
+{
+	if (!strcmp(before, after) || (*num >= max)) {
+		return;
+	}
+
+	diff[*num].key = key;
+	snprintf(diff[*num].before, sizeof(diff[*num].before), "%s", before);
+	snprintf(diff[*num].after, sizeof(diff[*num].after), "%s", after);
+	diff[*num].reloadable = reloadable;
+	(*num)++;
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 設定差分取得関数
+//!
+//! 現在の設定と再読み込みした設定の共通設定/デバイス設定を比較し、
+//! 値が異なる項目を設定差分として格納する。
+//! 運用中に反映可能な項目は debug_log, startup_script, miss_prefix_len,
+//! snapshot_file, snapshot_interval で、
+//! それ以外の項目は反映にプロセスの再起動が必要となる。
+//! ENTRY設定(テーブル)は比較対象外。
+//!
+//! @param [in]  config 現在の設定情報
+//! @param [in]  next   再読み込みした設定情報
+//! @param [out] diff   設定差分の格納先
+//! @param [in]  max    設定差分の最大格納数
+//!
+//! @return 格納した設定差分数
+///////////////////////////////////////////////////////////////////////////////
+int mx6e_config_diff(const mx6e_config_t * config, const mx6e_config_t * next, mx6e_config_diff_t * diff, int max)
+{
+	// ローカル変数宣言
+	char                            before[INET6_ADDRSTRLEN + 8];
+	char                            after[INET6_ADDRSTRLEN + 8];
+	char                            address[INET6_ADDRSTRLEN];
+	char                           *strbool[] = { CONFIG_BOOL_FALSE, CONFIG_BOOL_TRUE };
+	int                             num = 0;
+
+	// 引数チェック
+	if ((config == NULL) || (next == NULL) || (diff == NULL)) {
+		return 0;
+	}
+
+	// 共通設定
+	config_diff_add(diff, &num, max, SECTION_GENERAL_PROCESS_NAME, config->general.process_name, next->general.process_name, false);
+	config_diff_add(diff, &num, max, SECTION_GENERAL_DEBUG_LOG, strbool[config->general.debug_log], strbool[next->general.debug_log], true);
+	config_diff_add(diff, &num, max, SECTION_GENERAL_DAEMON, strbool[config->general.daemon], strbool[next->general.daemon], false);
+	config_diff_add(diff, &num, max, SECTION_GENERAL_STARTUP_SCRIPT, config->general.startup_script, next->general.startup_script, true);
+	snprintf(before, sizeof(before), "%d", config->general.miss_prefix_len);
+	snprintf(after, sizeof(after), "%d", next->general.miss_prefix_len);
+	config_diff_add(diff, &num, max, SECTION_GENERAL_MISS_PREFIX_LEN, before, after, true);
+	config_diff_add(diff, &num, max, SECTION_GENERAL_ROUTE_AGGREGATE, strbool[config->general.route_aggregate], strbool[next->general.route_aggregate], false);
+	config_diff_add(diff, &num, max, SECTION_GENERAL_ROUTE_INSTALL, strbool[config->general.route_install], strbool[next->general.route_install], false);
+	config_diff_add(diff, &num, max, SECTION_GENERAL_SNAPSHOT_FILE, config->general.snapshot_file, next->general.snapshot_file, true);
+	snprintf(before, sizeof(before), "%d", config->general.snapshot_interval);
+	snprintf(after, sizeof(after), "%d", next->general.snapshot_interval);
+	config_diff_add(diff, &num, max, SECTION_GENERAL_SNAPSHOT_INTERVAL, before, after, true);
+
+	// デバイス設定(デバイスの再生成が必要なため全て再起動が必要)
+	config_diff_add(diff, &num, max, SECTION_DEVICE_NAME_FP, config->devices.fp.name, next->devices.fp.name, false);
+	config_diff_add(diff, &num, max, SECTION_DEVICE_NAME_PR, config->devices.pr.name, next->devices.pr.name, false);
+	config_diff_add(diff, &num, max, SECTION_DEVICE_TUNNEL_FP, config->devices.tunnel_fp.name, next->devices.tunnel_fp.name, false);
+	config_diff_add(diff, &num, max, SECTION_DEVICE_TUNNEL_PR, config->devices.tunnel_pr.name, next->devices.tunnel_pr.name, false);
+
+	snprintf(before, sizeof(before), "%s/%d", inet_ntop(AF_INET6, &config->devices.tunnel_fp.ipv6_address, address, sizeof(address)), config->devices.tunnel_fp.ipv6_netmask);
+	snprintf(after, sizeof(after), "%s/%d", inet_ntop(AF_INET6, &next->devices.tunnel_fp.ipv6_address, address, sizeof(address)), next->devices.tunnel_fp.ipv6_netmask);
+	config_diff_add(diff, &num, max, SECTION_DEVICE_IPV6_ADDRESS_FP, before, after, false);
+
+	snprintf(before, sizeof(before), "%s/%d", inet_ntop(AF_INET6, &config->devices.tunnel_pr.ipv6_address, address, sizeof(address)), config->devices.tunnel_pr.ipv6_netmask);
+	snprintf(after, sizeof(after), "%s/%d", inet_ntop(AF_INET6, &next->devices.tunnel_pr.ipv6_address, address, sizeof(address)), next->devices.tunnel_pr.ipv6_netmask);
+	config_diff_add(diff, &num, max, SECTION_DEVICE_IPV6_ADDRESS_PR, before, after, false);
+
+	config_diff_add(diff, &num, max, SECTION_DEVICE_FP2PR_RX, mx6e_io_type_name(config->devices.fp2pr_rx), mx6e_io_type_name(next->devices.fp2pr_rx), false);
+	config_diff_add(diff, &num, max, SECTION_DEVICE_FP2PR_TX, mx6e_io_type_name(config->devices.fp2pr_tx), mx6e_io_type_name(next->devices.fp2pr_tx), false);
+	config_diff_add(diff, &num, max, SECTION_DEVICE_PR2FP_RX, mx6e_io_type_name(config->devices.pr2fp_rx), mx6e_io_type_name(next->devices.pr2fp_rx), false);
+	config_diff_add(diff, &num, max, SECTION_DEVICE_PR2FP_TX, mx6e_io_type_name(config->devices.pr2fp_tx), mx6e_io_type_name(next->devices.pr2fp_tx), false);
+
+	return num;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief 設定情報格納用構造体初期化関数
 //!
@@ -452,6 +603,11 @@ bool config_init_general(mx6e_config_t * config)
 	config->general.debug_log = false;
 	config->general.daemon = true;
 	config->general.startup_script[0] = '\0';
+	config->general.miss_prefix_len = CONFIG_MISS_PREFIX_LEN_DEFAULT;
+	config->general.route_aggregate = true;
+	config->general.route_install = true;
+	config->general.snapshot_file[0] = '\0';
+	config->general.snapshot_interval = CONFIG_SNAPSHOT_INTERVAL_DEFAULT;
 
 	return true;
 }
@@ -516,6 +672,21 @@ static bool config_parse_general(const config_keyvalue_t * kv, mx6e_config_t * c
 	} else if (!strcasecmp(SECTION_GENERAL_STARTUP_SCRIPT, kv->key)) {
 		DEBUG_LOG("Match %s.\n", SECTION_GENERAL_STARTUP_SCRIPT);
 		snprintf(config->general.startup_script, sizeof(config->general.startup_script), "%s", kv->value);
+	} else if (!strcasecmp(SECTION_GENERAL_MISS_PREFIX_LEN, kv->key)) {
+		DEBUG_LOG("Match %s.\n", SECTION_GENERAL_MISS_PREFIX_LEN);
+		result = parse_int(kv->value, &config->general.miss_prefix_len, CONFIG_IPV6_PREFIX_MIN, CONFIG_IPV6_PREFIX_MAX);
+	} else if (!strcasecmp(SECTION_GENERAL_ROUTE_AGGREGATE, kv->key)) {
+		DEBUG_LOG("Match %s.\n", SECTION_GENERAL_ROUTE_AGGREGATE);
+		result = parse_bool(kv->value, &config->general.route_aggregate);
+	} else if (!strcasecmp(SECTION_GENERAL_ROUTE_INSTALL, kv->key)) {
+		DEBUG_LOG("Match %s.\n", SECTION_GENERAL_ROUTE_INSTALL);
+		result = parse_bool(kv->value, &config->general.route_install);
+	} else if (!strcasecmp(SECTION_GENERAL_SNAPSHOT_FILE, kv->key)) {
+		DEBUG_LOG("Match %s.\n", SECTION_GENERAL_SNAPSHOT_FILE);
+		snprintf(config->general.snapshot_file, sizeof(config->general.snapshot_file), "%s", kv->value);
+	} else if (!strcasecmp(SECTION_GENERAL_SNAPSHOT_INTERVAL, kv->key)) {
+		DEBUG_LOG("Match %s.\n", SECTION_GENERAL_SNAPSHOT_INTERVAL);
+		result = parse_int(kv->value, &config->general.snapshot_interval, 0, CONFIG_SNAPSHOT_INTERVAL_MAX);
 	} else {
 		// 不明なキーなのでスキップ
 		mx6e_logging(LOG_WARNING, "Ignore unknown key : %s\n", kv->key);
@@ -583,6 +754,11 @@ static bool config_init_device(mx6e_config_t * config)
 	config->devices.tunnel_fp.ifindex = -1;
 	config->devices.tunnel_fp.fd = -1;
 
+	config->devices.fp2pr_rx = MX6E_IO_TAP;
+	config->devices.fp2pr_tx = MX6E_IO_TAP;
+	config->devices.pr2fp_rx = MX6E_IO_TAP;
+	config->devices.pr2fp_tx = MX6E_IO_TAP;
+
 	return true;
 }
 
@@ -669,6 +845,20 @@ static bool config_parse_device(const config_keyvalue_t * kv, mx6e_config_t * co
 			// プレフィックスが指定されていない場合はエラーにする
 			result = false;
 		}
+
+		// パケットI/Oバックエンド
+	} else if (!strcasecmp(SECTION_DEVICE_FP2PR_RX, kv->key)) {
+		DEBUG_LOG("Match %s.\n", SECTION_DEVICE_FP2PR_RX);
+		result = mx6e_io_type_parse(kv->value, true, &config->devices.fp2pr_rx);
+	} else if (!strcasecmp(SECTION_DEVICE_FP2PR_TX, kv->key)) {
+		DEBUG_LOG("Match %s.\n", SECTION_DEVICE_FP2PR_TX);
+		result = mx6e_io_type_parse(kv->value, false, &config->devices.fp2pr_tx);
+	} else if (!strcasecmp(SECTION_DEVICE_PR2FP_RX, kv->key)) {
+		DEBUG_LOG("Match %s.\n", SECTION_DEVICE_PR2FP_RX);
+		result = mx6e_io_type_parse(kv->value, true, &config->devices.pr2fp_rx);
+	} else if (!strcasecmp(SECTION_DEVICE_PR2FP_TX, kv->key)) {
+		DEBUG_LOG("Match %s.\n", SECTION_DEVICE_PR2FP_TX);
+		result = mx6e_io_type_parse(kv->value, false, &config->devices.pr2fp_tx);
 	} else {
 		// 不明なキーなのでスキップ
 		mx6e_logging(LOG_WARNING, "Ignore unknown key : %s\n", kv->key);
@@ -706,7 +896,7 @@ static bool config_validate_device(mx6e_config_t * config)
 		return false;
 	}
 	// "name_pr" デバイスが存在するかチェック
-	if (if_nametoindex(devices->pr.name) == 0) {
+	if (!config_skip_device_check && (if_nametoindex(devices->pr.name) == 0)) {
 		mx6e_logging(LOG_ERR, "No such PR device : %s", devices->pr.name);
 		return false;
 	}
@@ -716,7 +906,7 @@ static bool config_validate_device(mx6e_config_t * config)
 		return false;
 	}
 	// "name_fp" デバイスが存在するかチェック
-	if (if_nametoindex(devices->fp.name) == 0) {
+	if (!config_skip_device_check && (if_nametoindex(devices->fp.name) == 0)) {
 		mx6e_logging(LOG_ERR, "No such FP device : %s", devices->fp.name);
 		return false;
 	}
@@ -9,6 +9,7 @@
 #   define __MX6EAPP_CONFIG_H__
 
 #   include <stdbool.h>
+#   include <stdint.h>
 #	include <stdio.h>
 #   include <net/if.h>
 #	include <netinet/in.h>
@@ -23,6 +24,11 @@ typedef struct {
 	bool                            debug_log;		///< デバッグログを出力するかどうか
 	bool                            daemon;			///< デーモン化するかどうか
 	char                            startup_script[FILENAME_MAX];	///< スタートアップスクリプト
+	int                             miss_prefix_len;	///< エントリ未登録宛先の集計単位プレフィックス長
+	bool                            route_aggregate;	///< トンネルデバイスの経路を集約するかどうか
+	bool                            route_install;	///< エントリの経路をカーネルに設定するかどうか
+	char                            snapshot_file[FILENAME_MAX];	///< テーブルスナップショットファイル(空の場合は保存/復元しない)
+	int                             snapshot_interval;	///< テーブルスナップショットの保存周期[sec](0の場合は終了時のみ)
 } mx6e_config_general_t;
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -40,6 +46,16 @@ typedef struct {
 
 } mx6e_device_t;
 
+///////////////////////////////////////////////////////////////////////////////
+//! パケットI/Oバックエンド種別
+///////////////////////////////////////////////////////////////////////////////
+typedef enum {
+	MX6E_IO_TAP,									///< トンネルデバイス(TAP)のread/write
+	MX6E_IO_MEMORY,									///< メモリ上のリング(試験/性能測定用)
+	MX6E_IO_RAW,									///< raw IPv6ソケットのsendmmsg(送信側のみ)
+	MX6E_IO_TYPE_MAX
+} mx6e_io_type_t;
+
 ///////////////////////////////////////////////////////////////////////////////
 //! デバイス情報
 ///////////////////////////////////////////////////////////////////////////////
@@ -50,6 +66,10 @@ typedef struct {
 	mx6e_device_t                   tunnel_fp;		///< FP側トンネルデバイス設定
 	int                             send_sock_fd_pr;	///< PR側送信用ソケットFD
 	int                             send_sock_fd_fp;	///< FP側送信用ソケットFD
+	mx6e_io_type_t                  pr2fp_rx;		///< PR->FP転送の受信バックエンド
+	mx6e_io_type_t                  pr2fp_tx;		///< PR->FP転送の送信バックエンド
+	mx6e_io_type_t                  fp2pr_rx;		///< FP->PR転送の受信バックエンド
+	mx6e_io_type_t                  fp2pr_tx;		///< FP->PR転送の送信バックエンド
 } mx6e_config_devices_t;
 
 typedef enum {
@@ -121,6 +141,51 @@ typedef enum {
 	CONFIG_TYPE_ME6E,
 } table_type_t;
 
+///////////////////////////////////////////////////////////////////////////////
+//! MX6E-PT Config Table マスク別グループのハッシュ表のスロット
+///////////////////////////////////////////////////////////////////////////////
+typedef struct {
+	uint64_t                        hash;			///< entryのハッシュ値(ドメイン + src.src & mask)
+	mx6e_config_entry_t            *entry;			///< エントリ(NULL:空き)
+} mx6e_config_slot_t;
+
+///////////////////////////////////////////////////////////////////////////////
+//! MX6E-PT Config Table マスク別グループのハッシュ表(線形探査。公開後は大きさを変えない)
+///////////////////////////////////////////////////////////////////////////////
+typedef struct {
+	int                             shift;			///< スロット位置算出用のシフト数(64 - log2(スロット数))
+	unsigned int                    mask;			///< スロット数 - 1
+	int                             used;			///< 空きでないスロット数(削除済みを含む)
+	mx6e_config_slot_t              slot[];			///< スロット
+} mx6e_config_index_t;
+
+///////////////////////////////////////////////////////////////////////////////
+//! MX6E-PT Config Table 受信パケット検索用のマスク別グループ
+///////////////////////////////////////////////////////////////////////////////
+typedef struct {
+	struct in6_addr                 mask;			///< src.mask(グループ内のエントリで共通)
+	int                             bits;			///< maskのビット数
+	int                             num;			///< エントリ数
+	mx6e_config_index_t            *index;			///< エントリのハッシュ表(検索スレッドへは差し替えで公開する)
+} mx6e_config_group_t;
+
+///////////////////////////////////////////////////////////////////////////////
+//! MX6E-PT Config Table 受信パケット検索用のマスク別グループ一覧(公開後は変更しない)
+///////////////////////////////////////////////////////////////////////////////
+typedef struct {
+	int                             num;			///< マスク別グループ数
+	mx6e_config_group_t            *group[];		///< マスク別グループ(マスクの長い順)
+} mx6e_config_group_list_t;
+
+///////////////////////////////////////////////////////////////////////////////
+//! MX6E-PT Config Table 受信パケット検索スレッドの状態
+//! (ドメイン毎に検索スレッドは1つ。スレッド間でキャッシュラインを共有しないよう64byteとする)
+///////////////////////////////////////////////////////////////////////////////
+typedef struct {
+	uint64_t                        seq;			///< 検索毎に2加算(検索中は奇数)
+	char                            pad[56];		///< 未使用
+} mx6e_config_reader_t;
+
 ///////////////////////////////////////////////////////////////////////////////
 //! MX6E-PT Config Table
 ///////////////////////////////////////////////////////////////////////////////
@@ -129,6 +194,10 @@ typedef struct {
 	pthread_mutex_t                 mutex;			///< 排他用のmutex
 	int                             num;			///< MX6E-PR Config Entry 数
 	void						   *root;			///< MX6E-PR Config Entry list
+	mx6e_config_group_list_t       *group;			///< 受信パケット検索用のマスク別グループ一覧(検索スレッドへは差し替えで公開する)
+	mx6e_config_reader_t            reader[DOMAIN_BOTH];	///< 受信パケット検索スレッドの状態(DOMAIN_FP/DOMAIN_PRで参照)
+	uint64_t                        version;		///< テーブル版数(エントリ変更の度に加算)
+	uint64_t                        hash;			///< テーブル内容のハッシュ値(エントリ毎のハッシュ値の和)
 } mx6e_config_table_t;
 
 
@@ -144,13 +213,31 @@ typedef struct {
 } mx6e_config_t;
 
 
+//! 設定差分の最大項目数
+#	define CONFIG_DIFF_MAX			32
+//! 設定差分の値の最大表示文字数
+#	define CONFIG_DIFF_VALUE_MAX	256
+
+///////////////////////////////////////////////////////////////////////////////
+//! 設定差分(設定ファイル再読み込み用)
+///////////////////////////////////////////////////////////////////////////////
+typedef struct {
+	const char                     *key;			///< 設定項目名
+	char                            before[CONFIG_DIFF_VALUE_MAX];	///< 変更前の値
+	char                            after[CONFIG_DIFF_VALUE_MAX];	///< 変更後の値
+	bool                            reloadable;		///< 運用中に反映可能かどうか(false:再起動が必要)
+} mx6e_config_diff_t;
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // 外部関数プロトタイプ
 ///////////////////////////////////////////////////////////////////////////////
 mx6e_config_t                  *mx6e_config_load(mx6e_config_t *config, const char *filename);
 void                            mx6e_config_destruct(mx6e_config_t * config);
 void                            mx6e_config_dump(const mx6e_config_t * config, int fd);
+int                             mx6e_config_diff(const mx6e_config_t * config, const mx6e_config_t * next, mx6e_config_diff_t * diff, int max);
 void                            config_init(mx6e_config_t * config);
+void                            mx6e_config_skip_device_check(bool skip);
 
 
 #endif												// __MX6EAPP_CONFIG_H__
@@ -1,329 +1,851 @@
 /******************************************************************************/
 /* ファイル名 : mx6eapp_ct.c                                                  */
-/* 機能概要   : 単体試験                                                      */
+/* 機能概要   : 単体試験(エントリ検索/アドレス置換 差分試験)                  */
 /* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
 /*                                                                            */
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
 /******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <netinet/ip6.h>
+#include <netinet/ether.h>
+#include <arpa/inet.h>
+
+#include "mx6eapp_config.h"
+#include "mx6eapp_pt.h"
+#include "mx6eapp_route.h"
+#include "mx6eapp_util.h"
+#include "mx6eapp_log.h"
+#include "mx6ectl_command.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! 既定の乱数の種(make checkの結果を再現可能にするため固定)
+#define CT_DEFAULT_SEED         1
+//! 既定の試験回数(テーブル生成回数)
+#define CT_DEFAULT_ROUNDS       200
+//! 既定の1回あたりのエントリ追加数
+#define CT_DEFAULT_ENTRIES      64
+//! 既定の1回あたりの検索パケット数
+#define CT_DEFAULT_PACKETS      2000
+//! 不一致の詳細を表示する最大件数
+#define CT_REPORT_MAX           20
+//! 試験で使用するエントリの最大数
+#define CT_ENTRY_MAX            PT_MAX_ENTRY_NUM
+//! 送信元の値を使い回す候補数(PlaneID/IPv4/MACを重複させて重なりを作る)
+#define CT_POOL_NUM             8
+//! 追加コマンド(表示用)の最大長(コマンド名、テーブルタイプと8項目の各値がアドレス/プレフィクス長の場合)
+#define CT_LINE_MAX             ((INET6_ADDRSTRLEN + 8) * 10)
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! 試験条件
+typedef struct {
+	uint64_t                        seed;			///< 乱数の種
+	int                             rounds;			///< 試験回数
+	int                             entries;		///< 1回あたりのエントリ追加数
+	int                             packets;		///< 1回あたりの検索パケット数
+	bool                            type[CONFIG_TYPE_ME6E + 1];	///< 試験するテーブルタイプ
+	bool                            verbose;		///< 試験回毎の結果を表示する
+} ct_option_t;
+
+//! 参照用エントリ(ユーザ指定値のみを保持し、内部生成項目は使用しない)
+typedef struct {
+	domain_t                        domain;			///< ドメイン
+	bool                            enable;			///< 有効/無効
+	int                             src_prefix_len;	///< prefix_len_in
+	struct in6_addr                 src_pid;		///< plane_id_in ("::plane_id_in")
+	char                            src_plane_id[INET6_ADDRSTRLEN];	///< plane_id_in(文字列)
+	struct in_addr                  v4addr;			///< IPv4アドレス(M46Eのみ)
+	int                             v4cidr;			///< IPv4のCIDR(M46Eのみ)
+	struct ether_addr               hwaddr;			///< MACアドレス(ME6Eのみ)
+	struct in6_addr                 des_prefix;		///< IPv6prefixアドレス
+	int                             des_prefix_len;	///< IPv6prefixのCIDR
+	struct in6_addr                 des_pid;		///< plane_id_out ("::plane_id_out")
+	char                            line[CT_LINE_MAX];	///< 追加コマンド(表示用)
+} ct_ref_entry_t;
+
+//! 検索エンジン
+typedef struct {
+	const char                     *name;			///< 名前
+	mx6e_config_entry_t            *(*match) (domain_t domain, mx6e_config_table_t * table, struct in6_addr * v6addr);	///< 検索関数
+} ct_match_engine_t;
+
+//! アドレス置換エンジン
+typedef struct {
+	const char                     *name;			///< 名前
+	bool                            (*replace) (mx6e_config_entry_t * entry, struct ip6_hdr * ip6);	///< 置換関数
+} ct_replace_engine_t;
+
+//! 試験結果
+typedef struct {
+	long                            added;			///< 追加できたエントリ数
+	long                            lookups;		///< 検索回数
+	long                            hits;			///< 参照実装での検索成功数
+	long                            rewrites;		///< アドレス置換回数
+	long                            mismatches;		///< 不一致数
+} ct_result_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部変数
+////////////////////////////////////////////////////////////////////////////////
+//! 乱数の状態(xorshift64*)
+static uint64_t                 rand_state = 88172645463325252ULL;
+
+//! 試験対象の検索エンジン一覧(検索方式を追加した場合はここに登録する)
+// *INDENT-OFF*
+static const ct_match_engine_t  match_engine[] = {
+	{"tsearch",	mx6e_match_config_table},
+};
+//! 試験対象のアドレス置換エンジン一覧
+static const ct_replace_engine_t replace_engine[] = {
+	{"replace",	mx6e_replace_address},
+};
+// *INDENT-ON*
+
+//! コマンドオプション構造体
+// *INDENT-OFF*
+static const struct option      options[] = {
+	{"seed",	required_argument,	NULL, 's'},
+	{"rounds",	required_argument,	NULL, 'r'},
+	{"entries",	required_argument,	NULL, 'n'},
+	{"packets",	required_argument,	NULL, 'p'},
+	{"type",	required_argument,	NULL, 't'},
+	{"verbose",	no_argument,		NULL, 'v'},
+	{"help",	no_argument,		NULL, 'h'},
+	{0, 0, 0, 0}
+};
+// *INDENT-ON*
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief コマンド凡例表示関数
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void usage(void)
+{
+	fprintf(stderr, "Usage: mx6eapp_ct [ -s SEED ] [ -r ROUNDS ] [ -n ENTRIES ] [ -p PACKETS ] [ -t m46e|me6e|all ] [ -v ]\n" "\n"
+			"  -s, --seed    : random seed (default %d)\n"
+			"  -r, --rounds  : number of generated tables (default %d)\n"
+			"  -n, --entries : entries added to each table (default %d, max %d)\n"
+			"  -p, --packets : packets looked up in each table (default %d)\n"
+			"  -t, --type    : table type (default all)\n"
+			"  -v, --verbose : print the result of each table\n" "\n",
+			CT_DEFAULT_SEED, CT_DEFAULT_ROUNDS, CT_DEFAULT_ENTRIES, CT_ENTRY_MAX, CT_DEFAULT_PACKETS);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 乱数生成関数(xorshift64*)
+//!
+//! @return 64bit乱数
+///////////////////////////////////////////////////////////////////////////////
+static inline uint64_t ct_rand(void)
+{
+	rand_state ^= rand_state >> 12;
+	rand_state ^= rand_state << 25;
+	rand_state ^= rand_state >> 27;
 
-#include "mx6eapp_ct.h"
+	return rand_state * 2685821657736338717ULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 範囲指定乱数生成関数
+//!
+//! @param [in]  min    最小値
+//! @param [in]  max    最大値
+//!
+//! @return min以上max以下の乱数
+///////////////////////////////////////////////////////////////////////////////
+static inline int ct_rand_range(int min, int max)
+{
+	return min + (int)(ct_rand() % (uint64_t) (max - min + 1));
+}
 
-#if defined(CT)
-#   include <stdlib.h>
-#	include <string.h>
-#   include "mx6eapp_pt.h"
-#   include "mx6eapp_config.h"
-#   include "mx6eapp_print_packet.h"
-#   include "mx6eapp_tunnel.h"
-#   include "mx6eapp_util.h"
-#	include "mx6ectl_command.h"
+///////////////////////////////////////////////////////////////////////////////
+//! @brief IPv6アドレスのビット取得関数
+//!
+//! @param [in]  addr   IPv6アドレス
+//! @param [in]  bit    ビット位置(0:最上位ビット 〜 127:最下位ビット)
+//!
+//! @return ビット値(0 or 1)
+///////////////////////////////////////////////////////////////////////////////
+static inline int ct_bit(const struct in6_addr *addr, int bit)
+{
+	return (addr->s6_addr[bit / 8] >> (7 - bit % 8)) & 1;
+}
 
-static void CT_get_pid_bit_width(void)
+///////////////////////////////////////////////////////////////////////////////
+//! @brief IPv6アドレスのビット設定関数
+//!
+//! @param [in/out] addr   IPv6アドレス
+//! @param [in]     bit    ビット位置(0:最上位ビット 〜 127:最下位ビット)
+//! @param [in]     value  ビット値(0 or 1)
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static inline void ct_set_bit(struct in6_addr *addr, int bit, int value)
 {
-	char                            buf[128];
-	struct in6_addr pid;
-	
-	inet_pton(AF_INET6, "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff", &pid);
-	inet_ntop(AF_INET6, &pid, buf, sizeof(buf));
+	uint8_t                         b = 0x80 >> (bit % 8);
 
-	for (int i = 0; i < sizeof(pid.s6_addr); i ++) {
-		printf("%02x ", pid.s6_addr[i]);
+	if (value) {
+		addr->s6_addr[bit / 8] |= b;
+	} else {
+		addr->s6_addr[bit / 8] &= ~b;
 	}
-	printf("\n");
-	printf("%s : %d\n", buf, get_pid_bit_width(buf));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief IPv4アドレスのビット取得関数
+//!
+//! @param [in]  addr   IPv4アドレス
+//! @param [in]  bit    ビット位置(0:最上位ビット 〜 31:最下位ビット)
+//!
+//! @return ビット値(0 or 1)
+///////////////////////////////////////////////////////////////////////////////
+static inline int ct_bit4(const struct in_addr *addr, int bit)
+{
+	return (ntohl(addr->s_addr) >> (31 - bit)) & 1;
+}
 
-	inet_pton(AF_INET6, "0fff:ffff:ffff:ffff:ffff:ffff:ffff:ffff", &pid);
-	inet_ntop(AF_INET6, &pid, buf, sizeof(buf));
-	for (int i = 0; i < sizeof(pid.s6_addr); i ++) {
-		printf("%02x ", pid.s6_addr[i]);
+///////////////////////////////////////////////////////////////////////////////
+//! @brief MACアドレスのビット取得関数
+//!
+//! @param [in]  hwaddr MACアドレス
+//! @param [in]  bit    ビット位置(0:最上位ビット 〜 47:最下位ビット)
+//!
+//! @return ビット値(0 or 1)
+///////////////////////////////////////////////////////////////////////////////
+static inline int ct_bit_hw(const struct ether_addr *hwaddr, int bit)
+{
+	return (hwaddr->ether_addr_octet[bit / 8] >> (7 - bit % 8)) & 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief IPv6アドレス下位ビット乱数生成関数
+//!
+//! 下位width bitのみを乱数とし、それより上位を0としたアドレスを生成する。
+//! PlaneIDの生成に使用する。
+//!
+//! @param [in]  width  乱数とするビット数
+//! @param [out] addr   生成したアドレス
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void ct_rand_low_bits(int width, struct in6_addr *addr)
+{
+	memset(addr, 0, sizeof(struct in6_addr));
+	for (int b = 128 - width; b < 128; b++) {
+		ct_set_bit(addr, b, ct_rand() & 1);
 	}
-	printf("\n");
-	printf("%s : %d\n", buf, get_pid_bit_width(buf));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief PlaneID文字列生成関数
+//!
+//! "::"に続けてPlaneIDとして指定する文字列を生成する。
+//! inet_ntopはIPv4埋め込み形式で出力する場合があるので、16bit毎に書式化する。
+//!
+//! @param [in]  pid    PlaneID ("::plane_id"形式)
+//! @param [out] buf    PlaneID文字列
+//! @param [in]  size   bufのサイズ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void ct_format_pid(const struct in6_addr *pid, char *buf, size_t size)
+{
+	int                             i = 0;
+	int                             len = 0;
 
-	inet_pton(AF_INET6, "::70:1", &pid);
-	inet_ntop(AF_INET6, &pid, buf, sizeof(buf));
-	for (int i = 0; i < sizeof(pid.s6_addr); i ++) {
-		printf("%02x ", pid.s6_addr[i]);
+	// 先頭の0のグループは省略する(最下位のグループは残す)
+	while ((i < 7) && (pid->s6_addr16[i] == 0)) {
+		i++;
 	}
-	printf("\n");
-	printf("%s : %d\n", buf, get_pid_bit_width(buf));
+	for (; i < 8; i++) {
+		len += snprintf(buf + len, size - len, "%s%x", (len > 0) ? ":" : "", ntohs(pid->s6_addr16[i]));
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 参照実装 エントリ照合関数
+//!
+//! 宛先アドレスがエントリにマッチするかを1bitずつ照合する。
+//! |<- prefix_len ->|<-- PlaneID -->|<-- IPv4(v4cidrまで)/MAC -->|
+//! プレフィクス部は照合せず、PlaneID部は plane_id_in の下位ビットと、
+//! IPv4/MAC部はエントリの値と一致すればマッチとする。
+//!
+//! @param [in]  type    テーブルタイプ
+//! @param [in]  entry   参照用エントリ
+//! @param [in]  addr    宛先アドレス
+//!
+//! @return 0以上   マッチした(照合したビット数)
+//! @return -1      マッチしない
+///////////////////////////////////////////////////////////////////////////////
+static int ct_ref_entry_match(table_type_t type, const ct_ref_entry_t * entry, const struct in6_addr *addr)
+{
+	int                             tail = (CONFIG_TYPE_M46E == type) ? 32 : 48;
+	int                             len = (CONFIG_TYPE_M46E == type) ? entry->v4cidr : 48;
 
-	inet_pton(AF_INET6, "::1", &pid);
-	inet_ntop(AF_INET6, &pid, buf, sizeof(buf));
-	for (int i = 0; i < sizeof(pid.s6_addr); i ++) {
-		printf("%02x ", pid.s6_addr[i]);
+	// PlaneID部(PlaneIDのビット b + tail がアドレスのビット b に対応する)
+	for (int b = entry->src_prefix_len; b < 128 - tail; b++) {
+		if (ct_bit(addr, b) != ct_bit(&entry->src_pid, b + tail)) {
+			return -1;
+		}
+	}
+	// IPv4/MAC部
+	for (int b = 0; b < len; b++) {
+		int                             v = (CONFIG_TYPE_M46E == type) ? ct_bit4(&entry->v4addr, b) : ct_bit_hw(&entry->hwaddr, b);
+		if (ct_bit(addr, 128 - tail + b) != v) {
+			return -1;
+		}
 	}
-	printf("\n");
-	printf("%s : %d\n", buf, get_pid_bit_width(buf));
 
-	return;
+	return (128 - tail - entry->src_prefix_len) + len;
 }
 
-static void CT_m46e_pt_add_config_entry(mx6e_handler_t * handler)
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 参照実装 テーブル検索関数
+//!
+//! 全エントリを線形に照合し、以下の規則で1エントリを選択する。
+//!  1. ドメインが一致し、ct_ref_entry_match() でマッチするエントリが候補
+//!  2. 照合したビット数が最長の候補を選択(最長一致)
+//!  3. ビット数が同じ場合はIPv4のCIDRが長い候補を選択
+//!  4. 選択した候補が無効(disable)の場合は検索失敗とする
+//!     (無効なエントリより短い有効なエントリにはフォールバックしない)
+//!
+//! @param [in]  type    テーブルタイプ
+//! @param [in]  entry   参照用エントリ一覧
+//! @param [in]  num     参照用エントリ数
+//! @param [in]  domain  検索するドメイン
+//! @param [in]  addr    宛先アドレス
+//! @param [out] found   選択したエントリ番号(無効なエントリを含む、候補無しは-1)
+//!
+//! @return 0以上   検索成功(エントリ番号)
+//! @return -1      検索失敗
+///////////////////////////////////////////////////////////////////////////////
+static int ct_ref_match(table_type_t type, const ct_ref_entry_t * entry, int num, domain_t domain, const struct in6_addr *addr, int *found)
 {
-	mx6e_command_t	command;
-
-#define	ENABLE	"enable"
-
-	// テストエントリ
-	// *INDENT-OFF*
-	struct {
-		mx6e_config_table_t *table;
-		mx6e_command_code_t code;
-		char *opt[7];
-	} cmd[] = {
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"fp",	"1",		"16",	"ab:cd:ef:01:23:45",	"f00d:1:a::/48",	"1:1",	ENABLE}},	// OK
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"fp",	"1:1",		"16",	"ab:cd:ef:01:23:45",	"f00d:1:b::/48",	"1:2",	ENABLE}},	// OK
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"fp",	"1:1:1",	"16",	"ab:cd:ef:01:23:45",	"f00d:1:c::/48",	"1:3",	ENABLE}},	// OK
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"fp",	"1:1:1:1",	"16",	"ab:cd:ef:01:23:45",	"f00d:1:d::/48",	"1:4",	ENABLE}},	// OK
-		{NULL, MX6E_COMMAND_NONE, {NULL}},
-	}, cmd_a[] = {
-		// Me6E prefix 最大79bit + 最小planeid  1bit + MAC48
-		// Me6E prefix 最小1bit  + 最大planeid 79bit + MAC48
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"fp",	"1",	"1",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"1:1",	ENABLE}},	// OK
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"pr",	"1",	"1",	"ab:cd:ef:01:23:45",	"f00d:1:2::/48",	"2:1",	ENABLE}},	// OK
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"fp",	"1:1",	"62",	"ab:cd:ef:01:23:45",	"f00d:1:3::/48",	"3:1",	ENABLE}},
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"pr",	"1:2",	"62",	"ab:cd:ef:01:23:45",	"f00d:1:4::/48",	"4:1",	ENABLE}},
-		// すでに同じとみなされるエントリがあるので重複
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"fp",	"1",	"79",	"ab:cd:ef:01:23:45",	"f00d:1:3::/48",	"3:1",	ENABLE}},
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"pr",	"1",	"79",	"ab:cd:ef:01:23:45",	"f00d:1:4::/48",	"4:1",	ENABLE}},
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"fp",	"1:1",	"1",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"1:1",	ENABLE}},	// OK
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"pr",	"1:2",	"1",	"ab:cd:ef:01:23:45",	"f00d:1:2::/48",	"2:1",	ENABLE}},	// OK
-		
-		// M46E prefix 最大95bit + 最小planeid  1bit + IPv4 32
-		// M46E prefix 最小1bit  + 最大planeid 95bit + IPv4 32
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"fp",	"1",	"1",	"192.168.100.0/24",		"f00d:1:5::/48",	"5:1",	ENABLE}},
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"pr",	"1",	"1",	"192.168.100.0/24",		"f00d:1:6::/48",	"6:1",	ENABLE}},
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"fp",	"1:3",	"78",	"192.168.100.0/24",		"f00d:1:5::/48",	"5:1",	ENABLE}},
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"pr",	"1:4",	"78",	"192.168.100.0/24",		"f00d:1:6::/48",	"6:1",	ENABLE}},
-		// すでに同じとみなされるエントリがあるので重複
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"fp",	"1",	"95",	"192.168.100.0/24",		"f00d:1:7::/48",	"7:1",	ENABLE}},
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"pr",	"1",	"95",	"192.168.100.0/24",		"f00d:1:8::/48",	"8:1",	ENABLE}},
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"fp",	"1:3",	"1",	"192.168.100.0/24",		"f00d:1:5::/48",	"5:1",	ENABLE}},
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"pr",	"1:4",	"1",	"192.168.100.0/24",		"f00d:1:6::/48",	"6:1",	ENABLE}},
-		{NULL, MX6E_COMMAND_NONE, {NULL}},
-	}, 
-	cmd_b[] = {
-		// Me6E prefix 最大79bit + 最小planeid  1bit + MAC48
-		// Me6E prefix 最小1bit  + 最大planeid 79bit + MAC48
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"fp",	"1",						"48",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"e:4",	ENABLE}},	// OK
-		// {&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"fp",	"1",						"79",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"e:5",	ENABLE}},	// OK
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"fp",	"7fff:ffff:ffff:ffff:ffff",	"1",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"e:6",	ENABLE}},	// OK
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"fp",	"ffff:ffff:ffff:ffff:ffff",	"1",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"e:7",	ENABLE}},	// NG
-		
-		// {&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"pr",	"1",			"1",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"e:8",	ENABLE}},	// OK
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"pr",	"1",			"48",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"e:9",	ENABLE}},	// OK
-		// {&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"pr",	"1",			"79",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"e:a",	ENABLE}},	// OK
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"pr",	"1",			"80",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"e:b",	ENABLE}},	// NG
-																		                
-		// M46E prefix 最大95bit + 最小planeid  1bit + IPv4 32
-		// M46E prefix 最小1bit  + 最大planeid 95bit + IPv4 32
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"pr",	"1",			"1",	"192.168.100.0/24",	"f00d:1:1::/48",	"4:4",	ENABLE}},	// OK
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"pr",	"1",			"95",	"192.168.100.0/24",	"f00d:1:1::/48",	"4:5",	ENABLE}},	// OK
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"pr",	"1",			"96",	"192.168.100.0/24",	"f00d:1:1::/48",	"4:6",	ENABLE}},	// NG
-																		                
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"fp",	"1",								"95",	"192.168.100.0/24",	"f00d:1:1::/48",	"4:7",	ENABLE}},	// OK
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"fp",	"7fff:ffff:ffff:ffff:ffff:ffff",	"1",	"192.168.100.0/24",	"f00d:1:1::/48",	"4:8",	ENABLE}},	// OK
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"fp",	"ffff:ffff:ffff:ffff:ffff:ffff",	"1",	"192.168.100.0/24",	"f00d:1:1::/48",	"4:9",	ENABLE}},	// NG
-
-		
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"fp",	"1",			"65",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"e:10",	ENABLE}},
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"pr",	"1",			"65",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"e:11",	ENABLE}},
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"fp",	"2",			"64",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"e:12",	ENABLE}},
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"pr",	"8000",			"64",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"e:13",	ENABLE}},	// 128-48-64 = 16, 8000 = 16bit
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"fp",	"8000",			"64",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"e:14",	ENABLE}},
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"pr",	"1:ffff",		"64",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"e:15",	ENABLE}},	// 128-48-64 = 16, 1:ffff = 17bit -> NG
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"fp",	"1:ffff",		"64",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"e:16",	ENABLE}},
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"pr",	"1:2",			"64",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"8fff:ffff:ffff",	ENABLE}},	// 128-32-48 = 48
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"fp",	"1:2",			"64",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"8fff:ffff:ffff",	ENABLE}},
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"pr",	"1:2",			"64",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"1:ffff:ffff:ffff",	ENABLE}},	// 128-32-48 = 48, 1:ffff:ffff:ffff = 49bit -> NG
-		{&handler->conf.me6e_conf_table, MX6E_ADD_ME6E_ENTRY, {"fp",	"1:2",			"64",	"ab:cd:ef:01:23:45",	"f00d:1:1::/48",	"1:ffff:ffff:ffff",	ENABLE}},
-
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"pr",	"1:2",			"64",	"192.168.100.0/24",		"f00d:1:1::/48",	"4:7",	ENABLE}},
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"fp",	"1:2",			"64",	"192.168.100.0/24",		"f00d:1:1::/48",	"4:8",	ENABLE}},
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"pr",	"8000:1234",	"64",	"192.168.101.0/24",		"f00d:1:1::/48",	"4:9",	ENABLE}},	// 128-32-64 = 32, 8000:1234 = 32bit
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"fp",	"8000:1234",	"64",	"192.168.101.0/24",		"f00d:1:1::/48",	"4:a",	ENABLE}},
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"pr",	"1:ffff:1234",	"64",	"192.168.101.0/24",		"f00d:1:1::/48",	"4:b",	ENABLE}},	// 128-32-64 = 32, 1:ffff:1234 = 33bit -> NG
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"fp",	"1:ffff:1234",	"64",	"192.168.101.0/24",		"f00d:1:1::/48",	"4:c",	ENABLE}},
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"pr",	"1:2",			"64",	"192.168.102.0/24",		"f00d:1:1::/48",	"8fff:ffff:ffff",	ENABLE}},	// 128-32-48 = 48
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"fp",	"1:2",			"64",	"192.168.102.0/24",		"f00d:1:1::/48",	"8fff:ffff:ffff",	ENABLE}},
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"pr",	"1:2",			"64",	"192.168.103.0/24",		"f00d:1:1::/48",	"1:ffff:ffff:ffff",	ENABLE}},	// 128-32-48 = 48, 1:ffff:ffff:ffff = 49bit -> NG
-		{&handler->conf.m46e_conf_table, MX6E_ADD_M46E_ENTRY, {"fp",	"1:2",			"64",	"192.168.103.0/24",		"f00d:1:1::/48",	"1:ffff:ffff:ffff",	ENABLE}},
-		{NULL, MX6E_COMMAND_NONE, {NULL}},
-	};
-	// *INDENT-ON*
-
-	int m46e_item = 0;
-	int me6e_item = 0;
-	for (int i = 0; cmd[i].table; i ++) {
-		if (MX6E_ADD_M46E_ENTRY == cmd[i].code) {
-			m46e_item ++;
+	int                             best = -1;
+	int                             best_len = -1;
+
+	for (int i = 0; i < num; i++) {
+		int                             len;
+
+		if (entry[i].domain != domain) {
+			continue;
 		}
-		if (MX6E_ADD_ME6E_ENTRY == cmd[i].code) {
-			me6e_item ++;
+		if (0 > (len = ct_ref_entry_match(type, &entry[i], addr))) {
+			continue;
 		}
-		printf("****************************************\n");
-		printf("* CT_m46e_pt_add_config_entry %3d * ", i);
-		command.code = cmd[i].code;
-		printf("%s ", get_command_name(command.code));
-		for (int n = 0; n < 7; n ++) {
-			printf("%s\t", cmd[i].opt[n]);
+		if ((len > best_len) || ((len == best_len) && (CONFIG_TYPE_M46E == type) && (entry[i].v4cidr > entry[best].v4cidr))) {
+			best = i;
+			best_len = len;
 		}
-		printf("\n");
-		printf("in  pid %s %d[bit]\n", cmd[i].opt[1], get_pid_bit_width(cmd[i].opt[1]));
-		printf("out pid %s %d[bit]\n", cmd[i].opt[5], get_pid_bit_width(cmd[i].opt[5]));
-		mx6e_command_add_entry_option(7, cmd[i].opt, &command);	// mx6ectlのコマンドライン分解関数でmx6e_config_entry_tを作成
-		bool r = m46e_pt_add_config_entry(cmd[i].table, &command.req.mx6e_data.entry, &handler->conf.devices);
-		if (r) {
-			printf("m46e_pt_add_config_entry add\n");
-		} else {
-			printf("m46e_pt_add_config_entry fail\n");
+	}
+	*found = best;
+
+	return ((best >= 0) && entry[best].enable) ? best : -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 参照実装 アドレス置換関数
+//!
+//! マッチしたエントリの送信データで送信先/送信元アドレスを1bitずつ生成する。
+//! 送信先: |des.prefix(prefix_len)|plane_id_out|IPv4(v4cidrまで)/MAC|ホスト部(受信値)|
+//! 送信元: |des.prefix(prefix_len)|plane_id_out|IPv4/MAC部(受信値)|
+//! FPドメインで受信した場合、送信元の先頭はPRトンネルデバイスの
+//! プレフィクス(ipv6_netmask bit)で上書きする。
+//!
+//! @param [in]     type     テーブルタイプ
+//! @param [in]     entry    マッチした参照用エントリ
+//! @param [in]     devices  デバイス設定
+//! @param [in/out] ip6      変換するIPv6ヘッダ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void ct_ref_replace(table_type_t type, const ct_ref_entry_t * entry, const mx6e_config_devices_t * devices, struct ip6_hdr *ip6)
+{
+	int                             tail = (CONFIG_TYPE_M46E == type) ? 32 : 48;
+	int                             len = (CONFIG_TYPE_M46E == type) ? entry->v4cidr : 48;
+	struct in6_addr                 dst = ip6->ip6_dst;
+	struct in6_addr                 src = ip6->ip6_src;
+
+	for (int b = 0; b < 128 - tail; b++) {
+		int                             v = (b < entry->des_prefix_len) ? ct_bit(&entry->des_prefix, b) : ct_bit(&entry->des_pid, b + tail);
+		ct_set_bit(&dst, b, v);
+		ct_set_bit(&src, b, v);
+	}
+	for (int b = 0; b < len; b++) {
+		int                             v = (CONFIG_TYPE_M46E == type) ? ct_bit4(&entry->v4addr, b) : ct_bit_hw(&entry->hwaddr, b);
+		ct_set_bit(&dst, 128 - tail + b, v);
+	}
+	if (DOMAIN_FP == entry->domain) {
+		for (int b = 0; b < devices->tunnel_pr.ipv6_netmask; b++) {
+			ct_set_bit(&src, b, ct_bit(&devices->tunnel_pr.ipv6_address, b));
 		}
-		
 	}
+	ip6->ip6_dst = dst;
+	ip6->ip6_src = src;
+}
 
-	printf("****************************************\n");
-	printf("me6e add entry item: %d\n", me6e_item);
-	printf("m46e add entry item: %d\n", m46e_item);
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 試験対象エントリ同一判定関数
+//!
+//! 試験対象の検索結果が参照用エントリと同じエントリかをユーザ指定値で判定する。
+//!
+//! @param [in]  type    テーブルタイプ
+//! @param [in]  ref     参照用エントリ
+//! @param [in]  entry   試験対象の検索結果
+//!
+//! @retval true  同一
+//! @retval false 不一致
+///////////////////////////////////////////////////////////////////////////////
+static bool ct_same_entry(table_type_t type, const ct_ref_entry_t * ref, const mx6e_config_entry_t * entry)
+{
+	if ((ref->domain != entry->domain) || (ref->src_prefix_len != entry->src.prefix_len) || strcmp(ref->src_plane_id, entry->src.plane_id)) {
+		return false;
+	}
+	if (CONFIG_TYPE_M46E == type) {
+		return (ref->v4addr.s_addr == entry->src.in.m46e.v4addr.s_addr) && (ref->v4cidr == entry->src.in.m46e.v4cidr);
+	}
 
-	printf("handler->conf.me6e_conf_table\n");
-	m46e_pt_config_table_dump(&handler->conf.me6e_conf_table);
-	printf("handler->conf.m46e_conf_table\n");
-	m46e_pt_config_table_dump(&handler->conf.m46e_conf_table);
+	return !memcmp(&ref->hwaddr, &entry->src.in.me6e.hwaddr, sizeof(struct ether_addr));
+}
 
-	printf("%s: exit\n", __func__);
-	
-	return;
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 試験対象エントリ表示用文字列生成関数
+//!
+//! @param [in]  type    テーブルタイプ
+//! @param [in]  entry   試験対象の検索結果(NULL:検索失敗)
+//! @param [out] buf     表示用文字列
+//! @param [in]  size    bufのサイズ
+//!
+//! @return 表示用文字列
+///////////////////////////////////////////////////////////////////////////////
+static const char *ct_entry_name(table_type_t type, const mx6e_config_entry_t * entry, char *buf, size_t size)
+{
+	char                            address[INET6_ADDRSTRLEN];
+
+	if (entry == NULL) {
+		snprintf(buf, size, "(none)");
+	} else if (CONFIG_TYPE_M46E == type) {
+		snprintf(buf, size, "%s %s %d %s/%d %s", get_domain_name(entry->domain), entry->src.plane_id, entry->src.prefix_len,
+				 inet_ntop(AF_INET, &entry->src.in.m46e.v4addr, address, sizeof(address)), entry->src.in.m46e.v4cidr, entry->enable ? "enable" : "disable");
+	} else {
+		snprintf(buf, size, "%s %s %d %s %s", get_domain_name(entry->domain), entry->src.plane_id, entry->src.prefix_len,
+				 ether_ntoa_r(&entry->src.in.me6e.hwaddr, address), entry->enable ? "enable" : "disable");
+	}
+
+	return buf;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief ランダムエントリ生成関数
+//!
+//! ENTRY 追加コマンドの引数を乱数で生成し、mx6ectlと同じ関数で分解する。
+//! 送信元のPlaneID/IPv4/MACは候補から選んで重複させ、
+//! プレフィクス長・PlaneID幅・IPv4 CIDRの異なるエントリが重なるようにする。
+//!
+//! @param [in]  type      テーブルタイプ
+//! @param [in]  plen      送信元プレフィクス長の候補(3個)
+//! @param [in]  pid_pool  送信元PlaneIDの候補
+//! @param [in]  v4_pool   IPv4アドレスの候補
+//! @param [in]  hw_pool   MACアドレスの候補
+//! @param [out] ref       参照用エントリ
+//! @param [out] command   コマンド構造体(entryに追加するエントリ)
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了(コマンド引数の分解に失敗)
+///////////////////////////////////////////////////////////////////////////////
+static bool ct_make_entry(table_type_t type, const int *plen, const struct in6_addr *pid_pool, const struct in_addr *v4_pool,
+						  const struct ether_addr *hw_pool, ct_ref_entry_t * ref, mx6e_command_t * command)
+{
+	int                             tail = (CONFIG_TYPE_M46E == type) ? 32 : 48;
+	char                            section[INET6_ADDRSTRLEN + 8];
+	char                            in[INET6_ADDRSTRLEN];
+	char                            prefix[INET6_ADDRSTRLEN + 8];
+	char                            des_pid[INET6_ADDRSTRLEN];
+	char                            address[INET6_ADDRSTRLEN];
+	char                            src_plen[8];
+	struct in6_addr                 section_addr;
+	char                           *opt[8];
+
+	memset(ref, 0, sizeof(ct_ref_entry_t));
+	memset(command, 0, sizeof(mx6e_command_t));
+	command->code = (CONFIG_TYPE_M46E == type) ? MX6E_ADD_M46E_ENTRY : MX6E_ADD_ME6E_ENTRY;
+
+	ref->domain = (ct_rand() & 1) ? DOMAIN_FP : DOMAIN_PR;
+	ref->enable = (ct_rand() % 8) != 0;
+
+	// 送信元 PlaneIDはプレフィクス長に収まる候補から選ぶ(収まらなければ幅を詰める)
+	ref->src_prefix_len = plen[ct_rand() % 3];
+	ref->src_pid = pid_pool[ct_rand() % CT_POOL_NUM];
+	for (int b = 0; b < ref->src_prefix_len + tail; b++) {
+		ct_set_bit(&ref->src_pid, b, 0);
+	}
+	ct_format_pid(&ref->src_pid, ref->src_plane_id, sizeof(ref->src_plane_id));
+
+	// 送信元 IPv4(候補のネットワーク部)/MAC
+	if (CONFIG_TYPE_M46E == type) {
+		ref->v4cidr = ct_rand_range(0, 32);
+		PR_CIDR2SUBNETMASK(ref->v4cidr, ref->v4addr);
+		ref->v4addr.s_addr &= v4_pool[ct_rand() % CT_POOL_NUM].s_addr;
+		snprintf(in, sizeof(in), "%s/%d", inet_ntop(AF_INET, &ref->v4addr, address, sizeof(address)), ref->v4cidr);
+	} else {
+		ref->hwaddr = hw_pool[ct_rand() % CT_POOL_NUM];
+		if (ct_rand() & 1) {
+			ref->hwaddr.ether_addr_octet[ETH_ALEN - 1] = (uint8_t) ct_rand();
+		}
+		ether_ntoa_r(&ref->hwaddr, in);
+	}
+
+	// 送信データ(プレフィクス長は1bit単位、PlaneIDは残りの幅に収まる乱数)
+	ref->des_prefix_len = ct_rand_range(CONFIG_IPV6_PREFIX_MIN, 128 - tail - 1);
+	for (int i = 0; i < 4; i++) {
+		ref->des_prefix.s6_addr32[i] = (uint32_t) ct_rand();
+	}
+	ct_rand_low_bits(ct_rand_range(0, 128 - tail - ref->des_prefix_len), &ref->des_pid);
+	ct_format_pid(&ref->des_pid, des_pid, sizeof(des_pid));
+	snprintf(prefix, sizeof(prefix), "%s/%d", inet_ntop(AF_INET6, &ref->des_prefix, address, sizeof(address)), ref->des_prefix_len);
+
+	// セクションデバイスroute(FPのみ、検索/置換には影響しない)
+	for (int i = 0; i < 4; i++) {
+		section_addr.s6_addr32[i] = (uint32_t) ct_rand();
+	}
+	snprintf(section, sizeof(section), "%s/%d", inet_ntop(AF_INET6, &section_addr, address, sizeof(address)), ct_rand_range(16, 64));
+
+	// mx6ectl -n PLANE_NAME add m46e|me6e [pr|fp] [section|-] [plane_id_in] [prefix_len_in] [ipv4/cidr|hwaddr] [ipv6/prefix_len] [plane_id_out] [enable|disable]
+	snprintf(src_plen, sizeof(src_plen), "%d", ref->src_prefix_len);
+	opt[0] = (DOMAIN_FP == ref->domain) ? SECTION_DOMAIN_FP : SECTION_DOMAIN_PR;
+	opt[1] = (DOMAIN_FP == ref->domain) ? section : "-";
+	opt[2] = ref->src_plane_id;
+	opt[3] = src_plen;
+	opt[4] = in;
+	opt[5] = prefix;
+	opt[6] = des_pid;
+	opt[7] = ref->enable ? "enable" : "disable";
+	snprintf(ref->line, sizeof(ref->line), "add %s %s %s %s %s %s %s %s %s", (CONFIG_TYPE_M46E == type) ? "m46e" : "me6e",
+			 opt[0], opt[1], opt[2], opt[3], opt[4], opt[5], opt[6], opt[7]);
+
+	return mx6e_command_add_entry_option(8, opt, command);
 }
 
-static void CT_tunnel_forward_xx2xx_packet(mx6e_handler_t * handler)
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 試験宛先アドレス生成関数
+//!
+//! 以下のいずれかの宛先を生成する。
+//!  - いずれかのエントリにマッチする宛先(マスクされない部分は乱数)
+//!  - マッチする宛先の1bitを反転した宛先(境界の確認)
+//!  - 別のエントリのPlaneIDとIPv4/MACを組み合わせた宛先(重なりの確認)
+//!
+//! @param [in]  type    テーブルタイプ
+//! @param [in]  ref     参照用エントリ一覧
+//! @param [in]  num     参照用エントリ数
+//! @param [out] addr    宛先アドレス
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void ct_make_dst(table_type_t type, const ct_ref_entry_t * ref, int num, struct in6_addr *addr)
 {
-	char                            recv_buffer[1024];
-	ssize_t                         recv_len;
-	struct ethhdr                  *p_ether;
-	struct ip6_hdr                 *p_ip6;
-	
-	// テストパケット
-	// CT_m46e_pt_add_config_entryで登録したエントリで変換するかどうかを確認
-	// *INDENT-OFF*
-	struct {
-		domain_t	domain;
-		int next;			// ME6E_IPPROTO_ETHERIP:ME6E, IPPROTO_IPIP:M46E
-		char *hwaddrdes;
-		char *hwaddrsrc;
-		char *ipsrc;
-		char *ipdst;
-		int hoplimit;
-	} pack[] = {
-		//          ME6E_IPPROTO_ETHERIP: Me6E
-		{DOMAIN_FP, ME6E_IPPROTO_ETHERIP,	"11:22:33:44:55:66", "de:ad:be:ef:00:01", "2000::1:abcd:ef01:6789",			"2000::1:abcd:ef01:2345",		2},
-		{DOMAIN_FP, ME6E_IPPROTO_ETHERIP,	"11:22:33:44:55:66", "de:ad:be:ef:00:01", "2000::1:1:abcd:ef01:6789",		"2000::1:1:abcd:ef01:2345",		2},
-		{DOMAIN_FP, ME6E_IPPROTO_ETHERIP,	"11:22:33:44:55:66", "de:ad:be:ef:00:01", "8000::1:1:1:abcd:ef01:6789",		"8000::1:1:1:abcd:ef01:2345",	2},
-		{DOMAIN_FP, ME6E_IPPROTO_ETHERIP,	"11:22:33:44:55:66", "de:ad:be:ef:00:01", "8000:1:1:1:1:abcd:ef01:6789",	"8000:1:1:1:1:abcd:ef01:2345",	2},
-		
-		{DOMAIN_FP, ME6E_IPPROTO_ETHERIP,	"11:22:33:44:55:66", "de:ad:be:ef:00:01", "2000::1:abcd:ef01:6789",		"2000::1:abcd:ef01:2345",		2},
-		{DOMAIN_PR, ME6E_IPPROTO_ETHERIP,	"11:22:33:44:55:66", "de:ad:be:ef:00:01", "2000::1:abcd:ef01:6789",		"2000::1:abcd:ef01:2345",		2},
-		{DOMAIN_FP, ME6E_IPPROTO_ETHERIP,	"11:22:33:44:55:66", "de:ad:be:ef:00:01", "8000::1:abcd:ef01:6789",		"8000::1:abcd:ef01:2345",		2},
-		{DOMAIN_PR, ME6E_IPPROTO_ETHERIP,	"11:22:33:44:55:66", "de:ad:be:ef:00:01", "8000::1:abcd:ef01:6789",		"8000::1:abcd:ef01:2345",		2},
-		{DOMAIN_FP, ME6E_IPPROTO_ETHERIP,	"11:22:33:44:55:66", "de:ad:be:ef:00:01", "7fff:ffff:ffff:ffff:ffff:abcd:ef01:6789",	"7fff:ffff:ffff:ffff:ffff:abcd:ef01:2345",	2},
-		{DOMAIN_PR, ME6E_IPPROTO_ETHERIP,	"11:22:33:44:55:66", "de:ad:be:ef:00:01", "7fff:ffff:ffff:ffff:ffff:abcd:ef01:6789",	"7fff:ffff:ffff:ffff:ffff:abcd:ef01:2345",	2},
-		{DOMAIN_FP, ME6E_IPPROTO_ETHERIP,	"11:22:33:44:55:66", "de:ad:be:ef:00:01", "2000::8000:abcd:ef01:6789",	"2000::8000:abcd:ef01:2345",	2},
-		{DOMAIN_PR, ME6E_IPPROTO_ETHERIP,	"11:22:33:44:55:66", "de:ad:be:ef:00:01", "2000::8000:abcd:ef01:6789",	"2000::8000:abcd:ef01:2345",	2},
-		//          IPPROTO_IPIP: M46E
-		{DOMAIN_FP, IPPROTO_IPIP,			"11:22:33:44:55:66", "de:ad:be:ef:00:01", "2000::8000:1234:c0a8:6501",	"2000::8000:1234:c0a8:6502",	2},	// 192.168.101.1,2
-		{DOMAIN_PR, IPPROTO_IPIP,			"11:22:33:44:55:66", "de:ad:be:ef:00:01", "2000::8000:1234:c0a8:6501",	"2000::8000:1234:c0a8:6502",	2},	// 192.168.101.1,2
-		{DOMAIN_FP, IPPROTO_IPIP,			"11:22:33:44:55:66", "de:ad:be:ef:00:01", "2000::1:2:c0a8:6601",		"2000::1:2:c0a8:6602",			2},	// 192.168.102.1,2
-		{DOMAIN_PR, IPPROTO_IPIP,			"11:22:33:44:55:66", "de:ad:be:ef:00:01", "2000::1:2:c0a8:6601",		"2000::1:2:c0a8:6602",			2},	// 192.168.102.1,2
-		{DOMAIN_NONE, 0, NULL, NULL, NULL, NULL, 0}
-	};
-	// *INDENT-ON*
-
-	for (int i = 0; pack[i].domain != DOMAIN_NONE; i ++) {
-		memset(recv_buffer, 0, sizeof(recv_buffer));	
-
-		p_ether = (struct ethhdr *) recv_buffer;
-		p_ip6 = (struct ip6_hdr *) (recv_buffer + sizeof(struct ethhdr));
-	
-		memset(recv_buffer, 0, sizeof(recv_buffer));
-		ether_aton_r(pack[i].hwaddrdes, (struct ether_addr *) p_ether->h_dest);
-		ether_aton_r(pack[i].hwaddrsrc, (struct ether_addr *) p_ether->h_source);
-		p_ether->h_proto = htons(ETH_P_IPV6);
-		p_ip6->ip6_vfc = 6;
-		p_ip6->ip6_nxt = pack[i].next;
-		inet_pton(AF_INET6, pack[i].ipsrc, &p_ip6->ip6_src);	// source IPv6
-		inet_pton(AF_INET6, pack[i].ipdst, &p_ip6->ip6_dst);	// destination IPv6
-		p_ip6->ip6_hlim = pack[i].hoplimit;						// Hop limit
-		recv_len = sizeof(struct ethhdr) + sizeof(struct ip6_hdr);
-
-		printf("*****************\n");
-		printf("before %2d 変換前 DOMAIN:%s\n", i, get_domain_name(pack[i].domain));
-		mx6e_print_packet(recv_buffer);
-		if (DOMAIN_FP == pack[i].domain) {
-			tunnel_forward_fp2pr_packet(handler, recv_buffer, recv_len);
-		} else if (DOMAIN_PR == pack[i].domain) {
-			tunnel_forward_pr2fp_packet(handler, recv_buffer, recv_len);
-		} else {
-			printf("domain ivalid\n");
+	int                             tail = (CONFIG_TYPE_M46E == type) ? 32 : 48;
+	const ct_ref_entry_t           *e = &ref[ct_rand() % num];
+	const ct_ref_entry_t           *o = &ref[ct_rand() % num];
+	int                             mode = ct_rand() % 4;
+
+	for (int i = 0; i < 4; i++) {
+		addr->s6_addr32[i] = (uint32_t) ct_rand();
+	}
+	// PlaneID部
+	for (int b = e->src_prefix_len; b < 128 - tail; b++) {
+		ct_set_bit(addr, b, ct_bit(&e->src_pid, b + tail));
+	}
+	// IPv4/MAC部(mode 3は別のエントリの値を使う)
+	if (3 == mode) {
+		e = o;
+	}
+	if (CONFIG_TYPE_M46E == type) {
+		for (int b = 0; b < e->v4cidr; b++) {
+			ct_set_bit(addr, 96 + b, ct_bit4(&e->v4addr, b));
+		}
+	} else {
+		for (int b = 0; b < 48; b++) {
+			ct_set_bit(addr, 80 + b, ct_bit_hw(&e->hwaddr, b));
 		}
-			
-		printf("*****************\n");
-		printf("after %2d 変換後\n", i);
-		mx6e_print_packet(recv_buffer);
+	}
+	// mode 2は1bit反転
+	if (2 == mode) {
+		int                             b = ct_rand_range(e->src_prefix_len, 127);
+		ct_set_bit(addr, b, !ct_bit(addr, b));
 	}
 }
 
-// 単体
-void ct(mx6e_handler_t * handler)
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 1テーブル分の差分試験関数
+//!
+//! 乱数で生成したエントリを実際の追加処理で登録し、追加できたエントリのみを
+//! 参照用エントリとする。乱数で生成した宛先について、試験対象の検索/置換結果と
+//! 参照実装の結果をビット単位で比較する。
+//!
+//! @param [in]     opt      試験条件
+//! @param [in]     type     テーブルタイプ
+//! @param [in]     round    試験回
+//! @param [in/out] result   試験結果
+//!
+//! @retval true  正常終了(不一致の有無は result に格納)
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static bool ct_round(const ct_option_t * opt, table_type_t type, int round, ct_result_t * result)
 {
-	
-	config_init(&handler->conf);
+	int                             tail = (CONFIG_TYPE_M46E == type) ? 32 : 48;
+	mx6e_config_devices_t           devices;
+	mx6e_config_table_t             table;
+	ct_ref_entry_t                 *ref;
+	mx6e_command_t                  command;
+	int                             plen[3];
+	struct in6_addr                 pid_pool[CT_POOL_NUM];
+	struct in_addr                  v4_pool[CT_POOL_NUM];
+	struct ether_addr               hw_pool[CT_POOL_NUM];
+	int                             num = 0;
+	long                            mismatches = result->mismatches;
+	char                            buf[3][256];
+
+	memset(&devices, 0, sizeof(devices));
+	memset(&table, 0, sizeof(table));
+	table.type = type;
+	pthread_mutex_init(&table.mutex, NULL);
+
+	ref = malloc(sizeof(ct_ref_entry_t) * opt->entries);
+	if (ref == NULL) {
+		fprintf(stderr, "ct: out of memory (%d entries)\n", opt->entries);
+		return false;
+	}
+
+	// PRトンネルデバイスのプレフィクス(FPドメインで受信した場合の送信元)
+	for (int i = 0; i < 4; i++) {
+		devices.tunnel_pr.ipv6_address.s6_addr32[i] = (uint32_t) ct_rand();
+	}
+	devices.tunnel_pr.ipv6_netmask = ct_rand_range(16, 64);
 
-	// 統計情報初期化
-	mx6e_initial_statistics(&handler->stat_info);
+	// 送信元の候補(プレフィクス長は同じ値が選ばれることもある)
+	for (int i = 0; i < 3; i++) {
+		plen[i] = ct_rand_range(CONFIG_IPV6_PREFIX_MIN, 128 - tail - 1);
+	}
+	for (int i = 0; i < CT_POOL_NUM; i++) {
+		ct_rand_low_bits(ct_rand_range(1, 128 - tail - 1), &pid_pool[i]);
+		v4_pool[i].s_addr = (i > 0 && (ct_rand() & 1)) ? v4_pool[i - 1].s_addr ^ htonl(1U << (ct_rand() % 32)) : (uint32_t) ct_rand();
+		for (int n = 0; n < ETH_ALEN; n++) {
+			hw_pool[i].ether_addr_octet[n] = (uint8_t) ct_rand();
+		}
+	}
 
-	mx6e_config_table_t            *table = &handler->conf.me6e_conf_table;
+	for (int i = 0; i < opt->entries; i++) {
+		if (!ct_make_entry(type, plen, pid_pool, v4_pool, hw_pool, &ref[num], &command)) {
+			fprintf(stderr, "ct: fail to parse '%s'\n", ref[num].line);
+			free(ref);
+			return false;
+		}
+		// 重複等で追加できないエントリは参照用エントリにも含めない
+		if (m46e_pt_add_config_entry(&table, &command.req.mx6e_data.entry, &devices)) {
+			num++;
+		}
+	}
+	result->added += num;
+
+	for (int p = 0; (num > 0) && (p < opt->packets); p++) {
+		domain_t                        domain = (ct_rand() & 1) ? DOMAIN_FP : DOMAIN_PR;
+		struct in6_addr                 addr;
+		int                             found;
+		int                             expect;
+
+		ct_make_dst(type, ref, num, &addr);
+		expect = ct_ref_match(type, ref, num, domain, &addr, &found);
+		result->lookups++;
+		if (expect >= 0) {
+			result->hits++;
+		}
+
+		for (int e = 0; e < sizeof(match_engine) / sizeof(match_engine[0]); e++) {
+			struct in6_addr                 key = addr;
+			mx6e_config_entry_t            *r = match_engine[e].match(domain, &table, &key);
+
+			if ((expect >= 0) ? ((r == NULL) || !ct_same_entry(type, &ref[expect], r)) : (r != NULL)) {
+				if (result->mismatches++ < CT_REPORT_MAX) {
+					printf("mismatch: round %d %s %s lookup %s %s\n", round, (CONFIG_TYPE_M46E == type) ? "m46e" : "me6e", match_engine[e].name,
+						   get_domain_name(domain), inet_ntop(AF_INET6, &addr, buf[0], sizeof(buf[0])));
+					printf("  expect : %s\n", (expect >= 0) ? ref[expect].line : (found >= 0) ? "(none, disabled)" : "(none)");
+					if ((found >= 0) && (expect < 0)) {
+						printf("           %s\n", ref[found].line);
+					}
+					printf("  result : %s\n", ct_entry_name(type, r, buf[1], sizeof(buf[1])));
+				}
+				continue;
+			}
+			if (r == NULL) {
+				continue;
+			}
+
+			// マッチしたエントリでアドレス置換(他のヘッダフィールドが変わらないことも確認する)
+			for (int n = 0; n < sizeof(replace_engine) / sizeof(replace_engine[0]); n++) {
+				struct ip6_hdr                  in;
+				struct ip6_hdr                  out;
+				struct ip6_hdr                  want;
+
+				for (int i = 0; i < sizeof(in) / sizeof(uint32_t); i++) {
+					((uint32_t *) & in)[i] = (uint32_t) ct_rand();
+				}
+				in.ip6_dst = addr;
+				out = in;
+				want = in;
+				replace_engine[n].replace(r, &out);
+				ct_ref_replace(type, &ref[expect], &devices, &want);
+				result->rewrites++;
+
+				if (memcmp(&out, &want, sizeof(struct ip6_hdr))) {
+					if (result->mismatches++ < CT_REPORT_MAX) {
+						printf("mismatch: round %d %s %s %s\n", round, (CONFIG_TYPE_M46E == type) ? "m46e" : "me6e", replace_engine[n].name, ref[expect].line);
+						printf("  in     : src %s ", inet_ntop(AF_INET6, &in.ip6_src, buf[0], sizeof(buf[0])));
+						printf("dst %s\n", inet_ntop(AF_INET6, &in.ip6_dst, buf[0], sizeof(buf[0])));
+						printf("  expect : src %s ", inet_ntop(AF_INET6, &want.ip6_src, buf[0], sizeof(buf[0])));
+						printf("dst %s\n", inet_ntop(AF_INET6, &want.ip6_dst, buf[0], sizeof(buf[0])));
+						printf("  result : src %s ", inet_ntop(AF_INET6, &out.ip6_src, buf[0], sizeof(buf[0])));
+						printf("dst %s\n", inet_ntop(AF_INET6, &out.ip6_dst, buf[0], sizeof(buf[0])));
+						printf("  tunnel_pr %s/%d\n", inet_ntop(AF_INET6, &devices.tunnel_pr.ipv6_address, buf[2], sizeof(buf[2])), devices.tunnel_pr.ipv6_netmask);
+					}
+				}
+			}
+		}
+	}
 
-	printf("mx6e_config_table_t:%ld\n", sizeof(mx6e_config_table_t));	// 80byte
-	printf("mx6e_config_entry_t:%ld\n", sizeof(mx6e_config_entry_t));	// 204byte x 4096 = 816KB
+	if (opt->verbose) {
+		printf("round %d %s: entries %d/%d, prefix_len %d,%d,%d, mismatches %ld\n", round, (CONFIG_TYPE_M46E == type) ? "m46e" : "me6e",
+			   num, opt->entries, plen[0], plen[1], plen[2], result->mismatches - mismatches);
+	}
 
+	m46e_pt_release_config_table(&table);
+	pthread_mutex_destroy(&table.mutex);
+	free(ref);
 
-	snprintf(handler->conf.devices.tunnel_pr.name, sizeof(handler->conf.devices.tunnel_pr.name), "tunnelpr");
-	snprintf(handler->conf.devices.tunnel_fp.name, sizeof(handler->conf.devices.tunnel_fp.name), "tunnelfp");
-	inet_pton(AF_INET6, "abcd:ef01:dead:beef:dead:beef::", &handler->conf.devices.tunnel_pr.ipv6_address);
-	inet_pton(AF_INET6, "face:feed:face:feed:face:feed::", &handler->conf.devices.tunnel_fp.ipv6_address);
+	return true;
+}
 
-	inet_pton(AF_INET6, "f00d::", &handler->conf.devices.fp.ipv6_address);
-	handler->conf.devices.fp.ipv6_netmask = 16;
+///////////////////////////////////////////////////////////////////////////////
+//! @brief テーブルタイプ指定解析関数
+//!
+//! @param [in]  arg    テーブルタイプ(m46e|me6e|all)
+//! @param [out] opt    試験条件
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static bool parse_type(const char *arg, ct_option_t * opt)
+{
+	opt->type[CONFIG_TYPE_M46E] = !strcmp(arg, "m46e") || !strcmp(arg, "all");
+	opt->type[CONFIG_TYPE_ME6E] = !strcmp(arg, "me6e") || !strcmp(arg, "all");
 
-	inet_pton(AF_INET6, "f005::", &handler->conf.devices.pr.ipv6_address);
-	handler->conf.devices.pr.ipv6_netmask = 16;
+	return opt->type[CONFIG_TYPE_M46E] || opt->type[CONFIG_TYPE_ME6E];
+}
 
-	// エントリ追加
-	CT_m46e_pt_add_config_entry(handler);
-	// PID有効ビット長計算
-	CT_get_pid_bit_width();
-	// 変換
-	CT_tunnel_forward_xx2xx_packet(handler);
+////////////////////////////////////////////////////////////////////////////////
+// メイン関数
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+	ct_option_t                     opt;
+	ct_result_t                     result;
+	mx6e_route_worker_t             route;
+	int                             option_index = 0;
+
+	memset(&opt, 0, sizeof(opt));
+	memset(&result, 0, sizeof(result));
+	opt.seed = CT_DEFAULT_SEED;
+	opt.rounds = CT_DEFAULT_ROUNDS;
+	opt.entries = CT_DEFAULT_ENTRIES;
+	opt.packets = CT_DEFAULT_PACKETS;
+	parse_type("all", &opt);
+
+	while (true) {
+		int                             c = getopt_long(argc, argv, "s:r:n:p:t:vh", options, &option_index);
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case 's':
+			opt.seed = strtoull(optarg, NULL, 0);
+			break;
+
+		case 'r':
+			opt.rounds = strtol(optarg, NULL, 10);
+			break;
+
+		case 'n':
+			opt.entries = strtol(optarg, NULL, 10);
+			if ((opt.entries <= 0) || (opt.entries > CT_ENTRY_MAX)) {
+				fprintf(stderr, "invalid entries : %s (1 - %d)\n", optarg, CT_ENTRY_MAX);
+				exit(EINVAL);
+			}
+			break;
+
+		case 'p':
+			opt.packets = strtol(optarg, NULL, 10);
+			break;
+
+		case 't':
+			if (!parse_type(optarg, &opt)) {
+				usage();
+				exit(EINVAL);
+			}
+			break;
+
+		case 'v':
+			opt.verbose = true;
+			break;
+
+		case 'h':
+			usage();
+			exit(EXIT_SUCCESS);
+
+		default:
+			usage();
+			exit(EINVAL);
+		}
+	}
+	if ((opt.rounds <= 0) || (opt.packets <= 0)) {
+		usage();
+		exit(EINVAL);
+	}
 
-	// 統計情報表示
-	mx6e_printf_statistics_info_normal(&handler->stat_info, -1);
+	mx6e_initial_log(NULL, false);
+	rand_state ^= opt.seed * 0x9e3779b97f4a7c15ULL;
+	if (rand_state == 0) {
+		rand_state = 1;
+	}
 
-#if 0	
-	mx6e_config_entry_t             entry = { 0 };
-	mx6e_config_entry_t             entry1;
-	mx6e_config_entry_t            *r;
-	// 同じキーの検索
-	r = mx6e_search_config_table(table, &entry, &handler->conf.devices);
-	m46e_pt_config_entry_dump(r);
+	// 経路はカーネルに設定しない
+	mx6e_route_init(&route, false);
+	route.offline = true;
+
+	for (int round = 0; round < opt.rounds; round++) {
+		for (table_type_t type = CONFIG_TYPE_M46E; type <= CONFIG_TYPE_ME6E; type++) {
+			if (!opt.type[type]) {
+				continue;
+			}
+			if (!ct_round(&opt, type, round, &result)) {
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
 
-	// 違うキーの検索
-	entry1 = entry;
-	snprintf(entry1.src.plane_id, sizeof(entry1.src.plane_id), "%s", "2:1");
-	inet_pton(AF_INET, "10.1.0.1", &entry1.src.in.m46e.v4addr);
-	r = mx6e_search_config_table(table, &entry1, &handler->conf.devices);
-	m46e_pt_config_entry_dump(r);
-#endif
+	printf("ct: seed %llu, rounds %d, entries %ld, lookups %ld (hit %ld), rewrites %ld, mismatches %ld\n",
+		   (unsigned long long) opt.seed, opt.rounds, result.added, result.lookups, result.hits, result.rewrites, result.mismatches);
 
-	exit(0);
+	return (result.mismatches == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
-#endif
@@ -0,0 +1,376 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_drop.c                                                */
+/* 機能概要   : 破棄パケット採取 ソースファイル                               */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <stdint.h>
+
+#include "mx6eapp_drop.h"
+#include "mx6eapp_log.h"
+#include "mx6eapp_util.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! pcapng ブロックタイプ
+#define PCAPNG_BLOCK_SHB        0x0A0D0D0A
+#define PCAPNG_BLOCK_IDB        0x00000001
+#define PCAPNG_BLOCK_EPB        0x00000006
+//! pcapng バイトオーダマジック
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+//! pcapng オプションコード
+#define PCAPNG_OPT_ENDOFOPT     0
+#define PCAPNG_OPT_COMMENT      1
+#define PCAPNG_OPT_IF_NAME      2
+//! リンクタイプ(Ethernet)
+#define PCAPNG_LINKTYPE_ETHERNET 1
+//! 1ブロックの最大長
+#define PCAPNG_BLOCK_MAX        512
+//! 4byte境界への切り上げ
+#define PCAPNG_PAD4(len)        (((len) + 3) & ~3)
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! 出力用に読み出したスロット
+typedef struct {
+	uint32_t                        ifid;			///< インタフェースID
+	mx6e_drop_slot_t                slot;			///< スロットの写し
+} drop_record_t;
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 破棄パケット採取リング初期化関数
+//!
+//! @param [out] ring 破棄パケット採取リング
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+bool mx6e_drop_init(mx6e_drop_ring_t * ring)
+{
+	ring->head = 0;
+	ring->slot = (mx6e_drop_slot_t *) calloc(DROP_RING_SLOT_NUM, sizeof(mx6e_drop_slot_t));
+	if (ring->slot == NULL) {
+		mx6e_logging(LOG_ERR, "drop capture ring allocation failed\n");
+		return false;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 破棄パケット採取リング解放関数
+//!
+//! @param [in] ring 破棄パケット採取リング
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_drop_destruct(mx6e_drop_ring_t * ring)
+{
+	free(ring->slot);
+	ring->slot = NULL;
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 破棄パケット採取関数
+//!
+//! 破棄したパケットの先頭DROP_CAPTURE_SNAPLENバイトを破棄理由、時刻と共に
+//! リングへ格納する。リングが一杯の場合は最も古いスロットを上書きする。
+//! 書き込みは転送スレッドのみが行うためロックは取らず、スロット毎の
+//! シーケンス番号で読み出し側に書き込み中であることを通知する。
+//!
+//! @param [in,out] ring   破棄パケット採取リング
+//! @param [in]     reason 破棄理由
+//! @param [in]     buf    パケットデータ
+//! @param [in]     len    パケット長
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_drop_capture(mx6e_drop_ring_t * ring, mx6e_drop_reason_t reason, const char *buf, ssize_t len)
+{
+	mx6e_drop_slot_t               *slot;
+	uint32_t                        seq;
+
+	if (ring->slot == NULL) {
+		return;
+	}
+
+	slot = &ring->slot[ring->head % DROP_RING_SLOT_NUM];
+	ring->head++;
+
+	// 書き込み開始(奇数)
+	seq = slot->seq;
+	__atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	clock_gettime(CLOCK_REALTIME, &slot->ts);
+	slot->reason = reason;
+	slot->len = len;
+	slot->caplen = min(len, DROP_CAPTURE_SNAPLEN);
+	memcpy(slot->data, buf, slot->caplen);
+
+	// 書き込み完了(偶数)
+	__atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 破棄理由の文字列を返す
+//!
+//! @param [in] reason 破棄理由
+//!
+//! @return 文字列
+///////////////////////////////////////////////////////////////////////////////
+const char                     *mx6e_drop_reason_name(mx6e_drop_reason_t reason)
+{
+	// *INDENT-OFF*
+	static const char *names[] = {
+		[MX6E_DROP_BROADCAST]	= "broadcast",
+		[MX6E_DROP_OTHER_PROTO]	= "not IPv6 protocol",
+		[MX6E_DROP_HOPLIMIT]	= "hop limit over",
+		[MX6E_DROP_NXTHDR]		= "invalid next header",
+		[MX6E_DROP_NO_ENTRY]	= "no matching entry",
+		[MX6E_DROP_SEND_ERR]	= "send error",
+	};
+	// *INDENT-ON*
+
+	if (reason >= MX6E_DROP_REASON_MAX) {
+		return "unknown";
+	}
+	return names[reason];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief リング読み出し関数
+//!
+//! 書き込みが完了しているスロットのみを出力用配列へ写す。
+//! 読み出し中に上書きされたスロットは読み捨てる。
+//!
+//! @param [in]  ring   破棄パケット採取リング
+//! @param [in]  ifid   インタフェースID
+//! @param [out] record 出力用配列
+//!
+//! @return 写したスロット数
+///////////////////////////////////////////////////////////////////////////////
+static int drop_ring_read(mx6e_drop_ring_t * ring, uint32_t ifid, drop_record_t * record)
+{
+	int                             num = 0;
+
+	if (ring->slot == NULL) {
+		return 0;
+	}
+
+	for (int i = 0; i < DROP_RING_SLOT_NUM; i++) {
+		mx6e_drop_slot_t               *slot = &ring->slot[i];
+		uint32_t                        seq1;
+		uint32_t                        seq2;
+
+		seq1 = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		if ((seq1 == 0) || (seq1 & 1)) {
+			// 未使用または書き込み中
+			continue;
+		}
+		record[num].slot = *slot;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		seq2 = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+		if (seq1 != seq2) {
+			continue;
+		}
+		record[num].ifid = ifid;
+		num++;
+	}
+
+	return num;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 時刻比較関数(qsort用)
+///////////////////////////////////////////////////////////////////////////////
+static int drop_record_compare(const void *a, const void *b)
+{
+	const struct timespec          *ta = &((const drop_record_t *) a)->slot.ts;
+	const struct timespec          *tb = &((const drop_record_t *) b)->slot.ts;
+
+	if (ta->tv_sec != tb->tv_sec) {
+		return (ta->tv_sec < tb->tv_sec) ? -1 : 1;
+	}
+	if (ta->tv_nsec != tb->tv_nsec) {
+		return (ta->tv_nsec < tb->tv_nsec) ? -1 : 1;
+	}
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief pcapngオプション書き込み関数
+//!
+//! @param [out] p     書き込み先
+//! @param [in]  code  オプションコード
+//! @param [in]  value オプション値
+//! @param [in]  len   オプション長
+//!
+//! @return 書き込んだバイト数
+///////////////////////////////////////////////////////////////////////////////
+static size_t pcapng_put_option(unsigned char *p, uint16_t code, const void *value, uint16_t len)
+{
+	memcpy(p, &code, sizeof(code));
+	memcpy(p + 2, &len, sizeof(len));
+	memset(p + 4, 0, PCAPNG_PAD4(len));
+	if (len) {
+		memcpy(p + 4, value, len);
+	}
+
+	return 4 + PCAPNG_PAD4(len);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief pcapngブロック書き込み関数
+//!
+//! ブロック長をヘッダと末尾に設定し、1回のwriteで出力する。
+//!
+//! @param [in] fd    出力先のディスクリプタ
+//! @param [in] block ブロック(先頭8byteと末尾4byteの領域を含む)
+//! @param [in] type  ブロックタイプ
+//! @param [in] len   ブロック長
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static bool pcapng_write_block(int fd, unsigned char *block, uint32_t type, uint32_t len)
+{
+	memcpy(block, &type, sizeof(type));
+	memcpy(block + 4, &len, sizeof(len));
+	memcpy(block + len - 4, &len, sizeof(len));
+
+	if (write(fd, block, len) != len) {
+		mx6e_logging(LOG_ERR, "fail to write pcapng block : %s\n", strerror(errno));
+		return false;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 破棄パケットpcapng出力関数
+//!
+//! FP/PRそれぞれのリングに残っている破棄パケットを時刻順に並べ、
+//! pcapng形式で出力する。破棄理由はパケットコメントに格納する。
+//!
+//! @param [in] fp_ring FP側破棄パケット採取リング
+//! @param [in] fp_name FP側インタフェース名
+//! @param [in] pr_ring PR側破棄パケット採取リング
+//! @param [in] pr_name PR側インタフェース名
+//! @param [in] fd      出力先のディスクリプタ
+//!
+//! @retval 0以上 出力したパケット数
+//! @retval -1    異常終了
+///////////////////////////////////////////////////////////////////////////////
+int mx6e_drop_dump_pcapng(mx6e_drop_ring_t * fp_ring, const char *fp_name, mx6e_drop_ring_t * pr_ring, const char *pr_name, int fd)
+{
+	unsigned char                   block[PCAPNG_BLOCK_MAX];
+	drop_record_t                  *record;
+	int                             num;
+	size_t                          len;
+	uint32_t                        u32;
+	uint16_t                        u16;
+	int64_t                         i64;
+	const char                     *names[] = { fp_name, pr_name };
+
+	record = (drop_record_t *) malloc(sizeof(drop_record_t) * DROP_RING_SLOT_NUM * 2);
+	if (record == NULL) {
+		mx6e_logging(LOG_ERR, "drop dump buffer allocation failed\n");
+		return -1;
+	}
+
+	num = drop_ring_read(fp_ring, 0, record);
+	num += drop_ring_read(pr_ring, 1, &record[num]);
+	qsort(record, num, sizeof(drop_record_t), drop_record_compare);
+
+	// Section Header Block
+	len = 8;
+	u32 = PCAPNG_BYTE_ORDER_MAGIC;
+	memcpy(&block[len], &u32, 4);
+	len += 4;
+	u16 = 1;										// major version
+	memcpy(&block[len], &u16, 2);
+	len += 2;
+	u16 = 0;										// minor version
+	memcpy(&block[len], &u16, 2);
+	len += 2;
+	i64 = -1;										// section length 未指定
+	memcpy(&block[len], &i64, 8);
+	len += 8;
+	len += 4;
+	if (!pcapng_write_block(fd, block, PCAPNG_BLOCK_SHB, len)) {
+		free(record);
+		return -1;
+	}
+
+	// Interface Description Block (0:FP, 1:PR)
+	for (int i = 0; i < 2; i++) {
+		len = 8;
+		u16 = PCAPNG_LINKTYPE_ETHERNET;
+		memcpy(&block[len], &u16, 2);
+		len += 2;
+		u16 = 0;
+		memcpy(&block[len], &u16, 2);
+		len += 2;
+		u32 = DROP_CAPTURE_SNAPLEN;
+		memcpy(&block[len], &u32, 4);
+		len += 4;
+		len += pcapng_put_option(&block[len], PCAPNG_OPT_IF_NAME, names[i], strnlen(names[i], 64));
+		len += pcapng_put_option(&block[len], PCAPNG_OPT_ENDOFOPT, NULL, 0);
+		len += 4;
+		if (!pcapng_write_block(fd, block, PCAPNG_BLOCK_IDB, len)) {
+			free(record);
+			return -1;
+		}
+	}
+
+	// Enhanced Packet Block
+	for (int i = 0; i < num; i++) {
+		mx6e_drop_slot_t               *slot = &record[i].slot;
+		uint64_t                        usec = (uint64_t) slot->ts.tv_sec * 1000000 + slot->ts.tv_nsec / 1000;
+		const char                     *reason = mx6e_drop_reason_name(slot->reason);
+
+		len = 8;
+		memcpy(&block[len], &record[i].ifid, 4);
+		len += 4;
+		u32 = (uint32_t) (usec >> 32);
+		memcpy(&block[len], &u32, 4);
+		len += 4;
+		u32 = (uint32_t) usec;
+		memcpy(&block[len], &u32, 4);
+		len += 4;
+		u32 = slot->caplen;
+		memcpy(&block[len], &u32, 4);
+		len += 4;
+		memcpy(&block[len], &slot->len, 4);
+		len += 4;
+		memset(&block[len], 0, PCAPNG_PAD4(slot->caplen));
+		memcpy(&block[len], slot->data, slot->caplen);
+		len += PCAPNG_PAD4(slot->caplen);
+		len += pcapng_put_option(&block[len], PCAPNG_OPT_COMMENT, reason, strlen(reason));
+		len += pcapng_put_option(&block[len], PCAPNG_OPT_ENDOFOPT, NULL, 0);
+		len += 4;
+		if (!pcapng_write_block(fd, block, PCAPNG_BLOCK_EPB, len)) {
+			free(record);
+			return -1;
+		}
+	}
+
+	free(record);
+
+	return num;
+}
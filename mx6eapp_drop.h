@@ -0,0 +1,63 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_drop.h                                                */
+/* 機能概要   : 破棄パケット採取 ヘッダファイル                               */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+#ifndef __MX6EAPP_DROP_H__
+#   define __MX6EAPP_DROP_H__
+
+#   include <stdbool.h>
+#   include <stdint.h>
+#   include <time.h>
+#   include <sys/types.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! 1スレッドあたりの採取スロット数
+#   define DROP_RING_SLOT_NUM      1024
+//! 1パケットあたりの採取バイト数(先頭から)
+#   define DROP_CAPTURE_SNAPLEN    128
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! 破棄理由
+typedef enum {
+	MX6E_DROP_BROADCAST,							///< ブロードキャスト
+	MX6E_DROP_OTHER_PROTO,							///< IPv6以外のプロトコル
+	MX6E_DROP_HOPLIMIT,								///< HOPLIMIT超過
+	MX6E_DROP_NXTHDR,								///< NextHeader不正
+	MX6E_DROP_NO_ENTRY,								///< 該当エントリなし
+	MX6E_DROP_SEND_ERR,								///< 送信失敗
+	MX6E_DROP_REASON_MAX
+} mx6e_drop_reason_t;
+
+//! 採取スロット
+typedef struct {
+	uint32_t                        seq;			///< 更新シーケンス(奇数:書き込み中)
+	uint16_t                        reason;			///< 破棄理由
+	uint16_t                        caplen;			///< 採取長
+	uint32_t                        len;			///< パケット長
+	struct timespec                 ts;				///< 破棄時刻
+	unsigned char                   data[DROP_CAPTURE_SNAPLEN];	///< パケット先頭
+} mx6e_drop_slot_t;
+
+//! 破棄パケット採取リング(書き込みは転送スレッドのみ)
+typedef struct {
+	mx6e_drop_slot_t               *slot;			///< スロット領域
+	uint64_t                        head;			///< 次回書き込み位置(累積)
+} mx6e_drop_ring_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部関数プロトタイプ宣言
+////////////////////////////////////////////////////////////////////////////////
+bool                            mx6e_drop_init(mx6e_drop_ring_t * ring);
+void                            mx6e_drop_destruct(mx6e_drop_ring_t * ring);
+void                            mx6e_drop_capture(mx6e_drop_ring_t * ring, mx6e_drop_reason_t reason, const char *buf, ssize_t len);
+const char                     *mx6e_drop_reason_name(mx6e_drop_reason_t reason);
+int                             mx6e_drop_dump_pcapng(mx6e_drop_ring_t * fp_ring, const char *fp_name, mx6e_drop_ring_t * pr_ring, const char *pr_name, int fd);
+
+#endif												// __MX6EAPP_DROP_H__
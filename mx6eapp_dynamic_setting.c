@@ -10,6 +10,7 @@
 #include <string.h>
 #include <errno.h>
 #include <stdbool.h>
+#include <sys/socket.h>
 #include <net/if.h>
 #include <arpa/inet.h>
 #include <netinet/ether.h>
@@ -19,8 +20,10 @@
 #include "mx6eapp_network.h"
 #include "mx6eapp_config.h"
 #include "mx6eapp_log.h"
+#include "mx6eapp_miss.h"
 #include "mx6eapp_dynamic_setting.h"
 #include "mx6eapp_pt.h"
+#include "mx6eapp_util.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 ////! @brief デバッグログ設定コマンド関数(PR側)
@@ -53,3 +56,363 @@ bool mx6eapp_set_debug_log(mx6e_handler_t * handler, mx6e_command_t * command, i
 
 	return true;
 }
+
+///////////////////////////////////////////////////////////////////////////////
+////! @brief 設定ファイル再読み込み関数(PR側)
+////!
+////! 設定ファイルを作業用の設定情報に読み込み、現在の設定との差分のうち
+////! 運用中に反映可能な項目(debug_log, startup_script, miss_prefix_len,
+////! snapshot_file, snapshot_interval)のみを反映する。再起動が必要な項目は反映せずに通知する。
+////! 読み込みに失敗した場合は何も変更しない。転送処理は停止しない。
+////!
+////! @param [in]     handler         アプリケーションハンドラー
+////! @param [in]     fd              出力先のディスクリプタ(-1の場合はログ出力のみ)
+////!
+////! @return  true       正常
+////! @return  false      異常
+/////////////////////////////////////////////////////////////////////////////////
+bool mx6eapp_reload_config(mx6e_handler_t * handler, int fd)
+{
+	// 引数チェック
+	if (handler == NULL) {
+		mx6e_logging(LOG_ERR, "Parameter Check NG(%s).", __func__);
+		return false;
+	}
+	// 内部変数
+	mx6e_config_general_t          *general = &handler->conf.general;
+	mx6e_config_t                  *next;
+	mx6e_config_diff_t             *diff;
+	int                             num;
+	int                             restart = 0;
+
+	next = malloc(sizeof(mx6e_config_t));
+	diff = malloc(sizeof(mx6e_config_diff_t) * CONFIG_DIFF_MAX);
+	if ((next == NULL) || (diff == NULL)) {
+		mx6e_logging(LOG_ERR, "reload : fail to allocate memory.");
+		free(next);
+		free(diff);
+		return false;
+	}
+
+	// 作業用の設定情報に読み込み(現在の設定には触れない)
+	if (mx6e_config_load(next, handler->conf.filename) == NULL) {
+		mx6e_logging(LOG_ERR, "reload : fail to load config file %s. nothing changed.", handler->conf.filename);
+		if (fd >= 0) {
+			dprintf(fd, "reload : fail to load config file %s. nothing changed.\n", handler->conf.filename);
+		}
+		free(next);
+		free(diff);
+		return false;
+	}
+
+	num = mx6e_config_diff(&handler->conf, next, diff, CONFIG_DIFF_MAX);
+	for (int i = 0; i < num; i++) {
+		if (!diff[i].reloadable) {
+			restart++;
+		}
+		mx6e_logging(diff[i].reloadable ? LOG_INFO : LOG_WARNING, "reload : %s : %s -> %s (%s)",
+					 diff[i].key, diff[i].before, diff[i].after, diff[i].reloadable ? "applied" : "restart required");
+		if (fd >= 0) {
+			dprintf(fd, "  %-16s : %s -> %s (%s)\n",
+					diff[i].key, diff[i].before, diff[i].after, diff[i].reloadable ? "applied" : "restart required");
+		}
+	}
+
+	// 運用中に反映可能な項目を反映
+	if (general->miss_prefix_len != next->general.miss_prefix_len) {
+		general->miss_prefix_len = next->general.miss_prefix_len;
+		mx6e_miss_set_prefix_len(&handler->miss_fp, general->miss_prefix_len);
+		mx6e_miss_set_prefix_len(&handler->miss_pr, general->miss_prefix_len);
+	}
+	// スタートアップスクリプトは次回起動時に使用する
+	snprintf(general->startup_script, sizeof(general->startup_script), "%s", next->general.startup_script);
+	// スナップショットの保存先/周期は次回保存時から使用する
+	snprintf(general->snapshot_file, sizeof(general->snapshot_file), "%s", next->general.snapshot_file);
+	general->snapshot_interval = next->general.snapshot_interval;
+	if (general->debug_log != next->general.debug_log) {
+		general->debug_log = next->general.debug_log;
+		mx6e_initial_log(general->process_name, general->debug_log);
+	}
+
+	mx6e_logging(LOG_INFO, "reload : %d applied, %d need restart.", num - restart, restart);
+	if (fd >= 0) {
+		if (num == 0) {
+			dprintf(fd, "reload : no changes\n");
+		} else {
+			dprintf(fd, "reload : %d applied, %d need restart\n", num - restart, restart);
+		}
+	}
+
+	mx6e_config_destruct(next);
+	free(next);
+	free(diff);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+////! @brief 一括読み込みレコード適用関数
+////!
+////! レコードのコマンドコードに応じて M46E/ME6E テーブルへ反映する。
+////!
+////! @param [in]     handler         アプリケーションハンドラー
+////! @param [in]     record          一括読み込みレコード
+////!
+////! @return  true       正常
+////! @return  false      異常
+/////////////////////////////////////////////////////////////////////////////////
+bool mx6eapp_load_batch_apply(mx6e_handler_t * handler, mx6e_load_batch_record_t * record)
+{
+	mx6e_config_table_t            *table;
+	mx6e_config_devices_t          *devices = &handler->conf.devices;
+
+	switch (record->code) {
+	case MX6E_ADD_M46E_ENTRY:
+	case MX6E_DEL_M46E_ENTRY:
+	case MX6E_ENABLE_M46E_ENTRY:
+	case MX6E_DISABLE_M46E_ENTRY:
+		table = &handler->conf.m46e_conf_table;
+		break;
+
+	case MX6E_ADD_ME6E_ENTRY:
+	case MX6E_DEL_ME6E_ENTRY:
+	case MX6E_ENABLE_ME6E_ENTRY:
+	case MX6E_DISABLE_ME6E_ENTRY:
+		table = &handler->conf.me6e_conf_table;
+		break;
+
+	default:
+		return false;
+	}
+
+	switch (record->code) {
+	case MX6E_ADD_M46E_ENTRY:
+	case MX6E_ADD_ME6E_ENTRY:
+		return m46e_pt_add_config_entry(table, &record->entry, devices);
+
+	case MX6E_DEL_M46E_ENTRY:
+	case MX6E_DEL_ME6E_ENTRY:
+		return m46e_pt_del_config_entry(table, &record->entry, devices);
+
+	default:
+		// 活性化/非活性化(entry.enable で区別)
+		return m46e_pt_enable_config_entry(table, &record->entry, devices);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+////! @brief ENTRY 同期反映関数(PR側)
+////!
+////! 受信した全レコードをあるべきテーブル内容として差分を反映する。
+////!
+////! @param [in]     handler         アプリケーションハンドラー
+////! @param [in,out] batch           一括読み込み/同期状態
+////!
+////! @return  true       正常
+////! @return  false      異常
+/////////////////////////////////////////////////////////////////////////////////
+static bool load_batch_sync(mx6e_handler_t * handler, mx6e_load_batch_t * batch)
+{
+	if (!m46e_pt_sync_config_table(batch->table, batch->record, batch->num, &handler->conf.devices, &batch->sync, batch->failed_line)) {
+		return false;
+	}
+	batch->failed = batch->sync.failed;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+////! @brief ENTRY 一括読み込み/同期開始関数(PR側)
+////!
+////! 一括読み込み/同期要求データを受けて、後続レコードの受信準備をおこなう。
+////! 一括読み込みは受信した順にレコードを反映するため受信バッファは1メッセージ分、
+////! 同期は全レコードが揃ってから差分を反映するため全レコード分を確保する。
+////! 同期でレコード数が0の場合は、この時点で反映する(全エントリ削除)。
+////!
+////! @param [in]     handler         アプリケーションハンドラー
+////! @param [out]    batch           一括読み込み/同期状態
+////! @param [in]     command         コマンド構造体
+////!
+////! @return  true       正常
+////! @return  false      異常
+/////////////////////////////////////////////////////////////////////////////////
+bool mx6eapp_load_batch_init(mx6e_handler_t * handler, mx6e_load_batch_t * batch, mx6e_command_t * command)
+{
+	int                             record_num = LOAD_BATCH_RECORD_NUM;
+	int                             failed_line_max;
+
+	// 引数チェック
+	if ((handler == NULL) || (batch == NULL) || (command == NULL)) {
+		mx6e_logging(LOG_ERR, "Parameter Check NG(%s).", __func__);
+		return false;
+	}
+
+	memset(batch, 0, sizeof(mx6e_load_batch_t));
+	batch->code = command->code;
+	batch->num = max(command->req.batch.num, 0);
+
+	switch (batch->code) {
+	case MX6E_SYNC_M46E_ENTRY:
+		batch->table = &handler->conf.m46e_conf_table;
+		break;
+	case MX6E_SYNC_ME6E_ENTRY:
+		batch->table = &handler->conf.me6e_conf_table;
+		break;
+	default:
+		break;
+	}
+	if (batch->table != NULL) {
+		if (batch->num > PT_MAX_ENTRY_NUM) {
+			mx6e_logging(LOG_ERR, "too many sync records(%d)\n", batch->num);
+			return false;
+		}
+		record_num = max(batch->num, 1);
+		failed_line_max = max(batch->num, 1);
+	} else {
+		// レコード総数は要求元の申告値なので、失敗行の記録領域は上限で抑える
+		failed_line_max = max(min(batch->num, LOAD_BATCH_FAILED_LINE_MAX), 1);
+	}
+
+	if ((batch->num == 0) && (batch->table == NULL)) {
+		return true;
+	}
+
+	batch->record = malloc(sizeof(mx6e_load_batch_record_t) * record_num);
+	batch->failed_line = malloc(sizeof(int) * failed_line_max);
+	batch->failed_line_max = failed_line_max;
+	if ((batch->record == NULL) || (batch->failed_line == NULL)) {
+		mx6e_logging(LOG_ERR, "batch buffer allocation failed\n");
+		mx6eapp_load_batch_destruct(batch);
+		return false;
+	}
+
+	if ((batch->num == 0) && !load_batch_sync(handler, batch)) {
+		mx6eapp_load_batch_destruct(batch);
+		return false;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+////! @brief ENTRY 一括読み込み/同期レコード受信関数(PR側)
+////!
+////! ソケットからレコードを1メッセージ分受信する。
+////! 一括読み込みは受信した順にテーブルへ反映し、失敗した行は記録して反映を続行する。
+////! 同期は全レコードを受信した時点で差分をまとめて反映する。
+////! ノンブロッキングソケットで受信データが無い場合は何もしない。
+////!
+////! @param [in]     handler         アプリケーションハンドラー
+////! @param [in,out] batch           一括読み込み/同期状態
+////! @param [in]     fd              レコード受信元のディスクリプタ
+////!
+////! @return  true       正常
+////! @return  false      異常(受信失敗、切断)
+/////////////////////////////////////////////////////////////////////////////////
+bool mx6eapp_load_batch_recv(mx6e_handler_t * handler, mx6e_load_batch_t * batch, int fd)
+{
+	ssize_t                         len;
+	mx6e_load_batch_record_t       *buf;
+	int                             buf_num;
+
+	// 引数チェック
+	if ((handler == NULL) || (batch == NULL)) {
+		mx6e_logging(LOG_ERR, "Parameter Check NG(%s).", __func__);
+		return false;
+	}
+
+	if (batch->table != NULL) {
+		buf = &batch->record[batch->received];
+		buf_num = min(batch->num - batch->received, LOAD_BATCH_RECORD_NUM);
+	} else {
+		buf = batch->record;
+		buf_num = LOAD_BATCH_RECORD_NUM;
+	}
+
+	len = recv(fd, buf, sizeof(mx6e_load_batch_record_t) * buf_num, 0);
+	if (len < 0) {
+		if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) {
+			return true;
+		}
+		mx6e_logging(LOG_ERR, "fail to receive batch record : %s\n", strerror(errno));
+		return false;
+	}
+	if (len == 0) {
+		mx6e_logging(LOG_ERR, "fail to receive batch record : connection closed\n");
+		return false;
+	}
+	if ((len % sizeof(mx6e_load_batch_record_t)) != 0) {
+		mx6e_logging(LOG_ERR, "unexpected batch record size(%zd)\n", len);
+		return false;
+	}
+
+	int                             cnt = len / sizeof(mx6e_load_batch_record_t);
+	if (batch->table != NULL) {
+		batch->received += cnt;
+		if (batch->received >= batch->num) {
+			return load_batch_sync(handler, batch);
+		}
+		return true;
+	}
+
+	for (int i = 0; (i < cnt) && (batch->received < batch->num); i++, batch->received++) {
+		if (!mx6eapp_load_batch_apply(handler, &buf[i])) {
+			if (batch->failed < batch->failed_line_max) {
+				batch->failed_line[batch->failed] = buf[i].line;
+			}
+			batch->failed++;
+		}
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+////! @brief ENTRY 一括読み込み/同期結果出力関数(PR側)
+////!
+////! 件数と失敗行の一覧をまとめて出力する。
+////! 一括読み込みの失敗行はLOAD_BATCH_FAILED_LINE_MAX行まで出力し、残りは件数のみ出力する。
+////! 同期の場合は反映した差分の件数と、反映後のテーブル版数も出力する。
+////!
+////! @param [in]     batch           一括読み込み/同期状態
+////! @param [in]     fd              出力先のディスクリプタ
+////!
+////! @return  なし
+/////////////////////////////////////////////////////////////////////////////////
+void mx6eapp_load_batch_print(mx6e_load_batch_t * batch, int fd)
+{
+	if (batch->table != NULL) {
+		dprintf(fd, "sync : %d added, %d deleted, %d modified, %d enabled, %d disabled, %d unchanged, %d failed\n",
+				batch->sync.added, batch->sync.deleted, batch->sync.modified, batch->sync.enabled, batch->sync.disabled, batch->sync.unchanged, batch->sync.failed);
+	} else {
+		dprintf(fd, "load : %d lines applied, %d lines failed\n", batch->received - batch->failed, batch->failed);
+	}
+	for (int i = 0; i < min(batch->failed, batch->failed_line_max); i++) {
+		dprintf(fd, "Line%d : command failed\n", batch->failed_line[i]);
+	}
+	if (batch->failed > batch->failed_line_max) {
+		dprintf(fd, "... and %d more lines failed\n", batch->failed - batch->failed_line_max);
+	}
+	if (batch->table != NULL) {
+		m46e_pt_show_version(batch->table, fd);
+	}
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+////! @brief ENTRY 一括読み込み/同期終了関数(PR側)
+////!
+////! @param [in,out] batch           一括読み込み/同期状態
+////!
+////! @return  なし
+/////////////////////////////////////////////////////////////////////////////////
+void mx6eapp_load_batch_destruct(mx6e_load_batch_t * batch)
+{
+	free(batch->record);
+	free(batch->failed_line);
+	batch->record = NULL;
+	batch->failed_line = NULL;
+
+	return;
+}
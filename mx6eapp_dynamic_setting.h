@@ -11,6 +11,29 @@
 #   include <stdbool.h>
 #   include "mx6eapp.h"
 #	include "mx6eapp_command_data.h"
+#   include "mx6eapp_pt.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! 一括読み込みで行番号を記録する反映失敗行の最大数(以降は件数のみ計上)
+#   define LOAD_BATCH_FAILED_LINE_MAX 1024
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! ENTRY 一括読み込み/同期状態
+typedef struct {
+	mx6e_command_code_t             code;			///< 要求コマンドコード(MX6E_LOAD_BATCH/MX6E_SYNC_*_ENTRY)
+	int                             num;			///< レコード総数
+	int                             received;		///< 受信済みレコード数
+	int                             failed;			///< 反映失敗レコード数
+	int                            *failed_line;	///< 反映失敗した行番号
+	int                             failed_line_max;	///< 反映失敗した行番号の格納可能数
+	mx6e_load_batch_record_t       *record;			///< 受信バッファ(同期時は全レコード分)
+	mx6e_config_table_t            *table;			///< 同期対象テーブル(同期時のみ)
+	mx6e_sync_result_t              sync;			///< 同期結果(同期時のみ)
+} mx6e_load_batch_t;
 
 ////////////////////////////////////////////////////////////////////////////////
 // 外部関数プロトタイプ宣言
@@ -18,5 +41,11 @@
 extern void                     mx6eapp_set_flag_restart(bool flg);
 extern bool                     mx6eapp_get_flag_restart(void);
 extern bool                     mx6eapp_set_debug_log(mx6e_handler_t * handler, mx6e_command_t * command, int fd);
+extern bool                     mx6eapp_reload_config(mx6e_handler_t * handler, int fd);
+extern bool                     mx6eapp_load_batch_init(mx6e_handler_t * handler, mx6e_load_batch_t * batch, mx6e_command_t * command);
+extern bool                     mx6eapp_load_batch_apply(mx6e_handler_t * handler, mx6e_load_batch_record_t * record);
+extern bool                     mx6eapp_load_batch_recv(mx6e_handler_t * handler, mx6e_load_batch_t * batch, int fd);
+extern void                     mx6eapp_load_batch_print(mx6e_load_batch_t * batch, int fd);
+extern void                     mx6eapp_load_batch_destruct(mx6e_load_batch_t * batch);
 
 #endif												// __MX6EAPP_DYNAMIC_SETTING_H__
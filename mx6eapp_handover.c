@@ -0,0 +1,498 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_handover.c                                            */
+/* 機能概要   : ホットリスタート引き継ぎ ソースファイル                       */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <limits.h>
+#include <net/if.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+
+#include "mx6eapp_handover.h"
+#include "mx6eapp_log.h"
+#include "mx6eapp_pt.h"
+#include "mx6eapp_socket.h"
+#include "mx6eapp_util.h"
+#include "mx6eapp_command_data.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! 実行ファイルのリンク先(置き換えられている場合は末尾に付与される)
+#define HANDOVER_DELETED_SUFFIX  " (deleted)"
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! 引き継ぐディスクリプタの種別(この順に転送する)
+typedef enum {
+	HANDOVER_FD_TUNNEL_FP,							///< FP側トンネルデバイス
+	HANDOVER_FD_TUNNEL_PR,							///< PR側トンネルデバイス
+	HANDOVER_FD_SEND_FP,							///< FP側送信用ソケット
+	HANDOVER_FD_SEND_PR,							///< PR側送信用ソケット
+	HANDOVER_FD_MAX
+} handover_fd_kind_t;
+
+//! ディスクリプタ引き継ぎメッセージ(ディスクリプタはSCM_RIGHTSで転送する)
+typedef struct {
+	handover_fd_kind_t              kind;			///< ディスクリプタ種別
+	char                            name[IFNAMSIZ];	///< デバイス名(トンネルデバイスのみ)
+	int                             ifindex;		///< デバイスのインデックス番号(トンネルデバイスのみ)
+	struct ether_addr               hwaddr;			///< デバイスのMACアドレス(トンネルデバイスのみ)
+} handover_fd_t;
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 引き継ぎ対象参照関数
+//!
+//! ディスクリプタ種別に対応するデバイス情報とディスクリプタの格納先を返す。
+//!
+//! @param [in]  devices   デバイス設定
+//! @param [in]  kind      ディスクリプタ種別
+//! @param [out] dev       デバイス情報(送信用ソケットの場合はNULL)
+//! @param [out] fd        ディスクリプタの格納先
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void handover_fd_ref(mx6e_config_devices_t * devices, handover_fd_kind_t kind, mx6e_device_t ** dev, int **fd)
+{
+	switch (kind) {
+	case HANDOVER_FD_TUNNEL_FP:
+		*dev = &devices->tunnel_fp;
+		*fd = &devices->tunnel_fp.fd;
+		break;
+	case HANDOVER_FD_TUNNEL_PR:
+		*dev = &devices->tunnel_pr;
+		*fd = &devices->tunnel_pr.fd;
+		break;
+	case HANDOVER_FD_SEND_FP:
+		*dev = NULL;
+		*fd = &devices->send_sock_fd_fp;
+		break;
+	case HANDOVER_FD_SEND_PR:
+	default:
+		*dev = NULL;
+		*fd = &devices->send_sock_fd_pr;
+		break;
+	}
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 引き継ぎ用ソケット設定関数
+//!
+//! 引き継ぎ中は相手プロセスとの間で順に送受信するため、ソケットを
+//! ブロッキングにし、相手プロセスの異常で止まらないようにタイムアウトを設定する。
+//!
+//! @param [in] sock    引き継ぎに使用するソケット
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static bool handover_set_timeout(int sock)
+{
+	struct timeval                  tv = { HANDOVER_TIMEOUT, 0 };
+	int                             flags;
+
+	flags = fcntl(sock, F_GETFL);
+	if ((flags < 0) || (fcntl(sock, F_SETFL, flags & ~O_NONBLOCK) < 0)) {
+		mx6e_logging(LOG_ERR, "fail to set handover socket blocking : %s\n", strerror(errno));
+		return false;
+	}
+	if (setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) || setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv))) {
+		mx6e_logging(LOG_ERR, "fail to set handover socket timeout : %s\n", strerror(errno));
+		return false;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief テーブル送信関数
+//!
+//! テーブルのエントリ数を送信した後、全エントリを一括読み込みと同じ
+//! LOAD_BATCH_RECORD_NUM 個単位のレコードで送信する。
+//!
+//! @param [in] sock    引き継ぎに使用するソケット
+//! @param [in] table   送信するテーブル
+//! @param [in] code    テーブルの同期コマンドコード(MX6E_SYNC_M46E_ENTRY/MX6E_SYNC_ME6E_ENTRY)
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static bool handover_send_table(int sock, mx6e_config_table_t * table, mx6e_command_code_t code)
+{
+	mx6e_load_batch_record_t       *record = NULL;
+	int                             num;
+	int                             ret;
+
+	num = m46e_pt_snapshot_config_table(table, &record);
+	if (num < 0) {
+		return false;
+	}
+
+	ret = mx6e_socket_send(sock, code, &num, sizeof(num), -1);
+	if (ret < 0) {
+		mx6e_logging(LOG_ERR, "fail to send %s : %s\n", get_command_name(code), strerror(-ret));
+		free(record);
+		return false;
+	}
+	for (int i = 0; i < num; i += LOAD_BATCH_RECORD_NUM) {
+		int                             cnt = min(num - i, LOAD_BATCH_RECORD_NUM);
+		if (send(sock, &record[i], sizeof(mx6e_load_batch_record_t) * cnt, 0) < 0) {
+			mx6e_logging(LOG_ERR, "fail to send %s record : %s\n", get_command_name(code), strerror(errno));
+			free(record);
+			return false;
+		}
+	}
+	free(record);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief テーブル受信関数
+//!
+//! 旧プロセスのテーブル内容を受信し、自プロセスのテーブルに同期する。
+//! 経路は旧プロセスが設定済みのため、カーネルの経路は変化しない。
+//!
+//! @param [in]     sock    引き継ぎに使用するソケット
+//! @param [in,out] handler MX6Eハンドラ
+//! @param [in,out] table   同期するテーブル
+//! @param [in]     code    テーブルの同期コマンドコード(MX6E_SYNC_M46E_ENTRY/MX6E_SYNC_ME6E_ENTRY)
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static bool handover_recv_table(int sock, mx6e_handler_t * handler, mx6e_config_table_t * table, mx6e_command_code_t code)
+{
+	mx6e_command_code_t             recv_code = MX6E_COMMAND_NONE;
+	mx6e_load_batch_record_t       *record;
+	mx6e_sync_result_t              result;
+	int                            *failed_line;
+	int                             num = -1;
+	int                             received;
+	int                             ret;
+
+	ret = mx6e_socket_recv(sock, &recv_code, &num, sizeof(num), NULL);
+	if ((ret != sizeof(int) + sizeof(num)) || (recv_code != code) || (num < 0) || (num > PT_MAX_ENTRY_NUM)) {
+		mx6e_logging(LOG_ERR, "unexpected %s message(ret=%d, code=%d, num=%d)\n", get_command_name(code), ret, recv_code, num);
+		return false;
+	}
+
+	record = malloc(sizeof(mx6e_load_batch_record_t) * max(num, 1));
+	failed_line = malloc(sizeof(int) * max(num, 1));
+	if ((record == NULL) || (failed_line == NULL)) {
+		mx6e_logging(LOG_ERR, "handover buffer allocation failed\n");
+		free(record);
+		free(failed_line);
+		return false;
+	}
+
+	for (received = 0; received < num;) {
+		ssize_t                         len = recv(sock, &record[received], sizeof(mx6e_load_batch_record_t) * min(num - received, LOAD_BATCH_RECORD_NUM), 0);
+		if ((len <= 0) || ((len % sizeof(mx6e_load_batch_record_t)) != 0)) {
+			mx6e_logging(LOG_ERR, "fail to receive %s record : %s\n", get_command_name(code), (len < 0) ? strerror(errno) : "unexpected size");
+			free(record);
+			free(failed_line);
+			return false;
+		}
+		received += len / sizeof(mx6e_load_batch_record_t);
+	}
+
+	bool                            ret_sync = m46e_pt_sync_config_table(table, record, num, &handler->conf.devices, &result, failed_line);
+	free(record);
+	free(failed_line);
+	if (!ret_sync || (result.failed > 0)) {
+		mx6e_logging(LOG_ERR, "fail to take over %s table : %d of %d entries failed\n", (CONFIG_TYPE_M46E == table->type) ? "m46e" : "me6e", result.failed, num);
+		return false;
+	}
+	mx6e_logging(LOG_INFO, "take over %s table : %d entries\n", (CONFIG_TYPE_M46E == table->type) ? "m46e" : "me6e", num);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief ホットリスタート起動関数
+//!
+//! 自身の実行ファイルを同じ設定ファイルとホットリスタートオプションで起動する。
+//! 起動した新プロセスは本プロセスに引き継ぎ要求を送信し、
+//! 本プロセスは引き継ぎ完了後に終了する。
+//! 実行ファイルが更新されている場合は更新後のファイルを起動する。
+//!
+//! @param [in] handler MX6Eハンドラ
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+bool mx6e_handover_spawn(mx6e_handler_t * handler)
+{
+	char                            path[PATH_MAX];
+	ssize_t                         len;
+	pid_t                           pid;
+
+	// 引数チェック
+	if (handler == NULL) {
+		return false;
+	}
+
+	// 実行ファイルのパスを取得(置き換えられている場合は置き換え後のファイルを使用する)
+	len = readlink("/proc/self/exe", path, sizeof(path) - 1);
+	if (len < 0) {
+		mx6e_logging(LOG_ERR, "fail to get executable path : %s\n", strerror(errno));
+		return false;
+	}
+	path[len] = '\0';
+	if ((len > strlen(HANDOVER_DELETED_SUFFIX)) && (strcmp(&path[len - strlen(HANDOVER_DELETED_SUFFIX)], HANDOVER_DELETED_SUFFIX) == 0)) {
+		path[len - strlen(HANDOVER_DELETED_SUFFIX)] = '\0';
+	}
+
+	char                           *argv[] = { path, "-f", handler->conf.filename, "--hot-restart", NULL };
+
+	pid = fork();
+	if (pid < 0) {
+		mx6e_logging(LOG_ERR, "fail to fork hot restart process : %s\n", strerror(errno));
+		return false;
+	}
+	if (pid == 0) {
+		// 子プロセス(シグナルマスクを起動時の状態に戻して実行する)
+		sigprocmask(SIG_SETMASK, &handler->oldsigmask, NULL);
+		execv(path, argv);
+		_exit(EXIT_FAILURE);
+	}
+	mx6e_logging(LOG_INFO, "hot restart process start(pid=%d) : %s\n", pid, path);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 引き継ぎ送信関数(旧プロセス側)
+//!
+//! 引き継ぎ要求を送信してきた新プロセスに、トンネルデバイスと送信用ソケットの
+//! ディスクリプタをSCM_RIGHTSで、テーブル内容をレコードで送信し、
+//! 新プロセスが転送を開始した旨の通知を待つ。
+//! 通知が無い場合(新プロセスの異常)は引き継ぎを中止し、本プロセスが運用を継続する。
+//! ディスクリプタは転送後も本プロセスが保持しているため、中止しても影響は無い。
+//!
+//! @param [in] handler MX6Eハンドラ
+//! @param [in] sock    引き継ぎ要求を受信したソケット
+//!
+//! @retval true  引き継ぎ完了(本プロセスは経路に触れずに終了すること)
+//! @retval false 引き継ぎ中止
+///////////////////////////////////////////////////////////////////////////////
+bool mx6e_handover_send(mx6e_handler_t * handler, int sock)
+{
+	mx6e_config_devices_t          *devices;
+	mx6e_command_code_t             code = MX6E_COMMAND_NONE;
+	mx6e_command_response_data_t    res = { 0 };
+	int                             ret;
+
+	// 引数チェック
+	if ((handler == NULL) || (sock < 0)) {
+		return false;
+	}
+	devices = &handler->conf.devices;
+
+	mx6e_logging(LOG_INFO, "hot restart handover start\n");
+
+	if (!handover_set_timeout(sock)) {
+		return false;
+	}
+
+	// トンネルデバイスと送信用ソケットのディスクリプタを送信
+	for (int i = 0; i < HANDOVER_FD_MAX; i++) {
+		handover_fd_t                   info;
+		mx6e_device_t                  *dev;
+		int                            *fd;
+
+		handover_fd_ref(devices, i, &dev, &fd);
+
+		memset(&info, 0, sizeof(info));
+		info.kind = i;
+		if (dev != NULL) {
+			memcpy(info.name, dev->name, sizeof(info.name));
+			info.ifindex = dev->ifindex;
+			info.hwaddr = dev->hwaddr;
+		}
+		ret = mx6e_socket_send(sock, MX6E_HANDOVER, &info, sizeof(info), *fd);
+		if (ret < 0) {
+			mx6e_logging(LOG_ERR, "fail to send handover descriptor : %s\n", strerror(-ret));
+			return false;
+		}
+	}
+
+	// テーブル内容を送信
+	if (!handover_send_table(sock, &handler->conf.m46e_conf_table, MX6E_SYNC_M46E_ENTRY)
+		|| !handover_send_table(sock, &handler->conf.me6e_conf_table, MX6E_SYNC_ME6E_ENTRY)) {
+		return false;
+	}
+
+	// 新プロセスの転送開始通知を待つ
+	ret = mx6e_socket_recv(sock, &code, &res, sizeof(res), NULL);
+	if (ret <= 0) {
+		mx6e_logging(LOG_ERR, "hot restart handover aborted : no response from new process(%s)\n", (ret < 0) ? strerror(-ret) : "closed");
+		return false;
+	}
+	if ((code != MX6E_HANDOVER) || (res.result != 0)) {
+		mx6e_logging(LOG_ERR, "hot restart handover aborted : new process failed to start(%s)\n", strerror(res.result));
+		return false;
+	}
+
+	mx6e_logging(LOG_INFO, "hot restart handover done. finish process without touching routes\n");
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 引き継ぎ受信関数(新プロセス側)
+//!
+//! 旧プロセスのコマンドソケットに接続して引き継ぎ要求を送信し、
+//! トンネルデバイスと送信用ソケットのディスクリプタ、テーブル内容を受信する。
+//! トンネルデバイスは旧プロセスと共有するため、再作成による通信断は発生しない。
+//! 転送スレッドを起動した後、mx6e_handover_complete()で旧プロセスに通知すること。
+//!
+//! @param [in,out] handler MX6Eハンドラ
+//!
+//! @return 0以上  引き継ぎ中のソケット(mx6e_handover_complete()に渡すこと)
+//!         -1     異常終了
+///////////////////////////////////////////////////////////////////////////////
+int mx6e_handover_receive(mx6e_handler_t * handler)
+{
+	mx6e_config_devices_t          *devices;
+	mx6e_command_t                  command = { 0 };
+	char                            path[sizeof(((struct sockaddr_un *) 0)->sun_path)] = { 0 };
+	struct sockaddr_un              addr;
+	int                             sock;
+	int                             ret;
+
+	// 引数チェック
+	if (handler == NULL) {
+		return -1;
+	}
+	devices = &handler->conf.devices;
+
+	// 以降、異常終了時は旧プロセスが運用を継続するため経路に触れない
+	handler->handover = MX6E_HANDOVER_TAKING;
+
+	ret = snprintf(&path[1], sizeof(path) - 1, MX6E_COMMAND_SOCK_NAME, handler->conf.general.process_name);
+	if ((ret < 0) || (ret >= (int) (sizeof(path) - 1))) {
+		// 切り詰めたパスでは別プロセスに接続しうるため引き継がない
+		mx6e_logging(LOG_ERR, "command socket path for %s is too long\n", handler->conf.general.process_name);
+		return -1;
+	}
+
+	sock = socket(PF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (sock < 0) {
+		mx6e_logging(LOG_ERR, "fail to create handover socket : %s\n", strerror(errno));
+		return -1;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	memcpy(addr.sun_path, path, sizeof(addr.sun_path));
+
+	if (connect(sock, (struct sockaddr *) &addr, sizeof(addr))) {
+		mx6e_logging(LOG_ERR, "fail to connect running MX6E application(%s) : %s\n", handler->conf.general.process_name, strerror(errno));
+		close(sock);
+		return -1;
+	}
+	if (!handover_set_timeout(sock)) {
+		close(sock);
+		return -1;
+	}
+
+	// 引き継ぎ要求
+	command.code = MX6E_HANDOVER;
+	ret = mx6e_socket_send_cred(sock, command.code, &command.req, sizeof(command.req));
+	if (ret > 0) {
+		ret = mx6e_socket_recv(sock, &command.code, &command.res, sizeof(command.res), NULL);
+	}
+	if ((ret <= 0) || (command.res.result != 0)) {
+		mx6e_logging(LOG_ERR, "fail to request handover : %s\n", strerror((ret < 0) ? -ret : command.res.result));
+		close(sock);
+		return -1;
+	}
+
+	// トンネルデバイスと送信用ソケットのディスクリプタを受信
+	for (int i = 0; i < HANDOVER_FD_MAX; i++) {
+		handover_fd_t                   info;
+		mx6e_device_t                  *dev;
+		int                            *p;
+		int                             fd = -1;
+
+		memset(&info, 0, sizeof(info));
+		ret = mx6e_socket_recv(sock, &command.code, &info, sizeof(info), &fd);
+		if ((ret != sizeof(int) + sizeof(info)) || (command.code != MX6E_HANDOVER) || (info.kind != i) || (fd < 0)) {
+			mx6e_logging(LOG_ERR, "unexpected handover descriptor message(ret=%d, code=%d, kind=%d)\n", ret, command.code, info.kind);
+			if (fd >= 0) {
+				close(fd);
+			}
+			close(sock);
+			return -1;
+		}
+		fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+		handover_fd_ref(devices, i, &dev, &p);
+		if (dev != NULL) {
+			if (strncmp(dev->name, info.name, sizeof(info.name)) != 0) {
+				mx6e_logging(LOG_ERR, "tunnel device name mismatch(config=%s, running=%.*s)\n", dev->name, IFNAMSIZ, info.name);
+				close(fd);
+				close(sock);
+				return -1;
+			}
+			dev->ifindex = info.ifindex;
+			dev->hwaddr = info.hwaddr;
+		}
+		*p = fd;
+	}
+
+	// テーブル内容を受信
+	if (!handover_recv_table(sock, handler, &handler->conf.m46e_conf_table, MX6E_SYNC_M46E_ENTRY)
+		|| !handover_recv_table(sock, handler, &handler->conf.me6e_conf_table, MX6E_SYNC_ME6E_ENTRY)) {
+		close(sock);
+		return -1;
+	}
+
+	return sock;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 引き継ぎ完了通知関数(新プロセス側)
+//!
+//! 転送スレッドの起動結果を旧プロセスに通知し、引き継ぎ用ソケットを閉じる。
+//! 正常(0)を通知した場合、旧プロセスは経路に触れずに終了する。
+//!
+//! @param [in] sock    mx6e_handover_receive()で取得したソケット
+//! @param [in] result  転送スレッドの起動結果(0:正常、0以外:エラー番号)
+//!
+//! @retval true  通知完了
+//! @retval false 通知失敗(旧プロセスが運用を継続する)
+///////////////////////////////////////////////////////////////////////////////
+bool mx6e_handover_complete(int sock, int result)
+{
+	mx6e_command_response_data_t    res = { 0 };
+	int                             ret;
+
+	if (sock < 0) {
+		return false;
+	}
+
+	res.result = result;
+	ret = mx6e_socket_send(sock, MX6E_HANDOVER, &res, sizeof(res), -1);
+	if (ret < 0) {
+		mx6e_logging(LOG_ERR, "fail to notify handover result : %s\n", strerror(-ret));
+	}
+	close(sock);
+
+	return (ret >= 0);
+}
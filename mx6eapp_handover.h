@@ -0,0 +1,31 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_handover.h                                            */
+/* 機能概要   : ホットリスタート引き継ぎ ヘッダファイル                       */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+#ifndef __MX6EAPP_HANDOVER_H__
+#   define __MX6EAPP_HANDOVER_H__
+
+#   include <stdbool.h>
+
+#   include "mx6eapp.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! 引き継ぎ中の送受信タイムアウト[sec]
+#   define HANDOVER_TIMEOUT         10
+//! 新プロセスがコマンドソケットを再作成する際の待ち合わせ間隔[msec]
+#   define HANDOVER_BIND_INTERVAL   10
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部関数プロトタイプ宣言
+////////////////////////////////////////////////////////////////////////////////
+bool                            mx6e_handover_spawn(mx6e_handler_t * handler);
+bool                            mx6e_handover_send(mx6e_handler_t * handler, int sock);
+int                             mx6e_handover_receive(mx6e_handler_t * handler);
+bool                            mx6e_handover_complete(int sock, int result);
+
+#endif												// __MX6EAPP_HANDOVER_H__
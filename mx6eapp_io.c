@@ -0,0 +1,752 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_io.c                                                  */
+/* 機能概要   : パケットI/Oバックエンド ソースファイル                        */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/ip6.h>
+#include <netinet/if_ether.h>
+
+#include "mx6eapp_io.h"
+#include "mx6eapp_log.h"
+#include "mx6eapp_util.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+#define DPRINTF(fd, ...)	if (0 > fd) {printf(__VA_ARGS__);} else {dprintf(fd, __VA_ARGS__);}
+
+//! メモリバックエンドのリング位置マスク
+#define IO_MEM_RING_MASK        (MX6E_IO_MEM_RING_NUM - 1)
+
+//! IPv6ヘッダを含めて送信するソケットオプション(Linux 4.5以降)
+#ifndef IPV6_HDRINCL
+#define IPV6_HDRINCL            36
+#endif
+//! 自ホスト以外の送信元アドレスを指定可能にするソケットオプション(Linux 4.15以降)
+#ifndef IPV6_FREEBIND
+#define IPV6_FREEBIND           78
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! メモリバックエンドのリング(書き込み側、読み出し側ともに1スレッド)
+typedef struct {
+	uint64_t                        head;			///< 次回書き込み位置(累積)
+	uint64_t                        tail;			///< 次回読み出し位置(累積)
+	uint32_t                        len[MX6E_IO_MEM_RING_NUM];	///< 格納したパケット長
+	char                            frame[MX6E_IO_MEM_RING_NUM][MX6E_IO_MEM_FRAME_MAX];	///< パケット格納領域
+} io_mem_ring_t;
+
+//! rawバックエンドの送信メッセージ
+typedef struct {
+	bool                            pktinfo;		///< 送信元アドレスをIPV6_PKTINFOで指定するかどうか
+	struct mmsghdr                  msg[MX6E_IO_BURST_MAX];	///< 送信メッセージ
+	struct iovec                    iov[MX6E_IO_BURST_MAX];	///< 送信データ(イーサネットヘッダを除く)
+	struct sockaddr_in6             daddr[MX6E_IO_BURST_MAX];	///< 送信先アドレス
+	char                            cmsg[MX6E_IO_BURST_MAX][CMSG_SPACE(sizeof(struct in6_pktinfo))];	///< 送信元情報
+} io_raw_msg_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部関数プロトタイプ宣言
+////////////////////////////////////////////////////////////////////////////////
+static bool                     io_tap_open(mx6e_io_t * io);
+static int                      io_tap_rx_burst(mx6e_io_t * io, mx6e_io_pkt_t * pkt, int num);
+static int                      io_tap_tx_burst(mx6e_io_t * io, mx6e_io_pkt_t * pkt, int num);
+static void                     io_tap_release(mx6e_io_t * io);
+static bool                     io_mem_open(mx6e_io_t * io);
+static int                      io_mem_rx_burst(mx6e_io_t * io, mx6e_io_pkt_t * pkt, int num);
+static int                      io_mem_tx_burst(mx6e_io_t * io, mx6e_io_pkt_t * pkt, int num);
+static void                     io_mem_release(mx6e_io_t * io);
+static bool                     io_raw_open(mx6e_io_t * io);
+static int                      io_raw_tx_burst(mx6e_io_t * io, mx6e_io_pkt_t * pkt, int num);
+static void                     io_raw_release(mx6e_io_t * io);
+static void                     io_stats_default(mx6e_io_t * io, mx6e_io_stats_t * stats);
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部変数
+////////////////////////////////////////////////////////////////////////////////
+//! バックエンド操作(mx6e_io_type_t の順)
+static const mx6e_io_ops_t      io_ops[MX6E_IO_TYPE_MAX] = {
+	[MX6E_IO_TAP] = {"tap", io_tap_open, io_tap_rx_burst, io_tap_tx_burst, io_tap_release, io_stats_default},
+	[MX6E_IO_MEMORY] = {"memory", io_mem_open, io_mem_rx_burst, io_mem_tx_burst, io_mem_release, io_stats_default},
+	[MX6E_IO_RAW] = {"raw", io_raw_open, NULL, io_raw_tx_burst, io_raw_release, io_stats_default},
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief パケットI/O初期化関数
+//!
+//! 未オープン状態に初期化する。
+//!
+//! @param [out] io   パケットI/O
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_io_init(mx6e_io_t * io)
+{
+	memset(io, 0, sizeof(*io));
+	io->fd = -1;
+	io->sock = -1;
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief パケットI/Oオープン関数
+//!
+//! 指定した種別のバックエンドでトンネルデバイスの送受信を開始できる状態にする。
+//!
+//! @param [in,out] io     パケットI/O
+//! @param [in]     type   バックエンド種別
+//! @param [in]     dev    対象のトンネルデバイス
+//! @param [in]     sock   送信用ソケット(rawバックエンドで使用、未使用の場合は-1)
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+bool mx6e_io_open(mx6e_io_t * io, mx6e_io_type_t type, mx6e_device_t * dev, int sock)
+{
+	if ((type < 0) || (type >= MX6E_IO_TYPE_MAX)) {
+		mx6e_logging(LOG_ERR, "unknown packet I/O backend : %d\n", type);
+		return false;
+	}
+
+	mx6e_io_init(io);
+	io->type = type;
+	io->dev = dev;
+	io->sock = sock;
+	if (!io_ops[type].open(io)) {
+		mx6e_logging(LOG_ERR, "fail to open %s packet I/O on %s\n", io_ops[type].name, dev->name);
+		mx6e_io_init(io);
+		return false;
+	}
+	io->ops = &io_ops[type];
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief パケットI/O解放関数
+//!
+//! 未オープンの場合は何もしない。
+//!
+//! @param [in,out] io   パケットI/O
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_io_release(mx6e_io_t * io)
+{
+	if (io->ops != NULL) {
+		io->ops->release(io);
+	}
+	mx6e_io_init(io);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief パケットI/O統計取得関数
+//!
+//! @param [in]  io      パケットI/O
+//! @param [out] stats   送受信統計の格納先(未オープンの場合は0)
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_io_get_stats(mx6e_io_t * io, mx6e_io_stats_t * stats)
+{
+	if (io->ops == NULL) {
+		memset(stats, 0, sizeof(*stats));
+		return;
+	}
+	io->ops->stats(io, stats);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief バックエンド名取得関数
+//!
+//! @param [in] type   バックエンド種別
+//!
+//! @return バックエンド名
+///////////////////////////////////////////////////////////////////////////////
+const char                     *mx6e_io_type_name(mx6e_io_type_t type)
+{
+	if ((type < 0) || (type >= MX6E_IO_TYPE_MAX)) {
+		return "unknown";
+	}
+
+	return io_ops[type].name;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief バックエンド名解析関数
+//!
+//! @param [in]  str    バックエンド名
+//! @param [in]  rx     受信側に使用するかどうか
+//! @param [out] type   バックエンド種別の格納先
+//!
+//! @retval true  正常終了
+//! @retval false 不明なバックエンド名、または受信側に送信専用のバックエンドを指定
+///////////////////////////////////////////////////////////////////////////////
+bool mx6e_io_type_parse(const char *str, bool rx, mx6e_io_type_t * type)
+{
+	for (int i = 0; i < MX6E_IO_TYPE_MAX; i++) {
+		if (!strcasecmp(str, io_ops[i].name)) {
+			if (rx && (io_ops[i].rx_burst == NULL)) {
+				mx6e_logging(LOG_ERR, "%s packet I/O can not receive\n", io_ops[i].name);
+				return false;
+			}
+			*type = (mx6e_io_type_t) i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 標準の統計取得関数
+//!
+//! 送受信関数で更新した統計をそのまま返す。
+//! カーネル側の破棄数など独自の統計を持つバックエンドは別に用意する。
+//!
+//! @param [in]  io      パケットI/O
+//! @param [out] stats   送受信統計の格納先
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void io_stats_default(mx6e_io_t * io, mx6e_io_stats_t * stats)
+{
+	*stats = io->stats;
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief TAPバックエンド オープン関数
+//!
+//! 生成済み(またはホットリスタートで引き継ぎ済み)のトンネルデバイスの
+//! ディスクリプタを使用する。受信をまとめて行うためノンブロッキングにする。
+//!
+//! @param [in,out] io   パケットI/O
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static bool io_tap_open(mx6e_io_t * io)
+{
+	int                             flags;
+
+	if (io->dev->fd < 0) {
+		mx6e_logging(LOG_ERR, "%s is not opened\n", io->dev->name);
+		return false;
+	}
+	flags = fcntl(io->dev->fd, F_GETFL);
+	if ((flags < 0) || (fcntl(io->dev->fd, F_SETFL, flags | O_NONBLOCK) < 0)) {
+		mx6e_logging(LOG_ERR, "fail to set %s non-blocking : %s\n", io->dev->name, strerror(errno));
+		return false;
+	}
+	io->fd = io->dev->fd;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief TAPバックエンド 受信関数
+//!
+//! 読み出せるパケットが無くなるか、num個に達するまでreadを繰り返す。
+//!
+//! @param [in,out] io    パケットI/O
+//! @param [in,out] pkt   受信パケット
+//! @param [in]     num   受信する最大パケット数
+//!
+//! @retval 0以上 受信したパケット数
+//! @retval -1    異常終了
+///////////////////////////////////////////////////////////////////////////////
+static int io_tap_rx_burst(mx6e_io_t * io, mx6e_io_pkt_t * pkt, int num)
+{
+	int                             n = 0;
+
+	while (n < num) {
+		ssize_t                         len = read(io->fd, pkt[n].data, pkt[n].len);
+		if (len > 0) {
+			pkt[n].len = len;
+			n++;
+		} else if ((len < 0) && (errno == EINTR)) {
+			continue;
+		} else if ((len < 0) && (errno != EAGAIN) && (n == 0)) {
+			return -1;
+		} else {
+			break;
+		}
+	}
+
+	return n;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief TAPバックエンド 送信関数
+//!
+//! パケット毎にwriteする。送信に失敗した時点で打ち切る。
+//!
+//! @param [in,out] io    パケットI/O
+//! @param [in]     pkt   送信パケット
+//! @param [in]     num   送信するパケット数
+//!
+//! @return 送信できたパケット数
+///////////////////////////////////////////////////////////////////////////////
+static int io_tap_tx_burst(mx6e_io_t * io, mx6e_io_pkt_t * pkt, int num)
+{
+	int                             n;
+
+	for (n = 0; n < num; n++) {
+		if (0 > write(io->fd, pkt[n].data, pkt[n].len)) {
+			break;
+		}
+	}
+
+	return n;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief TAPバックエンド 解放関数
+//!
+//! ディスクリプタはトンネルデバイスが所有するので閉じない。
+//!
+//! @param [in,out] io   パケットI/O
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void io_tap_release(mx6e_io_t * io)
+{
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief リング格納関数
+//!
+//! @param [in,out] ring   メモリバックエンドのリング
+//! @param [in]     data   パケットデータ
+//! @param [in]     len    パケット長
+//!
+//! @retval true  正常終了
+//! @retval false リングが一杯、またはパケット長が格納領域を超える(errnoを設定)
+///////////////////////////////////////////////////////////////////////////////
+static bool io_mem_push(io_mem_ring_t * ring, const char *data, ssize_t len)
+{
+	uint64_t                        head = ring->head;
+
+	if ((len <= 0) || (len > MX6E_IO_MEM_FRAME_MAX)) {
+		errno = EMSGSIZE;
+		return false;
+	}
+	if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= MX6E_IO_MEM_RING_NUM) {
+		errno = ENOBUFS;
+		return false;
+	}
+	memcpy(ring->frame[head & IO_MEM_RING_MASK], data, len);
+	ring->len[head & IO_MEM_RING_MASK] = len;
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief リング取り出し関数
+//!
+//! @param [in,out] ring   メモリバックエンドのリング
+//! @param [out]    buf    パケットの格納先(NULLの場合は捨てる)
+//! @param [in]     size   格納先の領域長(超える部分は切り捨てる)
+//!
+//! @retval 0より大 取り出したパケット長
+//! @retval 0       リングが空
+///////////////////////////////////////////////////////////////////////////////
+static ssize_t io_mem_pop(io_mem_ring_t * ring, char *buf, ssize_t size)
+{
+	uint64_t                        tail = ring->tail;
+	ssize_t                         len;
+
+	if (tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+		return 0;
+	}
+	len = ring->len[tail & IO_MEM_RING_MASK];
+	if (buf != NULL) {
+		memcpy(buf, ring->frame[tail & IO_MEM_RING_MASK], (len < size) ? len : size);
+	}
+	__atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+
+	return len;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief メモリバックエンド オープン関数
+//!
+//! リングと、受信待ち用のeventfdを作成する。トンネルデバイスは使用しない。
+//!
+//! @param [in,out] io   パケットI/O
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static bool io_mem_open(mx6e_io_t * io)
+{
+	io->priv = calloc(1, sizeof(io_mem_ring_t));
+	if (io->priv == NULL) {
+		mx6e_logging(LOG_ERR, "packet I/O ring allocation failed\n");
+		return false;
+	}
+	io->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (io->fd < 0) {
+		mx6e_logging(LOG_ERR, "fail to create eventfd : %s\n", strerror(errno));
+		free(io->priv);
+		io->priv = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief メモリバックエンド 受信関数
+//!
+//! mx6e_io_mem_inject() で格納されたパケットを取り出す。
+//! 取り残したパケットがある場合は再度 io->fd を読み出し可能にする。
+//!
+//! @param [in,out] io    パケットI/O
+//! @param [in,out] pkt   受信パケット
+//! @param [in]     num   受信する最大パケット数
+//!
+//! @return 受信したパケット数
+///////////////////////////////////////////////////////////////////////////////
+static int io_mem_rx_burst(mx6e_io_t * io, mx6e_io_pkt_t * pkt, int num)
+{
+	io_mem_ring_t                  *ring = (io_mem_ring_t *) io->priv;
+	uint64_t                        value;
+	int                             n;
+
+	// 通知を消してから取り出す(取り出し中に格納されたパケットは次の通知で受信する)
+	if (read(io->fd, &value, sizeof(value)) < 0) {
+		// 通知が無くても取り出しは行う
+	}
+	for (n = 0; n < num; n++) {
+		ssize_t                         len = io_mem_pop(ring, pkt[n].data, pkt[n].len);
+		if (len == 0) {
+			break;
+		}
+		pkt[n].len = (len < pkt[n].len) ? len : pkt[n].len;
+	}
+	if (ring->tail != __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+		value = 1;
+		if (write(io->fd, &value, sizeof(value)) < 0) {
+			// 通知済みの場合は失敗しても問題無い
+		}
+	}
+
+	return n;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief メモリバックエンド 送信関数
+//!
+//! パケットをリングに格納する。格納したパケットは mx6e_io_mem_drain() で取り出す。
+//!
+//! @param [in,out] io    パケットI/O
+//! @param [in]     pkt   送信パケット
+//! @param [in]     num   送信するパケット数
+//!
+//! @return 格納できたパケット数
+///////////////////////////////////////////////////////////////////////////////
+static int io_mem_tx_burst(mx6e_io_t * io, mx6e_io_pkt_t * pkt, int num)
+{
+	io_mem_ring_t                  *ring = (io_mem_ring_t *) io->priv;
+	int                             n;
+
+	for (n = 0; n < num; n++) {
+		if (!io_mem_push(ring, pkt[n].data, pkt[n].len)) {
+			break;
+		}
+	}
+
+	return n;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief メモリバックエンド 解放関数
+//!
+//! @param [in,out] io   パケットI/O
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void io_mem_release(mx6e_io_t * io)
+{
+	close(io->fd);
+	free(io->priv);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief rawバックエンド オープン関数
+//!
+//! 送信用ソケット(send_sock_fd_fp/send_sock_fd_pr)を、変換済みのIPv6ヘッダを
+//! そのまま送信するように設定する。送信元アドレスは自ホストのアドレスではないため、
+//! 経路選択に送信元を使えるよう非ローカルアドレスの指定を許可する。
+//! 許可できない場合は送信先のみで経路を選択する。
+//!
+//! @param [in,out] io   パケットI/O
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static bool io_raw_open(mx6e_io_t * io)
+{
+	io_raw_msg_t                   *raw;
+	int                             on = 1;
+
+	if (io->sock < 0) {
+		mx6e_logging(LOG_ERR, "send socket for %s is not opened\n", io->dev->name);
+		return false;
+	}
+	if (setsockopt(io->sock, IPPROTO_IPV6, IPV6_HDRINCL, &on, sizeof(on)) < 0) {
+		mx6e_logging(LOG_ERR, "fail to set sockopt IPV6_HDRINCL : %s\n", strerror(errno));
+		return false;
+	}
+
+	raw = (io_raw_msg_t *) calloc(1, sizeof(io_raw_msg_t));
+	if (raw == NULL) {
+		mx6e_logging(LOG_ERR, "packet I/O message allocation failed\n");
+		return false;
+	}
+	if ((setsockopt(io->sock, IPPROTO_IPV6, IPV6_FREEBIND, &on, sizeof(on)) == 0)
+		|| (setsockopt(io->sock, IPPROTO_IPV6, IPV6_TRANSPARENT, &on, sizeof(on)) == 0)) {
+		raw->pktinfo = true;
+	} else {
+		mx6e_logging(LOG_WARNING, "fail to allow non-local source address (%s). route by destination only\n", strerror(errno));
+	}
+
+	// 送信メッセージの固定部分を設定
+	for (int i = 0; i < MX6E_IO_BURST_MAX; i++) {
+		struct msghdr                  *hdr = &raw->msg[i].msg_hdr;
+
+		raw->daddr[i].sin6_family = AF_INET6;
+		hdr->msg_name = &raw->daddr[i];
+		hdr->msg_namelen = sizeof(raw->daddr[i]);
+		hdr->msg_iov = &raw->iov[i];
+		hdr->msg_iovlen = 1;
+		if (raw->pktinfo) {
+			struct cmsghdr                 *cmsg;
+
+			hdr->msg_control = raw->cmsg[i];
+			hdr->msg_controllen = sizeof(raw->cmsg[i]);
+			cmsg = CMSG_FIRSTHDR(hdr);
+			cmsg->cmsg_len = CMSG_LEN(sizeof(struct in6_pktinfo));
+			cmsg->cmsg_level = IPPROTO_IPV6;
+			cmsg->cmsg_type = IPV6_PKTINFO;
+		}
+	}
+	io->priv = raw;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief rawバックエンド 送信関数
+//!
+//! イーサネットヘッダを除いたIPv6パケットを、送信元情報(IPV6_PKTINFO)付きで
+//! sendmmsgによりまとめて送信する。トンネルデバイスを経由したカーネルの
+//! 転送処理を通らないため、Hop Limitはここで減算する(1以下のパケットは送信エラー)。
+//!
+//! @param [in,out] io    パケットI/O
+//! @param [in]     pkt   送信パケット
+//! @param [in]     num   送信するパケット数
+//!
+//! @return 送信できたパケット数
+///////////////////////////////////////////////////////////////////////////////
+static int io_raw_tx_burst(mx6e_io_t * io, mx6e_io_pkt_t * pkt, int num)
+{
+	io_raw_msg_t                   *raw = (io_raw_msg_t *) io->priv;
+	int                             sent = 0;
+
+	while (sent < num) {
+		int                             n = min(num - sent, MX6E_IO_BURST_MAX);
+		int                             ret;
+
+		for (int i = 0; i < n; i++) {
+			mx6e_io_pkt_t                  *p = &pkt[sent + i];
+			struct ip6_hdr                 *p_ip6 = (struct ip6_hdr *) (p->data + sizeof(struct ethhdr));
+
+			if ((p->len < (ssize_t) (sizeof(struct ethhdr) + sizeof(struct ip6_hdr))) || (p_ip6->ip6_hlim <= 1)) {
+				// IPv6ヘッダが無い、またはHop Limitを減算できないパケットの手前まで送信する
+				n = i;
+				break;
+			}
+			p_ip6->ip6_hlim--;
+			raw->daddr[i].sin6_addr = p_ip6->ip6_dst;
+			raw->iov[i].iov_base = p_ip6;
+			raw->iov[i].iov_len = p->len - sizeof(struct ethhdr);
+			if (raw->pktinfo) {
+				struct in6_pktinfo             *info = (struct in6_pktinfo *) CMSG_DATA(CMSG_FIRSTHDR(&raw->msg[i].msg_hdr));
+				info->ipi6_addr = p_ip6->ip6_src;
+				info->ipi6_ifindex = 0;
+			}
+		}
+		if (n == 0) {
+			errno = EINVAL;
+			return sent;
+		}
+
+		ret = sendmmsg(io->sock, raw->msg, n, 0);
+		if (ret < 0) {
+			if (errno == EINTR) {
+				ret = 0;
+			} else {
+				// 送信できなかったパケットのHop Limitを戻して呼び出し元に返す
+				for (int i = 0; i < n; i++) {
+					((struct ip6_hdr *) (pkt[sent + i].data + sizeof(struct ethhdr)))->ip6_hlim++;
+				}
+				return sent;
+			}
+		}
+		// 送信しきれなかった分は再度送信する(エラーは次の送信で通知される)
+		for (int i = ret; i < n; i++) {
+			((struct ip6_hdr *) (pkt[sent + i].data + sizeof(struct ethhdr)))->ip6_hlim++;
+		}
+		sent += ret;
+	}
+
+	return sent;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief rawバックエンド 解放関数
+//!
+//! 送信用ソケットはデバイス設定が所有するので閉じない。
+//!
+//! @param [in,out] io   パケットI/O
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void io_raw_release(mx6e_io_t * io)
+{
+	free(io->priv);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief メモリバックエンド パケット投入関数
+//!
+//! 受信側のメモリバックエンドにパケットを格納し、受信待ちを起こす。
+//! 投入は1スレッドから行うこと。
+//!
+//! @param [in,out] io     パケットI/O(メモリバックエンド)
+//! @param [in]     data   パケットデータ
+//! @param [in]     len    パケット長
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了(メモリバックエンドでない、リングが一杯など)
+///////////////////////////////////////////////////////////////////////////////
+bool mx6e_io_mem_inject(mx6e_io_t * io, const char *data, ssize_t len)
+{
+	uint64_t                        value = 1;
+
+	if ((io->ops == NULL) || (io->type != MX6E_IO_MEMORY)) {
+		errno = EINVAL;
+		return false;
+	}
+	if (!io_mem_push((io_mem_ring_t *) io->priv, data, len)) {
+		return false;
+	}
+	if (write(io->fd, &value, sizeof(value)) < 0) {
+		// 通知済みの場合は失敗しても問題無い
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief メモリバックエンド パケット取り出し関数
+//!
+//! 送信側のメモリバックエンドから送信されたパケットを1つ取り出す。
+//! 取り出しは1スレッドから行うこと。
+//!
+//! @param [in,out] io     パケットI/O(メモリバックエンド)
+//! @param [out]    buf    パケットの格納先(NULLの場合は捨てる)
+//! @param [in]     size   格納先の領域長(超える部分は切り捨てる)
+//!
+//! @retval 0より大 取り出したパケット長
+//! @retval 0       送信されたパケットが無い
+//! @retval -1      メモリバックエンドでない
+///////////////////////////////////////////////////////////////////////////////
+ssize_t mx6e_io_mem_drain(mx6e_io_t * io, char *buf, ssize_t size)
+{
+	if ((io->ops == NULL) || (io->type != MX6E_IO_MEMORY)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	return io_mem_pop((io_mem_ring_t *) io->priv, buf, size);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief パケットI/O統計表示関数
+//!
+//! 転送方向毎の受信側、送信側のバックエンドと送受信統計を表示する。
+//!
+//! @param [in] pr2fp   PR->FP転送のパケットI/O
+//! @param [in] fp2pr   FP->PR転送のパケットI/O
+//! @param [in] fd      出力先ディスクリプタ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_io_print(mx6e_io_path_t * pr2fp, mx6e_io_path_t * fp2pr, int fd)
+{
+	struct {
+		const char                     *name;
+		mx6e_io_t                      *io;
+		bool                            rx;
+	} row[] = {
+		{"FP->PR rx", &fp2pr->rx, true},
+		{"FP->PR tx", &fp2pr->tx, false},
+		{"PR->FP rx", &pr2fp->rx, true},
+		{"PR->FP tx", &pr2fp->tx, false},
+	};
+
+	DPRINTF(fd, "【MX6E packet I/O】\n");
+	DPRINTF(fd, "\n");
+	DPRINTF(fd, "  %-10s %-8s %16s %18s %14s %10s %12s\n", "", "backend", "packets", "bytes", "bursts", "pkt/burst", "errors");
+	for (int i = 0; i < (int) (sizeof(row) / sizeof(row[0])); i++) {
+		mx6e_io_stats_t                 stats;
+		uint64_t                        packets;
+		uint64_t                        bytes;
+		uint64_t                        bursts;
+		uint64_t                        errors;
+
+		mx6e_io_get_stats(row[i].io, &stats);
+		packets = row[i].rx ? stats.rx_packets : stats.tx_packets;
+		bytes = row[i].rx ? stats.rx_bytes : stats.tx_bytes;
+		bursts = row[i].rx ? stats.rx_bursts : stats.tx_bursts;
+		errors = row[i].rx ? stats.rx_errors : stats.tx_errors;
+		DPRINTF(fd, "  %-10s %-8s %16lu %18lu %14lu %10.2f %12lu\n", row[i].name,
+				(row[i].io->ops != NULL) ? row[i].io->ops->name : "-",
+				(unsigned long) packets, (unsigned long) bytes, (unsigned long) bursts,
+				(bursts > 0) ? ((double) packets / bursts) : 0.0, (unsigned long) errors);
+	}
+	DPRINTF(fd, "\n");
+
+	return;
+}
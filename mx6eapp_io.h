@@ -0,0 +1,151 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_io.h                                                  */
+/* 機能概要   : パケットI/Oバックエンド ヘッダファイル                        */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+#ifndef __MX6EAPP_IO_H__
+#   define __MX6EAPP_IO_H__
+
+#   include <stdbool.h>
+#   include <stdint.h>
+#   include <sys/types.h>
+
+#   include "mx6eapp_config.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! 一度に送受信する最大パケット数
+#   define MX6E_IO_BURST_MAX       32
+//! メモリバックエンドのリング段数(2のべき乗)
+#   define MX6E_IO_MEM_RING_NUM    256
+//! メモリバックエンドの1パケットあたりの最大長
+#   define MX6E_IO_MEM_FRAME_MAX   9216
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! 送受信パケット
+typedef struct {
+	char                           *data;			///< パケットデータ(受信時は呼び出し元が用意した領域)
+	ssize_t                         len;			///< パケット長(受信時は入力で領域長、出力で受信長)
+} mx6e_io_pkt_t;
+
+//! 送受信統計
+typedef struct {
+	uint64_t                        rx_packets;		///< 受信パケット数
+	uint64_t                        rx_bytes;		///< 受信バイト数
+	uint64_t                        rx_bursts;		///< 1パケット以上受信した受信処理の回数
+	uint64_t                        rx_errors;		///< 受信エラー数
+	uint64_t                        tx_packets;		///< 送信パケット数
+	uint64_t                        tx_bytes;		///< 送信バイト数
+	uint64_t                        tx_bursts;		///< 1パケット以上送信した送信処理の回数
+	uint64_t                        tx_errors;		///< 送信エラー数
+} mx6e_io_stats_t;
+
+typedef struct mx6e_io_s mx6e_io_t;
+
+//! バックエンド操作
+typedef struct {
+	const char                     *name;			///< バックエンド名(設定ファイルの値)
+	bool                            (*open) (mx6e_io_t * io);	///< オープン(io->dev、io->sockは設定済み)
+	int                             (*rx_burst) (mx6e_io_t * io, mx6e_io_pkt_t * pkt, int num);	///< 受信(待たない、NULL:送信専用)
+	int                             (*tx_burst) (mx6e_io_t * io, mx6e_io_pkt_t * pkt, int num);	///< 送信
+	void                            (*release) (mx6e_io_t * io);	///< 解放
+	void                            (*stats) (mx6e_io_t * io, mx6e_io_stats_t * stats);	///< 統計取得
+} mx6e_io_ops_t;
+
+//! パケットI/O(転送方向の受信側、送信側毎に一つ)
+struct mx6e_io_s {
+	const mx6e_io_ops_t            *ops;			///< バックエンド操作(NULL:未オープン)
+	mx6e_io_type_t                  type;			///< バックエンド種別
+	mx6e_device_t                  *dev;			///< 対象のトンネルデバイス
+	int                             fd;				///< 受信待ち用ディスクリプタ(-1:待ち受け不可)
+	int                             sock;			///< 送信用ソケット(-1:未使用)
+	void                           *priv;			///< バックエンド固有データ
+	mx6e_io_stats_t                 stats;			///< 送受信統計(書き込みは転送スレッドのみ)
+};
+
+//! 転送方向毎のパケットI/O
+typedef struct {
+	mx6e_io_t                       rx;				///< 受信側
+	mx6e_io_t                       tx;				///< 送信側
+} mx6e_io_path_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部関数プロトタイプ宣言
+////////////////////////////////////////////////////////////////////////////////
+void                            mx6e_io_init(mx6e_io_t * io);
+bool                            mx6e_io_open(mx6e_io_t * io, mx6e_io_type_t type, mx6e_device_t * dev, int sock);
+void                            mx6e_io_release(mx6e_io_t * io);
+void                            mx6e_io_get_stats(mx6e_io_t * io, mx6e_io_stats_t * stats);
+const char                     *mx6e_io_type_name(mx6e_io_type_t type);
+bool                            mx6e_io_type_parse(const char *str, bool rx, mx6e_io_type_t * type);
+bool                            mx6e_io_mem_inject(mx6e_io_t * io, const char *data, ssize_t len);
+ssize_t                         mx6e_io_mem_drain(mx6e_io_t * io, char *buf, ssize_t size);
+void                            mx6e_io_print(mx6e_io_path_t * pr2fp, mx6e_io_path_t * fp2pr, int fd);
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief パケット受信関数
+//!
+//! バックエンドから最大num個のパケットを待たずに受信し、統計を更新する。
+//! 受信待ちは呼び出し元が io->fd で行う。
+//!
+//! @param [in,out] io    パケットI/O
+//! @param [in,out] pkt   受信パケット(領域と領域長を設定しておくこと)
+//! @param [in]     num   受信する最大パケット数
+//!
+//! @retval 0以上 受信したパケット数
+//! @retval -1    異常終了(errnoを設定)
+///////////////////////////////////////////////////////////////////////////////
+static inline int mx6e_io_rx_burst(mx6e_io_t * io, mx6e_io_pkt_t * pkt, int num)
+{
+	int                             n = io->ops->rx_burst(io, pkt, num);
+
+	if (n > 0) {
+		io->stats.rx_bursts++;
+		io->stats.rx_packets += n;
+		for (int i = 0; i < n; i++) {
+			io->stats.rx_bytes += pkt[i].len;
+		}
+	} else if (n < 0) {
+		io->stats.rx_errors++;
+	}
+
+	return n;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief パケット送信関数
+//!
+//! バックエンドへnum個のパケットを先頭から送信し、統計を更新する。
+//! 戻り値がnumより少ない場合、その位置のパケットが送信エラーとなっており、
+//! 以降のパケットは送信していない。
+//!
+//! @param [in,out] io    パケットI/O
+//! @param [in]     pkt   送信パケット
+//! @param [in]     num   送信するパケット数
+//!
+//! @return 先頭から送信できたパケット数(numより少ない場合はerrnoを設定)
+///////////////////////////////////////////////////////////////////////////////
+static inline int mx6e_io_tx_burst(mx6e_io_t * io, mx6e_io_pkt_t * pkt, int num)
+{
+	int                             n = io->ops->tx_burst(io, pkt, num);
+
+	if (n > 0) {
+		io->stats.tx_bursts++;
+		io->stats.tx_packets += n;
+		for (int i = 0; i < n; i++) {
+			io->stats.tx_bytes += pkt[i].len;
+		}
+	}
+	if (n < num) {
+		io->stats.tx_errors++;
+	}
+
+	return n;
+}
+
+#endif												// __MX6EAPP_IO_H__
@@ -6,8 +6,83 @@
 /* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
 /******************************************************************************/
 
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
 #include "mx6eapp_log.h"
 
+////////////////////////////////////////////////////////////////////////////////
+// 内部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! 非同期ログリングを持てるスレッド数
+#define LOG_RING_THREAD_MAX      4
+//! 1スレッドあたりの非同期ログリングのレコード数(2のべき乗)
+#define LOG_RING_SIZE            1024
+#define LOG_RING_MASK            (LOG_RING_SIZE - 1)
+//! ログ出力スレッドがリングを確認する周期[usec]
+#define LOG_FLUSH_INTERVAL       10000
+
+//! 流量制限 秒間件数/バースト件数(エラー以上)
+#define LOG_LIMIT_RATE_ERR       10
+#define LOG_LIMIT_BURST_ERR      100
+//! 流量制限 秒間件数/バースト件数(警告、通知、情報)
+#define LOG_LIMIT_RATE_INFO      10
+#define LOG_LIMIT_BURST_INFO     50
+//! 流量制限 秒間件数/バースト件数(デバッグ)
+#define LOG_LIMIT_RATE_DEBUG     10
+#define LOG_LIMIT_BURST_DEBUG    20
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! 非同期ログレコード
+typedef struct {
+	int                             priority;		///< syslog優先度
+	int                             err;			///< 格納時点のerrno(%m用)
+	const char                     *message;		///< 書式(文字列リテラル)
+	long                            arg[LOG_ASYNC_ARG_MAX];	///< 引数
+} log_record_t;
+
+//! 非同期ログリング(書き込みは所有スレッドのみ、読み出しはログ出力スレッドのみ)
+typedef struct {
+	uint64_t                        head;			///< 書き込み位置(所有スレッドが更新)
+	uint64_t                        tail;			///< 読み出し位置(ログ出力スレッドが更新)
+	uint64_t                        dropped;		///< リング満杯で破棄したレコード数
+	log_record_t                    record[LOG_RING_SIZE];	///< レコード格納領域
+} log_ring_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部変数定義
+////////////////////////////////////////////////////////////////////////////////
+static log_ring_t               log_ring[LOG_RING_THREAD_MAX];	///< 非同期ログリング
+static int                      log_ring_num;	///< 割り当て済みのリング数
+static __thread log_ring_t     *log_ring_self;	///< 呼び出しスレッドのリング
+static pthread_t                log_tid;		///< ログ出力スレッドID
+static bool                     log_running;	///< ログ出力スレッド起動中フラグ
+static bool                     log_stop;		///< ログ出力スレッド停止要求フラグ
+static uint64_t                 log_dropped_reported;	///< 通知済みの破棄レコード数
+static bool                     log_debug;		///< デバッグログを出力するかどうか
+static mx6e_log_limit_t        *log_limit_list;	///< ログを抑止したことのある呼び出し箇所のリスト
+
+//! ログ優先度毎の流量制限(秒間件数、バースト件数)
+static const struct {
+	int                             rate;			///< 秒間件数
+	int                             burst;			///< バースト件数
+} log_limit_class[] = {
+	[LOG_EMERG] = {LOG_LIMIT_RATE_ERR, LOG_LIMIT_BURST_ERR},
+	[LOG_ALERT] = {LOG_LIMIT_RATE_ERR, LOG_LIMIT_BURST_ERR},
+	[LOG_CRIT] = {LOG_LIMIT_RATE_ERR, LOG_LIMIT_BURST_ERR},
+	[LOG_ERR] = {LOG_LIMIT_RATE_ERR, LOG_LIMIT_BURST_ERR},
+	[LOG_WARNING] = {LOG_LIMIT_RATE_INFO, LOG_LIMIT_BURST_INFO},
+	[LOG_NOTICE] = {LOG_LIMIT_RATE_INFO, LOG_LIMIT_BURST_INFO},
+	[LOG_INFO] = {LOG_LIMIT_RATE_INFO, LOG_LIMIT_BURST_INFO},
+	[LOG_DEBUG] = {LOG_LIMIT_RATE_DEBUG, LOG_LIMIT_BURST_DEBUG},
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief ログ初期化関数
 //!
@@ -33,6 +108,7 @@ void mx6e_initial_log(const char *name, const bool debuglog)
 	_DS_(opt |= LOG_PERROR);
 
 	openlog(name, opt, LOG_USER);
+	__atomic_store_n(&log_debug, debuglog, __ATOMIC_RELAXED);
 
 	// 現在のマスク値を取得
 	int                             mask = setlogmask(0);
@@ -50,6 +126,7 @@ void mx6e_initial_log(const char *name, const bool debuglog)
 ////////////////////////////////////////////////////////////////////////////////
 //! @brief syslogへのログ出力関数
 //!
+//! mx6e_logging() から流量制限の判定後に呼び出す。
 //! @param [in] priority    syslog出力用
 //!      priorityとして設定できる値は以下とする
 //!       - { "alert",   LOG_ALERT },
@@ -67,7 +144,7 @@ void mx6e_initial_log(const char *name, const bool debuglog)
 //
 //! @return なし
 ////////////////////////////////////////////////////////////////////////////////
-void mx6e_logging(const int priority, const char *message, ...)
+void mx6e_logging_output(const int priority, const char *message, ...)
 {
 	va_list                         list;
 
@@ -77,3 +154,286 @@ void mx6e_logging(const int priority, const char *message, ...)
 
 	return;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+//! @brief 非同期ログレコード出力関数
+//!
+//! 格納時点のerrnoを復元してから書式化し、syslogへ出力する。
+//!
+//! @param [in] record  非同期ログレコード
+//!
+//! @return なし
+////////////////////////////////////////////////////////////////////////////////
+static void log_record_emit(const log_record_t * record)
+{
+	errno = record->err;
+	syslog(record->priority, record->message, record->arg[0], record->arg[1], record->arg[2], record->arg[3]);
+
+	return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! @brief 非同期ログリング出力関数
+//!
+//! 全リングの格納済みレコードを出力し、前回から増えた破棄数を通知する。
+//!
+//! @return なし
+////////////////////////////////////////////////////////////////////////////////
+static void log_ring_flush(void)
+{
+	int                             num = __atomic_load_n(&log_ring_num, __ATOMIC_ACQUIRE);
+	uint64_t                        dropped;
+
+	for (int i = 0; i < num; i++) {
+		log_ring_t                     *ring = &log_ring[i];
+		uint64_t                        head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+		while (ring->tail != head) {
+			log_record_emit(&ring->record[ring->tail & LOG_RING_MASK]);
+			__atomic_store_n(&ring->tail, ring->tail + 1, __ATOMIC_RELEASE);
+		}
+	}
+
+	dropped = mx6e_log_dropped();
+	if (dropped != log_dropped_reported) {
+		syslog(LOG_WARNING, "%lu log records dropped (log ring full)\n", (unsigned long) (dropped - log_dropped_reported));
+		log_dropped_reported = dropped;
+	}
+
+	return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! @brief ログ出力スレッド
+//!
+//! LOG_FLUSH_INTERVAL 毎に全リングを出力し、LOG_LIMIT_REPORT_INTERVAL 毎に
+//! 流量制限で抑止したログの要約を出力する。停止要求後は残りを出力して終了する。
+//!
+//! @param [in] arg     未使用
+//!
+//! @return NULL固定
+////////////////////////////////////////////////////////////////////////////////
+static void *log_thread(void *arg)
+{
+	time_t                          report = time(NULL);
+
+	while (!__atomic_load_n(&log_stop, __ATOMIC_ACQUIRE)) {
+		log_ring_flush();
+		if (time(NULL) - report >= LOG_LIMIT_REPORT_INTERVAL) {
+			mx6e_log_limit_report();
+			report = time(NULL);
+		}
+		usleep(LOG_FLUSH_INTERVAL);
+	}
+	log_ring_flush();
+	mx6e_log_limit_report();
+
+	return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! @brief ログ出力スレッド起動関数
+//!
+//! デーモン化(fork)の後に呼び出すこと。
+//! 起動に失敗した場合、非同期ログは同期的に出力される。
+//!
+//! @return true        起動成功
+//!         false       起動失敗
+////////////////////////////////////////////////////////////////////////////////
+bool mx6e_log_async_start(void)
+{
+	int                             ret;
+
+	if (log_running) {
+		return true;
+	}
+	log_stop = false;
+	ret = pthread_create(&log_tid, NULL, log_thread, NULL);
+	if (ret != 0) {
+		mx6e_logging(LOG_ERR, "fail to create log thread : %s\n", strerror(ret));
+		return false;
+	}
+	__atomic_store_n(&log_running, true, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! @brief ログ出力スレッド停止関数
+//!
+//! 格納済みのレコードを全て出力してからスレッドを停止する。
+//! 以降の非同期ログは同期的に出力される。
+//!
+//! @return なし
+////////////////////////////////////////////////////////////////////////////////
+void mx6e_log_async_stop(void)
+{
+	if (!log_running) {
+		return;
+	}
+	__atomic_store_n(&log_stop, true, __ATOMIC_RELEASE);
+	pthread_join(log_tid, NULL);
+	__atomic_store_n(&log_running, false, __ATOMIC_RELEASE);
+
+	return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! @brief 非同期ログリング割り当て関数
+//!
+//! 呼び出しスレッドに非同期ログリングを割り当てる。転送スレッドの開始時に呼び出す。
+//! 割り当てられなかったスレッドの非同期ログは同期的に出力される。
+//!
+//! @return true        割り当て成功
+//!         false       割り当て失敗(リング不足)
+////////////////////////////////////////////////////////////////////////////////
+bool mx6e_log_ring_register(void)
+{
+	int                             num;
+
+	if (log_ring_self != NULL) {
+		return true;
+	}
+	num = __atomic_load_n(&log_ring_num, __ATOMIC_RELAXED);
+	do {
+		if (num >= LOG_RING_THREAD_MAX) {
+			mx6e_logging(LOG_WARNING, "no more log ring. log synchronously\n");
+			return false;
+		}
+	} while (!__atomic_compare_exchange_n(&log_ring_num, &num, num + 1, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+	log_ring_self = &log_ring[num];
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! @brief 非同期ログ格納関数
+//!
+//! mx6e_logging_async() から呼び出す。呼び出しスレッドのリングにレコードを格納する。
+//! リングが満杯の場合はブロックせずに破棄数を計数する。
+//! リング未割り当て、またはログ出力スレッド未起動の場合は同期的に出力する。
+//!
+//! @param [in] priority    syslog優先度
+//! @param [in] message     書式(文字列リテラル)
+//! @param [in] arg         引数(LOG_ASYNC_ARG_MAX 個)
+//!
+//! @return なし
+////////////////////////////////////////////////////////////////////////////////
+void mx6e_log_enqueue(const int priority, const char *message, const long *arg)
+{
+	log_ring_t                     *ring = log_ring_self;
+	log_record_t                   *record;
+	uint64_t                        head;
+
+	if ((ring == NULL) || !__atomic_load_n(&log_running, __ATOMIC_ACQUIRE)) {
+		log_record_t                    sync = { priority, errno, message, {arg[0], arg[1], arg[2], arg[3]} };
+		log_record_emit(&sync);
+		return;
+	}
+
+	head = ring->head;
+	if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= LOG_RING_SIZE) {
+		__atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED);
+		return;
+	}
+	record = &ring->record[head & LOG_RING_MASK];
+	record->priority = priority;
+	record->err = errno;
+	record->message = message;
+	memcpy(record->arg, arg, sizeof(record->arg));
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+	return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! @brief 非同期ログ破棄数取得関数
+//!
+//! @return 全リングでリング満杯により破棄したレコード数の合計
+////////////////////////////////////////////////////////////////////////////////
+unsigned long mx6e_log_dropped(void)
+{
+	int                             num = __atomic_load_n(&log_ring_num, __ATOMIC_ACQUIRE);
+	unsigned long                   dropped = 0;
+
+	for (int i = 0; i < num; i++) {
+		dropped += __atomic_load_n(&log_ring[i].dropped, __ATOMIC_RELAXED);
+	}
+
+	return dropped;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! @brief ログ流量制限判定関数
+//!
+//! LOG_LIMIT_CHECK() から呼び出し箇所毎の状態を指定して呼び出す。
+//! ログ優先度毎の秒間件数/バースト件数によるトークンバケット(GCRA)で判定し、
+//! 超過した場合は抑止数を計数する。ロックを取らないので転送スレッドからも呼び出せる。
+//! デバッグログを出力しない設定の場合、デバッグログは syslog 側で破棄されるため計数しない。
+//!
+//! @param [in,out] limit       呼び出し箇所毎のログ流量制限状態
+//! @param [in]     priority    syslog優先度
+//!
+//! @return true        出力可
+//!         false       抑止
+////////////////////////////////////////////////////////////////////////////////
+bool mx6e_log_limit_check(mx6e_log_limit_t * limit, const int priority)
+{
+	int                             pri = LOG_PRI(priority);
+	struct timespec                 ts;
+	uint64_t                        now;
+	uint64_t                        interval;
+	uint64_t                        tau;
+	uint64_t                        tat;
+	uint64_t                        base;
+
+	if ((pri == LOG_DEBUG) && !__atomic_load_n(&log_debug, __ATOMIC_RELAXED)) {
+		return true;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+	now = (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	interval = 1000000000ULL / log_limit_class[pri].rate;
+	tau = interval * (log_limit_class[pri].burst - 1);
+
+	tat = __atomic_load_n(&limit->tat, __ATOMIC_RELAXED);
+	do {
+		base = (tat > now) ? tat : now;
+		if (base - now > tau) {
+			// 超過(抑止数を計数し、初回は要約出力対象リストに登録する)
+			__atomic_fetch_add(&limit->suppressed, 1, __ATOMIC_RELAXED);
+			if (!__atomic_exchange_n(&limit->listed, true, __ATOMIC_ACQ_REL)) {
+				mx6e_log_limit_t               *head = __atomic_load_n(&log_limit_list, __ATOMIC_RELAXED);
+				do {
+					limit->next = head;
+				} while (!__atomic_compare_exchange_n(&log_limit_list, &head, limit, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+			}
+			return false;
+		}
+	} while (!__atomic_compare_exchange_n(&limit->tat, &tat, base + interval, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! @brief 抑止ログ要約出力関数
+//!
+//! 前回の要約出力以降に流量制限で抑止したログの件数を、呼び出し箇所毎に出力する。
+//! ログ出力スレッドから LOG_LIMIT_REPORT_INTERVAL 毎に呼び出される。
+//!
+//! @return なし
+////////////////////////////////////////////////////////////////////////////////
+void mx6e_log_limit_report(void)
+{
+	mx6e_log_limit_t               *limit = __atomic_load_n(&log_limit_list, __ATOMIC_ACQUIRE);
+
+	for (; limit != NULL; limit = limit->next) {
+		unsigned long                   suppressed = __atomic_exchange_n(&limit->suppressed, 0, __ATOMIC_RELAXED);
+		if (suppressed > 0) {
+			syslog(LOG_WARNING, "%s(%d): %lu messages suppressed\n", limit->file, limit->line, suppressed);
+		}
+	}
+
+	return;
+}
@@ -11,6 +11,36 @@
 #   include <syslog.h>
 #   include <stdbool.h>
 #   include <stdarg.h>
+#   include <stdint.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// 外部構造体定義
+///////////////////////////////////////////////////////////////////////////////
+//! 呼び出し箇所毎のログ流量制限状態(LOG_LIMIT_CHECK が呼び出し箇所毎に静的に確保する)
+typedef struct mx6e_log_limit_s {
+	uint64_t                        tat;			///< 次に許容する時刻[nsec](GCRA形式のトークンバケット)
+	unsigned long                   suppressed;		///< 抑止したログ数(要約出力で0に戻す)
+	bool                            listed;			///< 要約出力対象リストに登録済みかどうか
+	const char                     *file;			///< 呼び出し元ファイル名
+	int                             line;			///< 呼び出し元行番号
+	struct mx6e_log_limit_s        *next;			///< 要約出力対象リストの次要素
+} mx6e_log_limit_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// 外部マクロ定義
+///////////////////////////////////////////////////////////////////////////////
+//! 抑止したログの要約を出力する周期[sec]
+#   define LOG_LIMIT_REPORT_INTERVAL  10
+
+//! 呼び出し箇所毎のログ流量制限判定マクロ(true:出力可、false:抑止)
+//! 流量(秒間件数/バースト件数)はログ優先度毎に mx6eapp_log.c で定義する。
+#   define LOG_LIMIT_CHECK(priority) \
+        ({ static mx6e_log_limit_t __log_limit = { .file = __FILE__, .line = __LINE__ }; \
+           mx6e_log_limit_check(&__log_limit, (priority)); })
+
+//! syslogへのログ出力マクロ(呼び出し箇所毎に流量を制限する)
+#   define mx6e_logging(priority, ...) \
+        (LOG_LIMIT_CHECK(priority) ? mx6e_logging_output((priority), __VA_ARGS__) : (void) 0)
 
 // 経路同期用デバッグマクロを追加
 
@@ -27,7 +57,7 @@
 #   	ifdef	DEBUG
 #   	define   DEBUG_LOG(...) _DEBUG_LOG(__FILE__, __LINE__, __VA_ARGS__)
 #   	define  _DEBUG_LOG(FILE, LINE, ...) __DEBUG_LOG(FILE, LINE, __VA_ARGS__)
-#   		define __DEBUG_LOG(FILE, LINE, ...) mx6e_logging(LOG_DEBUG, FILE "(" #LINE ") " __VA_ARGS__), printf(FILE "(" #LINE ") " __VA_ARGS__)
+#   		define __DEBUG_LOG(FILE, LINE, ...) (LOG_LIMIT_CHECK(LOG_DEBUG) ? (mx6e_logging_output(LOG_DEBUG, FILE "(" #LINE ") " __VA_ARGS__), (void) printf(FILE "(" #LINE ") " __VA_ARGS__)) : (void) 0)
 #   	else
 #   	define DEBUG_LOG(...)
 #endif
@@ -46,11 +76,28 @@
 #   define _D_(x)
 #endif
 
+//! 非同期ログ1件あたりの最大引数数
+#   define LOG_ASYNC_ARG_MAX      4
+
+//! 非同期ログ出力マクロ(転送処理などの高頻度経路用)
+//! ログ出力スレッドで書式化して出力するため、呼び出し元はレコードを格納するのみでブロックしない。
+//! 書式は文字列リテラルとし、引数は long に変換して格納するため %ld/%lu/%lx のみ使用できる
+//! (文字列引数は不可)。errno は格納時点の値を %m で出力できる。
+#   define mx6e_logging_async(priority, message, ...) \
+        (LOG_LIMIT_CHECK(priority) ? mx6e_log_enqueue((priority), (message), (const long[LOG_ASYNC_ARG_MAX]){ __VA_ARGS__ }) : (void) 0)
+
 ///////////////////////////////////////////////////////////////////////////////
 // 外部関数プロトタイプ
 ///////////////////////////////////////////////////////////////////////////////
 void                            mx6e_initial_log(const char *name, const bool debuglog);
-void                            mx6e_logging(const int priority, const char *message, ...);
+void                            mx6e_logging_output(const int priority, const char *message, ...);
+bool                            mx6e_log_limit_check(mx6e_log_limit_t * limit, const int priority);
+void                            mx6e_log_limit_report(void);
+bool                            mx6e_log_async_start(void);
+void                            mx6e_log_async_stop(void);
+bool                            mx6e_log_ring_register(void);
+void                            mx6e_log_enqueue(const int priority, const char *message, const long *arg);
+unsigned long                   mx6e_log_dropped(void);
 
 
 #   endif													// __MX6EAPP_LOG_H__
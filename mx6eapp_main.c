@@ -27,12 +27,14 @@
 #include "mx6eapp_setup.h"
 #include "mx6eapp_statistics.h"
 #include "mx6eapp_dynamic_setting.h"
-#include "mx6eapp_ct.h"
+#include "mx6eapp_pt.h"
+#include "mx6eapp_handover.h"
 
 //! コマンドオプション構造体 see getopt(3)
 // *INDENT-OFF*
 static const struct option      options[] = {
 	{"file",	required_argument,	NULL, 'f'},
+	{"hot-restart",	no_argument,		NULL, 'r'},
 	{"help",	no_argument,		NULL, 'h'},
 	{"usage",	no_argument,		NULL, 'h'},
 	{0, 0, 0, 0}
@@ -50,7 +52,8 @@ static const struct option      options[] = {
 ///////////////////////////////////////////////////////////////////////////////
 static void usage(void)
 {
-	fprintf(stderr, "Usage: mx6eapp { -f | --file } CONFIG_FILE \n" "       mx6eapp { -h | --help | --usage }\n" "\n");
+	fprintf(stderr, "Usage: mx6eapp { -f | --file } CONFIG_FILE [ -r | --hot-restart ]\n" "       mx6eapp { -h | --help | --usage }\n" "\n"
+			"  -r, --hot-restart : take over tunnel devices and tables from the running process\n" "\n");
 
 	return;
 }
@@ -70,11 +73,8 @@ int main(int argc, char *argv[])
 	pthread_t                       pr_tid = 0;
 	int fpt_result = -1;
 	int prt_result = -1;
-
-#if defined(CT)
-	// 単体用
-	ct(&handler);
-#endif
+	bool                            hot_restart = false;
+	int                             handover_fd = -1;
 
 	ret = 0;
 	conf_file = NULL;
@@ -82,7 +82,7 @@ int main(int argc, char *argv[])
 
 	// 引数チェック
 	while (true) {
-		int                             c = getopt_long(argc, argv, "f:h", options, &option_index);
+		int                             c = getopt_long(argc, argv, "f:hr", options, &option_index);
 		if (c == -1)
 			break;
 
@@ -91,6 +91,10 @@ int main(int argc, char *argv[])
 			conf_file = optarg;
 			break;
 
+		case 'r':
+			hot_restart = true;
+			break;
+
 		case 'h':
 			usage();
 			exit(EXIT_SUCCESS);	// 終了
@@ -149,14 +153,64 @@ int main(int argc, char *argv[])
 			return -1;
 		}
 	}
+	// ログ出力スレッド起動(転送スレッドのログを非同期に出力する。デーモン化の後に起動すること)
+	mx6e_log_async_start();
+
 	// 統計情報初期化
 	mx6e_initial_statistics(&handler.stat_info);
 
-	// ネットワークデバイス生成
-	if (mx6e_create_network_device(&handler) != 0) {
+	// 破棄パケット採取リング初期化
+	if (!mx6e_drop_init(&handler.drop_fp) || !mx6e_drop_init(&handler.drop_pr)) {
+		mx6e_drop_destruct(&handler.drop_fp);
+		mx6e_config_destruct(&handler.conf);
+		return -1;
+	}
+
+	// 宛先/64別負荷集計初期化
+	mx6e_topk_init(&handler.topk_fp);
+	mx6e_topk_init(&handler.topk_pr);
+
+	// エントリ未登録宛先集計初期化
+	mx6e_miss_init(&handler.miss_fp, DOMAIN_FP, handler.conf.general.miss_prefix_len);
+	mx6e_miss_init(&handler.miss_pr, DOMAIN_PR, handler.conf.general.miss_prefix_len);
+
+	// 転送スレッド性能カウンタ初期化(カウンタは各スレッドが作成する)
+	mx6e_perf_init(&handler.perf_fp);
+	mx6e_perf_init(&handler.perf_pr);
+
+	// パケットI/O初期化(オープンはトンネルデバイスの準備後に行う)
+	mx6e_tunnel_io_init(&handler);
+
+	// 経路設定ワーカ起動(失敗した場合は要求元で同期的に経路を設定する)
+	mx6e_route_init(&handler.route, handler.conf.general.route_aggregate);
+	handler.route.offline = !handler.conf.general.route_install;
+	mx6e_route_start(&handler.route);
+
+	// ホットリスタートの引き継ぎ状態初期化
+	handler.handover = MX6E_HANDOVER_NONE;
+
+	// テーブルスナップショット保存状態初期化
+	mx6e_snapshot_init(&handler.snapshot);
+
+	// ネットワークデバイス生成(ホットリスタートの場合は稼働中のプロセスから引き継ぐ)
+	if (hot_restart) {
+		handover_fd = mx6e_handover_receive(&handler);
+		ret = (handover_fd < 0) ? -1 : 0;
+	} else {
+		ret = mx6e_create_network_device(&handler);
+	}
+	if (ret != 0) {
 		mx6e_logging(LOG_ERR, "fail to netowrk device\n");
 		// 後始末
+		mx6e_drop_destruct(&handler.drop_fp);
+		mx6e_drop_destruct(&handler.drop_pr);
+		if (handler.handover == MX6E_HANDOVER_TAKING) {
+			// 稼働中のプロセスが運用を継続するので経路に触れない
+			m46e_pt_release_config_table(&handler.conf.m46e_conf_table);
+			m46e_pt_release_config_table(&handler.conf.me6e_conf_table);
+		}
 		mx6e_config_destruct(&handler.conf);
+		mx6e_route_stop(&handler.route);
 		return -1;
 	}
 	////////////////////////////////////////////////////////////////////////
@@ -174,6 +228,19 @@ int main(int argc, char *argv[])
 		goto proc_end;
 	}
 	////////////////////////////////////////////////////////////////////////
+	// 転送方向毎のパケットI/Oオープン
+	if (!mx6e_tunnel_io_open(&handler)) {
+		// 異常終了
+		ret = -1;
+		goto proc_end;
+	}
+	////////////////////////////////////////////////////////////////////////
+
+	// 前回保存したテーブルスナップショットを復元
+	// (ホットリスタートの場合は稼働中のプロセスからテーブルを引き継ぎ済み)
+	if (!hot_restart) {
+		mx6e_snapshot_restore(&handler.snapshot, &handler.conf);
+	}
 
 	// FP->PR パケット送受信スレッド起動
 	if (0 != (fpt_result = pthread_create(&fp_tid, NULL, mx6e_tunnel_fp_thread, &handler))) {
@@ -183,10 +250,25 @@ int main(int argc, char *argv[])
 	if (0 != (prt_result = pthread_create(&pr_tid, NULL, mx6e_tunnel_pr_thread, &handler))) {
 		mx6e_logging(LOG_ERR, "fail to create IPv6 tunnel thread : %s\n", strerror(errno));
 	}
+	// 引き継ぎ元のプロセスに転送開始を通知(通知後、引き継ぎ元は経路に触れずに終了する)
+	if (handover_fd >= 0) {
+		int                             result = (fpt_result != 0) ? fpt_result : prt_result;
+		if (!mx6e_handover_complete(handover_fd, result) || (result != 0)) {
+			// 異常終了
+			ret = -1;
+			goto proc_end;
+		}
+		handler.handover = MX6E_HANDOVER_TAKEN;
+	}
 	// コマンド処理ループ
 	DEBUG_LOG("mx6e_pt_mainloop start");
 	mx6e_pt_mainloop(&handler);
 
+	// テーブルスナップショット保存(新プロセスへ引き継いだ場合は新プロセスが保存する)
+	if (handler.handover != MX6E_HANDOVER_GIVEN) {
+		mx6e_snapshot_save(&handler.snapshot, &handler.conf);
+	}
+
   proc_end:
 	if (0 == fpt_result) {
 		// FPスレッドの取り消し
@@ -206,9 +288,26 @@ int main(int argc, char *argv[])
 		DEBUG_LOG("IPv6 PR thread done.");
 	}
 
+	mx6e_tunnel_io_release(&handler);
+	mx6e_perf_close(&handler.perf_fp);
+	mx6e_perf_close(&handler.perf_pr);
+	mx6e_drop_destruct(&handler.drop_fp);
+	mx6e_drop_destruct(&handler.drop_pr);
+
+	if ((handler.handover == MX6E_HANDOVER_TAKING) || (handler.handover == MX6E_HANDOVER_GIVEN)) {
+		// 経路は引き継ぎ先(または引き継ぎ元)のプロセスが使用しているので削除しない
+		m46e_pt_release_config_table(&handler.conf.m46e_conf_table);
+		m46e_pt_release_config_table(&handler.conf.me6e_conf_table);
+	}
 	mx6e_config_destruct(&handler.conf);
 
+	// 経路削除要求を送信し終えてから経路設定ワーカを停止する
+	mx6e_route_stop(&handler.route);
+
 	mx6e_logging(LOG_INFO, "MX6E application finish!!\n");
 	DEBUG_LOG("MX6E application finish!!");
+
+	// 格納済みの非同期ログを出力してからログ出力スレッドを停止する
+	mx6e_log_async_stop();
 	return ret;
 }
@@ -0,0 +1,266 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_miss.c                                                */
+/* 機能概要   : エントリ未登録宛先集計 ソースファイル                         */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <arpa/inet.h>
+
+#include "mx6eapp_miss.h"
+#include "mx6eapp_util.h"
+
+#define DPRINTF(fd, ...)	if (0 > fd) {printf(__VA_ARGS__);} else {dprintf(fd, __VA_ARGS__);}
+
+//! 集計テーブルのマスク
+#define MISS_TABLE_MASK         (MISS_TABLE_SIZE - 1)
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! 出力用に読み出したエントリ
+typedef struct {
+	domain_t                        domain;			///< ドメイン
+	int                             prefix_len;		///< プレフィックス長
+	mx6e_miss_entry_t               entry;			///< エントリの写し
+} miss_record_t;
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 集計位置算出関数
+//!
+//! @param [in] prefix プレフィックス
+//!
+//! @return 集計位置
+///////////////////////////////////////////////////////////////////////////////
+static inline unsigned int miss_hash(const struct in6_addr *prefix)
+{
+	uint32_t                        h = 2166136261U;
+
+	for (int i = 0; i < 4; i++) {
+		h = (h ^ prefix->s6_addr32[i]) * 16777619U;
+	}
+
+	return (h ^ (h >> 16)) & MISS_TABLE_MASK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 未登録宛先集計初期化関数
+//!
+//! @param [out] table      未登録宛先集計テーブル
+//! @param [in]  domain     集計対象ドメイン
+//! @param [in]  prefix_len 集計単位のプレフィックス長
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_miss_init(mx6e_miss_table_t * table, domain_t domain, int prefix_len)
+{
+	memset(table, 0, sizeof(mx6e_miss_table_t));
+	table->domain = domain;
+	table->prefix_len = prefix_len;
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 集計単位プレフィックス長変更関数
+//!
+//! 設定再読み込み時に呼び出す。変更前に集計したエントリはそのまま残し、
+//! 以降の記録から新しいプレフィックス長で集計する。
+//!
+//! @param [in,out] table      未登録宛先集計テーブル
+//! @param [in]     prefix_len 集計単位のプレフィックス長
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_miss_set_prefix_len(mx6e_miss_table_t * table, int prefix_len)
+{
+	__atomic_store_n(&table->prefix_len, prefix_len, __ATOMIC_RELAXED);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 未登録宛先記録関数
+//!
+//! 宛先アドレスを集計単位のプレフィックスに丸めて計数する。
+//! 探索範囲内に該当も空きも無い場合は、最終検出時刻が最も古いエントリを
+//! 置き換える。
+//!
+//! @param [in,out] table 未登録宛先集計テーブル
+//! @param [in]     dst   宛先アドレス
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_miss_record(mx6e_miss_table_t * table, const struct in6_addr *dst)
+{
+	struct in6_addr                 prefix;
+	unsigned int                    hash;
+	int                             victim = -1;
+	time_t                          now = time(NULL);
+	mx6e_miss_entry_t              *e;
+	uint32_t                        seq;
+	int                             prefix_len = __atomic_load_n(&table->prefix_len, __ATOMIC_RELAXED);
+
+	// プレフィックス長で丸める
+	for (int i = 0; i < 16; i++) {
+		int                             bits = prefix_len - i * 8;
+		if (bits >= 8) {
+			prefix.s6_addr[i] = dst->s6_addr[i];
+		} else if (bits > 0) {
+			prefix.s6_addr[i] = dst->s6_addr[i] & (0xff << (8 - bits));
+		} else {
+			prefix.s6_addr[i] = 0;
+		}
+	}
+
+	hash = miss_hash(&prefix);
+	for (int i = 0; i < MISS_PROBE_MAX; i++) {
+		int                             pos = (hash + i) & MISS_TABLE_MASK;
+		e = &table->entry[pos];
+
+		if (e->seq == 0) {
+			// 空き
+			victim = pos;
+			break;
+		}
+		if ((e->prefix_len == prefix_len) && IN6_ARE_ADDR_EQUAL(&e->prefix, &prefix)) {
+			e->count++;
+			e->last = now;
+			return;
+		}
+		if ((victim < 0) || (e->last < table->entry[victim].last)) {
+			victim = pos;
+		}
+	}
+
+	e = &table->entry[victim];
+	if (e->seq != 0) {
+		table->evict++;
+	}
+
+	// 書き込み開始(奇数)
+	seq = e->seq;
+	__atomic_store_n(&e->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	e->prefix = prefix;
+	e->prefix_len = prefix_len;
+	e->count = 1;
+	e->first = now;
+	e->last = now;
+
+	// 書き込み完了(偶数)
+	__atomic_store_n(&e->seq, seq + 2, __ATOMIC_RELEASE);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 集計テーブル読み出し関数
+//!
+//! 書き込み中のエントリは読み捨てる。
+//!
+//! @param [in]  table  未登録宛先集計テーブル
+//! @param [out] record 出力用配列
+//!
+//! @return 読み出したエントリ数
+///////////////////////////////////////////////////////////////////////////////
+static int miss_table_read(mx6e_miss_table_t * table, miss_record_t * record)
+{
+	int                             num = 0;
+
+	for (int i = 0; i < MISS_TABLE_SIZE; i++) {
+		mx6e_miss_entry_t              *e = &table->entry[i];
+		uint32_t                        seq1;
+		uint32_t                        seq2;
+
+		seq1 = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+		if ((seq1 == 0) || (seq1 & 1)) {
+			continue;
+		}
+		record[num].entry = *e;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		seq2 = __atomic_load_n(&e->seq, __ATOMIC_RELAXED);
+		if (seq1 != seq2) {
+			continue;
+		}
+		record[num].domain = table->domain;
+		record[num].prefix_len = record[num].entry.prefix_len;
+		num++;
+	}
+
+	return num;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 未登録パケット数降順比較関数(qsort用)
+///////////////////////////////////////////////////////////////////////////////
+static int miss_record_compare(const void *a, const void *b)
+{
+	const miss_record_t            *ra = (const miss_record_t *) a;
+	const miss_record_t            *rb = (const miss_record_t *) b;
+
+	if (ra->entry.count != rb->entry.count) {
+		return (ra->entry.count > rb->entry.count) ? -1 : 1;
+	}
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 未登録宛先集計出力関数
+//!
+//! FP/PRの集計を合わせ、未登録パケット数の降順で出力する。
+//!
+//! @param [in] fp_table FP側未登録宛先集計テーブル
+//! @param [in] pr_table PR側未登録宛先集計テーブル
+//! @param [in] fd       出力先のディスクリプタ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_miss_print(mx6e_miss_table_t * fp_table, mx6e_miss_table_t * pr_table, int fd)
+{
+	miss_record_t                  *record;
+	int                             num;
+	char                            address[INET6_ADDRSTRLEN];
+	char                            prefix[INET6_ADDRSTRLEN + 4];
+	char                            first[32];
+	char                            last[32];
+	struct tm                       tm;
+
+	record = (miss_record_t *) malloc(sizeof(miss_record_t) * MISS_TABLE_SIZE * 2);
+	if (record == NULL) {
+		DPRINTF(fd, "memory allocation failed\n");
+		return;
+	}
+
+	num = miss_table_read(fp_table, record);
+	num += miss_table_read(pr_table, &record[num]);
+	qsort(record, num, sizeof(miss_record_t), miss_record_compare);
+
+	DPRINTF(fd, "【MX6E lookup miss】\n");
+	DPRINTF(fd, "\n");
+	DPRINTF(fd, "%-3s %-44s %14s  %-19s  %-19s\n", "dom", "destination", "count", "first seen", "last seen");
+	for (int i = 0; i < num; i++) {
+		inet_ntop(AF_INET6, &record[i].entry.prefix, address, sizeof(address));
+		snprintf(prefix, sizeof(prefix), "%s/%d", address, record[i].prefix_len);
+		localtime_r(&record[i].entry.first, &tm);
+		strftime(first, sizeof(first), "%Y-%m-%d %H:%M:%S", &tm);
+		localtime_r(&record[i].entry.last, &tm);
+		strftime(last, sizeof(last), "%Y-%m-%d %H:%M:%S", &tm);
+		DPRINTF(fd, "%-3s %-44s %14lu  %-19s  %-19s\n", get_domain_name(record[i].domain), prefix,
+				(unsigned long) record[i].entry.count, first, last);
+	}
+	DPRINTF(fd, "\n");
+	DPRINTF(fd, "evicted entries : FP %lu, PR %lu\n", (unsigned long) fp_table->evict, (unsigned long) pr_table->evict);
+	DPRINTF(fd, "\n");
+
+	free(record);
+
+	return;
+}
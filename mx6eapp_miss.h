@@ -0,0 +1,54 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_miss.h                                                */
+/* 機能概要   : エントリ未登録宛先集計 ヘッダファイル                         */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+#ifndef __MX6EAPP_MISS_H__
+#   define __MX6EAPP_MISS_H__
+
+#   include <stdint.h>
+#   include <time.h>
+#   include <netinet/in.h>
+
+#   include "mx6eapp_config.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! 1スレッドあたりの集計エントリ数(2のべき乗)
+#   define MISS_TABLE_SIZE         256
+//! 登録位置の探索範囲(範囲内に空きが無ければ最も古いエントリを置き換える)
+#   define MISS_PROBE_MAX          8
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! 集計エントリ
+typedef struct {
+	uint32_t                        seq;			///< 更新シーケンス(奇数:書き込み中、0:未使用)
+	struct in6_addr                 prefix;			///< 宛先プレフィックス
+	int                             prefix_len;		///< 宛先プレフィックス長(集計時点の値)
+	uint64_t                        count;			///< 未登録パケット数
+	time_t                          first;			///< 初回検出時刻
+	time_t                          last;			///< 最終検出時刻
+} mx6e_miss_entry_t;
+
+//! エントリ未登録宛先集計テーブル(書き込みは転送スレッドのみ)
+typedef struct {
+	domain_t                        domain;			///< 集計対象ドメイン
+	int                             prefix_len;		///< 集計単位のプレフィックス長(設定再読み込みで変更)
+	uint64_t                        evict;			///< 置き換えたエントリ数
+	mx6e_miss_entry_t               entry[MISS_TABLE_SIZE];	///< 集計エントリ
+} mx6e_miss_table_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部関数プロトタイプ宣言
+////////////////////////////////////////////////////////////////////////////////
+void                            mx6e_miss_init(mx6e_miss_table_t * table, domain_t domain, int prefix_len);
+void                            mx6e_miss_set_prefix_len(mx6e_miss_table_t * table, int prefix_len);
+void                            mx6e_miss_record(mx6e_miss_table_t * table, const struct in6_addr *dst);
+void                            mx6e_miss_print(mx6e_miss_table_t * fp_table, mx6e_miss_table_t * pr_table, int fd);
+
+#endif												// __MX6EAPP_MISS_H__
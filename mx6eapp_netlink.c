@@ -13,6 +13,7 @@
 #include <errno.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
 
 #include "mx6eapp_netlink.h"
 #include "mx6eapp_log.h"
@@ -504,3 +505,289 @@ int mx6e_netlink_parse_ack(struct nlmsghdr *nlmsg_h, int *errcd, void *data)
 	/* Unexpected  messege */
 	return RESULT_SKIP_NLMSG;
 }
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief  netlink一括送信チャネル初期化関数
+//!
+//! 未オープン状態に初期化する。ソケットは生成しない。
+//!
+//! @param [out]   batch           一括送信チャネル
+//!
+//! @return none
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_netlink_batch_init(mx6e_netlink_batch_t * batch)
+{
+	memset(batch, 0, sizeof(*batch));
+	batch->sock_fd = -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief  netlink一括送信チャネルOPEN
+//!
+//! NETLINK_ROUTEソケットを生成し、プロセス終了まで使い回す。
+//! 一括送信した要求のACKを取りこぼさないよう受信バッファを拡張し、
+//! NACKに元メッセージのペイロードを含めないよう設定する。
+//!
+//! @param [in,out] batch          一括送信チャネル
+//! @param [out]    errcd          detail error code
+//!
+//! @return result code
+//! @retval RESULT_OK          normal end
+//! @retval RESULT_SYSCALL_NG  system call error
+//! @retval RESULT_NG          another error
+///////////////////////////////////////////////////////////////////////////////
+int mx6e_netlink_batch_open(mx6e_netlink_batch_t * batch, int *errcd)
+{
+	int                             ret;
+	int                             rcvbuf = NETLINK_BATCH_RCVBUF;
+
+	mx6e_netlink_batch_init(batch);
+
+	ret = mx6e_netlink_open(0, &batch->sock_fd, &batch->local, &batch->seq, errcd);
+	if (ret != RESULT_OK) {
+		batch->sock_fd = -1;
+		return ret;
+	}
+	fcntl(batch->sock_fd, F_SETFD, FD_CLOEXEC);
+
+	// rmem_maxを超えて拡張できない場合は上限値で妥協する
+	if (setsockopt(batch->sock_fd, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf)) < 0) {
+		setsockopt(batch->sock_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+	}
+#ifdef NETLINK_CAP_ACK
+	{
+		int                             on = 1;
+		setsockopt(batch->sock_fd, SOL_NETLINK, NETLINK_CAP_ACK, &on, sizeof(on));
+	}
+#endif
+
+	batch->sndbuf = malloc(NETLINK_BATCH_BUF);
+	batch->rcvbuf = malloc(NETLINK_RCVBUF);
+	if ((batch->sndbuf == NULL) || (batch->rcvbuf == NULL)) {
+		*errcd = errno;
+		mx6e_logging(LOG_ERR, "netlink batch buffer malloc ng. errno=%d\n", errno);
+		mx6e_netlink_batch_close(batch);
+		return RESULT_SYSCALL_NG;
+	}
+	batch->first_seq = batch->seq;
+
+	return RESULT_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief  netlink一括送信チャネルCLOSE
+//!
+//! 送信待ちのメッセージは破棄する。
+//!
+//! @param [in,out] batch          一括送信チャネル
+//!
+//! @return none
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_netlink_batch_close(mx6e_netlink_batch_t * batch)
+{
+	if (batch->sock_fd >= 0) {
+		mx6e_netlink_close(batch->sock_fd);
+	}
+	free(batch->sndbuf);
+	free(batch->rcvbuf);
+	mx6e_netlink_batch_init(batch);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief  netlinkメッセージ一括送信登録
+//!
+//! メッセージにシーケンス番号とNLM_F_ACKを設定して送信待ちバッファに追加する。
+//! バッファが満杯の場合は、先に送信待ちメッセージを送信する。
+//!
+//! @param [in,out] batch          一括送信チャネル
+//! @param [in,out] nlm            Netlink message
+//! @param [in]     tag            結果通知関数に渡すタグ
+//! @param [out]    errcd          detail error code
+//!
+//! @return result code
+//! @retval RESULT_OK          normal end
+//! @retval RESULT_SYSCALL_NG  system call error
+//! @retval RESULT_NG          another error
+///////////////////////////////////////////////////////////////////////////////
+int mx6e_netlink_batch_add(mx6e_netlink_batch_t * batch, struct nlmsghdr *nlm, void *tag, int *errcd)
+{
+	int                             len = NLMSG_ALIGN(nlm->nlmsg_len);
+	int                             ret;
+
+	if (batch->sock_fd < 0) {
+		*errcd = EBADF;
+		return RESULT_NG;
+	}
+	if (len > NETLINK_BATCH_BUF) {
+		*errcd = EMSGSIZE;
+		mx6e_logging(LOG_ERR, "Netlink message is too long for batch. length=%d\n", nlm->nlmsg_len);
+		return RESULT_NG;
+	}
+
+	if ((batch->num >= NETLINK_BATCH_MSG_MAX) || (batch->len + len > NETLINK_BATCH_BUF)) {
+		// 送信待ちの要求のNACKはbatch->failedに計上されるので、送受信異常のみ返す
+		ret = mx6e_netlink_batch_flush(batch, errcd);
+		if (ret == RESULT_SYSCALL_NG) {
+			return ret;
+		}
+	}
+
+	if (batch->num == 0) {
+		batch->first_seq = batch->seq;
+	}
+	nlm->nlmsg_seq = batch->seq++;
+	nlm->nlmsg_pid = 0;
+	nlm->nlmsg_flags |= NLM_F_ACK;
+
+	batch->tag[batch->num] = tag;
+	batch->acked[batch->num] = false;
+
+	memcpy(batch->sndbuf + batch->len, nlm, nlm->nlmsg_len);
+	memset(batch->sndbuf + batch->len + nlm->nlmsg_len, 0, len - nlm->nlmsg_len);
+	batch->len += len;
+	batch->num++;
+
+	return RESULT_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief  netlinkメッセージ一括送信
+//!
+//! 送信待ちメッセージを1回のsendmsgで送信し、全メッセージのACKを受信する。
+//! 応答はシーケンス番号で要求と対応付け、NACKの数をbatch->failedに加算する。
+//! 結果通知関数が登録されている場合は要求毎の結果を通知する。
+//! 送受信異常で応答を得られなかった要求には、そのエラー番号を通知する。
+//!
+//! @param [in,out] batch          一括送信チャネル
+//! @param [out]    errcd          detail error code(NACKの場合は最後のNACKのエラー番号)
+//!
+//! @return result code
+//! @retval RESULT_OK          normal end(全メッセージACK)
+//! @retval RESULT_SYSCALL_NG  system call error
+//! @retval RESULT_NG          NACK受信 or another error
+///////////////////////////////////////////////////////////////////////////////
+int mx6e_netlink_batch_flush(mx6e_netlink_batch_t * batch, int *errcd)
+{
+	struct sockaddr_nl              nladdr;
+	socklen_t                       nladdr_len;
+	struct iovec                    iov;
+	struct msghdr                   msg;
+	struct nlmsghdr                *nlmsg_h;
+	struct nlmsgerr                *nl_err;
+	uint32_t                        first_seq = batch->first_seq;
+	int                             num = batch->num;
+	int                             acked = 0;
+	int                             idx;
+	int                             err;
+	int                             status;
+	int                             ret = RESULT_OK;
+
+	if ((batch->sock_fd < 0) || (num == 0)) {
+		return RESULT_OK;
+	}
+
+	/* ------------------------------ */
+	/* Send netlink messages          */
+	/* ------------------------------ */
+	memset(&nladdr, 0, sizeof(nladdr));
+	nladdr.nl_family = AF_NETLINK;					/* To kernel */
+
+	iov.iov_base = batch->sndbuf;
+	iov.iov_len = batch->len;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_name = &nladdr;
+	msg.msg_namelen = sizeof(nladdr);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+
+	// 送信に失敗しても再送はしない
+	batch->len = 0;
+	batch->num = 0;
+
+	while (sendmsg(batch->sock_fd, &msg, 0) < 0) {
+		if (errno == EINTR) {
+			continue;
+		}
+		*errcd = errno;
+		mx6e_logging(LOG_ERR, "Cannot send netlink batch message. seq=%u,num=%d,errno=%d\n", first_seq, num, errno);
+		ret = RESULT_SYSCALL_NG;
+		goto notify;
+	}
+
+	/* ------------------------------ */
+	/* Recv multi-part ACK            */
+	/* ------------------------------ */
+	while (acked < num) {
+		nladdr_len = sizeof(nladdr);
+		status = recvfrom(batch->sock_fd, batch->rcvbuf, NETLINK_RCVBUF, 0, (struct sockaddr *) &nladdr, &nladdr_len);
+		if (status < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			// ENOBUFSの場合は応答を取りこぼしているため、残りの応答は待たない
+			*errcd = errno;
+			mx6e_logging(LOG_ERR, "Recieve netlink batch msg error. seq=%u,acked=%d/%d,errno=%d\n", first_seq, acked, num, errno);
+			ret = RESULT_SYSCALL_NG;
+			goto notify;
+		}
+		if (status == 0) {
+			mx6e_logging(LOG_ERR, "EOF on netlink. seq=%u\n", first_seq);
+			*errcd = EPIPE;
+			ret = RESULT_NG;
+			goto notify;
+		}
+
+		for (nlmsg_h = (struct nlmsghdr *) batch->rcvbuf; NLMSG_OK(nlmsg_h, status); nlmsg_h = NLMSG_NEXT(nlmsg_h, status)) {
+			// 以前の一括送信で取りこぼした応答等、今回の送信分以外は読み捨てる
+			if ((nladdr.nl_pid != 0) ||
+				(nlmsg_h->nlmsg_pid != batch->local.nl_pid) ||
+				((uint32_t) (nlmsg_h->nlmsg_seq - first_seq) >= (uint32_t) num) ||
+				(nlmsg_h->nlmsg_type != NLMSG_ERROR)) {
+				continue;
+			}
+			idx = nlmsg_h->nlmsg_seq - first_seq;
+			if (batch->acked[idx]) {
+				continue;
+			}
+			batch->acked[idx] = true;
+			acked++;
+
+			nl_err = (struct nlmsgerr *) NLMSG_DATA(nlmsg_h);
+			if (nlmsg_h->nlmsg_len < NLMSG_LENGTH(sizeof(struct nlmsgerr))) {
+				mx6e_logging(LOG_ERR, "Ack netlink message. payload is too short. seq=%u, length=%d\n", nlmsg_h->nlmsg_seq, nlmsg_h->nlmsg_len);
+				err = EPROTO;
+			} else if (nl_err->error != 0) {
+				err = -nl_err->error;
+				mx6e_logging(LOG_ERR, "Netlink batch request failed. seq=%u,type=%d : %s\n", nlmsg_h->nlmsg_seq, nl_err->msg.nlmsg_type, strerror(err));
+			} else {
+				err = 0;
+			}
+			if (err != 0) {
+				*errcd = err;
+				batch->failed++;
+				ret = RESULT_NG;
+			}
+			if (batch->result_func != NULL) {
+				batch->result_func(batch->tag[idx], err);
+			}
+		}
+	}
+
+	return ret;
+
+  notify:
+	// 応答を得られなかった要求は失敗として扱う
+	for (idx = 0; idx < num; idx++) {
+		if (batch->acked[idx]) {
+			continue;
+		}
+		batch->acked[idx] = true;
+		batch->failed++;
+		if (batch->result_func != NULL) {
+			batch->result_func(batch->tag[idx], *errcd);
+		}
+	}
+
+	return ret;
+}
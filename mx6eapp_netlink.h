@@ -9,6 +9,7 @@
 #   define __MX6EAPP_NETLINK_H__
 
 #   include <stdint.h>
+#   include <stdbool.h>
 #   include <sys/socket.h>
 #   include <linux/netlink.h>
 
@@ -24,6 +25,32 @@
 #   define NETLINK_RCVBUF (16*1024)
 #   define NETLINK_SNDBUF (16*1024)
 
+//! 一括送信バッファサイズ
+#   define NETLINK_BATCH_BUF     (64*1024)
+//! 一括送信で1回のsendmsgに格納する最大メッセージ数
+#   define NETLINK_BATCH_MSG_MAX 256
+//! 一括送信の応答受信用ソケットバッファサイズ
+#   define NETLINK_BATCH_RCVBUF  (1024*1024)
+
+//! 一括送信結果通知関数(要求毎に登録時のタグとエラー番号(0:ACK)を通知する)
+typedef void                    (*netlink_batch_result_func) (void *tag, int errcd);
+
+//! netlink一括送信チャネル
+typedef struct {
+	int                             sock_fd;		///< ソケットディスクリプタ(-1:未オープン)
+	struct sockaddr_nl              local;			///< ローカルアドレス
+	uint32_t                        seq;			///< 次に使用するシーケンス番号
+	uint32_t                        first_seq;		///< 送信待ちメッセージ先頭のシーケンス番号
+	char                           *sndbuf;		///< 送信待ちメッセージ格納バッファ
+	char                           *rcvbuf;		///< 応答受信バッファ
+	int                             len;			///< 送信待ちメッセージ長
+	int                             num;			///< 送信待ちメッセージ数
+	int                             failed;			///< NACK受信数(mx6e_netlink_batch_flushの度に加算)
+	netlink_batch_result_func       result_func;	///< 一括送信結果通知関数(NULL:通知しない)
+	void                           *tag[NETLINK_BATCH_MSG_MAX];	///< 送信待ちメッセージのタグ
+	bool                            acked[NETLINK_BATCH_MSG_MAX];	///< 応答受信済みフラグ
+} mx6e_netlink_batch_t;
+
 //! 受信データ解析関数
 typedef int                     (*netlink_parse_func) (struct nlmsghdr *, int *, void *);
 
@@ -40,5 +67,10 @@ struct rtattr                  *mx6e_netlink_attr_begin(struct nlmsghdr *n, int
 void                            mx6e_netlink_attr_end(struct nlmsghdr *n, struct rtattr *attr);
 int                             mx6e_netlink_parse_rtattr(struct rtattr *tb[], int max, struct rtattr *rta, int len);
 int                             mx6e_netlink_parse_ack(struct nlmsghdr *nlmsg_h, int *errcd, void *data);
+void                            mx6e_netlink_batch_init(mx6e_netlink_batch_t * batch);
+int                             mx6e_netlink_batch_open(mx6e_netlink_batch_t * batch, int *errcd);
+void                            mx6e_netlink_batch_close(mx6e_netlink_batch_t * batch);
+int                             mx6e_netlink_batch_add(mx6e_netlink_batch_t * batch, struct nlmsghdr *nlm, void *tag, int *errcd);
+int                             mx6e_netlink_batch_flush(mx6e_netlink_batch_t * batch, int *errcd);
 
 #endif												// __MX6EAPP_NETLINK_H__
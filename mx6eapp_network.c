@@ -34,6 +34,145 @@
 
 
 
+//! 経路設定メッセージ長(rtmsg + RTA_DST + RTA_GATEWAY + RTA_OIF)
+#define ROUTE_NLMSG_LEN    (NLMSG_SPACE(sizeof(struct rtmsg)) + 2 * RTA_SPACE(sizeof(struct in6_addr)) + RTA_SPACE(sizeof(int)))
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 経路設定メッセージ生成関数
+//!
+//! @param [out] nlmsg     メッセージ格納先(ROUTE_NLMSG_LENバイト)
+//! @param [in]  type      メッセージ種別(RTM_NEWROUTE or RTM_DELROUTE)
+//! @param [in]  family    アドレス種別(AF_INET or AF_INET6)
+//! @param [in]  ifindex   デバイスのインデックス番号
+//! @param [in]  dst       経路の送信先アドレス
+//! @param [in]  prefixlen 経路のプレフィックス長
+//! @param [in]  gw        経路のゲートウェイアドレス
+//!
+//! @retval 0     正常終了
+//! @retval 0以外 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static int network_route_message(struct nlmsghdr *nlmsg, const int type, const int family, const int ifindex, const void *dst, const int prefixlen, const void *gw)
+{
+	struct rtmsg                   *rt;
+	int                             addrlen = (family == AF_INET) ? sizeof(struct in_addr) : sizeof(struct in6_addr);
+
+	memset(nlmsg, 0, ROUTE_NLMSG_LEN);
+
+	rt = (struct rtmsg *) (((void *) nlmsg) + NLMSG_HDRLEN);
+	rt->rtm_family = family;
+	rt->rtm_table = RT_TABLE_MAIN;
+	rt->rtm_scope = RT_SCOPE_UNIVERSE;
+	rt->rtm_protocol = RTPROT_STATIC;
+	rt->rtm_type = RTN_UNICAST;
+	rt->rtm_dst_len = prefixlen;
+
+	nlmsg->nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+	nlmsg->nlmsg_type = type;
+	if (type == RTM_NEWROUTE) {
+		nlmsg->nlmsg_flags = NLM_F_REQUEST | NLM_F_CREATE | NLM_F_EXCL | NLM_F_ACK;
+	} else {
+		// 削除要求のNLM_F_EXCLはカーネルがNLM_F_BULKと解釈するので付けない
+		nlmsg->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+	}
+
+	if ((dst != NULL) && (mx6e_netlink_addattr_l(nlmsg, ROUTE_NLMSG_LEN, RTA_DST, dst, addrlen) != RESULT_OK)) {
+		mx6e_logging(LOG_ERR, "Netlink add attrubute error");
+		return ENOMEM;
+	}
+	if ((gw != NULL) && (mx6e_netlink_addattr_l(nlmsg, ROUTE_NLMSG_LEN, RTA_GATEWAY, gw, addrlen) != RESULT_OK)) {
+		mx6e_logging(LOG_ERR, "Netlink add attrubute error");
+		return ENOMEM;
+	}
+	if (mx6e_netlink_addattr_l(nlmsg, ROUTE_NLMSG_LEN, RTA_OIF, &ifindex, sizeof(ifindex)) != RESULT_OK) {
+		mx6e_logging(LOG_ERR, "Netlink add attrubute error");
+		return ENOMEM;
+	}
+
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 経路設定要求関数
+//!
+//! 経路設定メッセージを要求毎に生成したソケットで送信し、応答を待つ。
+//!
+//! @param [in]  type      メッセージ種別(RTM_NEWROUTE or RTM_DELROUTE)
+//! @param [in]  family    アドレス種別(AF_INET or AF_INET6)
+//! @param [in]  ifindex   デバイスのインデックス番号
+//! @param [in]  dst       経路の送信先アドレス
+//! @param [in]  prefixlen 経路のプレフィックス長
+//! @param [in]  gw        経路のゲートウェイアドレス
+//!
+//! @retval 0     正常終了
+//! @retval 0以外 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static int network_route_request(const int type, const int family, const int ifindex, const void *dst, const int prefixlen, const void *gw)
+{
+	char                            buf[ROUTE_NLMSG_LEN] __attribute__ ((aligned(NLMSG_ALIGNTO)));
+	struct nlmsghdr                *nlmsg = (struct nlmsghdr *) buf;
+	int                             sock_fd;
+	struct sockaddr_nl              local;
+	uint32_t                        seq;
+	int                             ret;
+	int                             errcd = 0;
+
+	_D_(printf("enter %s\n", __func__));
+
+	ret = network_route_message(nlmsg, type, family, ifindex, dst, prefixlen, gw);
+	if (ret != 0) {
+		return ret;
+	}
+
+	ret = mx6e_netlink_open(0, &sock_fd, &local, &seq, &errcd);
+	if (ret != RESULT_OK) {
+		// socket open error
+		mx6e_logging(LOG_ERR, "Netlink socket error errcd=%d", errcd);
+		return errcd;
+	}
+	ret = mx6e_netlink_transaction(sock_fd, &local, seq, nlmsg, &errcd);
+	mx6e_netlink_close(sock_fd);
+
+	_D_(printf("exit %s\n", __func__));
+	return (ret == RESULT_OK) ? 0 : errcd;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 経路設定一括送信登録関数
+//!
+//! 経路追加/削除メッセージを生成してnetlink一括送信チャネルの送信待ちに積む。
+//! 処理結果はmx6e_netlink_batch_flush時にチャネルの結果通知関数へ通知される。
+//!
+//! @param [in,out] channel   netlink一括送信チャネル
+//! @param [in]     add       true:経路追加、false:経路削除
+//! @param [in]     family    アドレス種別(AF_INET or AF_INET6)
+//! @param [in]     ifindex   デバイスのインデックス番号
+//! @param [in]     dst       経路の送信先アドレス
+//! @param [in]     prefixlen 経路のプレフィックス長
+//! @param [in]     gw        経路のゲートウェイアドレス
+//! @param [in]     tag       結果通知関数に渡すタグ
+//!
+//! @retval 0     正常終了
+//! @retval 0以外 異常終了
+///////////////////////////////////////////////////////////////////////////////
+int mx6e_network_route_queue(mx6e_netlink_batch_t * channel, const bool add, const int family, const int ifindex, const void *dst, const int prefixlen, const void *gw, void *tag)
+{
+	char                            buf[ROUTE_NLMSG_LEN] __attribute__ ((aligned(NLMSG_ALIGNTO)));
+	struct nlmsghdr                *nlmsg = (struct nlmsghdr *) buf;
+	int                             ret;
+	int                             errcd = 0;
+
+	ret = network_route_message(nlmsg, add ? RTM_NEWROUTE : RTM_DELROUTE, family, ifindex, dst, prefixlen, gw);
+	if (ret != 0) {
+		return ret;
+	}
+
+	if (mx6e_netlink_batch_add(channel, nlmsg, tag, &errcd) != RESULT_OK) {
+		return errcd;
+	}
+
+	return 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief フラグ取得関数(デバイス名)
 //!
@@ -433,87 +572,7 @@ int mx6e_network_del_gateway(const int family, const int ifindex, const void *gw
 ///////////////////////////////////////////////////////////////////////////////
 int mx6e_network_add_route(const int family, const int ifindex, const void *dst, const int prefixlen, const void *gw)
 {
-	struct nlmsghdr                *nlmsg;
-	struct rtmsg                   *rt;
-	int                             sock_fd;
-	struct sockaddr_nl              local;
-	uint32_t                        seq;
-	int                             ret;
-	int                             errcd;
-
-	_D_(printf("enter %s\n", __func__));
-
-	ret = mx6e_netlink_open(0, &sock_fd, &local, &seq, &errcd);
-	if (ret != RESULT_OK) {
-		// socket open error
-		mx6e_logging(LOG_ERR, "Netlink socket error errcd=%d", errcd);
-		return errcd;
-	}
-
-	nlmsg = malloc(NETLINK_SNDBUF);					// 16kbyte
-	if (nlmsg == NULL) {
-		mx6e_logging(LOG_ERR, "Netlink send buffur malloc NG : %s", strerror(errno));
-		mx6e_netlink_close(sock_fd);
-		return errno;
-	}
-
-	memset(nlmsg, 0, NETLINK_SNDBUF);
-
-	rt = (struct rtmsg *) (((void *) nlmsg) + NLMSG_HDRLEN);
-	rt->rtm_family = family;
-	rt->rtm_table = RT_TABLE_MAIN;
-	rt->rtm_scope = RT_SCOPE_UNIVERSE;
-	rt->rtm_protocol = RTPROT_STATIC;
-	rt->rtm_type = RTN_UNICAST;
-	rt->rtm_dst_len = prefixlen;
-
-	nlmsg->nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
-	nlmsg->nlmsg_flags = NLM_F_REQUEST | NLM_F_CREATE | NLM_F_EXCL | NLM_F_ACK;
-	nlmsg->nlmsg_type = RTM_NEWROUTE;
-
-	int                             addrlen = (family == AF_INET) ? sizeof(struct in_addr) : sizeof(struct in6_addr);
-
-	if (dst != NULL) {
-		ret = mx6e_netlink_addattr_l(nlmsg, NETLINK_SNDBUF, RTA_DST, dst, addrlen);
-		if (ret != RESULT_OK) {
-			mx6e_logging(LOG_ERR, "Netlink add attrubute error");
-			mx6e_netlink_close(sock_fd);
-			free(nlmsg);
-			return ENOMEM;
-		}
-	}
-
-	if (gw != NULL) {
-		ret = mx6e_netlink_addattr_l(nlmsg, NETLINK_SNDBUF, RTA_GATEWAY, gw, addrlen);
-		if (ret != RESULT_OK) {
-			mx6e_logging(LOG_ERR, "Netlink add attrubute error");
-			mx6e_netlink_close(sock_fd);
-			free(nlmsg);
-			return ENOMEM;
-		}
-	}
-
-	ret = mx6e_netlink_addattr_l(nlmsg, NETLINK_SNDBUF, RTA_OIF, &ifindex, sizeof(ifindex));
-	if (ret != RESULT_OK) {
-		mx6e_logging(LOG_ERR, "Netlink add attrubute error");
-		mx6e_netlink_close(sock_fd);
-		free(nlmsg);
-		return ENOMEM;
-	}
-
-	ret = mx6e_netlink_transaction(sock_fd, &local, seq, nlmsg, &errcd);
-	if (ret != RESULT_OK) {
-		mx6e_netlink_close(sock_fd);
-		free(nlmsg);
-		return errcd;
-	}
-
-	mx6e_netlink_close(sock_fd);
-	free(nlmsg);
-
-	_D_(printf("exit %s\n", __func__));
-
-	return 0;
+	return network_route_request(RTM_NEWROUTE, family, ifindex, dst, prefixlen, gw);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -535,86 +594,7 @@ int mx6e_network_add_route(const int family, const int ifindex, const void *dst,
 ///////////////////////////////////////////////////////////////////////////////
 int mx6e_network_del_route(const int family, const int ifindex, const void *dst, const int prefixlen, const void *gw)
 {
-	struct nlmsghdr                *nlmsg;
-	struct rtmsg                   *rt;
-	int                             sock_fd;
-	struct sockaddr_nl              local;
-	uint32_t                        seq;
-	int                             ret;
-	int                             errcd;
-
-	_D_(printf("enter %s\n", __func__));
-
-	ret = mx6e_netlink_open(0, &sock_fd, &local, &seq, &errcd);
-	if (ret != RESULT_OK) {
-		// socket open error
-		mx6e_logging(LOG_ERR, "Netlink socket error errcd=%d", errcd);
-		return errcd;
-	}
-
-	nlmsg = malloc(NETLINK_SNDBUF);					// 16kbyte
-	if (nlmsg == NULL) {
-		mx6e_logging(LOG_ERR, "Netlink send buffur malloc NG : %s", strerror(errno));
-		mx6e_netlink_close(sock_fd);
-		return errno;
-	}
-
-	memset(nlmsg, 0, NETLINK_SNDBUF);
-
-	rt = (struct rtmsg *) (((void *) nlmsg) + NLMSG_HDRLEN);
-	rt->rtm_family = family;
-	rt->rtm_table = RT_TABLE_MAIN;
-	rt->rtm_scope = RT_SCOPE_UNIVERSE;
-	rt->rtm_protocol = RTPROT_STATIC;
-	rt->rtm_type = RTN_UNICAST;
-	rt->rtm_dst_len = prefixlen;
-
-	nlmsg->nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
-	nlmsg->nlmsg_flags = NLM_F_REQUEST | NLM_F_EXCL | NLM_F_ACK;
-	nlmsg->nlmsg_type = RTM_DELROUTE;
-
-	int                             addrlen = (family == AF_INET) ? sizeof(struct in_addr) : sizeof(struct in6_addr);
-
-	if (dst != NULL) {
-		ret = mx6e_netlink_addattr_l(nlmsg, NETLINK_SNDBUF, RTA_DST, dst, addrlen);
-		if (ret != RESULT_OK) {
-			mx6e_logging(LOG_ERR, "Netlink add attrubute error");
-			mx6e_netlink_close(sock_fd);
-			free(nlmsg);
-			return ENOMEM;
-		}
-	}
-
-	if (gw != NULL) {
-		ret = mx6e_netlink_addattr_l(nlmsg, NETLINK_SNDBUF, RTA_GATEWAY, gw, addrlen);
-		if (ret != RESULT_OK) {
-			mx6e_logging(LOG_ERR, "Netlink add attrubute error");
-			mx6e_netlink_close(sock_fd);
-			free(nlmsg);
-			return ENOMEM;
-		}
-	}
-
-	ret = mx6e_netlink_addattr_l(nlmsg, NETLINK_SNDBUF, RTA_OIF, &ifindex, sizeof(ifindex));
-	if (ret != RESULT_OK) {
-		mx6e_logging(LOG_ERR, "Netlink add attrubute error");
-		mx6e_netlink_close(sock_fd);
-		free(nlmsg);
-		return ENOMEM;
-	}
-
-	ret = mx6e_netlink_transaction(sock_fd, &local, seq, nlmsg, &errcd);
-	if (ret != RESULT_OK) {
-		mx6e_netlink_close(sock_fd);
-		free(nlmsg);
-		return errcd;
-	}
-
-	mx6e_netlink_close(sock_fd);
-	free(nlmsg);
-
-	_D_(printf("exit %s\n", __func__));
-	return 0;
+	return network_route_request(RTM_DELROUTE, family, ifindex, dst, prefixlen, gw);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
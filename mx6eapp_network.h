@@ -9,7 +9,9 @@
 #   define __MX6EAPP_NETWORK_H__
 
 #   include <unistd.h>
+#   include <stdbool.h>
 #   	include "mx6eapp_config.h"
+#   	include "mx6eapp_netlink.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 // 外部関数プロトタイプ
@@ -36,6 +38,7 @@ int                             mx6e_network_add_gateway(const int family, const
 int                             mx6e_network_del_ipaddr(const int family, const int ifindex, const void *addr, const int prefixlen);
 int                             mx6e_network_del_route(const int family, const int ifindex, const void *dst, const int prefixlen, const void *gw);
 int                             mx6e_network_del_gateway(const int family, const int ifindex, const void *gw);
+int                             mx6e_network_route_queue(mx6e_netlink_batch_t * channel, const bool add, const int family, const int ifindex, const void *dst, const int prefixlen, const void *gw, void *tag);
 int                             mx6e_network_create_tap(const char *name, mx6e_device_t * tunnel_dev);
 
 #endif												// __MX6EAPP_NETWORK_H__
@@ -0,0 +1,248 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_perf.c                                                */
+/* 機能概要   : 転送スレッド性能カウンタ ソースファイル                       */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "mx6eapp_perf.h"
+#include "mx6eapp_log.h"
+
+#define DPRINTF(fd, ...)	if (0 > fd) {printf(__VA_ARGS__);} else {dprintf(fd, __VA_ARGS__);}
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! イベント定義
+typedef struct {
+	uint32_t                        type;			///< perf_event_attr.type
+	uint64_t                        config;			///< perf_event_attr.config
+	char                           *name;			///< イベント名
+} perf_event_def_t;
+
+//! カウンタ読み出し値(PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING)
+typedef struct {
+	uint64_t                        value;			///< カウント値
+	uint64_t                        time_enabled;	///< 有効時間
+	uint64_t                        time_running;	///< 計測時間
+} perf_read_format_t;
+
+// *INDENT-OFF*
+static const perf_event_def_t   perf_event_def[MX6E_PERF_EVENT_NUM] = {
+	{PERF_TYPE_HARDWARE,	PERF_COUNT_HW_CPU_CYCLES,			"cycles"},
+	{PERF_TYPE_HARDWARE,	PERF_COUNT_HW_INSTRUCTIONS,			"instructions"},
+	{PERF_TYPE_HARDWARE,	PERF_COUNT_HW_CACHE_MISSES,			"LLC misses"},
+	{PERF_TYPE_HARDWARE,	PERF_COUNT_HW_BRANCH_MISSES,		"branch misses"},
+	{PERF_TYPE_SOFTWARE,	PERF_COUNT_SW_CONTEXT_SWITCHES,		"context switches"},
+};
+// *INDENT-ON*
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief カウンタオープン関数
+//!
+//! 呼び出し元スレッドを対象とするカウンタを作成する。
+//! カーネル空間の計測が許可されない場合はユーザ空間のみで再試行する。
+//!
+//! @param [in] def イベント定義
+//!
+//! @return 生成したディスクリプタ(失敗時は-1)
+///////////////////////////////////////////////////////////////////////////////
+static int perf_event_open(const perf_event_def_t * def)
+{
+	struct perf_event_attr          attr;
+	int                             fd;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = def->type;
+	attr.config = def->config;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	attr.exclude_hv = 1;
+
+	fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+	if ((fd < 0) && ((errno == EACCES) || (errno == EPERM))) {
+		attr.exclude_kernel = 1;
+		fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+	}
+
+	return fd;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief カウンタ読み出し関数
+//!
+//! 多重化で計測時間が有効時間より短い場合は有効時間に換算する。
+//!
+//! @param [in]  fd    カウンタのディスクリプタ
+//! @param [out] value カウント値
+//!
+//! @return true  正常
+//!         false 異常(未採取または読み出し失敗)
+///////////////////////////////////////////////////////////////////////////////
+static bool perf_event_read(int fd, double *value)
+{
+	perf_read_format_t              data;
+
+	if (fd < 0) {
+		return false;
+	}
+	if (read(fd, &data, sizeof(data)) != sizeof(data)) {
+		return false;
+	}
+	if (data.time_running == 0) {
+		return false;
+	}
+
+	*value = (double) data.value;
+	if (data.time_running < data.time_enabled) {
+		*value *= (double) data.time_enabled / (double) data.time_running;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 性能カウンタ初期化関数
+//!
+//! @param [out] perf 性能カウンタ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_perf_init(mx6e_perf_t * perf)
+{
+	for (int i = 0; i < MX6E_PERF_EVENT_NUM; i++) {
+		perf->fd[i] = -1;
+	}
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 性能カウンタ開始関数
+//!
+//! 転送スレッドの先頭で呼び出し、そのスレッドのカウンタを作成する。
+//! 作成できないイベントはログ出力のうえ未採取とする。
+//!
+//! @param [in,out] perf 性能カウンタ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_perf_open(mx6e_perf_t * perf)
+{
+	for (int i = 0; i < MX6E_PERF_EVENT_NUM; i++) {
+		int                             fd = perf_event_open(&perf_event_def[i]);
+		if (fd < 0) {
+			mx6e_logging(LOG_INFO, "perf counter %s unavailable : %s\n", perf_event_def[i].name, strerror(errno));
+		}
+		__atomic_store_n(&perf->fd[i], fd, __ATOMIC_RELEASE);
+	}
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 性能カウンタ終了関数
+//!
+//! 転送スレッドの終了後に呼び出す。
+//!
+//! @param [in,out] perf 性能カウンタ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_perf_close(mx6e_perf_t * perf)
+{
+	for (int i = 0; i < MX6E_PERF_EVENT_NUM; i++) {
+		if (perf->fd[i] >= 0) {
+			close(perf->fd[i]);
+		}
+		perf->fd[i] = -1;
+	}
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 性能カウンタ出力関数
+//!
+//! 各転送スレッドのカウンタ値と、転送成功パケットあたりの値を出力する。
+//! カウンタはスレッド起動時から、パケット数は統計初期化時からの累計である。
+//!
+//! @param [in] fp_perf FP->PR転送スレッドの性能カウンタ
+//! @param [in] pr_perf PR->FP転送スレッドの性能カウンタ
+//! @param [in] stat    統計情報
+//! @param [in] fd      出力先のディスクリプタ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_perf_print(mx6e_perf_t * fp_perf, mx6e_perf_t * pr_perf, mx6e_statistics_t * stat, int fd)
+{
+	mx6e_perf_t                    *perf[2] = { fp_perf, pr_perf };
+	double                          value[2][MX6E_PERF_EVENT_NUM];
+	bool                            valid[2][MX6E_PERF_EVENT_NUM];
+	double                          pkts[2];
+	char                            buf[2][32];
+
+	pkts[0] = (double) (stat->fp_m46e_send_success + stat->fp_me6e_send_success);
+	pkts[1] = (double) (stat->pr_m46e_send_success + stat->pr_me6e_send_success);
+
+	for (int d = 0; d < 2; d++) {
+		for (int i = 0; i < MX6E_PERF_EVENT_NUM; i++) {
+			int                             event_fd = __atomic_load_n(&perf[d]->fd[i], __ATOMIC_ACQUIRE);
+			valid[d][i] = perf_event_read(event_fd, &value[d][i]);
+		}
+	}
+
+	DPRINTF(fd, "【MX6E perf counter】\n");
+	DPRINTF(fd, "\n");
+	DPRINTF(fd, "  %-24s %18s %18s\n", "", "FP->PR", "PR->FP");
+	DPRINTF(fd, "  %-24s %18.0f %18.0f\n", "forwarded packets", pkts[0], pkts[1]);
+	for (int i = 0; i < MX6E_PERF_EVENT_NUM; i++) {
+		for (int d = 0; d < 2; d++) {
+			if (valid[d][i]) {
+				snprintf(buf[d], sizeof(buf[d]), "%.0f", value[d][i]);
+			} else {
+				snprintf(buf[d], sizeof(buf[d]), "n/a");
+			}
+		}
+		DPRINTF(fd, "  %-24s %18s %18s\n", perf_event_def[i].name, buf[0], buf[1]);
+	}
+	DPRINTF(fd, "\n");
+
+	// パケットあたりの値
+	for (int i = 0; i <= MX6E_PERF_EVENT_NUM; i++) {
+		char                            name[32];
+		for (int d = 0; d < 2; d++) {
+			if (i == MX6E_PERF_EVENT_NUM) {
+				// IPC
+				if (valid[d][MX6E_PERF_CYCLES] && valid[d][MX6E_PERF_INSTRUCTIONS] && (value[d][MX6E_PERF_CYCLES] > 0)) {
+					snprintf(buf[d], sizeof(buf[d]), "%.3f", value[d][MX6E_PERF_INSTRUCTIONS] / value[d][MX6E_PERF_CYCLES]);
+				} else {
+					snprintf(buf[d], sizeof(buf[d]), "n/a");
+				}
+			} else if (valid[d][i] && (pkts[d] > 0)) {
+				snprintf(buf[d], sizeof(buf[d]), "%.3f", value[d][i] / pkts[d]);
+			} else {
+				snprintf(buf[d], sizeof(buf[d]), "n/a");
+			}
+		}
+		if (i == MX6E_PERF_EVENT_NUM) {
+			snprintf(name, sizeof(name), "IPC");
+		} else {
+			snprintf(name, sizeof(name), "%s/pkt", perf_event_def[i].name);
+		}
+		DPRINTF(fd, "  %-24s %18s %18s\n", name, buf[0], buf[1]);
+	}
+	DPRINTF(fd, "\n");
+
+	return;
+}
@@ -0,0 +1,39 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_perf.h                                                */
+/* 機能概要   : 転送スレッド性能カウンタ ヘッダファイル                       */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+#ifndef __MX6EAPP_PERF_H__
+#   define __MX6EAPP_PERF_H__
+
+#   include "mx6eapp_statistics.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! 採取するイベント
+typedef enum {
+	MX6E_PERF_CYCLES,								///< CPUサイクル数
+	MX6E_PERF_INSTRUCTIONS,							///< 命令実行数
+	MX6E_PERF_LLC_MISSES,							///< LLCミス数
+	MX6E_PERF_BRANCH_MISSES,						///< 分岐予測ミス数
+	MX6E_PERF_CONTEXT_SWITCHES,						///< コンテキストスイッチ数
+	MX6E_PERF_EVENT_NUM								///< イベント数
+} mx6e_perf_event_t;
+
+//! 転送スレッド性能カウンタ
+typedef struct {
+	int                             fd[MX6E_PERF_EVENT_NUM];	///< カウンタのディスクリプタ(-1:未採取)
+} mx6e_perf_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部関数プロトタイプ宣言
+////////////////////////////////////////////////////////////////////////////////
+void                            mx6e_perf_init(mx6e_perf_t * perf);
+void                            mx6e_perf_open(mx6e_perf_t * perf);
+void                            mx6e_perf_close(mx6e_perf_t * perf);
+void                            mx6e_perf_print(mx6e_perf_t * fp_perf, mx6e_perf_t * pr_perf, mx6e_statistics_t * stat, int fd);
+
+#endif												// __MX6EAPP_PERF_H__
@@ -0,0 +1,57 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_probe.h                                               */
+/* 機能概要   : 静的トレースポイント(USDT)定義 ヘッダファイル                 */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+#ifndef __MX6EAPP_PROBE_H__
+#   define __MX6EAPP_PROBE_H__
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! sys/sdt.h(systemtap-sdt-dev)が存在する場合のみUSDTプローブを埋め込む。
+//! 埋め込んだプローブは未使用時nop1命令のみで、bpftrace/perf等から
+//! "usdt:<バイナリ>:mx6e:<名前>"として参照できる。
+//! -DMX6E_NO_PROBE指定時、またはsys/sdt.hが無い環境では何も生成しない。
+#   if !defined(MX6E_NO_PROBE) && defined(__has_include)
+#      if __has_include(<sys/sdt.h>)
+#         include <sys/sdt.h>
+#         define MX6E_PROBE_ENABLED
+#      endif
+#   endif
+
+#   ifdef MX6E_PROBE_ENABLED
+#      define MX6E_PROBE0(name)                         DTRACE_PROBE(mx6e, name)
+#      define MX6E_PROBE1(name, a1)                     DTRACE_PROBE1(mx6e, name, a1)
+#      define MX6E_PROBE2(name, a1, a2)                 DTRACE_PROBE2(mx6e, name, a1, a2)
+#      define MX6E_PROBE3(name, a1, a2, a3)             DTRACE_PROBE3(mx6e, name, a1, a2, a3)
+#      define MX6E_PROBE4(name, a1, a2, a3, a4)         DTRACE_PROBE4(mx6e, name, a1, a2, a3, a4)
+#      define MX6E_PROBE5(name, a1, a2, a3, a4, a5)     DTRACE_PROBE5(mx6e, name, a1, a2, a3, a4, a5)
+#      define MX6E_PROBE6(name, a1, a2, a3, a4, a5, a6) DTRACE_PROBE6(mx6e, name, a1, a2, a3, a4, a5, a6)
+#   else
+#      define MX6E_PROBE0(name)                         do {} while (0)
+#      define MX6E_PROBE1(name, a1)                     do {} while (0)
+#      define MX6E_PROBE2(name, a1, a2)                 do {} while (0)
+#      define MX6E_PROBE3(name, a1, a2, a3)             do {} while (0)
+#      define MX6E_PROBE4(name, a1, a2, a3, a4)         do {} while (0)
+#      define MX6E_PROBE5(name, a1, a2, a3, a4, a5)     do {} while (0)
+#      define MX6E_PROBE6(name, a1, a2, a3, a4, a5, a6) do {} while (0)
+#   endif
+
+//! プローブ一覧(引数)
+//!   rx           (domain, buf, len)                      : トンネルデバイスからの受信
+//!   lookup_hit   (domain, entry, dst)                    : エントリ検索成功
+//!   lookup_miss  (domain, dst)                           : エントリ検索失敗
+//!   rewrite      (domain, entry, src, dst)               : ヘッダ置換後(置換後のアドレス)
+//!   tx           (domain, buf, len)                      : 転送成功
+//!   tx_error     (domain, len, errno)                    : 転送失敗
+//!   entry_add    (type, entry)                           : エントリ追加
+//!   entry_del    (type, entry)                           : エントリ削除(解放前)
+//!   entry_enable (type, entry, enable)                   : エントリ活性/非活性
+//!   route        (family, ifindex, dst, prefixlen, install, result) : カーネルへの経路設定/削除結果
+//!   domainは DOMAIN_PR/DOMAIN_FP、typeは CONFIG_TYPE_M46E/CONFIG_TYPE_ME6E、
+//!   アドレスは struct in6_addr(経路はfamily毎のアドレス)へのポインタ。
+
+#endif												// __MX6EAPP_PROBE_H__
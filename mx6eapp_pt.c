@@ -16,12 +16,16 @@
 #include <pthread.h>
 #include <limits.h>
 #include <search.h>
+#include <inttypes.h>
+#include <sched.h>
 
 #include "mx6eapp.h"
 #include "mx6eapp_pt.h"
 #include "mx6eapp_log.h"
 #include "mx6eapp_network.h"
+#include "mx6eapp_route.h"
 #include "mx6eapp_util.h"
+#include "mx6eapp_probe.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 // 内部関数プロトタイプ宣言
@@ -317,6 +321,520 @@ static int compfind(const void *p1, const void *p2)
 	return 0;
 }
 
+//! 同期用ツリー解放時のノード解放関数(エントリは配列でまとめて解放する)
+static void tdnop(void *nodep)
+{
+	return;
+}
+
+//! マスク別グループのハッシュ表の最小スロット数(2のべき乗)
+#define GROUP_INDEX_MIN_SIZE    8
+
+//! ハッシュ表の削除済みスロットのエントリ(ドメインがDOMAIN_NONEなので検索キーとは一致しない)
+static mx6e_config_entry_t group_slot_deleted;
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief マスク別グループのエントリ比較関数
+//!
+//! マスク別グループ内のエントリは src.mask が全て同じなので、
+//! ドメインと src.src & src.mask が等しければ同じエントリとなる。
+//! 受信パケット検索時はキーの src.mask にグループのマスクを設定すること。
+//! (順序が一意に決まればよいので、ホストバイトオーダのまま比較する)
+//!
+//! @param [in] p1, p2   比較するエントリへのポインタ
+//!
+//! @return p1 < p2  -
+//! @return p1 = p2  0
+//! @return p1 > p2  +
+///////////////////////////////////////////////////////////////////////////////
+static int compgroup(const void *p1, const void *p2)
+{
+	const mx6e_config_entry_t      *v1 = (const mx6e_config_entry_t *) p1;
+	const mx6e_config_entry_t      *v2 = (const mx6e_config_entry_t *) p2;
+
+	if (v1->domain != v2->domain) {
+		return v2->domain - v1->domain;
+	}
+	for (int i = 0; i < 4; i++) {
+		uint32_t                        a1 = v1->src.src.s6_addr32[i] & v1->src.mask.s6_addr32[i];
+		uint32_t                        a2 = v2->src.src.s6_addr32[i] & v2->src.mask.s6_addr32[i];
+		if (a1 != a2) {
+			return (a1 < a2) ? -1 : 1;
+		}
+	}
+
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief マスク別グループのハッシュ値算出関数
+//!
+//! @param [in] domain  ドメイン
+//! @param [in] addr    エントリの src.src または受信パケットの宛先アドレス
+//! @param [in] mask    グループのマスク
+//!
+//! @return ハッシュ値(スロット位置は上位ビットから求める)
+///////////////////////////////////////////////////////////////////////////////
+static inline uint64_t group_hash(domain_t domain, const struct in6_addr *addr, const struct in6_addr *mask)
+{
+	uint64_t                        hash = domain;
+
+	for (int i = 0; i < 4; i++) {
+		hash = (hash ^ (addr->s6_addr32[i] & mask->s6_addr32[i])) * 0x9E3779B97F4A7C15ULL;
+	}
+
+	return hash;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief マスク別グループのハッシュ表確保関数
+//!
+//! @param [in] num   登録するエントリ数(スロットの使用率が1/4以下になる大きさで確保する)
+//!
+//! @return 確保したハッシュ表(NULL:メモリ不足)
+///////////////////////////////////////////////////////////////////////////////
+static mx6e_config_index_t *group_index_alloc(int num)
+{
+	mx6e_config_index_t            *index;
+	unsigned int                    size = GROUP_INDEX_MIN_SIZE;
+
+	while (size < (unsigned int)num * 4) {
+		size <<= 1;
+	}
+	index = calloc(1, sizeof(mx6e_config_index_t) + sizeof(mx6e_config_slot_t) * size);
+	if (index != NULL) {
+		index->shift = 64 - __builtin_ctz(size);
+		index->mask = size - 1;
+	}
+
+	return index;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief マスク別グループのハッシュ表登録関数
+//!
+//! 空きか削除済みのスロットにエントリを書き込む。検索スレッドがスロットを
+//! 参照していてもよいように、ハッシュ値を書いてからエントリを書く。
+//!
+//! @param [in/out] index   登録するハッシュ表(空きスロットがあること)
+//! @param [in]     hash    エントリのハッシュ値
+//! @param [in]     entry   登録するエントリ
+//!
+//! @return none
+///////////////////////////////////////////////////////////////////////////////
+static void group_index_put(mx6e_config_index_t * index, uint64_t hash, mx6e_config_entry_t * entry)
+{
+	unsigned int                    pos = hash >> index->shift;
+
+	while ((index->slot[pos].entry != NULL) && (index->slot[pos].entry != &group_slot_deleted)) {
+		pos = (pos + 1) & index->mask;
+	}
+	if (index->slot[pos].entry == NULL) {
+		index->used++;
+	}
+	__atomic_store_n(&index->slot[pos].hash, hash, __ATOMIC_RELAXED);
+	__atomic_store_n(&index->slot[pos].entry, entry, __ATOMIC_RELEASE);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 受信パケット検索終了待ち関数
+//!
+//! 呼び出し前に公開を取り消したマスク別グループ一覧・ハッシュ表を参照している
+//! 検索が全て終了するまで待つ。戻った後はそれらを解放してよい。
+//! テーブルのロックは呼び出し元でおこなう。
+//!
+//! @param [in] table   MX6E-PR Config Table
+//!
+//! @return none
+///////////////////////////////////////////////////////////////////////////////
+static void group_synchronize(mx6e_config_table_t * table)
+{
+	// 検索側の「検索中の通知 → 一覧の読み込み」と対になる順序保証
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	for (int d = 0; d < DOMAIN_BOTH; d++) {
+		uint64_t                        seq = __atomic_load_n(&table->reader[d].seq, __ATOMIC_ACQUIRE);
+
+		// 検索中(奇数)なら、その検索が終わるまで待つ(以降の検索は新しい一覧を参照する)
+		while ((seq & 1) && (seq == __atomic_load_n(&table->reader[d].seq, __ATOMIC_ACQUIRE))) {
+			sched_yield();
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief マスク別グループのハッシュ表追加関数
+//!
+//! エントリをグループのハッシュ表に追加する。空きスロットが半分を切る場合は
+//! 大きさを変えたハッシュ表を作り直して差し替え、旧ハッシュ表は参照中の検索が
+//! 終わってから解放する。
+//!
+//! @param [in/out] table   MX6E-PR Config Table
+//! @param [in/out] g       追加するマスク別グループ
+//! @param [in]     entry   追加するエントリ(テーブルに登録済みのもの)
+//!
+//! @return true        追加成功
+//!         false       追加失敗(メモリ不足)
+///////////////////////////////////////////////////////////////////////////////
+static bool group_index_add(mx6e_config_table_t * table, mx6e_config_group_t * g, mx6e_config_entry_t * entry)
+{
+	mx6e_config_index_t            *index = g->index;
+	mx6e_config_index_t            *new_index;
+	uint64_t                        hash = group_hash(entry->domain, &entry->src.src, &g->mask);
+
+	if ((index != NULL) && ((index->used + 1) * 2 <= (int)index->mask + 1)) {
+		group_index_put(index, hash, entry);
+		return true;
+	}
+
+	new_index = group_index_alloc(g->num + 1);
+	if (new_index == NULL) {
+		return false;
+	}
+	for (unsigned int i = 0; (index != NULL) && (i <= index->mask); i++) {
+		mx6e_config_entry_t            *e = index->slot[i].entry;
+		if ((e != NULL) && (e != &group_slot_deleted)) {
+			group_index_put(new_index, index->slot[i].hash, e);
+		}
+	}
+	group_index_put(new_index, hash, entry);
+
+	__atomic_store_n(&g->index, new_index, __ATOMIC_RELEASE);
+	if (index != NULL) {
+		group_synchronize(table);
+		free(index);
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief マスク別グループのハッシュ表削除関数
+//!
+//! エントリのスロットを削除済みにする。検索中のスレッドが後続のスロットを
+//! 辿れるように、スロットを空きに戻したり詰め直したりはしない。
+//!
+//! @param [in/out] g       削除するマスク別グループ
+//! @param [in]     entry   削除するエントリ(テーブルに登録済みのもの)
+//!
+//! @return true        削除成功
+//!         false       エントリが登録されていない
+///////////////////////////////////////////////////////////////////////////////
+static bool group_index_del(mx6e_config_group_t * g, mx6e_config_entry_t * entry)
+{
+	mx6e_config_index_t            *index = g->index;
+	unsigned int                    pos = group_hash(entry->domain, &entry->src.src, &g->mask) >> index->shift;
+
+	while (index->slot[pos].entry != NULL) {
+		if (index->slot[pos].entry == entry) {
+			__atomic_store_n(&index->slot[pos].entry, &group_slot_deleted, __ATOMIC_RELEASE);
+			return true;
+		}
+		pos = (pos + 1) & index->mask;
+	}
+
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief マスク別グループ一覧確保関数
+//!
+//! @param [in] num   マスク別グループ数
+//!
+//! @return 確保した一覧(NULL:メモリ不足)
+///////////////////////////////////////////////////////////////////////////////
+static mx6e_config_group_list_t *group_list_alloc(int num)
+{
+	mx6e_config_group_list_t       *list = malloc(sizeof(mx6e_config_group_list_t) + sizeof(mx6e_config_group_t *) * num);
+
+	if (list != NULL) {
+		list->num = num;
+	}
+
+	return list;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief マスク別グループ一覧公開関数
+//!
+//! 新しいマスク別グループ一覧を検索スレッドに公開し、公開前の一覧を参照している
+//! 検索が全て終了するまで待つ。検索スレッドはロックを取らずに一覧を参照するため、
+//! 一覧は書き換えずに差し替え、旧一覧(と旧一覧からのみ参照されるグループ)は
+//! この関数から戻った後に解放する。テーブルのロックは呼び出し元でおこなう。
+//!
+//! @param [in/out] table   公開するMX6E-PR Config Table
+//! @param [in]     list    新しい一覧(NULL:マスク別グループ無し)
+//!
+//! @return 旧一覧(解放してよい)
+///////////////////////////////////////////////////////////////////////////////
+static mx6e_config_group_list_t *group_publish(mx6e_config_table_t * table, mx6e_config_group_list_t * list)
+{
+	mx6e_config_group_list_t       *old = table->group;
+
+	__atomic_store_n(&table->group, list, __ATOMIC_RELEASE);
+	group_synchronize(table);
+
+	return old;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief マスク別グループ登録関数
+//!
+//! エントリを src.mask が同じマスク別グループに登録する。グループが無ければ
+//! マスクの長い順(ビット数が同じ場合はIPv4のCIDRが長い順)の位置に作成する。
+//! 受信パケット検索はこの順にグループを検索し、最初に見つかったエントリを最長一致とする。
+//!
+//! @param [in/out] table   登録するMX6E-PR Config Table
+//! @param [in]     entry   登録するエントリ(テーブルに登録済みのもの)
+//!
+//! @return true        登録成功
+//!         false       登録失敗(メモリ不足)
+///////////////////////////////////////////////////////////////////////////////
+static bool group_insert(mx6e_config_table_t * table, mx6e_config_entry_t * entry)
+{
+	mx6e_config_group_list_t       *list = table->group;
+	mx6e_config_group_list_t       *new_list;
+	mx6e_config_group_t            *g = NULL;
+	int                             num = (list != NULL) ? list->num : 0;
+	int                             bits = 0;
+	int                             pos;
+
+	for (int i = 0; i < 4; i++) {
+		bits += __builtin_popcount(entry->src.mask.s6_addr32[i]);
+	}
+
+	for (pos = 0; pos < num; pos++) {
+		g = list->group[pos];
+		if (IN6_ARE_ADDR_EQUAL(&g->mask, &entry->src.mask)) {
+			break;
+		}
+		if ((g->bits < bits) || ((g->bits == bits) && (ntohl(g->mask.s6_addr32[3]) < ntohl(entry->src.mask.s6_addr32[3])))) {
+			// ここに作成する
+			g = NULL;
+			break;
+		}
+		g = NULL;
+	}
+
+	if (g != NULL) {
+		if (!group_index_add(table, g, entry)) {
+			return false;
+		}
+		g->num++;
+		return true;
+	}
+
+	// 新しいグループはエントリを登録してから一覧に加えて公開する
+	g = calloc(1, sizeof(mx6e_config_group_t));
+	new_list = group_list_alloc(num + 1);
+	if ((g == NULL) || (new_list == NULL)) {
+		free(g);
+		free(new_list);
+		return false;
+	}
+	g->mask = entry->src.mask;
+	g->bits = bits;
+	if (!group_index_add(table, g, entry)) {
+		free(g);
+		free(new_list);
+		return false;
+	}
+	g->num = 1;
+
+	for (int i = 0; i < pos; i++) {
+		new_list->group[i] = list->group[i];
+	}
+	new_list->group[pos] = g;
+	for (int i = pos; i < num; i++) {
+		new_list->group[i + 1] = list->group[i];
+	}
+	free(group_publish(table, new_list));
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief マスク別グループ削除関数
+//!
+//! エントリをマスク別グループから削除する。最後のエントリを削除する場合は、
+//! 先にグループを一覧から外して参照中の検索が終わってから解放する。
+//!
+//! @param [in/out] table   削除するMX6E-PR Config Table
+//! @param [in]     entry   削除するエントリ(テーブルに登録済みのもの)
+//!
+//! @return none
+///////////////////////////////////////////////////////////////////////////////
+static void group_remove(mx6e_config_table_t * table, mx6e_config_entry_t * entry)
+{
+	mx6e_config_group_list_t       *list = table->group;
+	mx6e_config_group_list_t       *new_list = NULL;
+	int                             num = (list != NULL) ? list->num : 0;
+
+	for (int i = 0; i < num; i++) {
+		mx6e_config_group_t            *g = list->group[i];
+		if (!IN6_ARE_ADDR_EQUAL(&g->mask, &entry->src.mask)) {
+			continue;
+		}
+		if (g->num > 1) {
+			if (group_index_del(g, entry)) {
+				g->num--;
+			}
+			return;
+		}
+
+		if (num > 1) {
+			new_list = group_list_alloc(num - 1);
+			if (new_list == NULL) {
+				// 一覧を差し替えられない場合は空のグループを残す(検索結果には影響しない)
+				if (group_index_del(g, entry)) {
+					g->num--;
+				}
+				return;
+			}
+			for (int j = 0, k = 0; j < num; j++) {
+				if (j != i) {
+					new_list->group[k++] = list->group[j];
+				}
+			}
+		}
+		free(group_publish(table, new_list));
+		free(g->index);
+		free(g);
+		return;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief マスク別グループ解放関数
+//!
+//! 受信パケット検索用のマスク別グループを全て解放する。エントリ自体は解放しないので、
+//! テーブルのツリー(root)を解放する前に呼び出すこと。
+//! 戻った時点で検索スレッドはテーブルのエントリを参照していない。
+//!
+//! @param [in/out] table   解放するMX6E-PR Config Table
+//!
+//! @return none
+///////////////////////////////////////////////////////////////////////////////
+void m46e_pt_release_match_group(mx6e_config_table_t * table)
+{
+	mx6e_config_group_list_t       *list = group_publish(table, NULL);
+
+	if (list == NULL) {
+		return;
+	}
+	for (int i = 0; i < list->num; i++) {
+		free(list->group[i]->index);
+		free(list->group[i]);
+	}
+	free(list);
+}
+
+
+//! エントリのユーザ指定部分(ハッシュ値算出・同一判定用)
+typedef struct {
+	int                             domain;			///< ドメイン
+	int                             enable;			///< 有効/無効
+	struct in6_addr                 section_dev_addr;	///< セクションデバイスroute(FPのみ)
+	int                             section_dev_prefix_len;	///< セクションデバイスrouteのプレフィクス長(FPのみ)
+	char                            src_plane_id[INET6_ADDRSTRLEN];	///< plane_id_in
+	int                             src_prefix_len;	///< prefix_len_in
+	struct in_addr                  v4addr;			///< IPv4アドレス(M46Eのみ)
+	int                             v4cidr;			///< IPv4のCIDR(M46Eのみ)
+	struct ether_addr               hwaddr;			///< MACアドレス(ME6Eのみ)
+	char                            des_plane_id[INET6_ADDRSTRLEN];	///< plane_id_out
+	struct in6_addr                 des_prefix;		///< IPv6prefixアドレス
+	int                             des_prefix_len;	///< IPv6prefixのCIDR
+} entry_key_t;
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief エントリのユーザ指定部分抽出関数
+//!
+//! make_config_entry で内部生成される項目を除いた、ユーザ指定部分のみを
+//! パディングを含めて正規化した形で取り出す。
+//! PRドメインのセクションデバイスrouteはデバイス設定から生成されるため対象外とする。
+//!
+//! @param [in]  type    テーブルタイプ
+//! @param [in]  entry   エントリ
+//! @param [in]  enable  有効/無効を含めるかどうか
+//! @param [out] key     ユーザ指定部分
+//!
+//! @return none
+///////////////////////////////////////////////////////////////////////////////
+static void entry_key(table_type_t type, const mx6e_config_entry_t * entry, bool enable, entry_key_t * key)
+{
+	memset(key, 0, sizeof(entry_key_t));
+
+	key->domain = entry->domain;
+	key->enable = enable ? entry->enable : 0;
+	if (DOMAIN_FP == entry->domain) {
+		key->section_dev_addr = entry->section_dev_addr;
+		key->section_dev_prefix_len = entry->section_dev_prefix_len;
+	}
+	memcpy(key->src_plane_id, entry->src.plane_id, strnlen(entry->src.plane_id, sizeof(key->src_plane_id) - 1));
+	key->src_prefix_len = entry->src.prefix_len;
+	if (CONFIG_TYPE_M46E == type) {
+		key->v4addr = entry->src.in.m46e.v4addr;
+		key->v4cidr = entry->src.in.m46e.v4cidr;
+	} else {
+		key->hwaddr = entry->src.in.me6e.hwaddr;
+	}
+	memcpy(key->des_plane_id, entry->des.plane_id, strnlen(entry->des.plane_id, sizeof(key->des_plane_id) - 1));
+	key->des_prefix = entry->des.prefix;
+	key->des_prefix_len = entry->des.prefix_len;
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief エントリのハッシュ値算出関数
+//!
+//! ユーザ指定部分(有効/無効を含む)のFNV-1aハッシュ値を返す。
+//! テーブルのハッシュ値はエントリ毎のハッシュ値の和とするため、
+//! エントリの登録順に依存せず、追加/削除の度に差分で更新できる。
+//! 内部生成項目を含まないため、mx6ectl側で未登録のエントリに対しても同じ値が得られる。
+//!
+//! @param [in] type    テーブルタイプ
+//! @param [in] entry   エントリ
+//!
+//! @return ハッシュ値
+///////////////////////////////////////////////////////////////////////////////
+uint64_t m46e_pt_config_entry_hash(table_type_t type, const mx6e_config_entry_t * entry)
+{
+	entry_key_t                     key;
+	const uint8_t                  *p = (const uint8_t *) &key;
+	uint64_t                        hash = 0xcbf29ce484222325ULL;
+
+	entry_key(type, entry, true, &key);
+	for (int i = 0; i < sizeof(key); i++) {
+		hash ^= p[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief エントリ同一判定関数
+//!
+//! 有効/無効以外のユーザ指定部分が一致するかどうかを返す。
+//!
+//! @param [in] type    テーブルタイプ
+//! @param [in] e1, e2  比較するエントリ
+//!
+//! @return true        一致
+//!         false       不一致
+///////////////////////////////////////////////////////////////////////////////
+static bool entry_equal(table_type_t type, const mx6e_config_entry_t * e1, const mx6e_config_entry_t * e2)
+{
+	entry_key_t                     k1;
+	entry_key_t                     k2;
+
+	entry_key(type, e1, false, &k1);
+	entry_key(type, e2, false, &k2);
+
+	return (0 == memcmp(&k1, &k2, sizeof(entry_key_t)));
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief MX6E-PR Config Table追加関数
@@ -431,9 +949,17 @@ bool m46e_pt_add_config_entry(mx6e_config_table_t * table, mx6e_config_entry_t *
 				mx6e_logging(LOG_ERR, "This entry is is already exists.");
 				result = false;
 				free(p);
+			} else if (!group_insert(table, p)) {
+				mx6e_logging(LOG_ERR, "Out of memory.");
+				tdelete(p, &table->root, compfind);
+				result = false;
+				free(p);
 			} else {
 				// 要素数のインクリメント
 				table->num++;
+				table->version++;
+				table->hash += m46e_pt_config_entry_hash(table->type, p);
+				MX6E_PROBE2(entry_add, table->type, p);
 		
 				int                             ifindex = get_domain_src_ifindex(entry->domain, devices);
 				// PRテーブルへの登録が成功した場合、活性化を伴う追加要求の場合は
@@ -441,7 +967,7 @@ bool m46e_pt_add_config_entry(mx6e_config_table_t * table, mx6e_config_entry_t *
 				if (entry->enable) {
 					// 追加時にenableの場合のみrouteを追加
 					// route追加(IPアドレスを追加すると、OSがパケットを処理してしまうので、routeだけ追加する)
-					mx6e_network_add_route(AF_INET6, ifindex, &entry->src.tunnel_addr, entry->src.tunnel_prefix_len, NULL);
+					mx6e_route_request(AF_INET6, ifindex, &entry->src.tunnel_addr, entry->src.tunnel_prefix_len, true);
 					// 送信元アドレスがいずれかのデバイスに存在しないとパケットを送信しないため、tunnelデバイスに送信元アドレスを設定する
 					//mx6e_network_add_ipaddr(AF_INET6, ifindex, &entry->src.tunnel_src, entry->src.tunnel_src_prefix_len);
 				}
@@ -517,7 +1043,7 @@ bool m46e_pt_del_config_entry(mx6e_config_table_t * table, mx6e_config_entry_t *
 			int                             ifindex = get_domain_src_ifindex((*r)->domain, devices);
 
 			// route削除
-			mx6e_network_del_route(AF_INET6, ifindex, &(*r)->src.tunnel_addr, (*r)->src.tunnel_prefix_len, NULL);
+			mx6e_route_request(AF_INET6, ifindex, &(*r)->src.tunnel_addr, (*r)->src.tunnel_prefix_len, false);
 			// 送信元アドレス削除
 			// mx6e_network_del_ipaddr(AF_INET6, ifindex, &(*r)->src.tunnel_src, (*r)->src.tunnel_src_prefix_len);
 
@@ -525,14 +1051,19 @@ bool m46e_pt_del_config_entry(mx6e_config_table_t * table, mx6e_config_entry_t *
 			int                             ifindex = get_domain_src_ifindex((*r)->domain, devices);
 
 			// route削除
-			mx6e_network_del_route(AF_INET6, ifindex, &(*r)->src.tunnel_addr, (*r)->src.tunnel_prefix_len, NULL);
+			mx6e_route_request(AF_INET6, ifindex, &(*r)->src.tunnel_addr, (*r)->src.tunnel_prefix_len, false);
 			// 送信元アドレス削除
 			// mx6e_network_del_ipaddr(AF_INET6, ifindex, &(*r)->src.tunnel_src, (*r)->src.tunnel_src_prefix_len);
 
 		}
+		uint64_t                        hash = m46e_pt_config_entry_hash(table->type, *r);
+		MX6E_PROBE2(entry_del, table->type, *r);
+		group_remove(table, *r);
 		if (tdelete(entry, &table->root, compfind)) {
 			// 削除成功したので要素数のデクリメント
 			table->num--;
+			table->version++;
+			table->hash -= hash;
 		};
 	}
 
@@ -594,16 +1125,21 @@ bool m46e_pt_enable_config_entry(mx6e_config_table_t * table, mx6e_config_entry_
 
 			if (entry->enable) {
 				// route追加(IPアドレスを追加すると、OSがパケットを処理してしまうので、routeだけ追加する)
-				mx6e_network_add_route(AF_INET6, ifindex, &found->src.tunnel_addr, found->src.tunnel_prefix_len, NULL);
+				mx6e_route_request(AF_INET6, ifindex, &found->src.tunnel_addr, found->src.tunnel_prefix_len, true);
 				// 送信元アドレスがいずれかのデバイスに存在しないとパケットを送信しないため、tunnelデバイスに送信元アドレスを設定する
 				// mx6e_network_add_ipaddr(AF_INET6, ifindex, &found->src.tunnel_src, found->src.tunnel_src_prefix_len);
 			} else {
 				// route削除
-				mx6e_network_del_route(AF_INET6, ifindex, &found->src.tunnel_addr, found->src.tunnel_prefix_len, NULL);
+				mx6e_route_request(AF_INET6, ifindex, &found->src.tunnel_addr, found->src.tunnel_prefix_len, false);
 				// 送信元アドレス削除
 				// mx6e_network_del_ipaddr(AF_INET6, ifindex, &found->src.tunnel_src, found->src.tunnel_src_prefix_len);
 			}
 
+			table->version++;
+			table->hash -= m46e_pt_config_entry_hash(table->type, found);
+			found->enable = entry->enable;
+			table->hash += m46e_pt_config_entry_hash(table->type, found);
+			MX6E_PROBE3(entry_enable, table->type, found, found->enable);
 		}
 		// 一致したエントリーの有効/無効フラグを上書き
 		found->enable = entry->enable;
@@ -684,6 +1220,8 @@ mx6e_config_entry_t            *mx6e_search_config_table(mx6e_config_table_t * t
 //! @brief MX6E-PR拡張 MX6E-PR Config テーブル検索関数
 //!
 //! 送信先v6アドレスからエントリを検索する。(置換情報取得)
+//! マスク別グループをマスクの長い順に検索し、最初にマッチしたエントリを返す(最長一致)。
+//! マッチしたエントリが無効の場合は、より短いエントリを探さずに検索失敗とする。
 //!
 //! @param [in] table   検索するMX6E-PR Configテーブル
 //! @param [in] v6addr  検索するV6addr
@@ -694,8 +1232,12 @@ mx6e_config_entry_t            *mx6e_search_config_table(mx6e_config_table_t * t
 ///////////////////////////////////////////////////////////////////////////////
 mx6e_config_entry_t            *mx6e_match_config_table(domain_t domain, mx6e_config_table_t * table, struct in6_addr * v6addr)
 {
-	mx6e_config_entry_t            **r = NULL;
+	mx6e_config_entry_t            *r = NULL;
 	mx6e_config_entry_t				key = {0};
+	mx6e_config_entry_t            *result;
+	mx6e_config_group_list_t       *list;
+	mx6e_config_reader_t           *reader = &table->reader[domain];
+	uint64_t                        seq = reader->seq;
 
 	// 引数チェック
 	// 高速化のため省略
@@ -708,11 +1250,35 @@ mx6e_config_entry_t            *mx6e_match_config_table(domain_t domain, mx6e_co
 	// DEBUG_LOG("pthread_mutex_lock  TID  = %lx\n", (unsigned long int) pthread_self());
 	// pthread_mutex_lock(&table->mutex);
 
-	key.src.mask = in6_addr0;
 	key.src.src = *v6addr;
 	key.domain = domain;
 
-	if (NULL == (r = tfind(&key, &table->root, compfind))) {
+	// 検索中を通知してから一覧を参照する(書き込み側は検索が終わるまで旧一覧を解放しない)
+	__atomic_store_n(&reader->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	list = __atomic_load_n(&table->group, __ATOMIC_ACQUIRE);
+
+	for (int i = 0; (list != NULL) && (i < list->num) && (r == NULL); i++) {
+		mx6e_config_group_t            *g = list->group[i];
+		mx6e_config_index_t            *index = __atomic_load_n(&g->index, __ATOMIC_ACQUIRE);
+		uint64_t                        hash = group_hash(domain, v6addr, &g->mask);
+		mx6e_config_entry_t            *e;
+
+		key.src.mask = g->mask;
+		for (unsigned int pos = hash >> index->shift;
+			 NULL != (e = __atomic_load_n(&index->slot[pos].entry, __ATOMIC_ACQUIRE)); pos = (pos + 1) & index->mask) {
+			if ((index->slot[pos].hash == hash) && (0 == compgroup(&key, e))) {
+				r = e;
+				break;
+			}
+		}
+	}
+	// 有効なエントリならエントリポインタ、無効なエントリならNULLを返す
+	result = ((r != NULL) && r->enable) ? r : NULL;
+
+	__atomic_store_n(&reader->seq, seq + 2, __ATOMIC_RELEASE);
+
+	if (NULL == r) {
 		DEBUG_LOG("M46E-CONFIG table has no match in (%d) entries\n", table->num);
 	}
 		
@@ -721,9 +1287,9 @@ mx6e_config_entry_t            *mx6e_match_config_table(domain_t domain, mx6e_co
 	// DEBUG_LOG("pthread_mutex_unlock  TID  = %lx\n", (unsigned long int) pthread_self());
 
 	_D_({
-			if (r) {
+			if (result) {
 				printf("Match\n");
-				m46e_pt_config_entry_dump(*r);
+				m46e_pt_config_entry_dump(result);
 			}
 			// 	char                            address[INET6_ADDRSTRLEN];
 			// 	printf("Match MX6E-PR Table address key = %s, ", inet_ntop(AF_INET6, &key.src.src, address, sizeof(address)));
@@ -732,21 +1298,9 @@ mx6e_config_entry_t            *mx6e_match_config_table(domain_t domain, mx6e_co
 			// }
 		});
 
-	if (r) {
-		if ((*r)->enable) {
-			// 有効なエントリならエントリポインタを返す
-			_D_(printf("exit enabled %s\n", __func__));
-			return *r;
-		} else {
-			// 無効なエントリならNULLを返す
-			_D_(printf("exit disabled %s\n", __func__));
-			return NULL;
-		}
-	} else {
-		// 見つからなかった
-		_D_(printf("exit not found %s\n", __func__));
-		return NULL;
-	}
+	_D_(printf("exit %s %s\n", (r == NULL) ? "not found" : (result != NULL) ? "enabled" : "disabled", __func__));
+
+	return result;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -986,126 +1540,334 @@ static struct {
 		CL("plane_id(out)")}, {
 		CL("IPv6 Network Address                   ")}, {
 		CL("Netmask")}, {
+		CL("route    ")}, {
 		NULL, 0}
 };
 
-static mx6e_config_table_t *mytable;
-static int myfd;
-static void action(const void *nodep, const VISIT which, const int depth)
+//! スナップショット採取状態
+typedef struct {
+	mx6e_config_entry_t            *entry;			///< 採取先
+	int                             num;			///< 採取数
+	int                             max;			///< 採取先の格納可能数
+} snapshot_ctx_t;
+
+//! 採取中のスナップショット(twalkのコールバックに引数を渡せないため、採取の間だけ設定する)
+static __thread snapshot_ctx_t *snapshot_ctx;
+
+static void snapshot_action(const void *nodep, const VISIT which, const int depth)
 {
 	mx6e_config_entry_t *p = *(mx6e_config_entry_t **)nodep;
-	int                             n = 0;
-	char                            v4addr[INET_ADDRSTRLEN] = { 0 };
-	char                            v6addr[INET6_ADDRSTRLEN] = { 0 };
 
 	if (!p) {
 		return;
 	}
-	
+
 	switch(which) {
 	case preorder:
 	case endorder:
 		break;
 	case postorder:
 	case leaf:
-		if (p->enable == true) {
-			dprintf(myfd, "|%*s|", header[n].len, "*");
-		} else {
-			dprintf(myfd, "|%*s|", header[n].len, " ");
+		if (snapshot_ctx->num < snapshot_ctx->max) {
+			snapshot_ctx->entry[snapshot_ctx->num++] = *p;
 		}
-		n++;
-
-		// domain type
-		dprintf(myfd, "%-*s|", header[n].len, get_domain_name(p->domain));
-		n++;
+		break;
+	}
+}
 
-		/// マルチプレーン対応 2016/07/27 add start
-		// IPv6
-		dprintf(myfd, "%-*s|", header[n].len, inet_ntop(AF_INET6, &p->section_dev_addr, v6addr, sizeof(v6addr)));
-		n++;
+///////////////////////////////////////////////////////////////////////////////
+////! @brief エントリ採取関数
+////!
+////! ツリー上の全エントリを採取先に複写する。テーブルのロックは呼び出し元でおこなう。
+////!
+////! @param [in]  table   採取元テーブル
+////! @param [out] entry   採取先(table->num 個分の領域)
+////!
+////! @return 採取したエントリ数
+/////////////////////////////////////////////////////////////////////////////////
+static int snapshot_collect(mx6e_config_table_t * table, mx6e_config_entry_t * entry)
+{
+	snapshot_ctx_t                  ctx = { entry, 0, table->num };
 
-		// IPv6 cidr
-		dprintf(myfd, "%-*d|", header[n].len, p->section_dev_prefix_len);
-		n++;
-		/// マルチプレーン対応 2016/07/27 add end
+	snapshot_ctx = &ctx;
+	twalk(table->root, snapshot_action);
+	snapshot_ctx = NULL;
 
-		// plane_id(in)
-		dprintf(myfd, "%-*s|", header[n].len, p->src.plane_id);
-		n++;
+	return ctx.num;
+}
 
-		// prefix_len
-		dprintf(myfd, "%-*d|", header[n].len, p->src.prefix_len);
-		n++;
+///////////////////////////////////////////////////////////////////////////////
+////! @brief IPv6プレフィックス包含判定関数
+////!
+////! @param [in] prefix      プレフィックス
+////! @param [in] prefix_len  プレフィックス長
+////! @param [in] addr        判定するネットワークアドレス
+////! @param [in] addr_len    判定するネットワークのプレフィックス長
+////!
+////! @return true  addr/addr_len が prefix/prefix_len 配下
+////!         false 配下でない
+/////////////////////////////////////////////////////////////////////////////////
+static bool show_prefix6_contains(const struct in6_addr *prefix, int prefix_len, const struct in6_addr *addr, int addr_len)
+{
+	int                             bytes = prefix_len / 8;
+	int                             bits = prefix_len % 8;
 
-		switch (mytable->type) {
-		case CONFIG_TYPE_M46E:
-			// v4 addr
-			dprintf(myfd, "%-*s|", header[n].len, inet_ntop(AF_INET, &p->src.in.m46e.v4addr, v4addr, sizeof(v4addr)));
-			n++;
-			// v4 cidr
-			dprintf(myfd, "%-*d|", header[n].len, p->src.in.m46e.v4cidr);
-			n++;
-			break;
+	if (addr_len < prefix_len) {
+		return false;
+	}
+	if (memcmp(prefix, addr, bytes) != 0) {
+		return false;
+	}
+	if (bits && ((prefix->s6_addr[bytes] ^ addr->s6_addr[bytes]) & (0xff << (8 - bits)))) {
+		return false;
+	}
 
-		case CONFIG_TYPE_ME6E:
-			// mac address
-			dprintf(myfd, "%-*s|", header[n].len, ether_ntoa(&p->src.in.me6e.hwaddr));
-			n++;
-			dprintf(myfd, "%-*s|", header[n].len, "-");
-			n++;
-			break;
+	return true;
+}
 
-		default:
-			dprintf(myfd, "%-*s|", header[n].len, "-");
-			n++;
-			dprintf(myfd, "%-*s|", header[n].len, "-");
-			n++;
-			break;
+///////////////////////////////////////////////////////////////////////////////
+////! @brief 表示フィルタ判定関数
+////!
+////! @param [in] p       エントリ
+////! @param [in] type    テーブルタイプ
+////! @param [in] show    表示要求データ
+////!
+////! @return true  表示対象
+////!         false 表示対象外
+/////////////////////////////////////////////////////////////////////////////////
+static bool show_entry_match(const mx6e_config_entry_t * p, table_type_t type, const mx6e_show_table_t * show)
+{
+	if ((show->filter & SHOW_TABLE_FILTER_DOMAIN) && (p->domain != show->domain)) {
+		return false;
+	}
+	if ((show->filter & SHOW_TABLE_FILTER_PLANE) && strcmp(p->src.plane_id, show->plane_id) && strcmp(p->des.plane_id, show->plane_id)) {
+		return false;
+	}
+	if ((show->filter & SHOW_TABLE_FILTER_STATE) && (p->enable != show->enable)) {
+		return false;
+	}
+	if (show->filter & SHOW_TABLE_FILTER_PREFIX) {
+		if (show->family == AF_INET) {
+			// M46EのIPv4ネットワークがプレフィックス配下
+			struct in_addr                  mask;
+			if ((type != CONFIG_TYPE_M46E) || (p->src.in.m46e.v4cidr < show->prefix_len)) {
+				return false;
+			}
+			PR_CIDR2SUBNETMASK(show->prefix_len, mask);
+			if ((p->src.in.m46e.v4addr.s_addr & mask.s_addr) != (show->prefix.v4.s_addr & mask.s_addr)) {
+				return false;
+			}
+		} else {
+			// 出力側IPv6ネットワーク、またはFPの区間デバイスアドレスがプレフィックス配下
+			if (!show_prefix6_contains(&show->prefix.v6, show->prefix_len, &p->des.prefix, p->des.prefix_len)
+				&& !((p->domain == DOMAIN_FP)
+					 && show_prefix6_contains(&show->prefix.v6, show->prefix_len, &p->section_dev_addr, p->section_dev_prefix_len))) {
+				return false;
+			}
 		}
+	}
 
-		// IN/OUTセパレータ
-		dprintf(myfd, "%-*s|", header[n].len, "");
-		n++;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+////! @brief エントリ表形式出力関数
+////!
+////! @param [in] fd      出力先のディスクリプタ
+////! @param [in] type    テーブルタイプ
+////! @param [in] p       エントリ
+////!
+////! @return なし
+/////////////////////////////////////////////////////////////////////////////////
+static void show_entry_row(int fd, table_type_t type, const mx6e_config_entry_t * p)
+{
+	int                             n = 0;
+	char                            v4addr[INET_ADDRSTRLEN] = { 0 };
+	char                            v6addr[INET6_ADDRSTRLEN] = { 0 };
+
+	if (p->enable == true) {
+		dprintf(fd, "|%*s|", header[n].len, "*");
+	} else {
+		dprintf(fd, "|%*s|", header[n].len, " ");
+	}
+	n++;
 
-		// plane_id(out)
-		dprintf(myfd, "%-*s|", header[n].len, p->des.plane_id);
+	// domain type
+	dprintf(fd, "%-*s|", header[n].len, get_domain_name(p->domain));
+	n++;
+
+	/// マルチプレーン対応 2016/07/27 add start
+	// IPv6
+	dprintf(fd, "%-*s|", header[n].len, inet_ntop(AF_INET6, &p->section_dev_addr, v6addr, sizeof(v6addr)));
+	n++;
+
+	// IPv6 cidr
+	dprintf(fd, "%-*d|", header[n].len, p->section_dev_prefix_len);
+	n++;
+	/// マルチプレーン対応 2016/07/27 add end
+
+	// plane_id(in)
+	dprintf(fd, "%-*s|", header[n].len, p->src.plane_id);
+	n++;
+
+	// prefix_len
+	dprintf(fd, "%-*d|", header[n].len, p->src.prefix_len);
+	n++;
+
+	switch (type) {
+	case CONFIG_TYPE_M46E:
+		// v4 addr
+		dprintf(fd, "%-*s|", header[n].len, inet_ntop(AF_INET, &p->src.in.m46e.v4addr, v4addr, sizeof(v4addr)));
+		n++;
+		// v4 cidr
+		dprintf(fd, "%-*d|", header[n].len, p->src.in.m46e.v4cidr);
 		n++;
+		break;
 
-		// IPv6
-		dprintf(myfd, "%-*s|", header[n].len, inet_ntop(AF_INET6, &p->des.prefix, v6addr, sizeof(v6addr)));
+	case CONFIG_TYPE_ME6E:
+		// mac address
+		dprintf(fd, "%-*s|", header[n].len, ether_ntoa(&p->src.in.me6e.hwaddr));
+		n++;
+		dprintf(fd, "%-*s|", header[n].len, "-");
 		n++;
+		break;
 
-		// IPv6 cidr
-		dprintf(myfd, "%-*d|\n", header[n].len, p->des.prefix_len);
+	default:
+		dprintf(fd, "%-*s|", header[n].len, "-");
+		n++;
+		dprintf(fd, "%-*s|", header[n].len, "-");
 		n++;
 		break;
 	}
+
+	// IN/OUTセパレータ
+	dprintf(fd, "%-*s|", header[n].len, "");
+	n++;
+
+	// plane_id(out)
+	dprintf(fd, "%-*s|", header[n].len, p->des.plane_id);
+	n++;
+
+	// IPv6
+	dprintf(fd, "%-*s|", header[n].len, inet_ntop(AF_INET6, &p->des.prefix, v6addr, sizeof(v6addr)));
+	n++;
+
+	// IPv6 cidr
+	dprintf(fd, "%-*d|", header[n].len, p->des.prefix_len);
+	n++;
+
+	// route状態
+	dprintf(fd, "%-*s|\n", header[n].len, mx6e_route_state_name(mx6e_route_get_state(AF_INET6, &p->src.tunnel_addr, p->src.tunnel_prefix_len, NULL)));
+	n++;
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+////! @brief エントリJSON形式出力関数
+////!
+////! 1エントリを1行のJSONオブジェクトとして出力する。
+////!
+////! @param [in] fd      出力先のディスクリプタ
+////! @param [in] type    テーブルタイプ
+////! @param [in] p       エントリ
+////!
+////! @return なし
+/////////////////////////////////////////////////////////////////////////////////
+static void show_entry_json(int fd, table_type_t type, const mx6e_config_entry_t * p)
+{
+	char                            v4addr[INET_ADDRSTRLEN] = { 0 };
+	char                            v6addr[INET6_ADDRSTRLEN] = { 0 };
+
+	dprintf(fd, "{\"enable\":%s,\"domain\":\"%s\"", p->enable ? "true" : "false", get_domain_name(p->domain));
+	if (p->domain == DOMAIN_FP) {
+		dprintf(fd, ",\"section_dev\":\"%s/%d\"",
+				inet_ntop(AF_INET6, &p->section_dev_addr, v6addr, sizeof(v6addr)), p->section_dev_prefix_len);
+	}
+	dprintf(fd, ",\"plane_id_in\":\"%s\",\"prefix_len_in\":%d", p->src.plane_id, p->src.prefix_len);
+	switch (type) {
+	case CONFIG_TYPE_M46E:
+		dprintf(fd, ",\"ipv4\":\"%s/%d\"", inet_ntop(AF_INET, &p->src.in.m46e.v4addr, v4addr, sizeof(v4addr)), p->src.in.m46e.v4cidr);
+		break;
+	case CONFIG_TYPE_ME6E:
+		dprintf(fd, ",\"hwaddr\":\"%s\"", ether_ntoa(&p->src.in.me6e.hwaddr));
+		break;
+	default:
+		break;
+	}
+	dprintf(fd, ",\"plane_id_out\":\"%s\",\"prefix_out\":\"%s/%d\"",
+			p->des.plane_id, inet_ntop(AF_INET6, &p->des.prefix, v6addr, sizeof(v6addr)), p->des.prefix_len);
+
+	int                             errcd;
+	mx6e_route_state_t              state = mx6e_route_get_state(AF_INET6, &p->src.tunnel_addr, p->src.tunnel_prefix_len, &errcd);
+	dprintf(fd, ",\"route\":\"%s\"", mx6e_route_state_name(state));
+	if (state == MX6E_ROUTE_FAILED) {
+		dprintf(fd, ",\"route_error\":\"%s\"", strerror(errcd));
+	}
+	dprintf(fd, "}\n");
+
+	return;
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 ////! @brief テーブル内部情報出力関数
 ////!
-////! MX6E-PR情報管理内のテーブルを出力する
+////! MX6E-PR情報管理内のテーブルを出力する。
+////! テーブルロック中はエントリの複写のみおこない、フィルタ適用と出力は
+////! ロック解除後に複写したスナップショットに対しておこなう。
 ////!
-////! @param [in]     pr_handler      MX6E-PR情報管理
+////! @param [in]     table           MX6E-PR Config Table
+////! @param [in]     show            表示要求データ(フィルタ、表示範囲、表示形式)
 ////! @param [in]     fd              出力先のディスクリプタ
+////! @param [in]     process_name    プロセス名
 ////!
 ////! @return なし
 /////////////////////////////////////////////////////////////////////////////////
-void m46e_pt_show_entry_pr_table(mx6e_config_table_t * table, int fd, char *process_name)
+void m46e_pt_show_entry_pr_table(mx6e_config_table_t * table, mx6e_show_table_t * show, int fd, char *process_name)
 {
 
 	// ローカル変数初期化
 	char                            buf[1024];
+	mx6e_config_entry_t            *entry = NULL;
+	int                             num = 0;
 
 	// 引数チェック
-	if ((table == NULL) || (process_name == NULL)) {
+	if ((table == NULL) || (show == NULL) || (process_name == NULL)) {
 		return;
 	}
-	// テーブルロック
+	// テーブルロック(スナップショット採取の間のみ)
 	pthread_mutex_lock(&table->mutex);
 
+	if (table->num > 0) {
+		entry = malloc(sizeof(mx6e_config_entry_t) * table->num);
+		if (entry != NULL) {
+			num = snapshot_collect(table, entry);
+		} else {
+			mx6e_logging(LOG_ERR, "snapshot allocation failed\n");
+		}
+	}
+
+	// ロック解除
+	pthread_mutex_unlock(&table->mutex);
+
+	if (show->format == SHOW_TABLE_FORMAT_JSON) {
+		int                             matched = 0;
+		int                             shown = 0;
+		for (int i = 0; i < num; i++) {
+			if (!show_entry_match(&entry[i], table->type, show)) {
+				continue;
+			}
+			if ((matched++ < show->offset) || ((show->limit > 0) && (shown >= show->limit))) {
+				continue;
+			}
+			show_entry_json(fd, table->type, &entry[i]);
+			shown++;
+		}
+		free(entry);
+		return;
+	}
+
 	int                             width = 0;
 	width++;										// 最初の"|"分
 	for (int i = 0; header[i].note; i++) {
@@ -1148,21 +1910,33 @@ void m46e_pt_show_entry_pr_table(mx6e_config_table_t * table, int fd, char *proc
 	dprintf(fd, "%s\n", bar3);
 	dprintf(fd, "%s\n", bar2);
 
+	if (num > 0) {
+		int                             matched = 0;
+		int                             shown = 0;
 
-	mytable = table;
-	myfd = fd;
-
-	if (table && table->num) {
-		_D_(m46e_pt_config_table_dump(table));
-		
-		twalk(table->root, action);
+		for (int i = 0; i < num; i++) {
+			if (!show_entry_match(&entry[i], table->type, show)) {
+				continue;
+			}
+			if ((matched++ < show->offset) || ((show->limit > 0) && (shown >= show->limit))) {
+				continue;
+			}
+			show_entry_row(fd, table->type, &entry[i]);
+			shown++;
+		}
 
 		dprintf(fd, "%s\n", bar2);
+		if (shown > 0) {
+			dprintf(fd, "  Shown : %d-%d of %d matched entries (total %d)\n", show->offset + 1, show->offset + shown, matched, num);
+		} else {
+			dprintf(fd, "  Shown : 0 of %d matched entries (total %d)\n", matched, num);
+		}
 		dprintf(fd, "  Note : [*] shows available entry for prefix resolution process.\n");
+		dprintf(fd, "         [route] shows kernel route state (pending/installed/failed).\n");
 		dprintf(fd, "\n");
 	}
-	// ロック解除
-	pthread_mutex_unlock(&table->mutex);
+
+	free(entry);
 
 	return;
 }
@@ -1230,8 +2004,10 @@ static void tdaction(void *nodep)
 
 	int                             ifindex = get_domain_src_ifindex(entry->domain, mydevices);
 
-	// route削除
-	mx6e_network_del_route(AF_INET6, ifindex, &entry->src.tunnel_addr, entry->src.tunnel_prefix_len, NULL);
+	// route削除(非活性のエントリは経路を持たない)
+	if (entry->enable) {
+		mx6e_route_request(AF_INET6, ifindex, &entry->src.tunnel_addr, entry->src.tunnel_prefix_len, false);
+	}
 	free(entry);
 }
 
@@ -1272,10 +2048,13 @@ bool m46e_pt_delall_config_entry(mx6e_handler_t * handler, mx6e_command_code_t c
 	_D_(m46e_pt_config_table_dump(table));
 
 	mydevices = &handler->conf.devices;
+	m46e_pt_release_match_group(table);
 	tdestroy(table->root, tdaction);
 
 	table->root = NULL;
 	table->num = 0;
+	table->version++;
+	table->hash = 0;
 	
 	// 排他解除
 	pthread_mutex_unlock(&table->mutex);
@@ -1284,3 +2063,396 @@ bool m46e_pt_delall_config_entry(mx6e_handler_t * handler, mx6e_command_code_t c
 
 	return true;
 }
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief M46E-PR Table 同期関数
+//!
+//! 指定されたエントリ群をあるべきテーブル内容として現在のテーブルと比較し、
+//! 差分(追加/削除/変更/活性化/非活性化)のみを反映する。
+//! 一致するエントリには触れないため、経路の再設定や未登録期間は発生しない。
+//! キーが一致して内容が異なるエントリは削除後に追加する(変更)。
+//! テーブルの容量を空けるため、削除を先に、追加を後におこなう。
+//! 反映はテーブルの排他中におこなうため、途中状態が参照されることは無い。
+//!
+//! @param [in/out] table       同期するM46E-PR Table
+//! @param [in]     record      あるべきエントリ(ENTRY 追加コマンドのレコード)
+//! @param [in]     num         レコード数
+//! @param [in]     devices     デバイス設定
+//! @param [out]    result      反映結果の件数
+//! @param [out]    failed_line 反映に失敗したレコードの行番号(num個分の領域)
+//!
+//! @return true        OK(失敗したレコードがあっても残りは反映する)
+//!         false       NG(引数異常、メモリ確保失敗)
+///////////////////////////////////////////////////////////////////////////////
+bool m46e_pt_sync_config_table(mx6e_config_table_t * table, mx6e_load_batch_record_t * record, int num, mx6e_config_devices_t * devices, mx6e_sync_result_t * result, int *failed_line)
+{
+	mx6e_command_code_t             add_code;
+	mx6e_config_entry_t            *desired = NULL;
+	signed char                    *state = NULL;	// 0:追加対象 1:反映済み 2:変更(削除済みで追加対象) -1:無効
+	mx6e_config_entry_t            *current = NULL;
+	int                             current_num;
+	void                           *root = NULL;
+	bool                            ret = true;
+
+	_D_(printf("enter %s\n", __func__));
+
+	// 引数チェック
+	if ((table == NULL) || (num < 0) || ((num > 0) && (record == NULL)) || (result == NULL) || (failed_line == NULL)) {
+		mx6e_logging(LOG_ERR, "Parameter Check NG(%s).", __func__);
+		return false;
+	}
+	add_code = (CONFIG_TYPE_M46E == table->type) ? MX6E_ADD_M46E_ENTRY : MX6E_ADD_ME6E_ENTRY;
+
+	memset(result, 0, sizeof(mx6e_sync_result_t));
+	desired = malloc(sizeof(mx6e_config_entry_t) * max(num, 1));
+	state = calloc(max(num, 1), sizeof(signed char));
+	if ((desired == NULL) || (state == NULL)) {
+		mx6e_logging(LOG_ERR, "sync buffer allocation failed\n");
+		free(desired);
+		free(state);
+		return false;
+	}
+
+	// あるべきエントリのツリーを作成(キー重複は後の行を失敗とする)
+	for (int i = 0; i < num; i++) {
+		desired[i] = record[i].entry;
+		if ((record[i].code != add_code) || !make_config_entry(&desired[i], table->type, devices)) {
+			state[i] = -1;
+		} else {
+			mx6e_config_entry_t           **r = tsearch(&desired[i], &root, compfind);
+			if (r == NULL) {
+				mx6e_logging(LOG_ERR, "Out of memory.");
+				ret = false;
+				goto end;
+			} else if (*r != &desired[i]) {
+				state[i] = -1;
+			}
+		}
+		if (state[i] < 0) {
+			failed_line[result->failed++] = record[i].line;
+		}
+	}
+
+	// 排他開始
+	pthread_mutex_lock(&table->mutex);
+
+	// 現在のエントリを採取(反映中にツリーが変わるため)
+	current = malloc(sizeof(mx6e_config_entry_t) * max(table->num, 1));
+	if (current == NULL) {
+		pthread_mutex_unlock(&table->mutex);
+		mx6e_logging(LOG_ERR, "sync buffer allocation failed\n");
+		ret = false;
+		goto end;
+	}
+	current_num = snapshot_collect(table, current);
+
+	// 削除/変更/活性化/非活性化
+	for (int i = 0; i < current_num; i++) {
+		mx6e_config_entry_t            *cur = &current[i];
+		mx6e_config_entry_t           **r = tfind(cur, &root, compfind);
+		mx6e_config_entry_t            *want = (r != NULL) ? *r : NULL;
+
+		if ((want != NULL) && entry_equal(table->type, cur, want)) {
+			state[want - desired] = 1;
+			if (cur->enable == want->enable) {
+				result->unchanged++;
+			} else if (m46e_pt_enable_config_entry(table, want, devices)) {
+				if (want->enable) {
+					result->enabled++;
+				} else {
+					result->disabled++;
+				}
+			} else {
+				failed_line[result->failed++] = record[want - desired].line;
+			}
+			continue;
+		}
+
+		if (!m46e_pt_del_config_entry(table, cur, devices)) {
+			mx6e_logging(LOG_ERR, "fail to del MX6E-PR Entry on sync\n");
+			if (want != NULL) {
+				state[want - desired] = -1;
+				failed_line[result->failed++] = record[want - desired].line;
+			}
+			continue;
+		}
+		if (want != NULL) {
+			state[want - desired] = 2;
+		} else {
+			result->deleted++;
+		}
+	}
+
+	// 追加
+	for (int i = 0; i < num; i++) {
+		if ((state[i] != 0) && (state[i] != 2)) {
+			continue;
+		}
+		mx6e_config_entry_t             entry = record[i].entry;
+		if (!m46e_pt_add_config_entry(table, &entry, devices)) {
+			failed_line[result->failed++] = record[i].line;
+		} else if (state[i] == 2) {
+			result->modified++;
+		} else {
+			result->added++;
+		}
+	}
+
+	// 排他解除
+	pthread_mutex_unlock(&table->mutex);
+
+	free(current);
+
+  end:
+	tdestroy(root, tdnop);
+	free(desired);
+	free(state);
+
+	_D_(printf("exit %s\n", __func__));
+
+	return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief M46E-PR Table 版数表示関数
+//!
+//! テーブル版数、テーブル内容のハッシュ値、エントリ数を1行で出力する。
+//! ハッシュ値はエントリの登録順に依存しないため、コントローラは
+//! あるべきテーブル内容のハッシュ値と比較して同期の要否を判断できる。
+//!
+//! @param [in]     table   表示するM46E-PR Table
+//! @param [in]     fd      出力先のディスクリプタ
+//!
+//! @return none
+///////////////////////////////////////////////////////////////////////////////
+void m46e_pt_show_version(mx6e_config_table_t * table, int fd)
+{
+	// 引数チェック
+	if (table == NULL) {
+		mx6e_logging(LOG_ERR, "Parameter Check NG(%s).", __func__);
+		return;
+	}
+
+	// 排他開始
+	pthread_mutex_lock(&table->mutex);
+
+	dprintf(fd, "version=%" PRIu64 " hash=%016" PRIx64 " entries=%d\n", table->version, table->hash, table->num);
+
+	// 排他解除
+	pthread_mutex_unlock(&table->mutex);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief M46E-PR Table 全エントリ複写関数
+//!
+//! テーブル内の全エントリを、内部生成項目と有効/無効を含めてそのまま複写する。
+//! 複写したエントリは m46e_pt_restore_config_table() にそのまま渡すことができる。
+//! 領域は本関数内で確保するので、呼び出し元でfreeすること。
+//!
+//! @param [in]     table   複写するM46E-PR Table
+//! @param [out]    entry   複写したエントリの格納先
+//!
+//! @return 0以上       複写したエントリ数
+//!         -1          NG(引数異常、メモリ確保失敗)
+///////////////////////////////////////////////////////////////////////////////
+int m46e_pt_copy_config_table(mx6e_config_table_t * table, mx6e_config_entry_t ** entry)
+{
+	mx6e_config_entry_t            *p;
+	int                             num;
+
+	// 引数チェック
+	if ((table == NULL) || (entry == NULL)) {
+		mx6e_logging(LOG_ERR, "Parameter Check NG(%s).", __func__);
+		return -1;
+	}
+
+	// 排他開始
+	pthread_mutex_lock(&table->mutex);
+
+	p = malloc(sizeof(mx6e_config_entry_t) * max(table->num, 1));
+	if (p == NULL) {
+		pthread_mutex_unlock(&table->mutex);
+		mx6e_logging(LOG_ERR, "snapshot allocation failed\n");
+		return -1;
+	}
+	num = snapshot_collect(table, p);
+
+	// 排他解除
+	pthread_mutex_unlock(&table->mutex);
+
+	*entry = p;
+
+	return num;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief M46E-PR Table スナップショット採取関数
+//!
+//! テーブル内の全エントリを、ENTRY 追加コマンドのレコードとして採取する。
+//! 採取したレコードは m46e_pt_sync_config_table() にそのまま渡すことができる。
+//! 領域は本関数内で確保するので、呼び出し元でfreeすること。
+//!
+//! @param [in]     table   採取するM46E-PR Table
+//! @param [out]    record  採取したレコードの格納先
+//!
+//! @return 0以上       採取したレコード数
+//!         -1          NG(引数異常、メモリ確保失敗)
+///////////////////////////////////////////////////////////////////////////////
+int m46e_pt_snapshot_config_table(mx6e_config_table_t * table, mx6e_load_batch_record_t ** record)
+{
+	mx6e_command_code_t             add_code;
+	mx6e_config_entry_t            *entry;
+	mx6e_load_batch_record_t       *p;
+	int                             num;
+
+	// 引数チェック
+	if ((table == NULL) || (record == NULL)) {
+		mx6e_logging(LOG_ERR, "Parameter Check NG(%s).", __func__);
+		return -1;
+	}
+	add_code = (CONFIG_TYPE_M46E == table->type) ? MX6E_ADD_M46E_ENTRY : MX6E_ADD_ME6E_ENTRY;
+
+	num = m46e_pt_copy_config_table(table, &entry);
+	if (num < 0) {
+		return -1;
+	}
+	p = malloc(sizeof(mx6e_load_batch_record_t) * max(num, 1));
+	if (p == NULL) {
+		mx6e_logging(LOG_ERR, "snapshot allocation failed\n");
+		free(entry);
+		return -1;
+	}
+
+	for (int i = 0; i < num; i++) {
+		p[i].line = i + 1;
+		p[i].code = add_code;
+		p[i].entry = entry[i];
+	}
+	free(entry);
+
+	*record = p;
+
+	return num;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief M46E-PR Table 一括復元関数
+//!
+//! m46e_pt_copy_config_table() で複写したエントリを空のテーブルへ一括で登録する。
+//! 内部生成項目は複写時点の値をそのまま使用し、ENTRY 追加コマンドの
+//! 入力チェックと make_config_entry() を省略する。
+//! デバイス設定が複写時点から変わっている場合は remake を true にすること
+//! (内部生成項目を現在のデバイス設定で生成し直す)。
+//! 有効なエントリは経路を追加する。版数は復元全体で1つ進める。
+//!
+//! @param [in/out] table   復元先のM46E-PR Table
+//! @param [in]     entry   復元するエントリ
+//! @param [in]     num     復元するエントリ数
+//! @param [in]     devices デバイス設定
+//! @param [in]     remake  内部生成項目を生成し直すかどうか
+//!
+//! @return 0以上       復元したエントリ数
+//!         -1          NG(引数異常)
+///////////////////////////////////////////////////////////////////////////////
+int m46e_pt_restore_config_table(mx6e_config_table_t * table, const mx6e_config_entry_t * entry, int num, mx6e_config_devices_t * devices, bool remake)
+{
+	mx6e_config_entry_t           **r;
+	mx6e_config_entry_t            *p;
+	int                             restored = 0;
+
+	// 引数チェック
+	if ((table == NULL) || ((entry == NULL) && (num > 0)) || (devices == NULL)) {
+		mx6e_logging(LOG_ERR, "Parameter Check NG(%s).", __func__);
+		return -1;
+	}
+
+	// 排他開始
+	pthread_mutex_lock(&table->mutex);
+
+	for (int i = 0; i < num; i++) {
+		if (PT_MAX_ENTRY_NUM <= table->num) {
+			mx6e_logging(LOG_INFO, "MX6E-PR config table is enough. num = %d\n", table->num);
+			break;
+		}
+		p = malloc(sizeof(mx6e_config_entry_t));
+		if (p == NULL) {
+			mx6e_logging(LOG_ERR, "Out of memory.");
+			break;
+		}
+		*p = entry[i];
+		if (remake && !make_config_entry(p, table->type, devices)) {
+			mx6e_logging(LOG_INFO, "MX6E-PR make_config_entry fail\n");
+			free(p);
+			continue;
+		}
+		if (NULL == (r = tsearch((void *)p, &table->root, compfind))) {
+			mx6e_logging(LOG_ERR, "Out of memory.");
+			free(p);
+			break;
+		} else if (*r != p) {
+			mx6e_logging(LOG_ERR, "This entry is is already exists.");
+			free(p);
+			continue;
+		} else if (!group_insert(table, p)) {
+			mx6e_logging(LOG_ERR, "Out of memory.");
+			tdelete(p, &table->root, compfind);
+			free(p);
+			break;
+		}
+		table->num++;
+		table->hash += m46e_pt_config_entry_hash(table->type, p);
+		MX6E_PROBE2(entry_add, table->type, p);
+		if (p->enable) {
+			mx6e_route_request(AF_INET6, get_domain_src_ifindex(p->domain, devices), &p->src.tunnel_addr, p->src.tunnel_prefix_len, true);
+		}
+		restored++;
+	}
+	if (restored > 0) {
+		table->version++;
+	}
+
+	// 排他解除
+	pthread_mutex_unlock(&table->mutex);
+
+	return restored;
+}
+
+//! 経路に触れずにテーブルを解放する場合のノード解放関数
+static void tdrelease(void *nodep)
+{
+	free(nodep);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief M46E-PR Table 解放関数(経路維持)
+//!
+//! テーブル内の全エントリを、経路を削除せずに解放する。
+//! ホットリスタートで新プロセスへ引き継いだ経路を残したまま終了する場合に使用する。
+//!
+//! @param [in/out] table   解放するM46E-PR Table
+//!
+//! @return none
+///////////////////////////////////////////////////////////////////////////////
+void m46e_pt_release_config_table(mx6e_config_table_t * table)
+{
+	// 引数チェック
+	if (table == NULL) {
+		mx6e_logging(LOG_ERR, "Parameter Check NG(%s).", __func__);
+		return;
+	}
+
+	// 排他開始
+	pthread_mutex_lock(&table->mutex);
+
+	m46e_pt_release_match_group(table);
+	tdestroy(table->root, tdrelease);
+	table->root = NULL;
+	table->num = 0;
+
+	// 排他解除
+	pthread_mutex_unlock(&table->mutex);
+
+	return;
+}
@@ -20,7 +20,10 @@
 #	include "mx6eapp_command_data.h"
 
 //! MX6E PT Table 最大エントリー数(m46e と me6e別々に)
-#   define PT_MAX_ENTRY_NUM    4096
+//! 性能測定(make bench)では大規模テーブルを作るためビルド時に上書きする
+#   ifndef PT_MAX_ENTRY_NUM
+#      define PT_MAX_ENTRY_NUM    4096
+#   endif
 
 //! CIDR2(プレフィックス)をサブネットマスク(xxx.xxx.xxx.xxx)へ変換
 #   define PR_CIDR2SUBNETMASK(cidr, mask) mask.s_addr = (cidr == 0 ? 0 : htonl(0xFFFFFFFF << (32 - cidr)))
@@ -50,6 +53,17 @@ typedef enum {
 	MX6E_PT_COMMAND_MAX
 } mx6e_pr_command_error_code_t;
 
+//! M46E-PR Table 同期結果
+typedef struct {
+	int                             added;			///< 追加数
+	int                             deleted;		///< 削除数
+	int                             modified;		///< 変更数(削除後に追加)
+	int                             enabled;		///< 活性化数
+	int                             disabled;		///< 非活性化数
+	int                             unchanged;		///< 変更無し数
+	int                             failed;			///< 反映失敗数
+} mx6e_sync_result_t;
+
 ///////////////////////////////////////////////////////////////////////////////
 // 外部関数プロトタイプ
 ///////////////////////////////////////////////////////////////////////////////
@@ -69,6 +83,14 @@ void                            m46e_pt_print_error(int fd, mx6e_pr_command_erro
 
 bool                            mx6eapp_pt_convert_network_addr(struct in_addr *inaddr, int cidr, struct in_addr *outaddr);
 bool                            mx6eapp_pt_check_network_addr(struct in_addr *addr, int cidr);
-void                            m46e_pt_show_entry_pr_table(mx6e_config_table_t * pr_handler, int fd, char *plane_id);
+void                            m46e_pt_show_entry_pr_table(mx6e_config_table_t * table, mx6e_show_table_t * show, int fd, char *process_name);
+uint64_t                        m46e_pt_config_entry_hash(table_type_t type, const mx6e_config_entry_t * entry);
+bool                            m46e_pt_sync_config_table(mx6e_config_table_t * table, mx6e_load_batch_record_t * record, int num, mx6e_config_devices_t * devices, mx6e_sync_result_t * result, int *failed_line);
+void                            m46e_pt_show_version(mx6e_config_table_t * table, int fd);
+int                             m46e_pt_copy_config_table(mx6e_config_table_t * table, mx6e_config_entry_t ** entry);
+int                             m46e_pt_restore_config_table(mx6e_config_table_t * table, const mx6e_config_entry_t * entry, int num, mx6e_config_devices_t * devices, bool remake);
+int                             m46e_pt_snapshot_config_table(mx6e_config_table_t * table, mx6e_load_batch_record_t ** record);
+void                            m46e_pt_release_config_table(mx6e_config_table_t * table);
+void                            m46e_pt_release_match_group(mx6e_config_table_t * table);
 
 #endif												// __MX6EAPP_PR_H__
@@ -26,6 +26,7 @@
 #include <sys/wait.h>
 #include <sys/mount.h>
 #include <sys/signalfd.h>
+#include <sys/mman.h>
 
 #include "mx6eapp.h"
 #include "mx6eapp_pt_mainloop.h"
@@ -36,12 +37,50 @@
 #include "mx6eapp_pt.h"
 #include "mx6eapp_command_data.h"
 #include "mx6eapp_setup.h"
+#include "mx6eapp_handover.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! 同時接続可能なコマンドクライアント数
+#define COMMAND_CLIENT_MAX      32
+//! コマンドクライアントの無通信タイムアウト[sec]
+#define COMMAND_CLIENT_TIMEOUT  60
+//! 応答出力の1メッセージあたりの最大長(mx6ectlの受信バッファ長以下)
+#define COMMAND_OUTPUT_CHUNK    256
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! コマンドクライアント状態
+typedef enum {
+	COMMAND_CLIENT_NONE,							///< 未使用
+	COMMAND_CLIENT_RECV,							///< 要求受信待ち
+	COMMAND_CLIENT_LOAD,							///< 一括読み込みレコード受信中
+	COMMAND_CLIENT_SEND,							///< 出力送信中
+} command_client_state_t;
+
+//! コマンドクライアント
+typedef struct {
+	command_client_state_t          state;			///< 状態
+	int                             sock;			///< 接続ソケット
+	int                             out_fd;			///< 出力の一時格納先(memfd)
+	off_t                           out_offset;		///< 送信済み出力長
+	off_t                           out_len;		///< 出力長
+	time_t                          last;			///< 最終通信時刻
+	mx6e_load_batch_t               batch;			///< 一括読み込み状態
+} command_client_t;
 
 ////////////////////////////////////////////////////////////////////////////////
 // 内部関数プロトタイプ宣言
 ////////////////////////////////////////////////////////////////////////////////
 static bool                     signal_handler(int fd, mx6e_handler_t * handler);
-static bool                     command_handler(int fd, mx6e_handler_t * handler);
+static void                     command_accept(int fd, command_client_t * client);
+static bool                     command_handler(command_client_t * client, mx6e_handler_t * handler);
+static void                     command_load(command_client_t * client, mx6e_handler_t * handler);
+static void                     command_send(command_client_t * client);
+static void                     command_client_close(command_client_t * client);
+static bool                     command_output_ready(command_client_t * client);
 
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief PTネットワーク用のメインループ
@@ -63,7 +102,7 @@ bool mx6e_pt_mainloop(mx6e_handler_t * handler)
 
 	snprintf(offset, sizeof(path) - 1, MX6E_COMMAND_SOCK_NAME, handler->conf.general.process_name);
 
-	command_fd = socket(PF_UNIX, SOCK_SEQPACKET, 0);
+	command_fd = socket(PF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
 	if (command_fd < 0) {
 		mx6e_logging(LOG_ERR, "fail to create command socket : %s\n", strerror(errno));
 		return false;
@@ -75,7 +114,13 @@ bool mx6e_pt_mainloop(mx6e_handler_t * handler)
 	addr.sun_family = AF_UNIX;
 	memcpy(addr.sun_path, path, sizeof(addr.sun_path));
 
-	if (bind(command_fd, (struct sockaddr *) &addr, sizeof(addr))) {
+	// ホットリスタートの場合は引き継ぎ元のプロセスがソケットを閉じるまで待つ
+	int                             retry = (handler->handover == MX6E_HANDOVER_TAKEN) ? (HANDOVER_TIMEOUT * 1000 / HANDOVER_BIND_INTERVAL) : 0;
+	int                             ret_bind;
+	while (((ret_bind = bind(command_fd, (struct sockaddr *) &addr, sizeof(addr))) != 0) && (errno == EADDRINUSE) && (retry-- > 0)) {
+		usleep(HANDOVER_BIND_INTERVAL * 1000);
+	}
+	if (ret_bind) {
 		mx6e_logging(LOG_ERR, "fail to bind command socket : %s\n", strerror(errno));
 		close(command_fd);
 		return false;
@@ -86,26 +131,69 @@ bool mx6e_pt_mainloop(mx6e_handler_t * handler)
 		close(command_fd);
 		return false;
 	}
-	// selector用のファイディスクリプタ設定
-	// (待ち受けるディスクリプタの最大値+1)
-	max_fd = -1;
-	max_fd = max(max_fd, command_fd);
-	max_fd = max(max_fd, handler->signalfd);
-	max_fd++;
 
-	_D_(printf("PT network mainloop start max_fd:%d\n", max_fd));
+	// レート履歴採取用タイマ生成
+	if (!mx6e_rate_init(&handler->rate)) {
+		close(command_fd);
+		return false;
+	}
+	// コマンドクライアント初期化
+	command_client_t               *client = calloc(COMMAND_CLIENT_MAX, sizeof(command_client_t));
+	if (client == NULL) {
+		mx6e_logging(LOG_ERR, "command client allocation failed\n");
+		mx6e_rate_destruct(&handler->rate);
+		close(command_fd);
+		return false;
+	}
+	for (int i = 0; i < COMMAND_CLIENT_MAX; i++) {
+		client[i].sock = -1;
+		client[i].out_fd = -1;
+	}
+
+	_D_(printf("PT network mainloop start\n"));
 
 	// スタートアップスクリプトをバックグラウンドで起動
-	mx6e_startup_script(handler);
+	// (ホットリスタートの場合はデバイスと経路が設定済みなので起動しない)
+	if (handler->handover != MX6E_HANDOVER_TAKEN) {
+		mx6e_startup_script(handler);
+	}
 
 	// mainloop4
-	while (1) {
+	bool                            loop = true;
+	while (loop) {
+		fd_set                          wfds;
+
 		FD_ZERO(&fds);
+		FD_ZERO(&wfds);
 		FD_SET(command_fd, &fds);
 		FD_SET(handler->signalfd, &fds);
+		FD_SET(handler->rate.timerfd, &fds);
+
+		// selector用のファイディスクリプタ設定
+		// (待ち受けるディスクリプタの最大値+1)
+		max_fd = -1;
+		max_fd = max(max_fd, command_fd);
+		max_fd = max(max_fd, handler->signalfd);
+		max_fd = max(max_fd, handler->rate.timerfd);
+		for (int i = 0; i < COMMAND_CLIENT_MAX; i++) {
+			switch (client[i].state) {
+			case COMMAND_CLIENT_RECV:
+			case COMMAND_CLIENT_LOAD:
+				FD_SET(client[i].sock, &fds);
+				max_fd = max(max_fd, client[i].sock);
+				break;
+			case COMMAND_CLIENT_SEND:
+				FD_SET(client[i].sock, &wfds);
+				max_fd = max(max_fd, client[i].sock);
+				break;
+			default:
+				break;
+			}
+		}
+		max_fd++;
 
 		// 受信待ち
-		if (select(max_fd, &fds, NULL, NULL, NULL) < 0) {
+		if (select(max_fd, &fds, &wfds, NULL, NULL) < 0) {
 			if (errno == EINTR) {
 				mx6e_logging(LOG_INFO, "PT netowrk mainloop receive signal\n");
 				continue;
@@ -117,24 +205,73 @@ bool mx6e_pt_mainloop(mx6e_handler_t * handler)
 
 		_D_(printf("recv data\n"));
 
-		if (FD_ISSET(command_fd, &fds)) {
-			DEBUG_LOG("command receive\n");
-			if (!command_handler(command_fd, handler)) {
+		if (FD_ISSET(handler->signalfd, &fds)) {
+			DEBUG_LOG("signal receive\n");
+			if (!signal_handler(handler->signalfd, handler)) {
 				// ハンドラの戻り値がfalseの場合はループを抜ける
 				break;
 			}
 		}
 
-		if (FD_ISSET(handler->signalfd, &fds)) {
-			DEBUG_LOG("signal receive\n");
-			if (!signal_handler(handler->signalfd, handler)) {
-				// ハンドラの戻り値が0より大きい場合はループを抜ける
+		if (FD_ISSET(handler->rate.timerfd, &fds)) {
+			// 統計情報のスナップショット採取
+			mx6e_rate_sampling(&handler->rate, &handler->stat_info);
+
+			// テーブルスナップショットの定期保存
+			mx6e_snapshot_tick(&handler->snapshot, &handler->conf);
+
+			// 無通信のクライアントを切断
+			time_t                          now = time(NULL);
+			for (int i = 0; i < COMMAND_CLIENT_MAX; i++) {
+				if ((client[i].state != COMMAND_CLIENT_NONE) && (now - client[i].last > COMMAND_CLIENT_TIMEOUT)) {
+					mx6e_logging(LOG_INFO, "command client timeout\n");
+					command_client_close(&client[i]);
+				}
+			}
+		}
+
+		// 既存クライアントの処理(1回のselectで各クライアント1イベントのみ処理する)
+		for (int i = 0; (i < COMMAND_CLIENT_MAX) && loop; i++) {
+			switch (client[i].state) {
+			case COMMAND_CLIENT_RECV:
+				if (FD_ISSET(client[i].sock, &fds)) {
+					DEBUG_LOG("command receive\n");
+					if (!command_handler(&client[i], handler)) {
+						// ハンドラの戻り値がfalseの場合はループを抜ける
+						loop = false;
+					}
+				}
+				break;
+			case COMMAND_CLIENT_LOAD:
+				if (FD_ISSET(client[i].sock, &fds)) {
+					command_load(&client[i], handler);
+				}
+				break;
+			case COMMAND_CLIENT_SEND:
+				if (FD_ISSET(client[i].sock, &wfds)) {
+					command_send(&client[i]);
+				}
+				break;
+			default:
 				break;
 			}
 		}
+
+		if (FD_ISSET(command_fd, &fds)) {
+			DEBUG_LOG("command accept\n");
+			command_accept(command_fd, client);
+		}
 	}
 	DEBUG_LOG("PT network mainloop end.\n");
 
+	for (int i = 0; i < COMMAND_CLIENT_MAX; i++) {
+		command_client_close(&client[i]);
+	}
+	free(client);
+
+	mx6e_rate_destruct(&handler->rate);
+	close(command_fd);
+
 	return true;
 }
 
@@ -181,11 +318,16 @@ static bool signal_handler(int fd, mx6e_handler_t * handler)
 	case SIGINT:
 	case SIGTERM:
 	case SIGQUIT:
-	case SIGHUP:
 		DEBUG_LOG("signal %d catch. finish process.\n", siginfo.ssi_signo);
 		result = false;
 		break;
 
+	case SIGHUP:
+		DEBUG_LOG("signal %d catch. reload config.\n", siginfo.ssi_signo);
+		mx6eapp_reload_config(handler, -1);
+		result = true;
+		break;
+
 	default:
 		DEBUG_LOG("signal %d catch. ignore...\n", siginfo.ssi_signo);
 		result = true;
@@ -196,43 +338,204 @@ static bool signal_handler(int fd, mx6e_handler_t * handler)
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-//! @brief PTネットワーク用内部コマンドハンドラ
+//! @brief コマンドクライアント受け付け関数
 //!
-//! 親プロセス(PTネットワーク側)からの要求受信時に呼ばれるハンドラ。
+//! コマンドソケットへの接続を受け付け、空きクライアントに登録する。
+//! 接続ソケットはノンブロッキングとし、以降の送受信はメインループの
+//! selectで可能になった時点でおこなう。
 //!
-//! @param [in] fd      コマンドを受信したソケットのディスクリプタ
-//! @param [in] handler MX6Eハンドラ
+//! @param [in]     fd      コマンド待ち受けソケットのディスクリプタ
+//! @param [in,out] client  コマンドクライアント配列
 //!
-//! @retval true   メインループを継続する
-//! @retval false  メインループを継続しない
+//! @return なし
 ///////////////////////////////////////////////////////////////////////////////
-static bool command_handler(int fd, mx6e_handler_t * handler)
+static void command_accept(int fd, command_client_t * client)
 {
-	mx6e_command_t                  command;
-	int                             ret;
 	int                             sock;
+	command_client_t               *c = NULL;
 
-	sock = accept(fd, NULL, 0);
-	if (sock <= 0) {
-		return true;
+	sock = accept4(fd, NULL, 0, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if (sock < 0) {
+		return;
 	}
 	DEBUG_LOG("accept ok\n");
 
-	if (fcntl(sock, F_SETFD, FD_CLOEXEC)) {
-		mx6e_logging(LOG_ERR, "fail to set close-on-exec flag : %s\n", strerror(errno));
-		close(sock);
-		return true;
-	}
-
 	int                             opt = 1;
 	if (setsockopt(sock, SOL_SOCKET, SO_PASSCRED, &opt, sizeof(opt))) {
 		mx6e_logging(LOG_ERR, "fail to set sockopt SO_PASSCRED : %s\n", strerror(errno));
 		close(sock);
-		return true;
+		return;
+	}
+
+	for (int i = 0; i < COMMAND_CLIENT_MAX; i++) {
+		if (client[i].state == COMMAND_CLIENT_NONE) {
+			c = &client[i];
+			break;
+		}
+	}
+	if (c == NULL) {
+		mx6e_logging(LOG_WARNING, "too many command clients. connection refused\n");
+		close(sock);
+		return;
+	}
+
+	c->state = COMMAND_CLIENT_RECV;
+	c->sock = sock;
+	c->out_fd = -1;
+	c->out_offset = 0;
+	c->out_len = 0;
+	c->last = time(NULL);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief コマンドクライアント切断関数
+//!
+//! @param [in,out] client  コマンドクライアント
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void command_client_close(command_client_t * client)
+{
+	if (client->state == COMMAND_CLIENT_NONE) {
+		return;
+	}
+	if (client->state == COMMAND_CLIENT_LOAD) {
+		mx6eapp_load_batch_destruct(&client->batch);
+	}
+	if (client->out_fd >= 0) {
+		close(client->out_fd);
+	}
+	close(client->sock);
+
+	client->state = COMMAND_CLIENT_NONE;
+	client->sock = -1;
+	client->out_fd = -1;
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 出力送信開始関数
+//!
+//! 一時格納先に書き込まれた出力の送信を開始する。
+//!
+//! @param [in,out] client  コマンドクライアント
+//!
+//! @retval true   送信開始
+//! @retval false  出力無し(クライアントは切断済み)
+///////////////////////////////////////////////////////////////////////////////
+static bool command_output_ready(command_client_t * client)
+{
+	client->out_len = lseek(client->out_fd, 0, SEEK_END);
+	client->out_offset = 0;
+	if (client->out_len <= 0) {
+		command_client_close(client);
+		return false;
+	}
+	client->state = COMMAND_CLIENT_SEND;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 出力送信関数
+//!
+//! 一時格納先の出力を、ソケットが送信可能な分だけ送信する。
+//! 全て送信した時点でクライアントを切断する。
+//!
+//! @param [in,out] client  コマンドクライアント
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void command_send(command_client_t * client)
+{
+	char                            buf[COMMAND_OUTPUT_CHUNK];
+
+	while (client->out_offset < client->out_len) {
+		ssize_t                         len = pread(client->out_fd, buf, sizeof(buf), client->out_offset);
+		if (len <= 0) {
+			mx6e_logging(LOG_ERR, "fail to read command output : %s\n", strerror(errno));
+			command_client_close(client);
+			return;
+		}
+		ssize_t                         ret = send(client->sock, buf, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (ret < 0) {
+			if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) {
+				// 続きは次回送信可能になった時点で送信する
+				return;
+			}
+			DEBUG_LOG("fail to send command output : %s\n", strerror(errno));
+			command_client_close(client);
+			return;
+		}
+		client->out_offset += ret;
+		client->last = time(NULL);
 	}
 
+	command_client_close(client);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 一括読み込みレコード受信関数
+//!
+//! @param [in,out] client  コマンドクライアント
+//! @param [in]     handler MX6Eハンドラ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void command_load(command_client_t * client, mx6e_handler_t * handler)
+{
+	if (!mx6eapp_load_batch_recv(handler, &client->batch, client->sock)) {
+		command_client_close(client);
+		return;
+	}
+	client->last = time(NULL);
+
+	if (client->batch.received >= client->batch.num) {
+		mx6eapp_load_batch_print(&client->batch, client->out_fd);
+		mx6eapp_load_batch_destruct(&client->batch);
+		command_output_ready(client);
+	}
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief PTネットワーク用内部コマンドハンドラ
+//!
+//! コマンドクライアントからの要求受信時に呼ばれるハンドラ。
+//! コマンドの出力は一時格納先に書き込み、送信はメインループで
+//! ソケットが送信可能になった時点でおこなう。
+//!
+//! @param [in,out] client  コマンドクライアント
+//! @param [in]     handler MX6Eハンドラ
+//!
+//! @retval true   メインループを継続する
+//! @retval false  メインループを継続しない
+///////////////////////////////////////////////////////////////////////////////
+static bool command_handler(command_client_t * client, mx6e_handler_t * handler)
+{
+	mx6e_command_t                  command;
+	int                             ret;
+	int                             sock = client->sock;
+	int                             out;
+
 	ret = mx6e_socket_recv_cred(sock, &command.code, &command.req, sizeof(command.req));
 	DEBUG_LOG("command receive. code = %d(%s),ret = %d\n", command.code, get_command_name(command.code), ret);
+	if ((ret == -EAGAIN) || (ret == -EWOULDBLOCK) || (ret == -EINTR)) {
+		// 受信データ無し
+		return true;
+	}
+	if (ret == 0) {
+		// 切断
+		command_client_close(client);
+		return true;
+	}
+	client->last = time(NULL);
 
 	// コマンド応答
 	switch (command.code) {
@@ -250,6 +553,17 @@ static bool command_handler(int fd, mx6e_handler_t * handler)
 	case MX6E_SHOW_ME6E_ENTRY:						// PR ENTRY 表示要求
 	case MX6E_SET_DEBUG_LOG:						// デバッグログ出力設定 要求
 	case MX6E_SHOW_STATISTIC:						// 統計表示
+	case MX6E_SHOW_RATE:							// レート履歴表示
+	case MX6E_DUMP_DROPS:							// 破棄パケット出力
+	case MX6E_SHOW_TOP:								// 宛先/64別負荷上位表示
+	case MX6E_SHOW_MISSES:							// エントリ未登録宛先表示
+	case MX6E_LOAD_BATCH:							// ENTRY 一括読み込み
+	case MX6E_SYNC_M46E_ENTRY:						// ENTRY 同期要求
+	case MX6E_SYNC_ME6E_ENTRY:						// ENTRY 同期要求
+	case MX6E_SHOW_M46E_VERSION:					// テーブル版数表示要求
+	case MX6E_SHOW_ME6E_VERSION:					// テーブル版数表示要求
+	case MX6E_HANDOVER:								// ホットリスタート引き継ぎ要求
+	case MX6E_RELOAD_CONFIG:						// 設定ファイル再読み込み要求
 	case MX6E_SHOW_CONF:							// 設定ファイル構造体ダンプ
 	case MX6E_SHUTDOWN:
 	case MX6E_RESTART:
@@ -265,9 +579,9 @@ static bool command_handler(int fd, mx6e_handler_t * handler)
 			mx6e_logging(LOG_WARNING, "fail to send response to external command : %s\n", strerror(-ret));
 		}
 		if (command.res.result != 0) {
-			// エラー終了
-			close(sock);
-			return false;
+			// エラー終了(当該クライアントのみ切断する)
+			command_client_close(client);
+			return true;
 		}
 
 		break;
@@ -276,6 +590,15 @@ static bool command_handler(int fd, mx6e_handler_t * handler)
 		mx6e_logging(LOG_WARNING, "unknown command code(%d) ignore...\n", command.code);
 	}
 
+	// 出力の一時格納先を生成
+	out = memfd_create("mx6e_command", MFD_CLOEXEC);
+	if (out < 0) {
+		mx6e_logging(LOG_ERR, "fail to create command output buffer : %s\n", strerror(errno));
+		command_client_close(client);
+		return true;
+	}
+	client->out_fd = out;
+
 	bool                            result = false;
 	mx6e_config_table_t            *table = NULL;
 	mx6e_config_devices_t          *devices = NULL;
@@ -288,6 +611,7 @@ static bool command_handler(int fd, mx6e_handler_t * handler)
 	case MX6E_ENABLE_M46E_ENTRY:					// PR ENTRY 活性化要求
 	case MX6E_DISABLE_M46E_ENTRY:					// PR ENTRY 非活性化要求
 	case MX6E_SHOW_M46E_ENTRY:						// PR ENTRY 表示要求
+	case MX6E_SHOW_M46E_VERSION:					// テーブル版数表示要求
 		table = &handler->conf.m46e_conf_table;
 		devices = &handler->conf.devices;
 		break;
@@ -298,6 +622,7 @@ static bool command_handler(int fd, mx6e_handler_t * handler)
 	case MX6E_ENABLE_ME6E_ENTRY:					// PR ENTRY 活性化要求
 	case MX6E_DISABLE_ME6E_ENTRY:					// PR ENTRY 非活性化要求
 	case MX6E_SHOW_ME6E_ENTRY:						// PR ENTRY 表示要求
+	case MX6E_SHOW_ME6E_VERSION:					// テーブル版数表示要求
 		table = &handler->conf.me6e_conf_table;
 		devices = &handler->conf.devices;
 		break;
@@ -313,7 +638,7 @@ static bool command_handler(int fd, mx6e_handler_t * handler)
 		if (!m46e_pt_add_config_entry(table, &command.req.mx6e_data.entry, devices)) {
 			// エントリ登録失敗
 			// ここでConsoleに要求コマンド失敗のエラーを返す。
-			m46e_pt_print_error(sock, MX6E_PT_COMMAND_EXEC_FAILURE);
+			m46e_pt_print_error(out, MX6E_PT_COMMAND_EXEC_FAILURE);
 
 			mx6e_logging(LOG_ERR, "fail to add MX6E-PR Entry to MX6E-PR Table\n");
 		}
@@ -325,7 +650,7 @@ static bool command_handler(int fd, mx6e_handler_t * handler)
 		if (!m46e_pt_del_config_entry(table, &command.req.mx6e_data.entry, devices)) {
 			// エントリ削除失敗
 			// ここでConsoleに要求コマンド失敗のエラーを返す。
-			m46e_pt_print_error(sock, MX6E_PT_COMMAND_EXEC_FAILURE);
+			m46e_pt_print_error(out, MX6E_PT_COMMAND_EXEC_FAILURE);
 
 			mx6e_logging(LOG_ERR, "fail to del MX6E-PR Entry to MX6E-PR Table\n");
 		}
@@ -336,7 +661,7 @@ static bool command_handler(int fd, mx6e_handler_t * handler)
 	case MX6E_DELALL_ME6E_ENTRY:					// PR ENTRY 全削除要求
 		if (!m46e_pt_delall_config_entry(handler, command.code)) {
 			// エントリ削除失敗
-			m46e_pt_print_error(sock, MX6E_PT_COMMAND_EXEC_FAILURE);
+			m46e_pt_print_error(out, MX6E_PT_COMMAND_EXEC_FAILURE);
 			mx6e_logging(LOG_ERR, "fail to del all MX6E-PR Entry to MX6E-PR Table\n");
 		}
 		result = true;
@@ -346,7 +671,7 @@ static bool command_handler(int fd, mx6e_handler_t * handler)
 	case MX6E_ENABLE_ME6E_ENTRY:					// PR ENTRY 活性化要求
 		if (!m46e_pt_enable_config_entry(table, &command.req.mx6e_data.entry, devices)) {
 			// エントリ活性化失敗
-			m46e_pt_print_error(sock, MX6E_PT_COMMAND_EXEC_FAILURE);
+			m46e_pt_print_error(out, MX6E_PT_COMMAND_EXEC_FAILURE);
 			mx6e_logging(LOG_ERR, "fail to enable MX6E-PR Entry\n");
 		}
 		result = true;
@@ -356,7 +681,7 @@ static bool command_handler(int fd, mx6e_handler_t * handler)
 	case MX6E_DISABLE_ME6E_ENTRY:					// PR ENTRY 非活性化要求
 		if (!m46e_pt_enable_config_entry(table, &command.req.mx6e_data.entry, devices)) {
 			// エントリ非活性化失敗
-			m46e_pt_print_error(sock, MX6E_PT_COMMAND_EXEC_FAILURE);
+			m46e_pt_print_error(out, MX6E_PT_COMMAND_EXEC_FAILURE);
 			mx6e_logging(LOG_ERR, "fail to disable MX6E-PR Entry\n");
 		}
 		result = true;
@@ -364,12 +689,18 @@ static bool command_handler(int fd, mx6e_handler_t * handler)
 
 	case MX6E_SHOW_M46E_ENTRY:						// PR ENTRY 表示要求
 	case MX6E_SHOW_ME6E_ENTRY:						// PR ENTRY 表示要求
-		m46e_pt_show_entry_pr_table(table, sock, handler->conf.general.process_name);
+		m46e_pt_show_entry_pr_table(table, &command.req.mx6e_show, out, handler->conf.general.process_name);
+		result = true;
+		break;
+
+	case MX6E_SHOW_M46E_VERSION:					// テーブル版数表示要求
+	case MX6E_SHOW_ME6E_VERSION:					// テーブル版数表示要求
+		m46e_pt_show_version(table, out);
 		result = true;
 		break;
 
 	case MX6E_SET_DEBUG_LOG:						// デバッグログ出力設定 要求
-		if (mx6eapp_set_debug_log(handler, &command, sock)) {
+		if (mx6eapp_set_debug_log(handler, &command, out)) {
 		} else {
 			mx6e_logging(LOG_ERR, "fail to set debug_log mode\n");
 		}
@@ -377,16 +708,86 @@ static bool command_handler(int fd, mx6e_handler_t * handler)
 		break;
 
 	case MX6E_SHOW_CONF:							// 設定ファイル構造体ダンプ
-		mx6e_config_dump(&handler->conf, sock);
+		mx6e_config_dump(&handler->conf, out);
+		result = true;
+		break;
+
+	case MX6E_RELOAD_CONFIG:						// 設定ファイル再読み込み要求
+		if (!mx6eapp_reload_config(handler, out)) {
+			mx6e_logging(LOG_ERR, "fail to reload config file\n");
+		}
 		result = true;
 		break;
 
 	case MX6E_SHOW_STATISTIC:						// 統計表示
-		mx6e_printf_statistics_info_normal(&handler->stat_info, sock);
+		mx6e_printf_statistics_info_normal(&handler->stat_info, out);
+		if (command.req.stat.perf) {
+			mx6e_perf_print(&handler->perf_fp, &handler->perf_pr, &handler->stat_info, out);
+			mx6e_io_print(&handler->io_pr2fp, &handler->io_fp2pr, out);
+		}
 		result = true;
 
 		break;
 
+	case MX6E_SHOW_RATE:							// レート履歴表示
+		mx6e_rate_print(&handler->rate, command.req.rate.since, out);
+		result = true;
+		break;
+
+	case MX6E_DUMP_DROPS:							// 破棄パケット出力
+		if (0 > mx6e_drop_dump_pcapng(&handler->drop_fp, handler->conf.devices.tunnel_fp.name,
+									  &handler->drop_pr, handler->conf.devices.tunnel_pr.name, out)) {
+			mx6e_logging(LOG_ERR, "fail to dump dropped packets\n");
+		}
+		result = true;
+		break;
+
+	case MX6E_SHOW_TOP:								// 宛先/64別負荷上位表示
+		mx6e_topk_print(&handler->topk_fp, &handler->topk_pr, command.req.top.num, out);
+		result = true;
+		break;
+
+	case MX6E_SHOW_MISSES:							// エントリ未登録宛先表示
+		mx6e_miss_print(&handler->miss_fp, &handler->miss_pr, out);
+		result = true;
+		break;
+
+	case MX6E_LOAD_BATCH:							// ENTRY 一括読み込み
+	case MX6E_SYNC_M46E_ENTRY:						// ENTRY 同期要求
+	case MX6E_SYNC_ME6E_ENTRY:						// ENTRY 同期要求
+		if (!mx6eapp_load_batch_init(handler, &client->batch, &command)) {
+			mx6e_logging(LOG_ERR, "fail to load MX6E-PR Entry batch\n");
+			command_client_close(client);
+			return true;
+		}
+		if (client->batch.num > 0) {
+			// 後続レコードはメインループで受信する
+			client->state = COMMAND_CLIENT_LOAD;
+			return true;
+		}
+		mx6eapp_load_batch_print(&client->batch, out);
+		mx6eapp_load_batch_destruct(&client->batch);
+		result = true;
+		break;
+
+	case MX6E_RESTART:
+		// 新プロセスをホットリスタートで起動する(新プロセスからの引き継ぎ要求で終了する)
+		if (!mx6e_handover_spawn(handler)) {
+			mx6e_logging(LOG_ERR, "fail to restart MX6E application\n");
+		}
+		result = true;
+		break;
+
+	case MX6E_HANDOVER:								// ホットリスタート引き継ぎ要求
+		if (mx6e_handover_send(handler, sock)) {
+			// 新プロセスが転送を開始したので、経路に触れずに終了する
+			handler->handover = MX6E_HANDOVER_GIVEN;
+			result = false;
+		} else {
+			result = true;
+		}
+		break;
+
 	case MX6E_SHUTDOWN:
 		// なにもしない
 		break;
@@ -398,7 +799,7 @@ static bool command_handler(int fd, mx6e_handler_t * handler)
 		break;
 	}
 
-	close(sock);
+	command_output_ready(client);
 
 	return result;
 }
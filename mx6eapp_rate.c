@@ -0,0 +1,380 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_rate.c                                                */
+/* 機能概要   : レート履歴管理 ソースファイル                                 */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <stdint.h>
+#include <sys/timerfd.h>
+
+#include "mx6eapp_rate.h"
+#include "mx6eapp_config.h"
+#include "mx6eapp_log.h"
+#include "mx6eapp_util.h"
+
+#define DPRINTF(fd, ...)	if (0 > fd) {printf(__VA_ARGS__);} else {dprintf(fd, __VA_ARGS__);}
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! 1ドメイン分のレート
+typedef struct {
+	double                          rx_pps;			///< 受信パケットレート
+	double                          rx_bps;			///< 受信ビットレート
+	double                          tx_pps;			///< 送信成功パケットレート
+	double                          tx_bps;			///< 送信成功ビットレート
+	double                          broadcast;		///< ブロードキャスト破棄レート
+	double                          other_proto;	///< IPv6以外破棄レート
+	double                          hoplimit;		///< HOPLIMIT超過破棄レート
+	double                          nxthdr;			///< NextHeader不正破棄レート
+	double                          send_err;		///< 送信失敗(エントリ未登録含む)レート
+} rate_value_t;
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief リングバッファ初期化関数
+//!
+//! @param [out] ring リングバッファ
+//! @param [in]  size 格納可能数
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static bool rate_ring_init(mx6e_rate_ring_t * ring, int size)
+{
+	ring->sample = (mx6e_rate_sample_t *) calloc(size, sizeof(mx6e_rate_sample_t));
+	if (ring->sample == NULL) {
+		return false;
+	}
+	ring->size = size;
+	ring->num = 0;
+	ring->head = 0;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief リングバッファ格納関数
+//!
+//! 格納数が上限に達している場合は最も古いスナップショットを上書きする。
+//!
+//! @param [in,out] ring   リングバッファ
+//! @param [in]     sample 格納するスナップショット
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void rate_ring_push(mx6e_rate_ring_t * ring, const mx6e_rate_sample_t * sample)
+{
+	ring->sample[ring->head] = *sample;
+	ring->head = (ring->head + 1) % ring->size;
+	if (ring->num < ring->size) {
+		ring->num++;
+	}
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief リングバッファ参照関数
+//!
+//! @param [in] ring リングバッファ
+//! @param [in] back 最新から遡る数(0:最新)
+//!
+//! @return スナップショット
+///////////////////////////////////////////////////////////////////////////////
+static inline mx6e_rate_sample_t *rate_ring_get(mx6e_rate_ring_t * ring, int back)
+{
+	return &ring->sample[(ring->head - 1 - back + ring->size) % ring->size];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief レート算出関数
+//!
+//! 2つのスナップショットの差分から指定ドメインのレートを算出する。
+//! 採取間隔は時刻設定の変更やタイマの揺らぎに影響されないよう、
+//! 単調増加時刻のナノ秒差分から求める。
+//!
+//! @param [in]  prev    古いスナップショット
+//! @param [in]  cur     新しいスナップショット
+//! @param [in]  domain  算出対象ドメイン
+//! @param [out] value   算出結果
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void rate_calc(mx6e_rate_sample_t * prev, mx6e_rate_sample_t * cur, domain_t domain, rate_value_t * value)
+{
+	mx6e_statistics_t              *p = &prev->stat;
+	mx6e_statistics_t              *c = &cur->stat;
+	double                          sec = (double) (cur->mono_ns - prev->mono_ns) / 1000000000.0;
+
+	if (sec <= 0) {
+		sec = 1;
+	}
+
+	// カウンタの折り返しは符号なし減算で吸収する
+	if (DOMAIN_FP == domain) {
+		value->rx_pps = (uint32_t) (c->fp_recieve - p->fp_recieve) / sec;
+		value->rx_bps = (c->fp_recieve_bytes - p->fp_recieve_bytes) * 8 / sec;
+		value->tx_pps = (uint32_t) ((c->fp_m46e_send_success + c->fp_me6e_send_success)
+									- (p->fp_m46e_send_success + p->fp_me6e_send_success)) / sec;
+		value->tx_bps = (c->fp_send_bytes - p->fp_send_bytes) * 8 / sec;
+		value->broadcast = (uint32_t) (c->fp_err_broadcast - p->fp_err_broadcast) / sec;
+		value->other_proto = (uint32_t) (c->fp_err_other_proto - p->fp_err_other_proto) / sec;
+		value->hoplimit = (uint32_t) (c->fp_err_hoplimit - p->fp_err_hoplimit) / sec;
+		value->nxthdr = (uint32_t) (c->fp_err_nxthdr - p->fp_err_nxthdr) / sec;
+		value->send_err = (uint32_t) ((c->fp_m46e_send_err + c->fp_me6e_send_err)
+									  - (p->fp_m46e_send_err + p->fp_me6e_send_err)) / sec;
+	} else {
+		value->rx_pps = (uint32_t) (c->pr_recieve - p->pr_recieve) / sec;
+		value->rx_bps = (c->pr_recieve_bytes - p->pr_recieve_bytes) * 8 / sec;
+		value->tx_pps = (uint32_t) ((c->pr_m46e_send_success + c->pr_me6e_send_success)
+									- (p->pr_m46e_send_success + p->pr_me6e_send_success)) / sec;
+		value->tx_bps = (c->pr_send_bytes - p->pr_send_bytes) * 8 / sec;
+		value->broadcast = (uint32_t) (c->pr_err_broadcast - p->pr_err_broadcast) / sec;
+		value->other_proto = (uint32_t) (c->pr_err_other_proto - p->pr_err_other_proto) / sec;
+		value->hoplimit = (uint32_t) (c->pr_err_hoplimit - p->pr_err_hoplimit) / sec;
+		value->nxthdr = (uint32_t) (c->pr_err_nxthdr - p->pr_err_nxthdr) / sec;
+		value->send_err = (uint32_t) ((c->pr_m46e_send_err + c->pr_me6e_send_err)
+									  - (p->pr_m46e_send_err + p->pr_me6e_send_err)) / sec;
+	}
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief レート1行出力関数
+//!
+//! @param [in] fd     出力先のディスクリプタ
+//! @param [in] label  行ラベル(時刻等)
+//! @param [in] domain ドメイン
+//! @param [in] value  レート
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void rate_print_line(int fd, const char *label, domain_t domain, rate_value_t * value)
+{
+	DPRINTF(fd, "%-8s %-3s %10.0f %13.0f %10.0f %13.0f %10.0f %11.0f %9.0f %9.0f %9.0f\n",
+			label, get_domain_name(domain),
+			value->rx_pps, value->rx_bps, value->tx_pps, value->tx_bps,
+			value->broadcast, value->other_proto, value->hoplimit, value->nxthdr, value->send_err);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief レート集計関数
+//!
+//! 合計値と最大値を更新する。
+//!
+//! @param [in,out] sum   合計値
+//! @param [in,out] peak  最大値
+//! @param [in]     value レート
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void rate_accumulate(rate_value_t * sum, rate_value_t * peak, rate_value_t * value)
+{
+#define RATE_ACC(member)	sum->member += value->member; peak->member = max(peak->member, value->member);
+	RATE_ACC(rx_pps);
+	RATE_ACC(rx_bps);
+	RATE_ACC(tx_pps);
+	RATE_ACC(tx_bps);
+	RATE_ACC(broadcast);
+	RATE_ACC(other_proto);
+	RATE_ACC(hoplimit);
+	RATE_ACC(nxthdr);
+	RATE_ACC(send_err);
+#undef RATE_ACC
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief レート履歴初期化関数
+//!
+//! 採取周期(1秒)のタイマを生成し、履歴格納領域を確保する。
+//!
+//! @param [out] rate レート履歴管理構造体
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+bool mx6e_rate_init(mx6e_rate_t * rate)
+{
+	struct itimerspec               its = { {1, 0}, {1, 0} };
+
+	memset(rate, 0, sizeof(mx6e_rate_t));
+	rate->timerfd = -1;
+
+	if (!rate_ring_init(&rate->sec, RATE_SEC_SAMPLE_NUM) || !rate_ring_init(&rate->min, RATE_MIN_SAMPLE_NUM)) {
+		mx6e_logging(LOG_ERR, "rate history allocation failed\n");
+		mx6e_rate_destruct(rate);
+		return false;
+	}
+
+	rate->timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (rate->timerfd < 0) {
+		mx6e_logging(LOG_ERR, "fail to create rate timer : %s\n", strerror(errno));
+		mx6e_rate_destruct(rate);
+		return false;
+	}
+
+	if (timerfd_settime(rate->timerfd, 0, &its, NULL)) {
+		mx6e_logging(LOG_ERR, "fail to set rate timer : %s\n", strerror(errno));
+		mx6e_rate_destruct(rate);
+		return false;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief レート履歴解放関数
+//!
+//! @param [in] rate レート履歴管理構造体
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_rate_destruct(mx6e_rate_t * rate)
+{
+	if (rate->timerfd >= 0) {
+		close(rate->timerfd);
+		rate->timerfd = -1;
+	}
+	free(rate->sec.sample);
+	rate->sec.sample = NULL;
+	free(rate->min.sample);
+	rate->min.sample = NULL;
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 統計情報採取関数
+//!
+//! タイマ満了時に呼ばれ、統計情報のスナップショットを1秒粒度の履歴へ格納する。
+//! 60回に1回は1分粒度の履歴へも格納する。
+//!
+//! @param [in,out] rate      レート履歴管理構造体
+//! @param [in]     stat_info 統計情報
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_rate_sampling(mx6e_rate_t * rate, mx6e_statistics_t * stat_info)
+{
+	uint64_t                        expire;
+	mx6e_rate_sample_t              sample;
+	struct timespec                 now;
+
+	// 満了回数を読み捨てる(取りこぼした周期は補完しない)
+	if (read(rate->timerfd, &expire, sizeof(expire)) != sizeof(expire)) {
+		return;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	sample.mono_ns = (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+	sample.time = time(NULL);
+	sample.stat = *stat_info;
+
+	rate_ring_push(&rate->sec, &sample);
+	if (0 == (rate->tick % RATE_SEC_PER_MIN)) {
+		rate_ring_push(&rate->min, &sample);
+	}
+	rate->tick++;
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief レート履歴出力関数
+//!
+//! 指定された期間のレートをドメイン毎に出力する。
+//! 期間が1時間以内なら1秒粒度、それを超える場合は1分粒度の履歴を使用する。
+//!
+//! @param [in] rate  レート履歴管理構造体
+//! @param [in] since 出力対象期間[sec](0以下はデフォルト)
+//! @param [in] fd    出力先のディスクリプタ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_rate_print(mx6e_rate_t * rate, int since, int fd)
+{
+	mx6e_rate_ring_t               *ring;
+	int                             interval;
+	int                             count;
+	rate_value_t                    sum[2] = { {0} };
+	rate_value_t                    peak[2] = { {0} };
+	rate_value_t                    value;
+	domain_t                        domains[2] = { DOMAIN_FP, DOMAIN_PR };
+	char                            label[16];
+
+	if (since <= 0) {
+		since = RATE_SINCE_DEFAULT;
+	}
+	since = min(since, RATE_SINCE_MAX);
+
+	if (since <= RATE_SEC_SAMPLE_NUM) {
+		ring = &rate->sec;
+		interval = 1;
+	} else {
+		ring = &rate->min;
+		interval = RATE_SEC_PER_MIN;
+	}
+	count = (since + interval - 1) / interval;
+	// 差分を取るので格納数-1が上限
+	count = min(count, ring->num - 1);
+
+	DPRINTF(fd, "【MX6E rate】 interval %ds, since %ds\n", interval, since);
+	DPRINTF(fd, "\n");
+	if (ring->sample == NULL || count <= 0) {
+		DPRINTF(fd, "   no sample yet\n");
+		return;
+	}
+
+	DPRINTF(fd, "%-8s %-3s %10s %13s %10s %13s %10s %11s %9s %9s %9s\n",
+			"time", "dom", "rx_pps", "rx_bps", "tx_pps", "tx_bps",
+			"broadcast", "other_proto", "hoplimit", "nxthdr", "send_err");
+
+	for (int i = count; i > 0; i--) {
+		mx6e_rate_sample_t             *prev = rate_ring_get(ring, i);
+		mx6e_rate_sample_t             *cur = rate_ring_get(ring, i - 1);
+		struct tm                       tm;
+
+		localtime_r(&cur->time, &tm);
+		strftime(label, sizeof(label), "%H:%M:%S", &tm);
+
+		for (int d = 0; d < 2; d++) {
+			rate_calc(prev, cur, domains[d], &value);
+			rate_accumulate(&sum[d], &peak[d], &value);
+			rate_print_line(fd, label, domains[d], &value);
+		}
+	}
+
+	DPRINTF(fd, "\n");
+	for (int d = 0; d < 2; d++) {
+		value = sum[d];
+		value.rx_pps /= count;
+		value.rx_bps /= count;
+		value.tx_pps /= count;
+		value.tx_bps /= count;
+		value.broadcast /= count;
+		value.other_proto /= count;
+		value.hoplimit /= count;
+		value.nxthdr /= count;
+		value.send_err /= count;
+		rate_print_line(fd, "average", domains[d], &value);
+	}
+	for (int d = 0; d < 2; d++) {
+		rate_print_line(fd, "max", domains[d], &peak[d]);
+	}
+	DPRINTF(fd, "\n");
+
+	return;
+}
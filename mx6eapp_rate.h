@@ -0,0 +1,65 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_rate.h                                                */
+/* 機能概要   : レート履歴管理 ヘッダファイル                                 */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+#ifndef __MX6EAPP_RATE_H__
+#   define __MX6EAPP_RATE_H__
+
+#   include <stdbool.h>
+#   include <stdint.h>
+#   include <time.h>
+
+#   include "mx6eapp_statistics.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! 1秒粒度の履歴数(1時間分)
+#   define RATE_SEC_SAMPLE_NUM     3600
+//! 1分粒度の履歴数(1日分)
+#   define RATE_MIN_SAMPLE_NUM     1440
+//! 1分あたりの秒数
+#   define RATE_SEC_PER_MIN        60
+//! 履歴表示の最大範囲[sec]
+#   define RATE_SINCE_MAX          (RATE_MIN_SAMPLE_NUM * RATE_SEC_PER_MIN)
+//! 履歴表示の範囲省略時のデフォルト[sec]
+#   define RATE_SINCE_DEFAULT      60
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! 統計情報スナップショット
+typedef struct {
+	time_t                          time;			///< 採取時刻(表示用)
+	uint64_t                        mono_ns;		///< 採取時刻(CLOCK_MONOTONIC[nsec]、レート算出用)
+	mx6e_statistics_t               stat;			///< 採取時点の統計情報
+} mx6e_rate_sample_t;
+
+//! スナップショット格納用リングバッファ
+typedef struct {
+	mx6e_rate_sample_t             *sample;			///< 格納領域
+	int                             size;			///< 格納可能数
+	int                             num;			///< 格納数
+	int                             head;			///< 次回格納位置
+} mx6e_rate_ring_t;
+
+//! レート履歴管理構造体
+typedef struct {
+	int                             timerfd;		///< 採取周期タイマのディスクリプタ
+	unsigned int                    tick;			///< 採取回数
+	mx6e_rate_ring_t                sec;			///< 1秒粒度の履歴
+	mx6e_rate_ring_t                min;			///< 1分粒度の履歴
+} mx6e_rate_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部関数プロトタイプ宣言
+////////////////////////////////////////////////////////////////////////////////
+bool                            mx6e_rate_init(mx6e_rate_t * rate);
+void                            mx6e_rate_destruct(mx6e_rate_t * rate);
+void                            mx6e_rate_sampling(mx6e_rate_t * rate, mx6e_statistics_t * stat_info);
+void                            mx6e_rate_print(mx6e_rate_t * rate, int since, int fd);
+
+#endif												// __MX6EAPP_RATE_H__
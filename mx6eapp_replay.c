@@ -0,0 +1,721 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_replay.c                                              */
+/* 機能概要   : pcapオフライン再生による転送性能測定                          */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <search.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <byteswap.h>
+#include <netinet/in.h>
+#include <netinet/ip6.h>
+#include <netinet/if_ether.h>
+#include <netinet/ether.h>
+#include <arpa/inet.h>
+
+#include "mx6eapp.h"
+#include "mx6eapp_config.h"
+#include "mx6eapp_pt.h"
+#include "mx6eapp_log.h"
+#include "mx6eapp_util.h"
+#include "mx6eapp_tunnel.h"
+#include "mx6eapp_statistics.h"
+#include "mx6eapp_dynamic_setting.h"
+#include "mx6ectl_command.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! pcapのマジックナンバー(マイクロ秒精度)
+#define PCAP_MAGIC_USEC         0xa1b2c3d4
+//! pcapのマジックナンバー(ナノ秒精度)
+#define PCAP_MAGIC_NSEC         0xa1b23c4d
+//! pcapのリンクタイプ
+#define PCAP_LINKTYPE_ETHERNET  1
+#define PCAP_LINKTYPE_RAW       101
+#define PCAP_LINKTYPE_LINUX_SLL 113
+#define PCAP_LINKTYPE_IPV6      229
+//! Linux cooked captureヘッダ長
+#define PCAP_SLL_HDR_LEN        16
+//! 1フレームの最大長(転送スレッドの受信バッファと同じ)
+#define REPLAY_FRAME_MAX        65535
+//! 既定の表示エントリ数
+#define REPLAY_DEFAULT_TOP      10
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! pcapファイルヘッダ
+typedef struct {
+	uint32_t                        magic;			///< マジックナンバー
+	uint16_t                        version_major;	///< 形式版数(メジャー)
+	uint16_t                        version_minor;	///< 形式版数(マイナー)
+	int32_t                         thiszone;		///< タイムゾーン補正
+	uint32_t                        sigfigs;		///< タイムスタンプ精度
+	uint32_t                        snaplen;		///< 最大採取長
+	uint32_t                        linktype;		///< リンクタイプ
+} pcap_file_header_t;
+
+//! pcapレコードヘッダ
+typedef struct {
+	uint32_t                        ts_sec;			///< タイムスタンプ(秒)
+	uint32_t                        ts_frac;		///< タイムスタンプ(マイクロ秒 or ナノ秒)
+	uint32_t                        incl_len;		///< 採取長
+	uint32_t                        orig_len;		///< 元のフレーム長
+} pcap_record_header_t;
+
+//! 再生フレーム
+typedef struct {
+	size_t                          off;			///< フレームデータの位置
+	uint32_t                        len;			///< フレーム長(Ethernetヘッダを含む)
+	mx6e_config_entry_t            *entry;			///< 検索でヒットしたエントリ(NULL:ミス or 検索対象外)
+} replay_frame_t;
+
+//! 再生データ
+typedef struct {
+	char                           *data;			///< フレームデータ(元データ)
+	char                           *work;			///< フレームデータ(転送関数が書き換える作業領域)
+	size_t                          size;			///< フレームデータ長
+	size_t                          capacity;		///< フレームデータ領域長
+	replay_frame_t                 *frame;			///< フレーム一覧
+	int                             num;			///< フレーム数
+	int                             max;			///< フレーム一覧の領域数
+	int                             truncated;		///< 採取長が元のフレーム長より短いフレーム数
+	uint32_t                        linktype;		///< リンクタイプ
+} replay_data_t;
+
+//! エントリ毎のヒット数
+typedef struct {
+	mx6e_config_entry_t            *entry;			///< エントリ
+	table_type_t                    type;			///< テーブルタイプ
+	uint64_t                        hits;			///< ヒット数
+} replay_hit_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部変数
+////////////////////////////////////////////////////////////////////////////////
+//! エントリ毎のヒット数(tsearch)
+static void                    *hit_root = NULL;
+//! エントリ毎のヒット数(表示用一覧)
+static replay_hit_t           **hit_list = NULL;
+//! ヒットしたエントリ数
+static int                      hit_num = 0;
+
+//! コマンドオプション構造体
+// *INDENT-OFF*
+static const struct option      options[] = {
+	{"file",		required_argument,	NULL, 'f'},
+	{"command",		required_argument,	NULL, 'c'},
+	{"snapshot",	no_argument,		NULL, 'S'},
+	{"pcap",		required_argument,	NULL, 'r'},
+	{"side",		required_argument,	NULL, 'd'},
+	{"loops",		required_argument,	NULL, 'l'},
+	{"top",			required_argument,	NULL, 't'},
+	{"help",		no_argument,		NULL, 'h'},
+	{0, 0, 0, 0}
+};
+// *INDENT-ON*
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief コマンド凡例表示関数
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void usage(void)
+{
+	fprintf(stderr, "Usage: mx6e-replay -f CONFIG_FILE [ -c COMMAND_FILE ]... [ -S ] -r PCAP_FILE -d fp|pr\n"
+			"                   [ -l LOOPS ] [ -t TOP ]\n" "\n"
+			"  -f, --file     : config file\n"
+			"  -c, --command  : M46E/ME6E command file to load (same format as mx6ectl load)\n"
+			"  -S, --snapshot : restore tables from snapshot_file of the config file\n"
+			"  -r, --pcap     : pcap file to replay (ethernet, raw IP or linux cooked capture)\n"
+			"  -d, --side     : side the pcap was captured on (fp: FP->PR, pr: PR->FP)\n"
+			"  -l, --loops    : replay count (default 1)\n"
+			"  -t, --top      : number of entries shown in hit distribution (default %d)\n" "\n", REPLAY_DEFAULT_TOP);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 現在時刻取得関数
+//!
+//! @return CLOCK_MONOTONICの現在時刻[ns]
+///////////////////////////////////////////////////////////////////////////////
+static inline double replay_now(void)
+{
+	struct timespec                 ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 再生フレーム追加関数
+//!
+//! Ethernetヘッダが無いリンクタイプの場合はEthernetヘッダを付加する。
+//!
+//! @param [in,out] replay   再生データ
+//! @param [in]     buf      採取データ
+//! @param [in]     len      採取長
+//!
+//! @retval true  正常終了(対象外のフレームを含む)
+//! @retval false 異常終了(メモリ不足)
+///////////////////////////////////////////////////////////////////////////////
+static bool replay_add_frame(replay_data_t * replay, const uint8_t * buf, uint32_t len)
+{
+	struct ethhdr                   eth = { {0} };
+	const uint8_t                  *payload = buf;
+	uint32_t                        payload_len = len;
+	uint32_t                        hdr_len = 0;
+
+	switch (replay->linktype) {
+	case PCAP_LINKTYPE_ETHERNET:
+		break;
+	case PCAP_LINKTYPE_LINUX_SLL:
+		if (len < PCAP_SLL_HDR_LEN) {
+			return true;
+		}
+		memcpy(&eth.h_proto, buf + 14, sizeof(eth.h_proto));
+		payload = buf + PCAP_SLL_HDR_LEN;
+		payload_len = len - PCAP_SLL_HDR_LEN;
+		hdr_len = sizeof(struct ethhdr);
+		break;
+	default:
+		// IPパケットのみ(バージョンでEtherTypeを決める)
+		if (len < 1) {
+			return true;
+		}
+		eth.h_proto = htons(((buf[0] >> 4) == 6) ? ETH_P_IPV6 : ETH_P_IP);
+		hdr_len = sizeof(struct ethhdr);
+		break;
+	}
+	if (hdr_len + payload_len > REPLAY_FRAME_MAX) {
+		payload_len = REPLAY_FRAME_MAX - hdr_len;
+	}
+
+	if (replay->num >= replay->max) {
+		int                             max = (replay->max == 0) ? 1024 : replay->max * 2;
+		replay_frame_t                 *frame = realloc(replay->frame, sizeof(replay_frame_t) * max);
+		if (frame == NULL) {
+			return false;
+		}
+		replay->frame = frame;
+		replay->max = max;
+	}
+	if (replay->size + hdr_len + payload_len > replay->capacity) {
+		size_t                          capacity = (replay->capacity == 0) ? (1 << 20) : replay->capacity * 2;
+		while (capacity < replay->size + hdr_len + payload_len) {
+			capacity *= 2;
+		}
+		char                           *data = realloc(replay->data, capacity);
+		if (data == NULL) {
+			return false;
+		}
+		replay->data = data;
+		replay->capacity = capacity;
+	}
+
+	replay_frame_t                 *frame = &replay->frame[replay->num++];
+	frame->off = replay->size;
+	frame->len = hdr_len + payload_len;
+	frame->entry = NULL;
+	memcpy(replay->data + replay->size, &eth, hdr_len);
+	memcpy(replay->data + replay->size + hdr_len, payload, payload_len);
+	replay->size += frame->len;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief pcapファイル読み込み関数
+//!
+//! @param [in]  filename  pcapファイル名
+//! @param [out] replay    再生データ
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static bool replay_read_pcap(const char *filename, replay_data_t * replay)
+{
+	FILE                           *fp;
+	pcap_file_header_t              fh;
+	pcap_record_header_t            rh;
+	uint8_t                        *buf = NULL;
+	bool                            swap;
+	bool                            result = false;
+
+	memset(replay, 0, sizeof(replay_data_t));
+
+	if (NULL == (fp = fopen(filename, "r"))) {
+		fprintf(stderr, "fail to open %s : %s\n", filename, strerror(errno));
+		return false;
+	}
+	if (1 != fread(&fh, sizeof(fh), 1, fp)) {
+		fprintf(stderr, "%s : too short for pcap file\n", filename);
+		goto end;
+	}
+	if ((fh.magic == PCAP_MAGIC_USEC) || (fh.magic == PCAP_MAGIC_NSEC)) {
+		swap = false;
+	} else if ((fh.magic == bswap_32(PCAP_MAGIC_USEC)) || (fh.magic == bswap_32(PCAP_MAGIC_NSEC))) {
+		swap = true;
+	} else {
+		fprintf(stderr, "%s : not a pcap file (pcapng is not supported)\n", filename);
+		goto end;
+	}
+	replay->linktype = swap ? bswap_32(fh.linktype) : fh.linktype;
+	switch (replay->linktype) {
+	case PCAP_LINKTYPE_ETHERNET:
+	case PCAP_LINKTYPE_RAW:
+	case PCAP_LINKTYPE_LINUX_SLL:
+	case PCAP_LINKTYPE_IPV6:
+		break;
+	default:
+		fprintf(stderr, "%s : unsupported link type %u\n", filename, replay->linktype);
+		goto end;
+	}
+
+	if (NULL == (buf = malloc(REPLAY_FRAME_MAX + PCAP_SLL_HDR_LEN))) {
+		fprintf(stderr, "out of memory\n");
+		goto end;
+	}
+	while (1 == fread(&rh, sizeof(rh), 1, fp)) {
+		uint32_t                        incl_len = swap ? bswap_32(rh.incl_len) : rh.incl_len;
+		uint32_t                        orig_len = swap ? bswap_32(rh.orig_len) : rh.orig_len;
+		uint32_t                        len = incl_len;
+
+		if (len > REPLAY_FRAME_MAX + PCAP_SLL_HDR_LEN) {
+			len = REPLAY_FRAME_MAX + PCAP_SLL_HDR_LEN;
+		}
+		if (1 != fread(buf, len, 1, fp)) {
+			fprintf(stderr, "%s : truncated record at frame %d\n", filename, replay->num + 1);
+			goto end;
+		}
+		if ((len < incl_len) && (0 != fseek(fp, incl_len - len, SEEK_CUR))) {
+			goto end;
+		}
+		if (incl_len < orig_len) {
+			replay->truncated++;
+		}
+		if (!replay_add_frame(replay, buf, len)) {
+			fprintf(stderr, "out of memory\n");
+			goto end;
+		}
+	}
+	if (NULL == (replay->work = malloc(replay->size + 1))) {
+		fprintf(stderr, "out of memory\n");
+		goto end;
+	}
+	result = true;
+
+  end:
+	free(buf);
+	fclose(fp);
+
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief エントリ毎のヒット数比較関数(tsearch用)
+///////////////////////////////////////////////////////////////////////////////
+static int hit_compare(const void *p1, const void *p2)
+{
+	const replay_hit_t             *h1 = p1;
+	const replay_hit_t             *h2 = p2;
+
+	return (h1->entry < h2->entry) ? -1 : (h1->entry > h2->entry);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief エントリ毎のヒット数計上関数
+//!
+//! @param [in]  entry   エントリ
+//! @param [in]  type    テーブルタイプ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void hit_count(mx6e_config_entry_t * entry, table_type_t type)
+{
+	replay_hit_t                    key = { entry, type, 0 };
+	replay_hit_t                  **r = tfind(&key, &hit_root, hit_compare);
+
+	if (r == NULL) {
+		replay_hit_t                   *h = malloc(sizeof(replay_hit_t));
+		if (h == NULL) {
+			return;
+		}
+		*h = key;
+		if (NULL == (r = tsearch(h, &hit_root, hit_compare))) {
+			free(h);
+			return;
+		}
+		hit_num++;
+	}
+	(*r)->hits++;
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 表示用一覧作成関数(twalk用)
+///////////////////////////////////////////////////////////////////////////////
+static void hit_collect(const void *nodep, const VISIT which, const int depth)
+{
+	static int                      n = 0;
+
+	if ((which == postorder) || (which == leaf)) {
+		hit_list[n++] = *(replay_hit_t **) nodep;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief ヒット数の降順比較関数(qsort用)
+///////////////////////////////////////////////////////////////////////////////
+static int hit_sort(const void *p1, const void *p2)
+{
+	const replay_hit_t             *h1 = *(replay_hit_t * const *) p1;
+	const replay_hit_t             *h2 = *(replay_hit_t * const *) p2;
+
+	return (h1->hits < h2->hits) - (h1->hits > h2->hits);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 検索対象フレーム判定関数
+//!
+//! 転送関数と同じ条件(IPv6、ブロードキャスト以外、Hop Limit 1以外)で
+//! エントリ検索の対象となるフレームかどうかを返す。
+//!
+//! @param [in]  buf     フレームデータ
+//! @param [in]  len     フレーム長
+//!
+//! @return IPv6ヘッダ(NULL:検索対象外)
+///////////////////////////////////////////////////////////////////////////////
+static struct ip6_hdr *replay_lookup_target(char *buf, uint32_t len)
+{
+	struct ethhdr                  *p_ether = (struct ethhdr *) buf;
+	struct ip6_hdr                 *p_ip6 = (struct ip6_hdr *) (buf + sizeof(struct ethhdr));
+
+	if ((len < sizeof(struct ethhdr) + sizeof(struct ip6_hdr)) || mx6e_util_is_broadcast_mac(&p_ether->h_dest[0])) {
+		return NULL;
+	}
+	if ((ntohs(p_ether->h_proto) != ETH_P_IPV6) || (p_ip6->ip6_hlim <= 1)) {
+		return NULL;
+	}
+
+	return p_ip6;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief エントリ表示関数
+//!
+//! @param [in]  hit     エントリ毎のヒット数
+//! @param [in]  total   全パケット数
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void replay_print_hit(int rank, const replay_hit_t * hit, uint64_t total)
+{
+	const mx6e_config_entry_t      *e = hit->entry;
+	char                            addr[INET6_ADDRSTRLEN];
+
+	if (CONFIG_TYPE_M46E == hit->type) {
+		printf("  %4d %12" PRIu64 " %6.2f%%  m46e %-16s %3d %s/%d\n", rank, hit->hits, 100.0 * hit->hits / total,
+			   e->src.plane_id, e->src.prefix_len, inet_ntop(AF_INET, &e->src.in.m46e.v4addr, addr, sizeof(addr)), e->src.in.m46e.v4cidr);
+	} else {
+		printf("  %4d %12" PRIu64 " %6.2f%%  me6e %-16s %3d %s\n", rank, hit->hits, 100.0 * hit->hits / total,
+			   e->src.plane_id, e->src.prefix_len, ether_ntoa(&e->src.in.me6e.hwaddr));
+	}
+
+	return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// メイン関数
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+	static mx6e_handler_t           handler;
+	replay_data_t                   replay;
+	char                           *conf_file = NULL;
+	char                           *command_file[16];
+	int                             command_num = 0;
+	bool                            snapshot = false;
+	char                           *pcap_file = NULL;
+	domain_t                        domain = DOMAIN_NONE;
+	int                             loops = 1;
+	int                             top = REPLAY_DEFAULT_TOP;
+	int                             option_index = 0;
+
+	while (true) {
+		int                             c = getopt_long(argc, argv, "f:c:Sr:d:l:t:h", options, &option_index);
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case 'f':
+			conf_file = optarg;
+			break;
+
+		case 'c':
+			if (command_num >= sizeof(command_file) / sizeof(command_file[0])) {
+				usage();
+				exit(EINVAL);
+			}
+			command_file[command_num++] = optarg;
+			break;
+
+		case 'S':
+			snapshot = true;
+			break;
+
+		case 'r':
+			pcap_file = optarg;
+			break;
+
+		case 'd':
+			if (0 == strcmp(optarg, "fp")) {
+				domain = DOMAIN_FP;
+			} else if (0 == strcmp(optarg, "pr")) {
+				domain = DOMAIN_PR;
+			} else {
+				usage();
+				exit(EINVAL);
+			}
+			break;
+
+		case 'l':
+			loops = atoi(optarg);
+			break;
+
+		case 't':
+			top = atoi(optarg);
+			break;
+
+		case 'h':
+			usage();
+			exit(EXIT_SUCCESS);
+
+		default:
+			usage();
+			exit(EINVAL);
+		}
+	}
+	if ((conf_file == NULL) || (pcap_file == NULL) || (domain == DOMAIN_NONE) || (loops <= 0) || (top < 0)) {
+		usage();
+		exit(EINVAL);
+	}
+
+	mx6e_initial_log("mx6e-replay", false);
+
+	// 設定ファイルの読み込み(デバイスは生成しないので存在チェックもしない)
+	mx6e_config_skip_device_check(true);
+	if (NULL == mx6e_config_load(&handler.conf, conf_file)) {
+		fprintf(stderr, "fail to load config file : %s\n", conf_file);
+		exit(EXIT_FAILURE);
+	}
+	mx6e_initial_statistics(&handler.stat_info);
+	if (!mx6e_drop_init(&handler.drop_fp) || !mx6e_drop_init(&handler.drop_pr)) {
+		exit(EXIT_FAILURE);
+	}
+	mx6e_topk_init(&handler.topk_fp);
+	mx6e_topk_init(&handler.topk_pr);
+	mx6e_miss_init(&handler.miss_fp, DOMAIN_FP, handler.conf.general.miss_prefix_len);
+	mx6e_miss_init(&handler.miss_pr, DOMAIN_PR, handler.conf.general.miss_prefix_len);
+	mx6e_perf_init(&handler.perf_fp);
+	mx6e_perf_init(&handler.perf_pr);
+
+	// 経路はカーネルに設定しない
+	mx6e_route_init(&handler.route, false);
+	handler.route.offline = true;
+
+	// テーブルの作成
+	if (snapshot) {
+		mx6e_snapshot_init(&handler.snapshot);
+		if (!mx6e_snapshot_restore(&handler.snapshot, &handler.conf)) {
+			fprintf(stderr, "fail to restore snapshot : %s\n", handler.conf.general.snapshot_file);
+			exit(EXIT_FAILURE);
+		}
+	}
+	for (int i = 0; i < command_num; i++) {
+		mx6e_command_t                  command;
+		mx6e_load_batch_record_t       *record = NULL;
+		int                             record_num = 0;
+		int                             failed = 0;
+
+		if (!mx6e_command_file_read(command_file[i], &command, MX6E_COMMAND_MAX, &record, &record_num) && (record_num == 0)) {
+			free(record);
+			exit(EXIT_FAILURE);
+		}
+		for (int j = 0; j < record_num; j++) {
+			if (!mx6eapp_load_batch_apply(&handler, &record[j])) {
+				printf("Line%d : command failed\n", record[j].line);
+				failed++;
+			}
+		}
+		printf("load %s : %d lines applied, %d lines failed\n", command_file[i], record_num - failed, failed);
+		free(record);
+	}
+
+	if (!replay_read_pcap(pcap_file, &replay)) {
+		exit(EXIT_FAILURE);
+	}
+	if (replay.num == 0) {
+		fprintf(stderr, "%s : no frames\n", pcap_file);
+		exit(EXIT_FAILURE);
+	}
+
+	// 送信先はメモリバックエンドとし、送信されたパケットは都度捨てる
+	mx6e_io_t                      *sink = (DOMAIN_FP == domain) ? &handler.io_fp2pr.tx : &handler.io_pr2fp.tx;
+	mx6e_tunnel_io_init(&handler);
+	if (!mx6e_io_open(sink, MX6E_IO_MEMORY, (DOMAIN_FP == domain) ? &handler.conf.devices.tunnel_pr : &handler.conf.devices.tunnel_fp, -1)) {
+		fprintf(stderr, "fail to open memory packet I/O\n");
+		exit(EXIT_FAILURE);
+	}
+
+	void                            (*forward)(mx6e_handler_t *, char *, ssize_t) =
+		(DOMAIN_FP == domain) ? tunnel_forward_fp2pr_packet : tunnel_forward_pr2fp_packet;
+	void                            (*flush)(mx6e_handler_t *) =
+		(DOMAIN_FP == domain) ? tunnel_flush_fp2pr_packet : tunnel_flush_pr2fp_packet;
+	uint64_t                        packets = (uint64_t) replay.num * loops;
+	double                          total_ns = 0;
+	double                          lookup_ns = 0;
+	double                          rewrite_ns = 0;
+	double                          tx_ns = 0;
+	double                          start;
+	uint64_t                        hits = 0;
+	uint64_t                        targets = 0;
+
+	// 転送関数全体(フレームは転送関数が書き換えるので毎回元データから複写する)
+	for (int l = 0; l < loops; l++) {
+		memcpy(replay.work, replay.data, replay.size);
+		start = replay_now();
+		for (int i = 0; i < replay.num; i++) {
+			forward(&handler, replay.work + replay.frame[i].off, replay.frame[i].len);
+			// 転送スレッドと同じく受信処理1回分(最大MX6E_IO_BURST_MAX)毎にまとめて送信する
+			if ((((i + 1) % MX6E_IO_BURST_MAX) == 0) || (i == (replay.num - 1))) {
+				flush(&handler);
+				mx6e_io_mem_drain(sink, NULL, 0);
+			}
+		}
+		total_ns += replay_now() - start;
+	}
+
+	// エントリ検索(転送関数と同じくM46E、ME6Eの順に検索する)
+	struct in6_addr                *dst = malloc(sizeof(struct in6_addr) * replay.num);
+	int                            *index = malloc(sizeof(int) * replay.num);
+	int                             dst_num = 0;
+	if ((dst == NULL) || (index == NULL)) {
+		fprintf(stderr, "out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	for (int i = 0; i < replay.num; i++) {
+		struct ip6_hdr                 *p_ip6 = replay_lookup_target(replay.data + replay.frame[i].off, replay.frame[i].len);
+		if (p_ip6 != NULL) {
+			dst[dst_num] = p_ip6->ip6_dst;
+			index[dst_num] = i;
+			dst_num++;
+		}
+	}
+	for (int l = 0; l < loops; l++) {
+		start = replay_now();
+		for (int i = 0; i < dst_num; i++) {
+			mx6e_config_entry_t            *e = mx6e_match_config_table(domain, &handler.conf.m46e_conf_table, &dst[i]);
+			if (e == NULL) {
+				e = mx6e_match_config_table(domain, &handler.conf.me6e_conf_table, &dst[i]);
+			}
+			replay.frame[index[i]].entry = e;
+		}
+		lookup_ns += replay_now() - start;
+	}
+	targets = (uint64_t) dst_num * loops;
+
+	// ヒット数の集計
+	for (int i = 0; i < dst_num; i++) {
+		mx6e_config_entry_t            *e = replay.frame[index[i]].entry;
+		if (e != NULL) {
+			bool                            m46e = (e == mx6e_match_config_table(domain, &handler.conf.m46e_conf_table, &dst[i]));
+			hit_count(e, m46e ? CONFIG_TYPE_M46E : CONFIG_TYPE_ME6E);
+			hits++;
+		}
+	}
+
+	// ヘッダ置換と送信(ヒットしたフレームのみ)
+	for (int l = 0; l < loops; l++) {
+		memcpy(replay.work, replay.data, replay.size);
+		start = replay_now();
+		for (int i = 0; i < replay.num; i++) {
+			if (replay.frame[i].entry != NULL) {
+				mx6e_replace_address(replay.frame[i].entry, (struct ip6_hdr *) (replay.work + replay.frame[i].off + sizeof(struct ethhdr)));
+			}
+		}
+		rewrite_ns += replay_now() - start;
+
+		start = replay_now();
+		for (int i = 0; i < replay.num; i++) {
+			if (replay.frame[i].entry != NULL) {
+				mx6e_io_pkt_t                   pkt = { replay.work + replay.frame[i].off, replay.frame[i].len };
+				if (1 != mx6e_io_tx_burst(sink, &pkt, 1)) {
+					break;
+				}
+				mx6e_io_mem_drain(sink, NULL, 0);
+			}
+		}
+		tx_ns += replay_now() - start;
+	}
+	hits *= loops;
+
+	// 結果表示
+	printf("【replay】\n");
+	printf("  pcap file           : %s\n", pcap_file);
+	printf("  frames              : %d (%zu bytes, link type %u, truncated %d)\n", replay.num, replay.size, replay.linktype, replay.truncated);
+	printf("  side                : %s\n", (DOMAIN_FP == domain) ? "fp (FP->PR)" : "pr (PR->FP)");
+	printf("  loops               : %d\n", loops);
+	printf("  entries             : m46e %d, me6e %d\n", handler.conf.m46e_conf_table.num, handler.conf.me6e_conf_table.num);
+	printf("【throughput】\n");
+	printf("  packets             : %" PRIu64 "\n", packets);
+	printf("  elapsed             : %.6f sec\n", total_ns / 1e9);
+	printf("  rate                : %.0f pps, %.2f Mbps\n", packets / (total_ns / 1e9), (replay.size * 8.0 * loops) / (total_ns / 1e3));
+	printf("  forward             : %.1f ns/pkt\n", total_ns / packets);
+	printf("【stage cost】(ns/pkt, averaged over all packets)\n");
+	printf("  lookup              : %.1f\n", lookup_ns / packets);
+	printf("  rewrite             : %.1f\n", rewrite_ns / packets);
+	printf("  tx (memory I/O)     : %.1f\n", tx_ns / packets);
+	printf("  other               : %.1f (parse, MAC rewrite, statistics, capture)\n", (total_ns - lookup_ns - rewrite_ns - tx_ns) / packets);
+	printf("【entry hits】\n");
+	printf("  lookup target       : %" PRIu64 " (IPv6, not broadcast, hop limit > 1)\n", targets);
+	printf("  hit                 : %" PRIu64 " (%d entries)\n", hits, hit_num);
+	printf("  miss                : %" PRIu64 "\n", targets - hits);
+	if ((hit_num > 0) && (top > 0)) {
+		hit_list = malloc(sizeof(replay_hit_t *) * hit_num);
+		if (hit_list != NULL) {
+			twalk(hit_root, hit_collect);
+			qsort(hit_list, hit_num, sizeof(replay_hit_t *), hit_sort);
+			printf("  rank         hits  share  type plane_id        len in\n");
+			for (int i = 0; (i < hit_num) && (i < top); i++) {
+				hit_list[i]->hits *= loops;
+				replay_print_hit(i + 1, hit_list[i], packets);
+			}
+		}
+	}
+	fflush(stdout);
+	mx6e_printf_statistics_info_normal(&handler.stat_info, STDOUT_FILENO);
+
+	mx6e_tunnel_io_release(&handler);
+	mx6e_drop_destruct(&handler.drop_fp);
+	mx6e_drop_destruct(&handler.drop_pr);
+	mx6e_config_destruct(&handler.conf);
+	mx6e_route_stop(&handler.route);
+
+	return 0;
+}
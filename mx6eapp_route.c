@@ -0,0 +1,854 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_route.c                                               */
+/* 機能概要   : 経路設定ワーカ ソースファイル                                 */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <search.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#include "mx6eapp_route.h"
+#include "mx6eapp_network.h"
+#include "mx6eapp_log.h"
+#include "mx6eapp_probe.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! 経路の所属リスト
+typedef enum {
+	ROUTE_LIST_NONE,								///< 未所属
+	ROUTE_LIST_READY,								///< 処理待ちキュー
+	ROUTE_LIST_RETRY,								///< 再試行待ちリスト
+} route_list_t;
+
+//! 管理中の経路
+typedef struct mx6e_route_s {
+	int                             family;			///< アドレス種別(検索キー)
+	int                             prefixlen;		///< プレフィックス長(検索キー)
+	struct in6_addr                 dst;			///< 送信先アドレス(検索キー、IPv4は先頭4byte)
+	int                             ifindex;		///< 送信デバイスのインデックス番号
+	bool                            want;			///< 要求状態(true:設定、false:削除)
+	bool                            installed;		///< カーネルへの設定状態
+	bool                            busy;			///< ワーカスレッドが処理中
+	route_list_t                    list;			///< 所属リスト
+	mx6e_route_state_t              state;			///< 経路状態
+	int                             errcd;			///< 最後に失敗した時のエラー番号
+	int                             retry;			///< 連続失敗回数
+	time_t                          next;			///< 次回再試行時刻
+	struct mx6e_route_s            *link;			///< リストの次要素
+} route_t;
+
+//! 経路集約用トライのノード(1bit毎の二分木)
+typedef struct route_node_s {
+	struct route_node_s            *parent;			///< 親ノード
+	struct route_node_s            *child[2];		///< 子ノード
+	struct in6_addr                 prefix;			///< プレフィックス
+	int                             len;			///< プレフィックス長
+	int                             ref;			///< このプレフィックスの経路を要求しているエントリ数
+	bool                            full;			///< 配下のアドレスが全て要求済みかどうか
+} route_node_t;
+
+//! デバイス毎の経路集約用トライ
+typedef struct mx6e_route_trie_s {
+	int                             ifindex;		///< デバイスのインデックス番号
+	route_node_t                   *root;			///< ルートノード(::/0)
+	struct mx6e_route_trie_s       *next;			///< 次のデバイス
+} route_trie_t;
+
+//! ワーカスレッドの1回分の処理対象
+typedef struct {
+	route_t                        *route;			///< 対象経路
+	bool                            add;			///< true:経路追加、false:経路削除
+	int                             family;			///< アドレス種別
+	int                             ifindex;		///< 送信デバイスのインデックス番号
+	struct in6_addr                 dst;			///< 送信先アドレス
+	int                             prefixlen;		///< プレフィックス長
+	int                             result;			///< 処理結果(0:成功、0以外:エラー番号)
+} route_work_t;
+
+//! 初期化済みの経路設定ワーカ(未初期化の場合は要求元で同期的に経路を設定する)
+static mx6e_route_worker_t     *route_worker = NULL;
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 経路比較関数(tsearch用)
+///////////////////////////////////////////////////////////////////////////////
+static int route_compare(const void *p1, const void *p2)
+{
+	const route_t                  *r1 = p1;
+	const route_t                  *r2 = p2;
+
+	if (r1->family != r2->family) {
+		return r1->family - r2->family;
+	}
+	if (r1->prefixlen != r2->prefixlen) {
+		return r1->prefixlen - r2->prefixlen;
+	}
+	return memcmp(&r1->dst, &r2->dst, sizeof(r1->dst));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 検索キー生成関数
+///////////////////////////////////////////////////////////////////////////////
+static void route_key(route_t * key, const int family, const void *dst, const int prefixlen)
+{
+	memset(key, 0, sizeof(*key));
+	key->family = family;
+	key->prefixlen = prefixlen;
+	if (dst != NULL) {
+		memcpy(&key->dst, dst, (family == AF_INET) ? sizeof(struct in_addr) : sizeof(struct in6_addr));
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 処理待ちキュー追加関数(排他取得済みで呼び出すこと)
+///////////////////////////////////////////////////////////////////////////////
+static void route_push_ready(mx6e_route_worker_t * worker, route_t * r)
+{
+	r->link = NULL;
+	r->list = ROUTE_LIST_READY;
+	if (worker->ready_tail == NULL) {
+		worker->ready_head = r;
+	} else {
+		worker->ready_tail->link = r;
+	}
+	worker->ready_tail = r;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 再試行待ちリスト削除関数(排他取得済みで呼び出すこと)
+///////////////////////////////////////////////////////////////////////////////
+static void route_remove_retry(mx6e_route_worker_t * worker, route_t * r)
+{
+	for (route_t ** p = &worker->retry; *p != NULL; p = &(*p)->link) {
+		if (*p == r) {
+			*p = r->link;
+			break;
+		}
+	}
+	r->link = NULL;
+	r->list = ROUTE_LIST_NONE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 経路状態確定関数(排他取得済みで呼び出すこと)
+//!
+//! 要求状態とカーネルへの設定状態が一致すれば状態を確定し、削除済みの経路は
+//! 管理対象から外す。一致しなければ処理待ち、失敗時は再試行待ちに戻す。
+//!
+//! @param [in,out] worker    経路設定ワーカ
+//! @param [in,out] r         経路
+//! @param [in]     now       現在時刻
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void route_settle(mx6e_route_worker_t * worker, route_t * r, time_t now)
+{
+	if (r->want == r->installed) {
+		r->state = r->installed ? MX6E_ROUTE_INSTALLED : MX6E_ROUTE_NONE;
+		r->errcd = 0;
+		r->retry = 0;
+		if (!r->want) {
+			tdelete(r, &worker->root, route_compare);
+			worker->num--;
+			free(r);
+		}
+		return;
+	}
+
+	if (r->errcd == 0) {
+		// 処理中に要求状態が変わった
+		r->state = MX6E_ROUTE_PENDING;
+		route_push_ready(worker, r);
+	} else {
+		r->state = MX6E_ROUTE_FAILED;
+		if (!worker->stop) {
+			int                             shift = (r->retry < 8) ? r->retry - 1 : 7;
+			int                             interval = ROUTE_RETRY_INTERVAL_MIN << shift;
+			if (interval > ROUTE_RETRY_INTERVAL_MAX) {
+				interval = ROUTE_RETRY_INTERVAL_MAX;
+			}
+			r->next = now + interval;
+			r->list = ROUTE_LIST_RETRY;
+			r->link = worker->retry;
+			worker->retry = r;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 経路設定結果通知関数(netlink一括送信チャネルから呼ばれる)
+///////////////////////////////////////////////////////////////////////////////
+static void route_result(void *tag, int errcd)
+{
+	route_work_t                   *work = tag;
+
+	work->result = errcd;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 再試行時刻到来経路取り出し関数(排他取得済みで呼び出すこと)
+//!
+//! @param [in,out] worker    経路設定ワーカ
+//! @param [in]     now       現在時刻
+//!
+//! @return 残った再試行待ちの中で最も早い再試行時刻(再試行待ちが無い場合は0)
+///////////////////////////////////////////////////////////////////////////////
+static time_t route_retry_ready(mx6e_route_worker_t * worker, time_t now)
+{
+	time_t                          earliest = 0;
+	route_t                       **p = &worker->retry;
+
+	while (*p != NULL) {
+		route_t                        *r = *p;
+		if (r->next <= now) {
+			*p = r->link;
+			r->state = MX6E_ROUTE_PENDING;
+			route_push_ready(worker, r);
+			continue;
+		}
+		if ((earliest == 0) || (r->next < earliest)) {
+			earliest = r->next;
+		}
+		p = &r->link;
+	}
+
+	return earliest;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 経路設定ワーカスレッド
+//!
+//! 処理待ちキューから取り出した経路の追加/削除をまとめてカーネルに送信する。
+//! netlinkの送受信中は排他を解除するので、要求元は応答を待たない。
+//!
+//! @param [in] arg  経路設定ワーカ
+//!
+//! @return NULL
+///////////////////////////////////////////////////////////////////////////////
+static void *route_worker_main(void *arg)
+{
+	mx6e_route_worker_t            *worker = arg;
+	route_work_t                    work[NETLINK_BATCH_MSG_MAX];
+	int                             num;
+	int                             errcd;
+
+	mx6e_logging(LOG_INFO, "route worker start\n");
+
+	pthread_mutex_lock(&worker->mutex);
+	while (1) {
+		time_t                          now = time(NULL);
+		time_t                          earliest = route_retry_ready(worker, now);
+
+		if (worker->ready_head == NULL) {
+			if (worker->stop) {
+				break;
+			}
+			if (earliest == 0) {
+				pthread_cond_wait(&worker->cond, &worker->mutex);
+			} else {
+				struct timespec                 ts = {.tv_sec = earliest,.tv_nsec = 0 };
+				pthread_cond_timedwait(&worker->cond, &worker->mutex, &ts);
+			}
+			continue;
+		}
+
+		// 処理対象の取り出し
+		num = 0;
+		while ((worker->ready_head != NULL) && (num < NETLINK_BATCH_MSG_MAX)) {
+			route_t                        *r = worker->ready_head;
+			worker->ready_head = r->link;
+			if (worker->ready_head == NULL) {
+				worker->ready_tail = NULL;
+			}
+			r->link = NULL;
+			r->list = ROUTE_LIST_NONE;
+
+			if (r->want == r->installed) {
+				route_settle(worker, r, now);
+				continue;
+			}
+			r->busy = true;
+			work[num].route = r;
+			work[num].add = r->want;
+			work[num].family = r->family;
+			work[num].ifindex = r->ifindex;
+			work[num].dst = r->dst;
+			work[num].prefixlen = r->prefixlen;
+			work[num].result = 0;
+			num++;
+		}
+		if (num == 0) {
+			continue;
+		}
+		pthread_mutex_unlock(&worker->mutex);
+
+		// カーネルへの一括送信
+		for (int i = 0; i < num; i++) {
+			int                             ret = mx6e_network_route_queue(&worker->channel, work[i].add, work[i].family, work[i].ifindex,
+																		   &work[i].dst, work[i].prefixlen, NULL, &work[i]);
+			if (ret != 0) {
+				work[i].result = ret;
+			}
+		}
+		mx6e_netlink_batch_flush(&worker->channel, &errcd);
+		worker->channel.failed = 0;
+
+		pthread_mutex_lock(&worker->mutex);
+		now = time(NULL);
+		for (int i = 0; i < num; i++) {
+			route_t                        *r = work[i].route;
+			int                             result = work[i].result;
+
+			MX6E_PROBE6(route, work[i].family, work[i].ifindex, &work[i].dst, work[i].prefixlen, work[i].add, result);
+			r->busy = false;
+			// 追加済み経路の追加、削除済み経路の削除は成功とみなす
+			if ((result == 0) || (work[i].add && (result == EEXIST)) || (!work[i].add && (result == ESRCH))) {
+				r->installed = work[i].add;
+				r->errcd = 0;
+			} else {
+				r->errcd = result;
+				r->retry++;
+			}
+			route_settle(worker, r, now);
+		}
+	}
+	pthread_mutex_unlock(&worker->mutex);
+
+	mx6e_logging(LOG_INFO, "route worker end\n");
+
+	return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 集約用トライのノード解放関数(配下のノードも解放する)
+///////////////////////////////////////////////////////////////////////////////
+static void aggregate_free(route_node_t * n)
+{
+	if (n != NULL) {
+		aggregate_free(n->child[0]);
+		aggregate_free(n->child[1]);
+		free(n);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 経路設定ワーカ初期化関数
+//!
+//! 以降の経路追加/削除要求を受け付ける。ワーカスレッドを起動するまでは
+//! 要求元で同期的に経路を設定する。
+//!
+//! @param [out] worker    経路設定ワーカ
+//! @param [in]  aggregate 経路集約有無
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_route_init(mx6e_route_worker_t * worker, bool aggregate)
+{
+	memset(worker, 0, sizeof(*worker));
+	pthread_mutex_init(&worker->mutex, NULL);
+	pthread_cond_init(&worker->cond, NULL);
+	mx6e_netlink_batch_init(&worker->channel);
+	worker->aggregate = aggregate;
+
+	route_worker = worker;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 経路設定ワーカ起動関数
+//!
+//! 経路設定用netlinkチャネルを生成し、ワーカスレッドを起動する。
+//! 以降の経路追加/削除要求はワーカスレッドで非同期に処理する。
+//!
+//! @param [in,out] worker    経路設定ワーカ
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了(経路追加/削除要求は要求元で同期的に処理する)
+///////////////////////////////////////////////////////////////////////////////
+bool mx6e_route_start(mx6e_route_worker_t * worker)
+{
+	int                             errcd = 0;
+
+	if (mx6e_netlink_batch_open(&worker->channel, &errcd) != RESULT_OK) {
+		mx6e_logging(LOG_ERR, "fail to open route netlink channel : %s\n", strerror(errcd));
+		return false;
+	}
+	worker->channel.result_func = route_result;
+	worker->stop = false;
+
+	if (pthread_create(&worker->tid, NULL, route_worker_main, worker) != 0) {
+		mx6e_logging(LOG_ERR, "fail to create route worker thread : %s\n", strerror(errno));
+		mx6e_netlink_batch_close(&worker->channel);
+		return false;
+	}
+	worker->running = true;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 経路設定ワーカ停止関数
+//!
+//! 処理待ちの経路追加/削除を送信し終えてからワーカスレッドを停止する。
+//! 再試行待ちの経路は破棄する。
+//!
+//! @param [in,out] worker    経路設定ワーカ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_route_stop(mx6e_route_worker_t * worker)
+{
+	if (worker->running) {
+		pthread_mutex_lock(&worker->mutex);
+		worker->stop = true;
+		pthread_cond_signal(&worker->cond);
+		pthread_mutex_unlock(&worker->mutex);
+
+		pthread_join(worker->tid, NULL);
+		worker->running = false;
+	}
+	if (route_worker == worker) {
+		route_worker = NULL;
+	}
+
+	while (worker->trie != NULL) {
+		route_trie_t                   *trie = worker->trie;
+		worker->trie = trie->next;
+		aggregate_free(trie->root);
+		free(trie);
+	}
+
+	tdestroy(worker->root, free);
+	worker->root = NULL;
+	worker->num = 0;
+	worker->ready_head = worker->ready_tail = worker->retry = NULL;
+
+	mx6e_netlink_batch_close(&worker->channel);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 経路設定関数(排他取得済みで呼び出すこと)
+//!
+//! ワーカスレッド起動中は経路の要求状態を更新してワーカスレッドに通知する。
+//! 処理待ちの間に逆の要求を受けた場合は後の要求のみ処理する。
+//! ワーカスレッド未起動の場合は同期的に経路を追加/削除する。
+//!
+//! @param [in,out] worker    経路設定ワーカ
+//! @param [in]     family    アドレス種別(AF_INET or AF_INET6)
+//! @param [in]     ifindex   デバイスのインデックス番号
+//! @param [in]     dst       経路の送信先アドレス
+//! @param [in]     prefixlen 経路のプレフィックス長
+//! @param [in]     install   true:経路追加、false:経路削除
+//!
+//! @retval 0     正常終了
+//! @retval 0以外 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static int route_program(mx6e_route_worker_t * worker, const int family, const int ifindex, const void *dst, const int prefixlen, const bool install)
+{
+	route_t                         key;
+	route_t                        *r;
+	void                           *node;
+
+	if (!worker->running) {
+		int                             ret;
+		if (install) {
+			ret = mx6e_network_add_route(family, ifindex, dst, prefixlen, NULL);
+		} else {
+			ret = mx6e_network_del_route(family, ifindex, dst, prefixlen, NULL);
+		}
+		MX6E_PROBE6(route, family, ifindex, dst, prefixlen, install, ret);
+		return ret;
+	}
+
+	route_key(&key, family, dst, prefixlen);
+
+	node = tfind(&key, &worker->root, route_compare);
+	if (node != NULL) {
+		r = *(route_t **) node;
+	} else if (!install) {
+		// 設定していない経路の削除要求
+		return 0;
+	} else {
+		r = malloc(sizeof(route_t));
+		if (r == NULL) {
+			mx6e_logging(LOG_ERR, "route allocation failed\n");
+			return ENOMEM;
+		}
+		*r = key;
+		if (tsearch(r, &worker->root, route_compare) == NULL) {
+			free(r);
+			mx6e_logging(LOG_ERR, "route allocation failed\n");
+			return ENOMEM;
+		}
+		worker->num++;
+	}
+
+	r->want = install;
+	r->ifindex = ifindex;
+	r->errcd = 0;
+	r->retry = 0;
+	if (r->want != r->installed) {
+		r->state = MX6E_ROUTE_PENDING;
+	}
+	// 処理中の経路は処理完了時に要求状態を確認するのでキューに入れない
+	if (!r->busy && (r->list != ROUTE_LIST_READY)) {
+		if (r->list == ROUTE_LIST_RETRY) {
+			route_remove_retry(worker, r);
+		}
+		route_push_ready(worker, r);
+		pthread_cond_signal(&worker->cond);
+	}
+
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief アドレスのビット取得関数
+///////////////////////////////////////////////////////////////////////////////
+static inline int aggregate_bit(const struct in6_addr *addr, int pos)
+{
+	return (addr->s6_addr[pos / 8] >> (7 - (pos % 8))) & 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 集約用トライのノード検索関数
+//!
+//! @param [in,out] worker    経路設定ワーカ
+//! @param [in]     ifindex   デバイスのインデックス番号
+//! @param [in]     dst       プレフィックス
+//! @param [in]     prefixlen プレフィックス長
+//! @param [in]     create    ノードが無い場合に生成するかどうか
+//!
+//! @return ノード(見つからない場合、生成に失敗した場合はNULL)
+///////////////////////////////////////////////////////////////////////////////
+static route_node_t *aggregate_node(mx6e_route_worker_t * worker, const int ifindex, const struct in6_addr *dst, const int prefixlen, bool create)
+{
+	route_trie_t                   *trie;
+	route_node_t                   *n;
+
+	for (trie = worker->trie; trie != NULL; trie = trie->next) {
+		if (trie->ifindex == ifindex) {
+			break;
+		}
+	}
+	if (trie == NULL) {
+		if (!create) {
+			return NULL;
+		}
+		trie = calloc(1, sizeof(route_trie_t));
+		if (trie == NULL) {
+			return NULL;
+		}
+		trie->ifindex = ifindex;
+		trie->next = worker->trie;
+		worker->trie = trie;
+	}
+	if (trie->root == NULL) {
+		if (!create) {
+			return NULL;
+		}
+		trie->root = calloc(1, sizeof(route_node_t));
+		if (trie->root == NULL) {
+			return NULL;
+		}
+	}
+
+	n = trie->root;
+	for (int pos = 0; pos < prefixlen; pos++) {
+		int                             bit = aggregate_bit(dst, pos);
+		if (n->child[bit] == NULL) {
+			if (!create) {
+				return NULL;
+			}
+			route_node_t                   *c = calloc(1, sizeof(route_node_t));
+			if (c == NULL) {
+				return NULL;
+			}
+			c->parent = n;
+			c->prefix = n->prefix;
+			c->prefix.s6_addr[pos / 8] |= bit << (7 - (pos % 8));
+			c->len = pos + 1;
+			n->child[bit] = c;
+		}
+		n = n->child[bit];
+	}
+
+	return n;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 集約用トライの要求済みフラグ更新関数(指定ノードから根まで更新する)
+///////////////////////////////////////////////////////////////////////////////
+static void aggregate_update(route_node_t * n)
+{
+	for (; n != NULL; n = n->parent) {
+		n->full = (n->ref > 0) || ((n->child[0] != NULL) && (n->child[1] != NULL) && n->child[0]->full && n->child[1]->full);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 集約経路一括設定関数
+//!
+//! 指定ノード配下(指定ノードを除く)で要求済みのノードのうち最上位のもの、
+//! すなわち集約経路を全て追加または削除する。
+//!
+//! @param [in,out] worker    経路設定ワーカ
+//! @param [in]     ifindex   デバイスのインデックス番号
+//! @param [in]     n         ノード
+//! @param [in]     install   true:経路追加、false:経路削除
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void aggregate_program_below(mx6e_route_worker_t * worker, const int ifindex, route_node_t * n, bool install)
+{
+	for (int i = 0; i < 2; i++) {
+		route_node_t                   *c = n->child[i];
+		if (c == NULL) {
+			continue;
+		}
+		if (c->full) {
+			route_program(worker, AF_INET6, ifindex, &c->prefix, c->len, install);
+		} else {
+			aggregate_program_below(worker, ifindex, c, install);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 集約経路追加関数
+//!
+//! エントリの経路を集約用トライに登録し、集約経路の差分をカーネルに反映する。
+//! 通信断を避けるため、新しい集約経路を追加してから覆われた経路を削除する。
+//!
+//! @param [in,out] worker    経路設定ワーカ
+//! @param [in]     ifindex   デバイスのインデックス番号
+//! @param [in]     dst       エントリの経路のプレフィックス
+//! @param [in]     prefixlen エントリの経路のプレフィックス長
+//!
+//! @retval 0     正常終了
+//! @retval 0以外 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static int aggregate_add(mx6e_route_worker_t * worker, const int ifindex, const struct in6_addr *dst, const int prefixlen)
+{
+	route_node_t                   *n = aggregate_node(worker, ifindex, dst, prefixlen, true);
+	route_node_t                   *top;
+
+	if (n == NULL) {
+		mx6e_logging(LOG_ERR, "route aggregation node allocation failed\n");
+		return ENOMEM;
+	}
+
+	// 既存の集約経路に覆われている場合はカーネルの経路は変わらない
+	for (route_node_t * a = n; a != NULL; a = a->parent) {
+		if (a->full) {
+			n->ref++;
+			aggregate_update(n);
+			return 0;
+		}
+	}
+
+	// 兄弟が要求済みの間は親に集約できる
+	top = n;
+	while ((top->parent != NULL) && (top->parent->child[0] != NULL) && (top->parent->child[1] != NULL) &&
+		   top->parent->child[top == top->parent->child[0]]->full) {
+		top = top->parent;
+	}
+
+	route_program(worker, AF_INET6, ifindex, &top->prefix, top->len, true);
+	aggregate_program_below(worker, ifindex, top, false);
+
+	n->ref++;
+	aggregate_update(n);
+
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 集約経路削除関数
+//!
+//! エントリの経路を集約用トライから外し、集約経路の差分をカーネルに反映する。
+//! 通信断を避けるため、分割後の集約経路を追加してから元の集約経路を削除する。
+//!
+//! @param [in,out] worker    経路設定ワーカ
+//! @param [in]     ifindex   デバイスのインデックス番号
+//! @param [in]     dst       エントリの経路のプレフィックス
+//! @param [in]     prefixlen エントリの経路のプレフィックス長
+//!
+//! @retval 0     正常終了
+//! @retval 0以外 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static int aggregate_del(mx6e_route_worker_t * worker, const int ifindex, const struct in6_addr *dst, const int prefixlen)
+{
+	route_node_t                   *n = aggregate_node(worker, ifindex, dst, prefixlen, false);
+	route_node_t                   *top = NULL;
+
+	if ((n == NULL) || (n->ref == 0)) {
+		// 設定していない経路の削除要求
+		return 0;
+	}
+
+	// 現在の集約経路
+	for (route_node_t * a = n; a != NULL; a = a->parent) {
+		if (a->full) {
+			top = a;
+		}
+	}
+
+	n->ref--;
+	aggregate_update(n);
+
+	if (!top->full) {
+		aggregate_program_below(worker, ifindex, top, true);
+		route_program(worker, AF_INET6, ifindex, &top->prefix, top->len, false);
+	}
+
+	// 不要になったノードの解放
+	while ((n->parent != NULL) && (n->ref == 0) && (n->child[0] == NULL) && (n->child[1] == NULL)) {
+		route_node_t                   *parent = n->parent;
+		parent->child[n == parent->child[1]] = NULL;
+		free(n);
+		n = parent;
+	}
+
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 経路設定要求関数
+//!
+//! エントリの経路の追加/削除を要求する。経路集約有効時はIPv6経路を
+//! デバイス毎に集約し、集約経路の差分のみをカーネルに反映する。
+//! ワーカスレッド起動中はカーネルの応答を待たずに復帰する。
+//!
+//! @param [in]  family    アドレス種別(AF_INET or AF_INET6)
+//! @param [in]  ifindex   デバイスのインデックス番号
+//! @param [in]  dst       経路の送信先アドレス
+//! @param [in]  prefixlen 経路のプレフィックス長
+//! @param [in]  install   true:経路追加、false:経路削除
+//!
+//! @retval 0     正常終了
+//! @retval 0以外 異常終了
+///////////////////////////////////////////////////////////////////////////////
+int mx6e_route_request(const int family, const int ifindex, const void *dst, const int prefixlen, const bool install)
+{
+	mx6e_route_worker_t            *worker = route_worker;
+	int                             ret;
+
+	if ((worker != NULL) && worker->offline) {
+		// 経路を設定したものとみなす
+		return 0;
+	}
+	if (worker == NULL) {
+		if (install) {
+			return mx6e_network_add_route(family, ifindex, dst, prefixlen, NULL);
+		} else {
+			return mx6e_network_del_route(family, ifindex, dst, prefixlen, NULL);
+		}
+	}
+
+	pthread_mutex_lock(&worker->mutex);
+	if (worker->aggregate && (family == AF_INET6)) {
+		// トライはプレフィックス長までのビットのみ参照するのでマスク不要
+		if (install) {
+			ret = aggregate_add(worker, ifindex, dst, prefixlen);
+		} else {
+			ret = aggregate_del(worker, ifindex, dst, prefixlen);
+		}
+	} else {
+		ret = route_program(worker, family, ifindex, dst, prefixlen, install);
+	}
+	pthread_mutex_unlock(&worker->mutex);
+
+	return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 経路状態取得関数
+//!
+//! 経路集約有効時はエントリの経路を覆う集約経路の状態を返す。
+//!
+//! @param [in]  family    アドレス種別(AF_INET or AF_INET6)
+//! @param [in]  dst       経路の送信先アドレス
+//! @param [in]  prefixlen 経路のプレフィックス長
+//! @param [out] errcd     失敗時のエラー番号(不要な場合はNULL)
+//!
+//! @return 経路状態(ワーカ未起動の場合はMX6E_ROUTE_NONE)
+///////////////////////////////////////////////////////////////////////////////
+mx6e_route_state_t mx6e_route_get_state(const int family, const void *dst, const int prefixlen, int *errcd)
+{
+	mx6e_route_worker_t            *worker = route_worker;
+	mx6e_route_state_t              state = MX6E_ROUTE_NONE;
+	route_t                         key;
+	void                           *node;
+
+	if (errcd != NULL) {
+		*errcd = 0;
+	}
+	if (worker == NULL) {
+		return state;
+	}
+
+	route_key(&key, family, dst, prefixlen);
+
+	pthread_mutex_lock(&worker->mutex);
+	if (worker->aggregate && (family == AF_INET6)) {
+		// エントリの経路を覆う最上位の要求済みノードが集約経路
+		for (route_trie_t * trie = worker->trie; trie != NULL; trie = trie->next) {
+			route_node_t                   *top = NULL;
+			route_node_t                   *n = trie->root;
+			for (int pos = 0; (n != NULL) && (top == NULL); pos++) {
+				if (n->full) {
+					top = n;
+				} else if (pos < prefixlen) {
+					n = n->child[aggregate_bit(dst, pos)];
+				} else {
+					n = NULL;
+				}
+			}
+			if (top != NULL) {
+				route_key(&key, AF_INET6, &top->prefix, top->len);
+				break;
+			}
+		}
+	}
+	node = tfind(&key, &worker->root, route_compare);
+	if (node != NULL) {
+		route_t                        *r = *(route_t **) node;
+		state = r->state;
+		if (errcd != NULL) {
+			*errcd = r->errcd;
+		}
+	}
+	pthread_mutex_unlock(&worker->mutex);
+
+	return state;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 経路状態名取得関数
+//!
+//! @param [in]  state     経路状態
+//!
+//! @return 経路状態名
+///////////////////////////////////////////////////////////////////////////////
+const char                     *mx6e_route_state_name(mx6e_route_state_t state)
+{
+	switch (state) {
+	case MX6E_ROUTE_PENDING:
+		return "pending";
+	case MX6E_ROUTE_INSTALLED:
+		return "installed";
+	case MX6E_ROUTE_FAILED:
+		return "failed";
+	default:
+		return "-";
+	}
+}
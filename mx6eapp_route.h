@@ -0,0 +1,64 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_route.h                                               */
+/* 機能概要   : 経路設定ワーカ ヘッダファイル                                 */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+#ifndef __MX6EAPP_ROUTE_H__
+#   define __MX6EAPP_ROUTE_H__
+
+#   include <stdbool.h>
+#   include <pthread.h>
+#   include <netinet/in.h>
+
+#   include "mx6eapp_netlink.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! 失敗した経路設定の再試行間隔の初期値[sec](失敗毎に倍にする)
+#   define ROUTE_RETRY_INTERVAL_MIN    1
+//! 失敗した経路設定の再試行間隔の上限[sec]
+#   define ROUTE_RETRY_INTERVAL_MAX    60
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! 経路状態
+typedef enum {
+	MX6E_ROUTE_NONE,								///< 経路無し
+	MX6E_ROUTE_PENDING,								///< カーネルへの設定/削除待ち
+	MX6E_ROUTE_INSTALLED,							///< カーネルに設定済み
+	MX6E_ROUTE_FAILED,								///< カーネルへの設定/削除失敗(再試行待ち)
+} mx6e_route_state_t;
+
+//! 経路設定ワーカ
+typedef struct {
+	pthread_mutex_t                 mutex;			///< 排他用のmutex
+	pthread_cond_t                  cond;			///< 処理要求通知用の条件変数
+	pthread_t                       tid;			///< ワーカスレッドID
+	bool                            running;		///< ワーカスレッド起動中フラグ
+	bool                            stop;			///< 停止要求フラグ
+	bool                            offline;		///< カーネルに経路を設定しない(オフライン再生、経路設定無効時)
+	void                           *root;			///< 経路管理ツリー(tsearch)
+	int                             num;			///< 管理中の経路数
+	struct mx6e_route_s            *ready_head;		///< 処理待ちキュー先頭
+	struct mx6e_route_s            *ready_tail;		///< 処理待ちキュー末尾
+	struct mx6e_route_s            *retry;			///< 再試行待ちリスト
+	bool                            aggregate;		///< 経路集約有無(IPv6経路のみ対象)
+	struct mx6e_route_trie_s       *trie;			///< デバイス毎の経路集約用トライのリスト
+	mx6e_netlink_batch_t            channel;		///< 経路設定用netlinkチャネル(ワーカスレッド専用)
+} mx6e_route_worker_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部関数プロトタイプ宣言
+////////////////////////////////////////////////////////////////////////////////
+void                            mx6e_route_init(mx6e_route_worker_t * worker, bool aggregate);
+bool                            mx6e_route_start(mx6e_route_worker_t * worker);
+void                            mx6e_route_stop(mx6e_route_worker_t * worker);
+int                             mx6e_route_request(const int family, const int ifindex, const void *dst, const int prefixlen, const bool install);
+mx6e_route_state_t              mx6e_route_get_state(const int family, const void *dst, const int prefixlen, int *errcd);
+const char                     *mx6e_route_state_name(mx6e_route_state_t state);
+
+#endif												// __MX6EAPP_ROUTE_H__
@@ -0,0 +1,369 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_snapshot.c                                            */
+/* 機能概要   : テーブルスナップショット ソースファイル                       */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mx6eapp_snapshot.h"
+#include "mx6eapp_log.h"
+#include "mx6eapp_pt.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! 書き込み中のスナップショットファイルの接尾辞(書き込み完了後にrenameする)
+#define SNAPSHOT_TMP_SUFFIX      ".tmp"
+
+//! FNV-1a 64bit 初期値
+#define SNAPSHOT_FNV_OFFSET      0xcbf29ce484222325ULL
+//! FNV-1a 64bit 乗数
+#define SNAPSHOT_FNV_PRIME       0x100000001b3ULL
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! スナップショットファイルヘッダ
+//! (ヘッダの後に M46E エントリ、ME6E エントリの順に mx6e_config_entry_t をそのまま格納する)
+typedef struct {
+	char                            magic[8];		///< 識別子(SNAPSHOT_MAGIC)
+	uint32_t                        format;			///< 形式版数(SNAPSHOT_FORMAT_VERSION)
+	uint32_t                        entry_size;		///< エントリ構造体のサイズ
+	uint32_t                        m46e_num;		///< M46E エントリ数
+	uint32_t                        me6e_num;		///< ME6E エントリ数
+	uint64_t                        device_hash;	///< 内部生成項目の生成に使用したデバイス設定のハッシュ値
+	uint64_t                        checksum;		///< エントリ部のFNV-1aハッシュ値
+	uint64_t                        saved;			///< 保存時刻
+} snapshot_header_t;
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief FNV-1a ハッシュ値算出関数
+//!
+//! @param [in] hash    算出途中のハッシュ値(初回は SNAPSHOT_FNV_OFFSET)
+//! @param [in] data    データ
+//! @param [in] size    データサイズ
+//!
+//! @return ハッシュ値
+///////////////////////////////////////////////////////////////////////////////
+static uint64_t snapshot_fnv(uint64_t hash, const void *data, size_t size)
+{
+	const uint8_t                  *p = (const uint8_t *) data;
+
+	for (size_t i = 0; i < size; i++) {
+		hash ^= p[i];
+		hash *= SNAPSHOT_FNV_PRIME;
+	}
+
+	return hash;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief デバイス設定ハッシュ値算出関数
+//!
+//! make_config_entry() がエントリの内部生成項目の生成に使用する
+//! トンネルデバイスのアドレス設定のハッシュ値を返す。
+//!
+//! @param [in] devices デバイス設定
+//!
+//! @return ハッシュ値
+///////////////////////////////////////////////////////////////////////////////
+static uint64_t snapshot_device_hash(const mx6e_config_devices_t * devices)
+{
+	uint64_t                        hash = SNAPSHOT_FNV_OFFSET;
+
+	hash = snapshot_fnv(hash, &devices->tunnel_fp.ipv6_address, sizeof(devices->tunnel_fp.ipv6_address));
+	hash = snapshot_fnv(hash, &devices->tunnel_fp.ipv6_netmask, sizeof(devices->tunnel_fp.ipv6_netmask));
+	hash = snapshot_fnv(hash, &devices->tunnel_pr.ipv6_address, sizeof(devices->tunnel_pr.ipv6_address));
+	hash = snapshot_fnv(hash, &devices->tunnel_pr.ipv6_netmask, sizeof(devices->tunnel_pr.ipv6_netmask));
+
+	return hash;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 全データ書き込み関数
+//!
+//! @param [in] fd      書き込み先のディスクリプタ
+//! @param [in] data    データ
+//! @param [in] size    データサイズ
+//!
+//! @return true        書き込み成功
+//!         false       書き込み失敗
+///////////////////////////////////////////////////////////////////////////////
+static bool snapshot_write(int fd, const void *data, size_t size)
+{
+	const char                     *p = (const char *) data;
+
+	while (size > 0) {
+		ssize_t                         ret = write(fd, p, size);
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		p += ret;
+		size -= ret;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief テーブルスナップショット保存状態初期化関数
+//!
+//! @param [out] snapshot   テーブルスナップショット保存状態
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_snapshot_init(mx6e_snapshot_t * snapshot)
+{
+	memset(snapshot, 0, sizeof(mx6e_snapshot_t));
+	snapshot->last = time(NULL);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief テーブルスナップショット保存関数
+//!
+//! M46E/ME6E テーブルの全エントリを、内部生成項目と有効/無効を含めて
+//! snapshot_file へ保存する。一時ファイルへ書き込んでから置き換えるため、
+//! 保存中に異常終了しても前回のスナップショットは壊れない。
+//! snapshot_file が未設定の場合は何もしない。
+//!
+//! @param [in,out] snapshot   テーブルスナップショット保存状態
+//! @param [in]     config     設定情報
+//!
+//! @return true        保存成功(未設定を含む)
+//!         false       保存失敗
+///////////////////////////////////////////////////////////////////////////////
+bool mx6e_snapshot_save(mx6e_snapshot_t * snapshot, mx6e_config_t * config)
+{
+	snapshot_header_t               header;
+	mx6e_config_entry_t            *m46e = NULL;
+	mx6e_config_entry_t            *me6e = NULL;
+	char                            tmpfile[FILENAME_MAX + sizeof(SNAPSHOT_TMP_SUFFIX)];
+	uint64_t                        m46e_version;
+	uint64_t                        me6e_version;
+	int                             m46e_num;
+	int                             me6e_num;
+	int                             fd;
+	bool                            result;
+
+	// 引数チェック
+	if ((snapshot == NULL) || (config == NULL)) {
+		mx6e_logging(LOG_ERR, "Parameter Check NG(%s).", __func__);
+		return false;
+	}
+	if (config->general.snapshot_file[0] == '\0') {
+		return true;
+	}
+
+	// テーブルの複写(版数は複写前に採取する)
+	m46e_version = config->m46e_conf_table.version;
+	me6e_version = config->me6e_conf_table.version;
+	m46e_num = m46e_pt_copy_config_table(&config->m46e_conf_table, &m46e);
+	me6e_num = m46e_pt_copy_config_table(&config->me6e_conf_table, &me6e);
+	if ((m46e_num < 0) || (me6e_num < 0)) {
+		free(m46e);
+		free(me6e);
+		return false;
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.format = SNAPSHOT_FORMAT_VERSION;
+	header.entry_size = sizeof(mx6e_config_entry_t);
+	header.m46e_num = m46e_num;
+	header.me6e_num = me6e_num;
+	header.device_hash = snapshot_device_hash(&config->devices);
+	header.checksum = snapshot_fnv(SNAPSHOT_FNV_OFFSET, m46e, sizeof(mx6e_config_entry_t) * m46e_num);
+	header.checksum = snapshot_fnv(header.checksum, me6e, sizeof(mx6e_config_entry_t) * me6e_num);
+	header.saved = time(NULL);
+
+	snprintf(tmpfile, sizeof(tmpfile), "%s%s", config->general.snapshot_file, SNAPSHOT_TMP_SUFFIX);
+	fd = open(tmpfile, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	if (fd < 0) {
+		mx6e_logging(LOG_ERR, "fail to open snapshot file %s : %s\n", tmpfile, strerror(errno));
+		free(m46e);
+		free(me6e);
+		return false;
+	}
+	result = snapshot_write(fd, &header, sizeof(header))
+		&& snapshot_write(fd, m46e, sizeof(mx6e_config_entry_t) * m46e_num)
+		&& snapshot_write(fd, me6e, sizeof(mx6e_config_entry_t) * me6e_num)
+		&& (fsync(fd) == 0);
+	if (!result) {
+		mx6e_logging(LOG_ERR, "fail to write snapshot file %s : %s\n", tmpfile, strerror(errno));
+	}
+	close(fd);
+	free(m46e);
+	free(me6e);
+
+	if (result && (rename(tmpfile, config->general.snapshot_file) != 0)) {
+		mx6e_logging(LOG_ERR, "fail to rename snapshot file %s : %s\n", tmpfile, strerror(errno));
+		result = false;
+	}
+	if (!result) {
+		unlink(tmpfile);
+		return false;
+	}
+
+	snapshot->m46e_version = m46e_version;
+	snapshot->me6e_version = me6e_version;
+	DEBUG_LOG("snapshot saved : m46e %d, me6e %d entries\n", m46e_num, me6e_num);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief テーブルスナップショット復元関数
+//!
+//! snapshot_file をmmapし、形式版数とチェックサムを検証した上で
+//! M46E/ME6E テーブルへ一括で登録する(転送スレッド起動前に呼び出すこと)。
+//! デバイス設定が保存時から変わっている場合は内部生成項目を生成し直す。
+//! snapshot_file が未設定、または存在しない場合は何もしない。
+//!
+//! @param [in,out] snapshot   テーブルスナップショット保存状態
+//! @param [in,out] config     設定情報
+//!
+//! @return true        復元成功(未設定、ファイル無しを含む)
+//!         false       復元失敗(不正なファイル)
+///////////////////////////////////////////////////////////////////////////////
+bool mx6e_snapshot_restore(mx6e_snapshot_t * snapshot, mx6e_config_t * config)
+{
+	const snapshot_header_t        *header;
+	const mx6e_config_entry_t      *entry;
+	const char                     *file;
+	struct stat                     st;
+	struct timespec                 start;
+	struct timespec                 end;
+	void                           *addr;
+	uint64_t                        checksum;
+	bool                            remake;
+	int                             m46e_num;
+	int                             me6e_num;
+	int                             fd;
+
+	// 引数チェック
+	if ((snapshot == NULL) || (config == NULL)) {
+		mx6e_logging(LOG_ERR, "Parameter Check NG(%s).", __func__);
+		return false;
+	}
+	file = config->general.snapshot_file;
+	if (file[0] == '\0') {
+		return true;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	fd = open(file, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		if (errno == ENOENT) {
+			mx6e_logging(LOG_INFO, "no snapshot file %s. start with empty tables\n", file);
+			return true;
+		}
+		mx6e_logging(LOG_ERR, "fail to open snapshot file %s : %s\n", file, strerror(errno));
+		return false;
+	}
+	if ((fstat(fd, &st) != 0) || (st.st_size < sizeof(snapshot_header_t))) {
+		mx6e_logging(LOG_ERR, "invalid snapshot file %s (too short)\n", file);
+		close(fd);
+		return false;
+	}
+	addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED) {
+		mx6e_logging(LOG_ERR, "fail to mmap snapshot file %s : %s\n", file, strerror(errno));
+		return false;
+	}
+	madvise(addr, st.st_size, MADV_SEQUENTIAL);
+
+	// ヘッダ検証
+	header = (const snapshot_header_t *) addr;
+	entry = (const mx6e_config_entry_t *) (header + 1);
+	if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+		mx6e_logging(LOG_ERR, "invalid snapshot file %s (bad magic)\n", file);
+		munmap(addr, st.st_size);
+		return false;
+	}
+	if ((header->format != SNAPSHOT_FORMAT_VERSION) || (header->entry_size != sizeof(mx6e_config_entry_t))) {
+		mx6e_logging(LOG_ERR, "invalid snapshot file %s (format %u, entry size %u : expected %d, %zu)\n",
+					 file, header->format, header->entry_size, SNAPSHOT_FORMAT_VERSION, sizeof(mx6e_config_entry_t));
+		munmap(addr, st.st_size);
+		return false;
+	}
+	if (st.st_size != sizeof(snapshot_header_t) + ((uint64_t) header->m46e_num + header->me6e_num) * sizeof(mx6e_config_entry_t)) {
+		mx6e_logging(LOG_ERR, "invalid snapshot file %s (size mismatch)\n", file);
+		munmap(addr, st.st_size);
+		return false;
+	}
+	checksum = snapshot_fnv(SNAPSHOT_FNV_OFFSET, entry, st.st_size - sizeof(snapshot_header_t));
+	if (checksum != header->checksum) {
+		mx6e_logging(LOG_ERR, "invalid snapshot file %s (checksum mismatch)\n", file);
+		munmap(addr, st.st_size);
+		return false;
+	}
+
+	// 一括登録
+	remake = (header->device_hash != snapshot_device_hash(&config->devices));
+	if (remake) {
+		mx6e_logging(LOG_INFO, "device setting changed since snapshot was saved. regenerate entries\n");
+	}
+	m46e_num = m46e_pt_restore_config_table(&config->m46e_conf_table, entry, header->m46e_num, &config->devices, remake);
+	me6e_num = m46e_pt_restore_config_table(&config->me6e_conf_table, entry + header->m46e_num, header->me6e_num, &config->devices, remake);
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	mx6e_logging(LOG_INFO, "snapshot restored from %s : m46e %d/%u, me6e %d/%u entries (%ld usec)\n",
+				 file, m46e_num, header->m46e_num, me6e_num, header->me6e_num,
+				 (end.tv_sec - start.tv_sec) * 1000000L + (end.tv_nsec - start.tv_nsec) / 1000L);
+
+	munmap(addr, st.st_size);
+
+	// 復元直後は保存不要
+	snapshot->m46e_version = config->m46e_conf_table.version;
+	snapshot->me6e_version = config->me6e_conf_table.version;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief テーブルスナップショット定期保存関数
+//!
+//! メインループから1秒周期で呼び出す。snapshot_interval 経過毎に、
+//! 前回保存時からテーブル版数が変わっていればスナップショットを保存する。
+//!
+//! @param [in,out] snapshot   テーブルスナップショット保存状態
+//! @param [in]     config     設定情報
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_snapshot_tick(mx6e_snapshot_t * snapshot, mx6e_config_t * config)
+{
+	time_t                          now = time(NULL);
+
+	if ((config->general.snapshot_file[0] == '\0') || (config->general.snapshot_interval == 0)) {
+		return;
+	}
+	if (now - snapshot->last < config->general.snapshot_interval) {
+		return;
+	}
+	snapshot->last = now;
+
+	if ((snapshot->m46e_version == config->m46e_conf_table.version) && (snapshot->me6e_version == config->me6e_conf_table.version)) {
+		return;
+	}
+	mx6e_snapshot_save(snapshot, config);
+
+	return;
+}
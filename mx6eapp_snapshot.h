@@ -0,0 +1,43 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_snapshot.h                                            */
+/* 機能概要   : テーブルスナップショット ヘッダファイル                       */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+#ifndef __MX6EAPP_SNAPSHOT_H__
+#   define __MX6EAPP_SNAPSHOT_H__
+
+#   include <stdbool.h>
+#   include <stdint.h>
+#   include <time.h>
+
+#   include "mx6eapp_config.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! スナップショットファイルの識別子
+#   define SNAPSHOT_MAGIC           "MX6ESNAP"
+//! スナップショットファイルの形式版数(ファイル形式/エントリ構造体を変更したら加算する)
+#   define SNAPSHOT_FORMAT_VERSION  1
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! テーブルスナップショット保存状態(メインループのみ参照/更新)
+typedef struct {
+	time_t                          last;			///< 最終保存判定時刻
+	uint64_t                        m46e_version;	///< 保存済みのM46Eテーブル版数
+	uint64_t                        me6e_version;	///< 保存済みのME6Eテーブル版数
+} mx6e_snapshot_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部関数プロトタイプ宣言
+////////////////////////////////////////////////////////////////////////////////
+void                            mx6e_snapshot_init(mx6e_snapshot_t * snapshot);
+bool                            mx6e_snapshot_save(mx6e_snapshot_t * snapshot, mx6e_config_t * config);
+bool                            mx6e_snapshot_restore(mx6e_snapshot_t * snapshot, mx6e_config_t * config);
+void                            mx6e_snapshot_tick(mx6e_snapshot_t * snapshot, mx6e_config_t * config);
+
+#endif												// __MX6EAPP_SNAPSHOT_H__
@@ -135,6 +135,9 @@ void mx6e_printf_statistics_info_normal(mx6e_statistics_t * statistics_info, int
 	DPRINTF(fd, "       m46e send error               : %d \n", statistics_info->fp_m46e_send_err);
 	DPRINTF(fd, "       me6e send success             : %d \n", statistics_info->fp_me6e_send_success);
 	DPRINTF(fd, "       me6e send error               : %d \n", statistics_info->fp_me6e_send_err);
+	DPRINTF(fd, "   byte count\n");
+	DPRINTF(fd, "     recieve bytes                   : %lu \n", (unsigned long) statistics_info->fp_recieve_bytes);
+	DPRINTF(fd, "     send bytes                      : %lu \n", (unsigned long) statistics_info->fp_send_bytes);
 	DPRINTF(fd, "\n");
 	DPRINTF(fd, "\n");
 	DPRINTF(fd, "【PR domain】\n");
@@ -150,6 +153,13 @@ void mx6e_printf_statistics_info_normal(mx6e_statistics_t * statistics_info, int
 	DPRINTF(fd, "       m46e send error               : %d \n", statistics_info->pr_m46e_send_err);
 	DPRINTF(fd, "       me6e send success             : %d \n", statistics_info->pr_me6e_send_success);
 	DPRINTF(fd, "       me6e send error               : %d \n", statistics_info->pr_me6e_send_err);
+	DPRINTF(fd, "   byte count\n");
+	DPRINTF(fd, "     recieve bytes                   : %lu \n", (unsigned long) statistics_info->pr_recieve_bytes);
+	DPRINTF(fd, "     send bytes                      : %lu \n", (unsigned long) statistics_info->pr_send_bytes);
+	DPRINTF(fd, "\n");
+	DPRINTF(fd, "【log】\n");
+	DPRINTF(fd, "\n");
+	DPRINTF(fd, "     dropped records(ring full)      : %lu \n", mx6e_log_dropped());
 	DPRINTF(fd, "\n");
 
 	return;
@@ -35,6 +35,10 @@ typedef struct _mx6e_statistics_t {
 	uint32_t                        fp_err_other_proto;
 	//! NextHeaderがIPIP以外のパケット受信数
 	uint32_t                        fp_err_nxthdr;
+	//! 受信バイト数
+	uint64_t                        fp_recieve_bytes;
+	//! 送信成功バイト数
+	uint64_t                        fp_send_bytes;
 
 	////////////////////////////////////////////////////////////////////////////
 	// PR domain 関連
@@ -61,6 +65,10 @@ typedef struct _mx6e_statistics_t {
 	uint32_t                        pr_err_other_proto;
 	//! NextHeaderがIPIP以外のパケット受信数
 	uint32_t                        pr_err_nxthdr;
+	//! 受信バイト数
+	uint64_t                        pr_recieve_bytes;
+	//! 送信成功バイト数
+	uint64_t                        pr_send_bytes;
 
 } mx6e_statistics_t;
 
@@ -87,6 +95,8 @@ void                            mx6e_printf_statistics_info_normal(mx6e_statisti
 #   define STAT_FP_ERR_HOPLIMIT			(mx6e_statistics->fp_err_hoplimit ++)
 #   define STAT_FP_ERR_OTHER_PROTO		(mx6e_statistics->fp_err_other_proto ++)
 #   define STAT_FP_ERR_NXTHDR			(mx6e_statistics->fp_err_nxthdr ++)
+#   define STAT_FP_RECIEVE_BYTES(len)	(mx6e_statistics->fp_recieve_bytes += (len))
+#   define STAT_FP_SEND_BYTES(len)		(mx6e_statistics->fp_send_bytes += (len))
 
 #   define STAT_PR_RECIEVE				(mx6e_statistics->pr_recieve ++)
 #   define STAT_PR_SEND					(mx6e_statistics->pr_send ++)
@@ -98,5 +108,7 @@ void                            mx6e_printf_statistics_info_normal(mx6e_statisti
 #   define STAT_PR_ERR_HOPLIMIT			(mx6e_statistics->pr_err_hoplimit ++)
 #   define STAT_PR_ERR_OTHER_PROTO		(mx6e_statistics->pr_err_other_proto ++)
 #   define STAT_PR_ERR_NXTHDR			(mx6e_statistics->pr_err_nxthdr ++)
+#   define STAT_PR_RECIEVE_BYTES(len)	(mx6e_statistics->pr_recieve_bytes += (len))
+#   define STAT_PR_SEND_BYTES(len)		(mx6e_statistics->pr_send_bytes += (len))
 
 #endif												// __MX6EAPP_STATISTICS_H__
@@ -0,0 +1,787 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_tgen.c                                                */
+/* 機能概要   : 端間転送性能測定用 トラフィック生成/受信                      */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#include <getopt.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <net/ethernet.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/ip6.h>
+#include <netinet/udp.h>
+#include <netinet/ether.h>
+#include <arpa/inet.h>
+#include <linux/if_packet.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! 測定パケットの目印
+#define TGEN_MAGIC              0x6d783665U
+//! 既定のフレーム長(FCSを含まない)
+#define TGEN_DEFAULT_LEN        128
+//! 既定の送信時間[秒]
+#define TGEN_DEFAULT_DURATION   5
+//! 既定の送受信バッチ数
+#define TGEN_DEFAULT_BATCH      32
+//! 既定の送信終了後の受信待ち時間[ms]
+#define TGEN_DEFAULT_DRAIN      500
+//! 送受信バッチ数の最大
+#define TGEN_BATCH_MAX          256
+//! フレーム長の最大
+#define TGEN_FRAME_MAX          1514
+//! 遅延分布の刻み数(1us刻み、超過分は最終要素に計上)
+#define TGEN_HIST_NUM           100000
+//! 受信タイムアウト[ms](停止要求の確認周期)
+#define TGEN_RECV_TIMEOUT       100
+//! ME6E(EtherIP)の次ヘッダ番号
+#define TGEN_IPPROTO_ETHERIP    97
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! 測定パケットのペイロード
+typedef struct {
+	uint32_t                        magic;			///< 目印
+	uint32_t                        flow;			///< 宛先番号
+	uint64_t                        seq;			///< 送信順序番号
+	uint64_t                        tx_ns;			///< 送信時刻[ns](CLOCK_MONOTONIC)
+} __attribute__ ((__packed__)) tgen_payload_t;
+
+//! 測定条件
+typedef struct {
+	char                            tx_dev[IFNAMSIZ];	///< 送信デバイス名
+	char                            rx_dev[IFNAMSIZ];	///< 受信デバイス名
+	struct ether_addr               dst_mac;		///< 送信先MACアドレス
+	bool                            me6e;			///< ME6E(EtherIP)で送信する
+	struct in6_addr                 src;			///< 送信元IPv6アドレス
+	struct in6_addr                 dst;			///< 先頭の宛先IPv6アドレス
+	uint64_t                        stride;			///< 宛先毎の下位64bitの増分
+	int                             flows;			///< 宛先数
+	int                             len;			///< フレーム長
+	uint64_t                        rate;			///< 送信レート[pps](0は無制限)
+	double                          duration;		///< 送信時間[秒]
+	int                             batch;			///< 送受信バッチ数
+	int                             drain;			///< 送信終了後の受信待ち時間[ms]
+} tgen_option_t;
+
+//! 受信側の集計
+typedef struct {
+	uint64_t                        packets;		///< 測定パケット受信数
+	uint64_t                        bytes;			///< 測定パケット受信バイト数
+	uint64_t                        others;			///< 測定パケット以外の受信数
+	uint64_t                        unchanged;		///< 宛先が書き換わっていない受信数
+	uint64_t                        reorder;		///< 順序が逆転した受信数
+	uint64_t                        last_seq;		///< 最後に受信した順序番号
+	uint64_t                        first_ns;		///< 最初の受信時刻[ns]
+	uint64_t                        last_ns;		///< 最後の受信時刻[ns]
+	uint64_t                        lat_min;		///< 最小遅延[ns]
+	uint64_t                        lat_max;		///< 最大遅延[ns]
+	uint64_t                        lat_sum;		///< 遅延の合計[ns]
+	uint32_t                       *hist;			///< 遅延分布(1us刻み)
+} tgen_rx_stat_t;
+
+//! 受信スレッド引数
+typedef struct {
+	const tgen_option_t            *opt;			///< 測定条件
+	int                             fd;				///< 受信ソケット
+	int                             offset;			///< ペイロードのオフセット
+	volatile bool                   stop;			///< 停止要求
+	tgen_rx_stat_t                  stat;			///< 集計結果
+} tgen_rx_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部変数
+////////////////////////////////////////////////////////////////////////////////
+//! 中断要求(SIGINT/SIGTERM)
+static volatile sig_atomic_t    tgen_interrupted;
+
+//! コマンドオプション構造体
+// *INDENT-OFF*
+static const struct option      options[] = {
+	{"tx",			required_argument,	NULL, 'i'},
+	{"rx",			required_argument,	NULL, 'o'},
+	{"dst-mac",		required_argument,	NULL, 'D'},
+	{"type",		required_argument,	NULL, 't'},
+	{"src",			required_argument,	NULL, 's'},
+	{"dst",			required_argument,	NULL, 'a'},
+	{"stride",		required_argument,	NULL, 'k'},
+	{"flows",		required_argument,	NULL, 'n'},
+	{"len",			required_argument,	NULL, 'l'},
+	{"rate",		required_argument,	NULL, 'r'},
+	{"duration",	required_argument,	NULL, 'd'},
+	{"batch",		required_argument,	NULL, 'b'},
+	{"drain",		required_argument,	NULL, 'w'},
+	{"help",		no_argument,		NULL, 'h'},
+	{0, 0, 0, 0}
+};
+// *INDENT-ON*
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief コマンド凡例表示関数
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void usage(void)
+{
+	fprintf(stderr, "Usage: mx6eapp_tgen -i TX_DEV -o RX_DEV -D DST_MAC -a DST_ADDR [ -t m46e|me6e ] [ -s SRC_ADDR ]\n"
+			"                    [ -k STRIDE ] [ -n FLOWS ] [ -l LEN ] [ -r PPS ] [ -d SEC ] [ -b BATCH ] [ -w MSEC ]\n" "\n"
+			"  -i, --tx       : device to send frames on\n"
+			"  -o, --rx       : device to receive forwarded frames on\n"
+			"  -D, --dst-mac  : destination MAC of the sent frames\n"
+			"  -a, --dst      : destination IPv6 address of the first flow\n"
+			"  -t, --type     : encapsulation (m46e: IPv4 in IPv6, me6e: EtherIP, default m46e)\n"
+			"  -s, --src      : source IPv6 address (default 2001:db8::1)\n"
+			"  -k, --stride   : increment of the low 64 bits of the destination per flow (default 1)\n"
+			"  -n, --flows    : number of destinations, sent round robin (default 1)\n"
+			"  -l, --len      : frame length without FCS (default %d, max %d)\n"
+			"  -r, --rate     : packets per second (default 0: as fast as possible)\n"
+			"  -d, --duration : seconds to send (default %d)\n"
+			"  -b, --batch    : frames per sendmmsg/recvmmsg (default %d, max %d)\n"
+			"  -w, --drain    : milliseconds to keep receiving after sending (default %d)\n" "\n",
+			TGEN_DEFAULT_LEN, TGEN_FRAME_MAX, TGEN_DEFAULT_DURATION, TGEN_DEFAULT_BATCH, TGEN_BATCH_MAX, TGEN_DEFAULT_DRAIN);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 時刻取得関数
+//!
+//! @return CLOCK_MONOTONICの現在時刻[ns]
+///////////////////////////////////////////////////////////////////////////////
+static inline uint64_t tgen_now(void)
+{
+	struct timespec                 ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief シグナルハンドラ
+//!
+//! @param [in] signo シグナル番号
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void tgen_signal(int signo)
+{
+	tgen_interrupted = 1;
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief IPv6アドレス加算関数
+//!
+//! IPv6アドレスの下位64bitに値を加算する。
+//!
+//! @param [in,out] addr  IPv6アドレス
+//! @param [in]     value 加算する値
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void tgen_addr_add(struct in6_addr *addr, uint64_t value)
+{
+	uint64_t                        low = 0;
+
+	for (int i = 8; i < 16; i++) {
+		low = (low << 8) | addr->s6_addr[i];
+	}
+	low += value;
+	for (int i = 15; i >= 8; i--) {
+		addr->s6_addr[i] = low & 0xff;
+		low >>= 8;
+	}
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief IPv4ヘッダチェックサム計算関数
+//!
+//! @param [in] ip IPv4ヘッダ
+//!
+//! @return チェックサム
+///////////////////////////////////////////////////////////////////////////////
+static uint16_t tgen_ip_checksum(const struct iphdr *ip)
+{
+	const uint16_t                 *p = (const uint16_t *) ip;
+	uint32_t                        sum = 0;
+
+	for (int i = 0; i < ip->ihl * 2; i++) {
+		sum += p[i];
+	}
+	while (sum >> 16) {
+		sum = (sum & 0xffff) + (sum >> 16);
+	}
+
+	return ~sum;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief ペイロードオフセット取得関数
+//!
+//! フレーム先頭から測定パケットのペイロードまでのオフセットを返す。
+//!
+//! @param [in] me6e ME6E(EtherIP)かどうか
+//!
+//! @return オフセット
+///////////////////////////////////////////////////////////////////////////////
+static int tgen_payload_offset(bool me6e)
+{
+	int                             offset = sizeof(struct ether_header) + sizeof(struct ip6_hdr);
+
+	if (me6e) {
+		// EtherIPヘッダ(2byte) + 内側のEthernetヘッダ
+		offset += 2 + sizeof(struct ether_header);
+	}
+
+	return offset + sizeof(struct iphdr) + sizeof(struct udphdr);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 送信フレーム生成関数
+//!
+//! 宛先毎の送信フレームを生成する。順序番号と送信時刻は送信時に設定する。
+//!
+//! @param [in]  opt     測定条件
+//! @param [in]  src_mac 送信元MACアドレス
+//! @param [in]  flow    宛先番号
+//! @param [out] frame   生成したフレームの格納先(opt->len以上)
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void tgen_build_frame(const tgen_option_t * opt, const struct ether_addr *src_mac, int flow, uint8_t * frame)
+{
+	struct ether_header            *eth = (struct ether_header *) frame;
+	struct ip6_hdr                 *ip6 = (struct ip6_hdr *) (eth + 1);
+	uint8_t                        *p = (uint8_t *) (ip6 + 1);
+	struct iphdr                   *ip;
+	struct udphdr                  *udp;
+	tgen_payload_t                 *payload;
+	int                             inner_len;
+
+	memset(frame, 0, opt->len);
+
+	memcpy(eth->ether_dhost, &opt->dst_mac, ETH_ALEN);
+	memcpy(eth->ether_shost, src_mac, ETH_ALEN);
+	eth->ether_type = htons(ETHERTYPE_IPV6);
+
+	ip6->ip6_flow = htonl(6 << 28);
+	ip6->ip6_plen = htons(opt->len - sizeof(struct ether_header) - sizeof(struct ip6_hdr));
+	ip6->ip6_nxt = opt->me6e ? TGEN_IPPROTO_ETHERIP : IPPROTO_IPIP;
+	ip6->ip6_hlim = 64;
+	ip6->ip6_src = opt->src;
+	ip6->ip6_dst = opt->dst;
+	tgen_addr_add(&ip6->ip6_dst, opt->stride * flow);
+
+	if (opt->me6e) {
+		// EtherIPヘッダ(version 3)と内側のEthernetヘッダ
+		*p++ = 0x30;
+		*p++ = 0x00;
+		eth = (struct ether_header *) p;
+		eth->ether_dhost[0] = 0x02;
+		eth->ether_dhost[4] = (flow >> 8) & 0xff;
+		eth->ether_dhost[5] = flow & 0xff;
+		eth->ether_shost[0] = 0x02;
+		eth->ether_shost[5] = 0x01;
+		eth->ether_type = htons(ETHERTYPE_IP);
+		p += sizeof(struct ether_header);
+	}
+
+	inner_len = opt->len - (p - frame);
+	ip = (struct iphdr *) p;
+	ip->version = 4;
+	ip->ihl = sizeof(struct iphdr) / 4;
+	ip->tot_len = htons(inner_len);
+	ip->ttl = 64;
+	ip->protocol = IPPROTO_UDP;
+	ip->saddr = htonl(0xc0000201);
+	ip->daddr = htonl(0x0a000005 + (flow << 8));
+	ip->check = tgen_ip_checksum(ip);
+
+	udp = (struct udphdr *) (ip + 1);
+	udp->source = htons(40000);
+	udp->dest = htons(9);
+	udp->len = htons(inner_len - sizeof(struct iphdr));
+
+	payload = (tgen_payload_t *) (udp + 1);
+	payload->magic = htonl(TGEN_MAGIC);
+	payload->flow = flow;
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief パケットソケット生成関数
+//!
+//! 指定デバイスに結び付けたAF_PACKETソケットを生成する。
+//!
+//! @param [in]  name   デバイス名
+//! @param [out] hwaddr デバイスのMACアドレスの格納先(NULLの場合は取得しない)
+//!
+//! @retval 0以上 ソケットFD
+//! @retval -1    異常終了
+///////////////////////////////////////////////////////////////////////////////
+static int tgen_open_socket(const char *name, struct ether_addr *hwaddr)
+{
+	struct sockaddr_ll              sll = { 0 };
+	struct ifreq                    ifr = { 0 };
+	int                             fd;
+
+	if (0 > (fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL)))) {
+		fprintf(stderr, "tgen: socket : %s\n", strerror(errno));
+		return -1;
+	}
+
+	snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", name);
+	if (0 > ioctl(fd, SIOCGIFINDEX, &ifr)) {
+		fprintf(stderr, "tgen: %s : %s\n", name, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	sll.sll_family = AF_PACKET;
+	sll.sll_protocol = htons(ETH_P_ALL);
+	sll.sll_ifindex = ifr.ifr_ifindex;
+	if (0 > bind(fd, (struct sockaddr *) &sll, sizeof(sll))) {
+		fprintf(stderr, "tgen: bind %s : %s\n", name, strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	if (hwaddr != NULL) {
+		if (0 > ioctl(fd, SIOCGIFHWADDR, &ifr)) {
+			fprintf(stderr, "tgen: %s : %s\n", name, strerror(errno));
+			close(fd);
+			return -1;
+		}
+		memcpy(hwaddr, ifr.ifr_hwaddr.sa_data, ETH_ALEN);
+	}
+
+	return fd;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 受信パケット集計関数
+//!
+//! @param [in,out] rx    受信スレッド引数
+//! @param [in]     frame 受信フレーム
+//! @param [in]     len   受信フレーム長
+//! @param [in]     now   受信時刻[ns]
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void tgen_rx_account(tgen_rx_t * rx, const uint8_t * frame, ssize_t len, uint64_t now)
+{
+	tgen_rx_stat_t                 *stat = &rx->stat;
+	const struct ether_header      *eth = (const struct ether_header *) frame;
+	const struct ip6_hdr           *ip6 = (const struct ip6_hdr *) (eth + 1);
+	tgen_payload_t                  payload;
+	struct in6_addr                 sent;
+	uint64_t                        lat;
+
+	if ((len < rx->offset + (ssize_t) sizeof(payload)) || (eth->ether_type != htons(ETHERTYPE_IPV6))) {
+		stat->others++;
+		return;
+	}
+	memcpy(&payload, frame + rx->offset, sizeof(payload));
+	if (payload.magic != htonl(TGEN_MAGIC) || (payload.flow >= (uint32_t) rx->opt->flows)) {
+		stat->others++;
+		return;
+	}
+
+	if (stat->packets == 0) {
+		stat->first_ns = now;
+	}
+	stat->last_ns = now;
+	stat->packets++;
+	stat->bytes += len;
+
+	// 送信した宛先のまま届いた場合は書き換えられていない
+	sent = rx->opt->dst;
+	tgen_addr_add(&sent, rx->opt->stride * payload.flow);
+	if (IN6_ARE_ADDR_EQUAL(&sent, &ip6->ip6_dst)) {
+		stat->unchanged++;
+	}
+
+	if (payload.seq < stat->last_seq) {
+		stat->reorder++;
+	}
+	stat->last_seq = payload.seq;
+
+	lat = (now > payload.tx_ns) ? now - payload.tx_ns : 0;
+	if (lat < stat->lat_min) {
+		stat->lat_min = lat;
+	}
+	if (lat > stat->lat_max) {
+		stat->lat_max = lat;
+	}
+	stat->lat_sum += lat;
+	stat->hist[(lat / 1000 < TGEN_HIST_NUM) ? lat / 1000 : TGEN_HIST_NUM - 1]++;
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 受信スレッド
+//!
+//! 停止要求があるまで受信デバイスのフレームを集計する。
+//!
+//! @param [in,out] arg 受信スレッド引数
+//!
+//! @return NULL固定
+///////////////////////////////////////////////////////////////////////////////
+static void *tgen_rx_thread(void *arg)
+{
+	tgen_rx_t                      *rx = arg;
+	static uint8_t                  buf[TGEN_BATCH_MAX][TGEN_FRAME_MAX + 64];
+	struct mmsghdr                  msg[TGEN_BATCH_MAX];
+	struct iovec                    iov[TGEN_BATCH_MAX];
+	struct sockaddr_ll              from[TGEN_BATCH_MAX];
+	int                             num;
+
+	while (!rx->stop) {
+		for (int i = 0; i < rx->opt->batch; i++) {
+			iov[i].iov_base = buf[i];
+			iov[i].iov_len = sizeof(buf[i]);
+			memset(&msg[i], 0, sizeof(msg[i]));
+			msg[i].msg_hdr.msg_iov = &iov[i];
+			msg[i].msg_hdr.msg_iovlen = 1;
+			msg[i].msg_hdr.msg_name = &from[i];
+			msg[i].msg_hdr.msg_namelen = sizeof(from[i]);
+		}
+
+		num = recvmmsg(rx->fd, msg, rx->opt->batch, MSG_WAITFORONE, NULL);
+		if (num < 0) {
+			if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) {
+				continue;
+			}
+			fprintf(stderr, "tgen: recvmmsg : %s\n", strerror(errno));
+			break;
+		}
+
+		uint64_t                        now = tgen_now();
+		for (int i = 0; i < num; i++) {
+			if (from[i].sll_pkttype == PACKET_OUTGOING) {
+				continue;
+			}
+			tgen_rx_account(rx, buf[i], msg[i].msg_len, now);
+		}
+	}
+
+	return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 遅延分布の百分位数取得関数
+//!
+//! @param [in] stat  受信側の集計
+//! @param [in] ratio 百分位(0～1)
+//!
+//! @return 遅延[us]
+///////////////////////////////////////////////////////////////////////////////
+static double tgen_percentile(const tgen_rx_stat_t * stat, double ratio)
+{
+	uint64_t                        target = (uint64_t) (stat->packets * ratio);
+	uint64_t                        count = 0;
+
+	for (int i = 0; i < TGEN_HIST_NUM; i++) {
+		count += stat->hist[i];
+		if (count > target) {
+			return i;
+		}
+	}
+
+	return TGEN_HIST_NUM - 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 数値オプション解析関数
+//!
+//! @param [in]  arg   オプション文字列
+//! @param [in]  min   最小値
+//! @param [in]  max   最大値
+//! @param [out] value 解析結果の格納先
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static bool tgen_parse_number(const char *arg, uint64_t min, uint64_t max, uint64_t * value)
+{
+	char                           *end;
+
+	errno = 0;
+	*value = strtoull(arg, &end, 0);
+	if ((errno != 0) || (end == arg) || (*end != '\0') || (*value < min) || (*value > max)) {
+		fprintf(stderr, "invalid number : %s (%lu - %lu)\n", arg, (unsigned long) min, (unsigned long) max);
+		return false;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief トラフィック生成/受信メイン関数
+//!
+//! 送信デバイスから宛先を巡回しながら測定パケットを送信し、
+//! 受信デバイスに転送されてきた測定パケットから受信数/損失/遅延を集計して
+//! JSON形式で1行出力する。
+//!
+//! @param [in] argc 引数の数
+//! @param [in] argv 引数
+//!
+//! @retval EXIT_SUCCESS 正常終了
+//! @retval EXIT_FAILURE 異常終了
+///////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+	tgen_option_t                   opt = {
+		.stride = 1,
+		.flows = 1,
+		.len = TGEN_DEFAULT_LEN,
+		.duration = TGEN_DEFAULT_DURATION,
+		.batch = TGEN_DEFAULT_BATCH,
+		.drain = TGEN_DEFAULT_DRAIN,
+	};
+	tgen_rx_t                       rx = { 0 };
+	pthread_t                       rx_tid;
+	struct ether_addr               src_mac;
+	static uint8_t                  frames[TGEN_BATCH_MAX][TGEN_FRAME_MAX];
+	uint8_t                        *flow_frames;
+	struct mmsghdr                  msg[TGEN_BATCH_MAX];
+	struct iovec                    iov[TGEN_BATCH_MAX];
+	struct timeval                  tv = { 0, TGEN_RECV_TIMEOUT * 1000 };
+	bool                            has_dst = false;
+	bool                            has_mac = false;
+	uint64_t                        value;
+	uint64_t                        seq = 0;
+	uint64_t                        tx_err = 0;
+	uint64_t                        start;
+	uint64_t                        end;
+	uint64_t                        stop;
+	int                             tx_fd;
+	int                             c;
+
+	inet_pton(AF_INET6, "2001:db8::1", &opt.src);
+
+	while ((c = getopt_long(argc, argv, "i:o:D:t:s:a:k:n:l:r:d:b:w:h", options, NULL)) != -1) {
+		switch (c) {
+		case 'i':
+			snprintf(opt.tx_dev, sizeof(opt.tx_dev), "%s", optarg);
+			break;
+		case 'o':
+			snprintf(opt.rx_dev, sizeof(opt.rx_dev), "%s", optarg);
+			break;
+		case 'D':
+			if (ether_aton_r(optarg, &opt.dst_mac) == NULL) {
+				fprintf(stderr, "invalid MAC address : %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			has_mac = true;
+			break;
+		case 't':
+			if (strcmp(optarg, "m46e") == 0) {
+				opt.me6e = false;
+			} else if (strcmp(optarg, "me6e") == 0) {
+				opt.me6e = true;
+			} else {
+				fprintf(stderr, "invalid type : %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 's':
+		case 'a':
+			if (inet_pton(AF_INET6, optarg, (c == 's') ? &opt.src : &opt.dst) != 1) {
+				fprintf(stderr, "invalid IPv6 address : %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			has_dst |= (c == 'a');
+			break;
+		case 'k':
+			if (!tgen_parse_number(optarg, 0, UINT64_MAX, &opt.stride)) {
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'n':
+			if (!tgen_parse_number(optarg, 1, 65536, &value)) {
+				return EXIT_FAILURE;
+			}
+			opt.flows = value;
+			break;
+		case 'l':
+			if (!tgen_parse_number(optarg, 0, TGEN_FRAME_MAX, &value)) {
+				return EXIT_FAILURE;
+			}
+			opt.len = value;
+			break;
+		case 'r':
+			if (!tgen_parse_number(optarg, 0, UINT64_MAX, &opt.rate)) {
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'd':
+			opt.duration = strtod(optarg, NULL);
+			if (opt.duration <= 0) {
+				fprintf(stderr, "invalid duration : %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'b':
+			if (!tgen_parse_number(optarg, 1, TGEN_BATCH_MAX, &value)) {
+				return EXIT_FAILURE;
+			}
+			opt.batch = value;
+			break;
+		case 'w':
+			if (!tgen_parse_number(optarg, 0, 60000, &value)) {
+				return EXIT_FAILURE;
+			}
+			opt.drain = value;
+			break;
+		default:
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
+	if ((opt.tx_dev[0] == '\0') || (opt.rx_dev[0] == '\0') || !has_mac || !has_dst) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	rx.offset = tgen_payload_offset(opt.me6e);
+	if (opt.len < rx.offset + (int) sizeof(tgen_payload_t)) {
+		fprintf(stderr, "frame length too short : %d (min %d)\n", opt.len, rx.offset + (int) sizeof(tgen_payload_t));
+		return EXIT_FAILURE;
+	}
+
+	// ソケット生成
+	if (0 > (tx_fd = tgen_open_socket(opt.tx_dev, &src_mac))) {
+		return EXIT_FAILURE;
+	}
+	if (0 > (rx.fd = tgen_open_socket(opt.rx_dev, NULL))) {
+		return EXIT_FAILURE;
+	}
+	// 受信バッファを大きくして受信側の取りこぼしを損失に計上しないようにする
+	value = 32 * 1024 * 1024;
+	if (0 > setsockopt(rx.fd, SOL_SOCKET, SO_RCVBUFFORCE, &value, sizeof(int))) {
+		setsockopt(rx.fd, SOL_SOCKET, SO_RCVBUF, &value, sizeof(int));
+	}
+	setsockopt(rx.fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+	// 宛先毎のフレームを事前に生成する
+	if (NULL == (flow_frames = malloc((size_t) opt.flows * opt.len))) {
+		fprintf(stderr, "tgen: out of memory (%d flows)\n", opt.flows);
+		return EXIT_FAILURE;
+	}
+	for (int i = 0; i < opt.flows; i++) {
+		tgen_build_frame(&opt, &src_mac, i, flow_frames + (size_t) i * opt.len);
+	}
+
+	rx.opt = &opt;
+	rx.stat.lat_min = UINT64_MAX;
+	if (NULL == (rx.stat.hist = calloc(TGEN_HIST_NUM, sizeof(uint32_t)))) {
+		fprintf(stderr, "tgen: out of memory (histogram)\n");
+		return EXIT_FAILURE;
+	}
+	if (0 != pthread_create(&rx_tid, NULL, tgen_rx_thread, &rx)) {
+		fprintf(stderr, "tgen: fail to create rx thread\n");
+		return EXIT_FAILURE;
+	}
+
+	signal(SIGINT, tgen_signal);
+	signal(SIGTERM, tgen_signal);
+
+	for (int i = 0; i < opt.batch; i++) {
+		iov[i].iov_base = frames[i];
+		iov[i].iov_len = opt.len;
+		memset(&msg[i], 0, sizeof(msg[i]));
+		msg[i].msg_hdr.msg_iov = &iov[i];
+		msg[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	// 送信(レート指定時はバッチ単位で送信時刻を合わせる)
+	start = tgen_now();
+	stop = start + (uint64_t) (opt.duration * 1e9);
+	end = start;
+	while (!tgen_interrupted && (end < stop)) {
+		if (opt.rate) {
+			uint64_t                        due = start + (uint64_t) (seq * 1e9 / opt.rate);
+			while ((end = tgen_now()) < due) {
+				if (due - end > 50000) {
+					struct timespec                 ts = { 0, (due - end) - 50000 };
+					nanosleep(&ts, NULL);
+				}
+			}
+		}
+
+		uint64_t                        now = tgen_now();
+		for (int i = 0; i < opt.batch; i++) {
+			tgen_payload_t                 *payload;
+			int                             flow = (seq + i) % opt.flows;
+
+			memcpy(frames[i], flow_frames + (size_t) flow * opt.len, opt.len);
+			payload = (tgen_payload_t *) (frames[i] + rx.offset);
+			payload->seq = seq + i;
+			payload->tx_ns = now;
+		}
+
+		// 送信キュー溢れは損失ではなく送信失敗として数える
+		// (失敗分も順序番号は進め、受信側の順序逆転の判定を崩さない)
+		int                             sent = sendmmsg(tx_fd, msg, opt.batch, 0);
+		tx_err += (sent < 0) ? opt.batch : opt.batch - sent;
+		seq += opt.batch;
+		end = tgen_now();
+	}
+
+	// 送信終了後、転送中のパケットを待ってから受信を止める
+	usleep(opt.drain * 1000);
+	rx.stop = true;
+	pthread_join(rx_tid, NULL);
+
+	{
+		tgen_rx_stat_t                 *stat = &rx.stat;
+		uint64_t                        tx = seq - tx_err;
+		double                          tx_sec = (end - start) / 1e9;
+		double                          rx_sec = (stat->last_ns - stat->first_ns) / 1e9;
+		uint64_t                        loss = (tx > stat->packets) ? tx - stat->packets : 0;
+
+		if (stat->packets == 0) {
+			stat->lat_min = 0;
+		}
+		printf("{\"type\":\"%s\",\"flows\":%d,\"len\":%d,\"rate\":%lu,\"batch\":%d,\"duration\":%.3f,"
+			   "\"tx\":%lu,\"tx_err\":%lu,\"rx\":%lu,\"loss\":%lu,\"loss_ratio\":%.6f,"
+			   "\"tx_pps\":%.0f,\"rx_pps\":%.0f,\"rx_mbps\":%.1f,\"unchanged\":%lu,\"reorder\":%lu,\"others\":%lu,"
+			   "\"lat_us\":{\"min\":%.1f,\"avg\":%.1f,\"p50\":%.0f,\"p99\":%.0f,\"p999\":%.0f,\"max\":%.1f}}\n",
+			   opt.me6e ? "me6e" : "m46e", opt.flows, opt.len, (unsigned long) opt.rate, opt.batch, tx_sec,
+			   (unsigned long) tx, (unsigned long) tx_err, (unsigned long) stat->packets, (unsigned long) loss,
+			   tx ? (double) loss / tx : 0.0,
+			   tx_sec > 0 ? tx / tx_sec : 0.0, rx_sec > 0 ? stat->packets / rx_sec : 0.0,
+			   rx_sec > 0 ? stat->bytes * 8 / rx_sec / 1e6 : 0.0,
+			   (unsigned long) stat->unchanged, (unsigned long) stat->reorder, (unsigned long) stat->others,
+			   stat->lat_min / 1e3, stat->packets ? stat->lat_sum / 1e3 / stat->packets : 0.0,
+			   tgen_percentile(stat, 0.5), tgen_percentile(stat, 0.99), tgen_percentile(stat, 0.999), stat->lat_max / 1e3);
+	}
+
+	free(rx.stat.hist);
+	free(flow_frames);
+	close(rx.fd);
+	close(tx_fd);
+
+	return EXIT_SUCCESS;
+}
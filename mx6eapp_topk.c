@@ -0,0 +1,274 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_topk.c                                                */
+/* 機能概要   : 宛先プレフィックス別負荷集計 ソースファイル                   */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <arpa/inet.h>
+
+#include "mx6eapp_topk.h"
+#include "mx6eapp_util.h"
+
+#define DPRINTF(fd, ...)	if (0 > fd) {printf(__VA_ARGS__);} else {dprintf(fd, __VA_ARGS__);}
+
+//! インデックスのマスク
+#define TOPK_INDEX_MASK         (TOPK_INDEX_SIZE - 1)
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief インデックス位置算出関数
+//!
+//! @param [in] key キー
+//!
+//! @return インデックス位置
+///////////////////////////////////////////////////////////////////////////////
+static inline unsigned int topk_hash(uint64_t key)
+{
+	return (unsigned int) ((key * 0x9E3779B97F4A7C15ULL) >> 56) & TOPK_INDEX_MASK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief インデックス削除関数
+//!
+//! 線形探査のインデックスからキーを削除し、後続の要素を詰め直す。
+//!
+//! @param [in,out] topk 負荷集計
+//! @param [in]     key  削除するキー
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void topk_index_remove(mx6e_topk_t * topk, uint64_t key)
+{
+	unsigned int                    pos = topk_hash(key);
+	unsigned int                    next;
+
+	while (topk->index[pos] >= 0) {
+		if (topk->counter[topk->index[pos]].key == key) {
+			break;
+		}
+		pos = (pos + 1) & TOPK_INDEX_MASK;
+	}
+	if (topk->index[pos] < 0) {
+		return;
+	}
+	topk->index[pos] = -1;
+
+	// 削除位置より後ろの要素で、本来の位置が削除位置以前のものを前に詰める
+	next = pos;
+	while (1) {
+		unsigned int                    home;
+
+		next = (next + 1) & TOPK_INDEX_MASK;
+		if (topk->index[next] < 0) {
+			break;
+		}
+		home = topk_hash(topk->counter[topk->index[next]].key);
+		if (((next - home) & TOPK_INDEX_MASK) >= ((next - pos) & TOPK_INDEX_MASK)) {
+			topk->index[pos] = topk->index[next];
+			topk->index[next] = -1;
+			pos = next;
+		}
+	}
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 負荷集計初期化関数
+//!
+//! @param [out] topk 負荷集計
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_topk_init(mx6e_topk_t * topk)
+{
+	memset(topk->counter, 0, sizeof(topk->counter));
+	memset(topk->index, 0xff, sizeof(topk->index));
+	topk->num = 0;
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 負荷集計更新関数
+//!
+//! 宛先アドレスの上位64bitをキーとしてSpace-Saving法で計数する。
+//! 既存キーの場合はインデックス参照のみで更新し、新規キーでカウンタが
+//! 全て使用中の場合に限り最小カウンタを探して置き換える。
+//!
+//! @param [in,out] topk  負荷集計
+//! @param [in]     dst   宛先アドレス
+//! @param [in]     bytes パケット長
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_topk_update(mx6e_topk_t * topk, const struct in6_addr *dst, uint64_t bytes)
+{
+	uint64_t                        key;
+	unsigned int                    pos;
+	int                             slot;
+	mx6e_topk_counter_t            *c;
+
+	memcpy(&key, dst, sizeof(key));
+
+	pos = topk_hash(key);
+	while ((slot = topk->index[pos]) >= 0) {
+		c = &topk->counter[slot];
+		if (c->key == key) {
+			c->packets++;
+			c->bytes += bytes;
+			return;
+		}
+		pos = (pos + 1) & TOPK_INDEX_MASK;
+	}
+
+	if (topk->num < TOPK_COUNTER_NUM) {
+		// 空きカウンタに登録
+		slot = topk->num++;
+		c = &topk->counter[slot];
+		c->key = key;
+		c->packets = 1;
+		c->bytes = bytes;
+		c->error = 0;
+		topk->index[pos] = slot;
+		return;
+	}
+
+	// 最小カウンタを置き換える(旧カウント値を過大評価分として引き継ぐ)
+	slot = 0;
+	for (int i = 1; i < TOPK_COUNTER_NUM; i++) {
+		if (topk->counter[i].packets < topk->counter[slot].packets) {
+			slot = i;
+		}
+	}
+	c = &topk->counter[slot];
+	topk_index_remove(topk, c->key);
+
+	c->key = key;
+	c->error = c->packets;
+	c->packets++;
+	c->bytes += bytes;
+
+	pos = topk_hash(key);
+	while (topk->index[pos] >= 0) {
+		pos = (pos + 1) & TOPK_INDEX_MASK;
+	}
+	topk->index[pos] = slot;
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief パケット数降順比較関数(qsort用)
+///////////////////////////////////////////////////////////////////////////////
+static int topk_compare(const void *a, const void *b)
+{
+	const mx6e_topk_counter_t      *ca = (const mx6e_topk_counter_t *) a;
+	const mx6e_topk_counter_t      *cb = (const mx6e_topk_counter_t *) b;
+
+	if (ca->packets != cb->packets) {
+		return (ca->packets > cb->packets) ? -1 : 1;
+	}
+	if (ca->bytes != cb->bytes) {
+		return (ca->bytes > cb->bytes) ? -1 : 1;
+	}
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 集計結果出力関数
+//!
+//! @param [in] fd      出力先のディスクリプタ
+//! @param [in] title   見出し
+//! @param [in] counter カウンタ配列(降順ソート済み)
+//! @param [in] count   カウンタ数
+//! @param [in] num     出力件数
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void topk_print_list(int fd, const char *title, mx6e_topk_counter_t * counter, int count, int num)
+{
+	char                            address[INET6_ADDRSTRLEN];
+	char                            prefix[INET6_ADDRSTRLEN + 4];
+
+	DPRINTF(fd, "【%s】\n", title);
+	DPRINTF(fd, "\n");
+	DPRINTF(fd, " rank  %-28s %14s %18s %14s\n", "destination", "packets", "bytes", "error");
+	for (int i = 0; i < min(count, num); i++) {
+		struct in6_addr                 addr = in6addr_any;
+
+		memcpy(&addr, &counter[i].key, sizeof(counter[i].key));
+		inet_ntop(AF_INET6, &addr, address, sizeof(address));
+		snprintf(prefix, sizeof(prefix), "%s/64", address);
+		DPRINTF(fd, " %4d  %-28s %14lu %18lu %14lu\n", i + 1, prefix,
+				(unsigned long) counter[i].packets, (unsigned long) counter[i].bytes, (unsigned long) counter[i].error);
+	}
+	DPRINTF(fd, "\n");
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 負荷集計出力関数
+//!
+//! FP/PRそれぞれの集計と、両者をキー毎に合算した集計の上位を出力する。
+//! 転送スレッドの更新中に写すため、各値は近似値となる。
+//!
+//! @param [in] fp_topk FP側負荷集計
+//! @param [in] pr_topk PR側負荷集計
+//! @param [in] num     出力件数
+//! @param [in] fd      出力先のディスクリプタ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_topk_print(mx6e_topk_t * fp_topk, mx6e_topk_t * pr_topk, int num, int fd)
+{
+	mx6e_topk_counter_t             fp[TOPK_COUNTER_NUM];
+	mx6e_topk_counter_t             pr[TOPK_COUNTER_NUM];
+	mx6e_topk_counter_t             merged[TOPK_COUNTER_NUM * 2];
+	int                             fp_num;
+	int                             pr_num;
+	int                             merged_num;
+
+	if (num <= 0) {
+		num = TOPK_SHOW_DEFAULT;
+	}
+
+	fp_num = min(fp_topk->num, TOPK_COUNTER_NUM);
+	memcpy(fp, fp_topk->counter, sizeof(fp));
+	pr_num = min(pr_topk->num, TOPK_COUNTER_NUM);
+	memcpy(pr, pr_topk->counter, sizeof(pr));
+
+	// 合算(同一キーはカウント、過大評価分とも加算)
+	memcpy(merged, fp, sizeof(mx6e_topk_counter_t) * fp_num);
+	merged_num = fp_num;
+	for (int i = 0; i < pr_num; i++) {
+		int                             j;
+		for (j = 0; j < merged_num; j++) {
+			if (merged[j].key == pr[i].key) {
+				merged[j].packets += pr[i].packets;
+				merged[j].bytes += pr[i].bytes;
+				merged[j].error += pr[i].error;
+				break;
+			}
+		}
+		if (j == merged_num) {
+			merged[merged_num++] = pr[i];
+		}
+	}
+
+	qsort(fp, fp_num, sizeof(mx6e_topk_counter_t), topk_compare);
+	qsort(pr, pr_num, sizeof(mx6e_topk_counter_t), topk_compare);
+	qsort(merged, merged_num, sizeof(mx6e_topk_counter_t), topk_compare);
+
+	topk_print_list(fd, "FP domain", fp, fp_num, num);
+	topk_print_list(fd, "PR domain", pr, pr_num, num);
+	topk_print_list(fd, "total", merged, merged_num, num);
+
+	return;
+}
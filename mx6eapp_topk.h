@@ -0,0 +1,49 @@
+/******************************************************************************/
+/* ファイル名 : mx6eapp_topk.h                                                */
+/* 機能概要   : 宛先プレフィックス別負荷集計 ヘッダファイル                   */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+#ifndef __MX6EAPP_TOPK_H__
+#   define __MX6EAPP_TOPK_H__
+
+#   include <stdint.h>
+#   include <netinet/in.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! 1スレッドあたりの集計カウンタ数(Space-Saving の k)
+#   define TOPK_COUNTER_NUM        64
+//! カウンタ検索用インデックスのサイズ(2のべき乗)
+#   define TOPK_INDEX_SIZE         256
+//! 表示件数省略時のデフォルト
+#   define TOPK_SHOW_DEFAULT       10
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! 集計カウンタ
+typedef struct {
+	uint64_t                        key;			///< 宛先アドレス上位64bit(ネットワークバイトオーダのまま)
+	uint64_t                        packets;		///< パケット数(過大評価を含む)
+	uint64_t                        bytes;			///< バイト数(過大評価を含む)
+	uint64_t                        error;			///< 過大評価の上限(パケット数)
+} mx6e_topk_counter_t;
+
+//! 宛先/64別負荷集計(Space-Saving、書き込みは転送スレッドのみ)
+typedef struct {
+	mx6e_topk_counter_t             counter[TOPK_COUNTER_NUM];	///< 集計カウンタ
+	int16_t                         index[TOPK_INDEX_SIZE];	///< キー→カウンタ位置(-1:空き)
+	int                             num;			///< 使用中カウンタ数
+} mx6e_topk_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// 外部関数プロトタイプ宣言
+////////////////////////////////////////////////////////////////////////////////
+void                            mx6e_topk_init(mx6e_topk_t * topk);
+void                            mx6e_topk_update(mx6e_topk_t * topk, const struct in6_addr *dst, uint64_t bytes);
+void                            mx6e_topk_print(mx6e_topk_t * fp_topk, mx6e_topk_t * pr_topk, int num, int fd);
+
+#endif												// __MX6EAPP_TOPK_H__
@@ -35,16 +35,37 @@
 #include "mx6eapp_util.h"
 #include "mx6eapp_statistics.h"
 #include "mx6eapp_pt.h"
+#include "mx6eapp_drop.h"
+#include "mx6eapp_probe.h"
 
 //! 受信バッファのサイズ
 #define TUNNEL_RECV_BUF_SIZE 65535
 
+////////////////////////////////////////////////////////////////////////////////
+// 内部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! 送信待ちキュー(受信バッファを指したまま、受信処理1回分の送信パケットを溜める)
+typedef struct {
+	mx6e_io_pkt_t                   pkt[MX6E_IO_BURST_MAX];	///< 送信パケット
+	table_type_t                    type[MX6E_IO_BURST_MAX];	///< 一致したテーブルタイプ(統計用)
+	int                             num;			///< 送信待ちパケット数
+} tunnel_tx_queue_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部変数
+////////////////////////////////////////////////////////////////////////////////
+static __thread tunnel_tx_queue_t tunnel_txq_pr2fp;	///< PR->FP転送の送信待ちキュー
+static __thread tunnel_tx_queue_t tunnel_txq_fp2pr;	///< FP->PR転送の送信待ちキュー
+
 ////////////////////////////////////////////////////////////////////////////////
 // 内部関数プロトタイプ宣言
 ////////////////////////////////////////////////////////////////////////////////
 static void                     tunnel_buffer_cleanup(void *buffer);
 static void                     tunnel_pr2fp_main_loop(mx6e_handler_t * handler);
 static void                     tunnel_fp2pr_main_loop(mx6e_handler_t * handler);
+static inline void              tunnel_set_recv_buffer(mx6e_io_pkt_t * pkt, char *recv_buffer);
+static inline void              tunnel_enqueue_pr2fp(mx6e_handler_t * handler, char *buf, ssize_t len, table_type_t type);
+static inline void              tunnel_enqueue_fp2pr(mx6e_handler_t * handler, char *buf, ssize_t len, table_type_t type);
 
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief PRネットワーク用 パケットカプセル化スレッド
@@ -104,6 +125,72 @@ void                           *mx6e_tunnel_fp_thread(void *arg)
 	return NULL;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//! @brief パケットI/O初期化関数
+//!
+//! 両方向のパケットI/Oを未オープン状態に初期化する。
+//!
+//! @param [out] handler   MX6Eハンドラ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_tunnel_io_init(mx6e_handler_t * handler)
+{
+	mx6e_io_init(&handler->io_fp2pr.rx);
+	mx6e_io_init(&handler->io_fp2pr.tx);
+	mx6e_io_init(&handler->io_pr2fp.rx);
+	mx6e_io_init(&handler->io_pr2fp.tx);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief パケットI/Oオープン関数
+//!
+//! 設定ファイルで転送方向毎に指定されたバックエンドでパケットI/Oをオープンする。
+//! FP->PR転送はFP側トンネルデバイスから受信してPR側トンネルデバイスへ送信し、
+//! PR->FP転送はその逆となる。トンネルデバイスの生成(または引き継ぎ)後、
+//! 転送スレッドの起動前に呼ぶこと。
+//!
+//! @param [in,out] handler   MX6Eハンドラ
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+bool mx6e_tunnel_io_open(mx6e_handler_t * handler)
+{
+	mx6e_config_devices_t          *devices = &handler->conf.devices;
+
+	if (!mx6e_io_open(&handler->io_fp2pr.rx, devices->fp2pr_rx, &devices->tunnel_fp, -1)
+		|| !mx6e_io_open(&handler->io_fp2pr.tx, devices->fp2pr_tx, &devices->tunnel_pr, devices->send_sock_fd_pr)
+		|| !mx6e_io_open(&handler->io_pr2fp.rx, devices->pr2fp_rx, &devices->tunnel_pr, -1)
+		|| !mx6e_io_open(&handler->io_pr2fp.tx, devices->pr2fp_tx, &devices->tunnel_fp, devices->send_sock_fd_fp)) {
+		mx6e_tunnel_io_release(handler);
+		return false;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief パケットI/O解放関数
+//!
+//! 転送スレッドの終了後に呼ぶこと。
+//!
+//! @param [in,out] handler   MX6Eハンドラ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void mx6e_tunnel_io_release(mx6e_handler_t * handler)
+{
+	mx6e_io_release(&handler->io_fp2pr.rx);
+	mx6e_io_release(&handler->io_fp2pr.tx);
+	mx6e_io_release(&handler->io_pr2fp.rx);
+	mx6e_io_release(&handler->io_pr2fp.tx);
+
+	return;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief 受信バッファ解放関数
 //!
@@ -141,15 +228,16 @@ static void tunnel_pr2fp_main_loop(mx6e_handler_t * handler)
 	int                             max_fd;
 	fd_set                          fds;
 	char                           *recv_buffer;
-	ssize_t                         recv_len;
-	mx6e_device_t                  *pr_dev;
+	mx6e_io_pkt_t                   pkt[MX6E_IO_BURST_MAX];
+	int                             num;
+	mx6e_io_t                      *rx_io;
 
 	// 引数チェック
 	if (handler == NULL) {
 		return;
 	}
-	// 受信バッファ領域を確保
-	recv_buffer = (char *) malloc(TUNNEL_RECV_BUF_SIZE);
+	// 受信バッファ領域を確保(まとめて受信するパケット数分)
+	recv_buffer = (char *) malloc(TUNNEL_RECV_BUF_SIZE * MX6E_IO_BURST_MAX);
 	if (recv_buffer == NULL) {
 		mx6e_logging(LOG_ERR, "receive buffer allocation failed\n");
 		return;
@@ -157,42 +245,42 @@ static void tunnel_pr2fp_main_loop(mx6e_handler_t * handler)
 	// 後始末ハンドラ登録
 	pthread_cleanup_push(tunnel_buffer_cleanup, (void *) recv_buffer);
 
-	// デバイス
-	pr_dev = &handler->conf.devices.tunnel_pr;
+	// 受信側のパケットI/O
+	rx_io = &handler->io_pr2fp.rx;
+	if ((rx_io->ops == NULL) || (rx_io->fd < 0)) {
+		mx6e_logging(LOG_ERR, "PR tunnel packet I/O is not opened\n");
+		goto loop_end;
+	}
 
 	// selector用のファイディスクリプタ設定
 	// (待ち受けるディスクリプタの最大値+1)
 	max_fd = -1;
-	max_fd = max(max_fd, pr_dev->fd);
+	max_fd = max(max_fd, rx_io->fd);
 	max_fd++;
 
 	// ループ前に今溜まっているデータを全て吐き出す
-	while (1) {
-		struct timeval                  t;
-		FD_ZERO(&fds);
-		FD_SET(pr_dev->fd, &fds);
-
-		// timevalを0に設定することで、即時に受信できるデータを待つ
-		t.tv_sec = 0;
-		t.tv_usec = 0;
-
-		// 受信待ち
-		if (select(max_fd, &fds, NULL, NULL, &t) > 0) {
-			if (FD_ISSET(pr_dev->fd, &fds)) {
-				recv_len = read(pr_dev->fd, recv_buffer, TUNNEL_RECV_BUF_SIZE);
-			}
-		} else {
+	// (ホットリスタートの場合は引き継ぎ元の転送待ちパケットなので吐き出さない)
+	while (handler->handover == MX6E_HANDOVER_NONE) {
+		// 受信統計に計上しないようにバックエンドを直接呼ぶ
+		tunnel_set_recv_buffer(pkt, recv_buffer);
+		if (rx_io->ops->rx_burst(rx_io, pkt, MX6E_IO_BURST_MAX) <= 0) {
 			// 即時に受信できるデータが無くなったのでループを抜ける
 			break;
 		}
 	}
 
-	mx6e_logging(LOG_INFO, "tunnel_pr2fp_main_loop start\n");
+	// 本スレッドの性能カウンタを作成
+	mx6e_perf_open(&handler->perf_pr);
+
+	// 本スレッドの非同期ログリングを割り当て
+	mx6e_log_ring_register();
+
+	mx6e_logging(LOG_INFO, "tunnel_pr2fp_main_loop start (rx %s, tx %s)\n", mx6e_io_type_name(rx_io->type), mx6e_io_type_name(handler->io_pr2fp.tx.type));
 
 	while (1) {
 		// selectorの初期化
 		FD_ZERO(&fds);
-		FD_SET(pr_dev->fd, &fds);
+		FD_SET(rx_io->fd, &fds);
 
 		// 受信待ち
 		if (select(max_fd, &fds, NULL, NULL, NULL) < 0) {
@@ -206,18 +294,28 @@ static void tunnel_pr2fp_main_loop(mx6e_handler_t * handler)
 			}
 		}
 		// PR用デバイスでデータ受信
-		if (FD_ISSET(pr_dev->fd, &fds)) {
-			if ((recv_len = read(pr_dev->fd, recv_buffer, TUNNEL_RECV_BUF_SIZE)) > 0) {
-				// FPデバイスに転送
-				tunnel_forward_pr2fp_packet(handler, recv_buffer, recv_len);
+		if (FD_ISSET(rx_io->fd, &fds)) {
+			// 受信したパケットは転送し終えてから終了するため、転送中はスレッドの取り消しを保留する
+			pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+			tunnel_set_recv_buffer(pkt, recv_buffer);
+			if ((num = mx6e_io_rx_burst(rx_io, pkt, MX6E_IO_BURST_MAX)) >= 0) {
+				for (int i = 0; i < num; i++) {
+					MX6E_PROBE3(rx, DOMAIN_PR, pkt[i].data, pkt[i].len);
+					// FPデバイスに転送
+					tunnel_forward_pr2fp_packet(handler, pkt[i].data, pkt[i].len);
+				}
+				// 受信バッファを再利用する前にまとめて送信
+				tunnel_flush_pr2fp_packet(handler);
 			} else {
-				mx6e_logging(LOG_ERR, "v4 recvfrom\n");
+				mx6e_logging_async(LOG_ERR, "v4 recvfrom\n");
 			}
+			pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
 		}
 	}
 
 	mx6e_logging(LOG_INFO, "Fp tunnel thread main loop end\n");
 
+  loop_end:
 	// 後始末
 	pthread_cleanup_pop(1);
 
@@ -241,15 +339,16 @@ static void tunnel_fp2pr_main_loop(mx6e_handler_t * handler)
 	int                             max_fd;
 	fd_set                          fds;
 	char                           *recv_buffer;
-	ssize_t                         recv_len;
-	mx6e_device_t                  *fp_dev;
+	mx6e_io_pkt_t                   pkt[MX6E_IO_BURST_MAX];
+	int                             num;
+	mx6e_io_t                      *rx_io;
 
 	// 引数チェック
 	if (handler == NULL) {
 		return;
 	}
-	// 受信バッファ領域を確保
-	recv_buffer = (char *) malloc(TUNNEL_RECV_BUF_SIZE);
+	// 受信バッファ領域を確保(まとめて受信するパケット数分)
+	recv_buffer = (char *) malloc(TUNNEL_RECV_BUF_SIZE * MX6E_IO_BURST_MAX);
 	if (recv_buffer == NULL) {
 		mx6e_logging(LOG_ERR, "receive buffer allocation failed\n");
 		return;
@@ -257,42 +356,42 @@ static void tunnel_fp2pr_main_loop(mx6e_handler_t * handler)
 	// 後始末ハンドラ登録
 	pthread_cleanup_push(tunnel_buffer_cleanup, (void *) recv_buffer);
 
-	// デバイス
-	fp_dev = &handler->conf.devices.tunnel_fp;
+	// 受信側のパケットI/O
+	rx_io = &handler->io_fp2pr.rx;
+	if ((rx_io->ops == NULL) || (rx_io->fd < 0)) {
+		mx6e_logging(LOG_ERR, "Fp tunnel packet I/O is not opened\n");
+		goto loop_end;
+	}
 
 	// selector用のファイディスクリプタ設定
 	// (待ち受けるディスクリプタの最大値+1)
 	max_fd = -1;
-	max_fd = max(max_fd, fp_dev->fd);
+	max_fd = max(max_fd, rx_io->fd);
 	max_fd++;
 
 	// ループ前に今溜まっているデータを全て吐き出す
-	while (1) {
-		struct timeval                  t;
-		FD_ZERO(&fds);
-		FD_SET(fp_dev->fd, &fds);
-
-		// timevalを0に設定することで、即時に受信できるデータを待つ
-		t.tv_sec = 0;
-		t.tv_usec = 0;
-
-		// 受信待ち
-		if (select(max_fd, &fds, NULL, NULL, &t) > 0) {
-			if (FD_ISSET(fp_dev->fd, &fds)) {
-				recv_len = read(fp_dev->fd, recv_buffer, TUNNEL_RECV_BUF_SIZE);
-			}
-		} else {
+	// (ホットリスタートの場合は引き継ぎ元の転送待ちパケットなので吐き出さない)
+	while (handler->handover == MX6E_HANDOVER_NONE) {
+		// 受信統計に計上しないようにバックエンドを直接呼ぶ
+		tunnel_set_recv_buffer(pkt, recv_buffer);
+		if (rx_io->ops->rx_burst(rx_io, pkt, MX6E_IO_BURST_MAX) <= 0) {
 			// 即時に受信できるデータが無くなったのでループを抜ける
 			break;
 		}
 	}
 
-	mx6e_logging(LOG_INFO, "tunnel_fp2pr_main_loop start\n");
+	// 本スレッドの性能カウンタを作成
+	mx6e_perf_open(&handler->perf_fp);
+
+	// 本スレッドの非同期ログリングを割り当て
+	mx6e_log_ring_register();
+
+	mx6e_logging(LOG_INFO, "tunnel_fp2pr_main_loop start (rx %s, tx %s)\n", mx6e_io_type_name(rx_io->type), mx6e_io_type_name(handler->io_fp2pr.tx.type));
 
 	while (1) {
 		// selectorの初期化
 		FD_ZERO(&fds);
-		FD_SET(fp_dev->fd, &fds);
+		FD_SET(rx_io->fd, &fds);
 
 		// 受信待ち
 		if (select(max_fd, &fds, NULL, NULL, NULL) < 0) {
@@ -306,18 +405,28 @@ static void tunnel_fp2pr_main_loop(mx6e_handler_t * handler)
 			}
 		}
 		// FP用デバイスでデータ受信
-		if (FD_ISSET(fp_dev->fd, &fds)) {
-			if ((recv_len = read(fp_dev->fd, recv_buffer, TUNNEL_RECV_BUF_SIZE)) > 0) {
-				// PRデバイスに転送
-				tunnel_forward_fp2pr_packet(handler, recv_buffer, recv_len);
+		if (FD_ISSET(rx_io->fd, &fds)) {
+			// 受信したパケットは転送し終えてから終了するため、転送中はスレッドの取り消しを保留する
+			pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+			tunnel_set_recv_buffer(pkt, recv_buffer);
+			if ((num = mx6e_io_rx_burst(rx_io, pkt, MX6E_IO_BURST_MAX)) >= 0) {
+				for (int i = 0; i < num; i++) {
+					MX6E_PROBE3(rx, DOMAIN_FP, pkt[i].data, pkt[i].len);
+					// PRデバイスに転送
+					tunnel_forward_fp2pr_packet(handler, pkt[i].data, pkt[i].len);
+				}
+				// 受信バッファを再利用する前にまとめて送信
+				tunnel_flush_fp2pr_packet(handler);
 			} else {
-				mx6e_logging(LOG_ERR, "v6 recvfrom\n");
+				mx6e_logging_async(LOG_ERR, "v6 recvfrom\n");
 			}
+			pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
 		}
 	}
 
 	mx6e_logging(LOG_INFO, "Fp tunnel thread main loop end\n");
 
+  loop_end:
 	// 後始末
 	pthread_cleanup_pop(1);
 
@@ -325,77 +434,179 @@ static void tunnel_fp2pr_main_loop(mx6e_handler_t * handler)
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-//! @brief 送信処理関数
+//! @brief 受信バッファ設定関数
 //!
-//! socketに送信する
+//! まとめて受信するパケット毎に受信バッファ領域を割り当てる。
 //!
-//! @param [in] fd          送信先ソケットFD
-//! @param [in] buf         送信データポインタ
-//! @param [in] len			送信データ長
+//! @param [out] pkt           受信パケット(MX6E_IO_BURST_MAX個)
+//! @param [in]  recv_buffer   受信バッファ領域
 //!
-//! @retval 0 <   送信データ長
-//! @retval 0 >   異常終了
+//! @return なし
 ///////////////////////////////////////////////////////////////////////////////
-static inline int send_buf_msg(int fd, char *buf, ssize_t len)
+static inline void tunnel_set_recv_buffer(mx6e_io_pkt_t * pkt, char *recv_buffer)
 {
+	for (int i = 0; i < MX6E_IO_BURST_MAX; i++) {
+		pkt[i].data = recv_buffer + ((size_t) i * TUNNEL_RECV_BUF_SIZE);
+		pkt[i].len = TUNNEL_RECV_BUF_SIZE;
+	}
 
-	struct ip6_hdr                 *p_ip6;
-	struct sockaddr_in6             daddr;
-	struct cmsghdr                 *cmsg;
-	char                            cmsgbuf[CMSG_SPACE(sizeof(struct in6_pktinfo))] = { 0 };
-	struct iovec                    iov[2];
-	struct msghdr                   msg = { 0 };
-	struct in6_pktinfo             *info;
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief PR->FP送信待ちキュー追加関数
+//!
+//! 受信バッファを指したままキューに溜め、満杯の場合は先に送信する。
+//!
+//! @param [in,out] handler     MX6Eハンドラ
+//! @param [in]     buf         送信データポインタ
+//! @param [in]     len         送信データ長
+//! @param [in]     type        一致したテーブルタイプ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static inline void tunnel_enqueue_pr2fp(mx6e_handler_t * handler, char *buf, ssize_t len, table_type_t type)
+{
+	tunnel_tx_queue_t              *q = &tunnel_txq_pr2fp;
 
-	return write(fd, buf, len);
+	if (q->num >= MX6E_IO_BURST_MAX) {
+		tunnel_flush_pr2fp_packet(handler);
+	}
+	q->pkt[q->num].data = buf;
+	q->pkt[q->num].len = len;
+	q->type[q->num] = type;
+	q->num++;
 
-	
-	p_ip6 = (struct ip6_hdr *) (buf + sizeof(struct ethhdr));
+	return;
+}
 
-	// IPv6ヘッダの設定
-	daddr.sin6_family = AF_INET6;
-	daddr.sin6_port = htons(p_ip6->ip6_nxt);
-	daddr.sin6_addr = p_ip6->ip6_dst;
-	daddr.sin6_flowinfo = 0;
-	daddr.sin6_scope_id = 0;
+///////////////////////////////////////////////////////////////////////////////
+//! @brief FP->PR送信待ちキュー追加関数
+//!
+//! 受信バッファを指したままキューに溜め、満杯の場合は先に送信する。
+//!
+//! @param [in,out] handler     MX6Eハンドラ
+//! @param [in]     buf         送信データポインタ
+//! @param [in]     len         送信データ長
+//! @param [in]     type        一致したテーブルタイプ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static inline void tunnel_enqueue_fp2pr(mx6e_handler_t * handler, char *buf, ssize_t len, table_type_t type)
+{
+	tunnel_tx_queue_t              *q = &tunnel_txq_fp2pr;
 
-	iov[0].iov_base = buf;
-	iov[0].iov_len = len;
+	if (q->num >= MX6E_IO_BURST_MAX) {
+		tunnel_flush_fp2pr_packet(handler);
+	}
+	q->pkt[q->num].data = buf;
+	q->pkt[q->num].len = len;
+	q->type[q->num] = type;
+	q->num++;
 
-	_D_(printf("iov[0].iov_len:%ld\n", iov[0].iov_len));
+	return;
+}
 
-	iov[1].iov_base = NULL;
-	iov[1].iov_len = 0;
+///////////////////////////////////////////////////////////////////////////////
+//! @brief PR->FP送信関数
+//!
+//! 送信待ちキューのパケットを送信側パケットI/Oにまとめて送信し、
+//! 送信結果を統計に計上する。送信エラーのパケットは破棄して残りの送信を続ける。
+//! 受信バッファを再利用する前に呼び出すこと。
+//!
+//! @param [in,out] handler     MX6Eハンドラ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void tunnel_flush_pr2fp_packet(mx6e_handler_t * handler)
+{
+	tunnel_tx_queue_t              *q = &tunnel_txq_pr2fp;
+	mx6e_io_t                      *tx = &handler->io_pr2fp.tx;
+	int                             done = 0;
 
-	msg.msg_name = &daddr;
-	msg.msg_namelen = sizeof(daddr);
-	msg.msg_iov = iov;
-	msg.msg_iovlen = 1;
-	msg.msg_control = NULL;
-	msg.msg_controllen = 0;
+	while (done < q->num) {
+		int                             n = mx6e_io_tx_burst(tx, &q->pkt[done], q->num - done);
 
-	msg.msg_control = &cmsgbuf[0];
-	msg.msg_controllen = sizeof(cmsgbuf);
+		for (int i = done; i < (done + n); i++) {
+			DEBUG_LOG("forward %ld bytes\n", (long int) q->pkt[i].len);
+			if (CONFIG_TYPE_M46E == q->type[i]) {
+				STAT_PR_M46E_SEND_SUCCESS;
+			} else {
+				STAT_PR_ME6E_SEND_SUCCESS;
+			}
+			MX6E_PROBE3(tx, DOMAIN_PR, q->pkt[i].data, q->pkt[i].len);
+			STAT_PR_SEND_BYTES(q->pkt[i].len);
+		}
+		done += n;
+		if (done < q->num) {
+			mx6e_io_pkt_t                  *p = &q->pkt[done];
 
-	cmsg = CMSG_FIRSTHDR(&msg);
-	cmsg->cmsg_len = CMSG_LEN(sizeof(struct in6_pktinfo));
-	cmsg->cmsg_level = IPPROTO_IPV6;
-	cmsg->cmsg_type = IPV6_PKTINFO;
+			MX6E_PROBE3(tx_error, DOMAIN_PR, p->len, errno);
+			if (CONFIG_TYPE_M46E == q->type[done]) {
+				mx6e_logging_async(LOG_ERR, "fail to send IPPROTO_IPIP packet (%m)\n");
+				STAT_PR_M46E_SEND_ERR;
+			} else {
+				mx6e_logging_async(LOG_ERR, "fail to send ME6E_IPPROTO_ETHERIP packet (%m)\n");
+				STAT_PR_ME6E_SEND_ERR;
+			}
+			mx6e_drop_capture(&handler->drop_pr, MX6E_DROP_SEND_ERR, p->data, p->len);
+			done++;
+		}
+	}
+	q->num = 0;
 
-	// 送信元情報(in6_pktinfo)をcmsgへ設定
-	info = (struct in6_pktinfo *) CMSG_DATA(cmsg);
-	info->ipi6_addr = p_ip6->ip6_src;
+	return;
+}
 
-	if (IN6_IS_ADDR_MULTICAST(&p_ip6->ip6_dst)) {
-		// マルチキャスト送信はしない
-		return false;
-	} else {
-		// ユニキャスト送信
-		info->ipi6_ifindex = 0;
+///////////////////////////////////////////////////////////////////////////////
+//! @brief FP->PR送信関数
+//!
+//! 送信待ちキューのパケットを送信側パケットI/Oにまとめて送信し、
+//! 送信結果を統計に計上する。送信エラーのパケットは破棄して残りの送信を続ける。
+//! 受信バッファを再利用する前に呼び出すこと。
+//!
+//! @param [in,out] handler     MX6Eハンドラ
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+void tunnel_flush_fp2pr_packet(mx6e_handler_t * handler)
+{
+	tunnel_tx_queue_t              *q = &tunnel_txq_fp2pr;
+	mx6e_io_t                      *tx = &handler->io_fp2pr.tx;
+	int                             done = 0;
+
+	while (done < q->num) {
+		int                             n = mx6e_io_tx_burst(tx, &q->pkt[done], q->num - done);
+
+		for (int i = done; i < (done + n); i++) {
+			DEBUG_LOG("forward %ld bytes\n", (long int) q->pkt[i].len);
+			if (CONFIG_TYPE_M46E == q->type[i]) {
+				STAT_FP_M46E_SEND_SUCCESS;
+			} else {
+				STAT_FP_ME6E_SEND_SUCCESS;
+			}
+			MX6E_PROBE3(tx, DOMAIN_FP, q->pkt[i].data, q->pkt[i].len);
+			STAT_FP_SEND_BYTES(q->pkt[i].len);
+		}
+		done += n;
+		if (done < q->num) {
+			mx6e_io_pkt_t                  *p = &q->pkt[done];
+
+			MX6E_PROBE3(tx_error, DOMAIN_FP, p->len, errno);
+			if (CONFIG_TYPE_M46E == q->type[done]) {
+				mx6e_logging_async(LOG_ERR, "fail to send IPPROTO_IPIP packet (%m)\n");
+				STAT_FP_M46E_SEND_ERR;
+			} else {
+				mx6e_logging_async(LOG_ERR, "fail to send ME6E_IPPROTO_ETHERIP packet (%m)\n");
+				STAT_FP_ME6E_SEND_ERR;
+			}
+			mx6e_drop_capture(&handler->drop_fp, MX6E_DROP_SEND_ERR, p->data, p->len);
+			done++;
+		}
 	}
+	q->num = 0;
 
-	// カプセル化したデータを送信
-	return sendmsg(fd, &msg, 0);
+	return;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -406,7 +617,6 @@ static inline int send_buf_msg(int fd, char *buf, ssize_t len)
 //! @param [in,out] handler     MX6Eハンドラ
 //! @param [in]     recv_buffer 受信パケットデータ
 //! @param [in]     recv_len    受信パケット長
-//! @param [in]     send_fd     パケットを転送するファイルディスクリプタ
 //!
 //! @return なし
 ///////////////////////////////////////////////////////////////////////////////
@@ -414,22 +624,24 @@ void tunnel_forward_pr2fp_packet(mx6e_handler_t * handler, char *recv_buffer, ss
 {
 	mx6e_device_t *dev_src = &handler->conf.devices.tunnel_pr;
 	mx6e_device_t *dev_dst = &handler->conf.devices.tunnel_fp;
+	mx6e_io_t *tx = &handler->io_pr2fp.tx;
 	
 	struct ethhdr                  *p_ether;		// see /usr/include/linux/if_ether.h
 	struct ip6_hdr                 *p_ip6 = NULL;	// see /usr/include/netinet/ip6.h
 	mx6e_config_entry_t            *entry;
-	ssize_t                         send_len;
 
 	// ローカル変数初期化
 	p_ether = (struct ethhdr *) recv_buffer;
 
 	// 統計情報
 	STAT_PR_RECIEVE;
+	STAT_PR_RECIEVE_BYTES(recv_len);
 
 	if (mx6e_util_is_broadcast_mac(&p_ether->h_dest[0])) {
 		// ブロードキャストパケットは黙って破棄
 		DEBUG_LOG("drop packet so that recv packet is broadcast\n");
 		STAT_PR_ERR_BROADCAST;
+		mx6e_drop_capture(&handler->drop_pr, MX6E_DROP_BROADCAST, recv_buffer, recv_len);
 		return;
 	}
 	
@@ -464,10 +676,11 @@ void tunnel_forward_pr2fp_packet(mx6e_handler_t * handler, char *recv_buffer, ss
 		// IPPROTO_IPV6 = 41,     // IPv6 header.
 		// ME6E_IPPROTO_ETHERIP   97 : EtherIP(97 0x61 ETHERIP Ethernet-within-IP Encapsulation)ならME6E-PTテーブル、
 
-		if (p_ip6->ip6_hlim == 1) {
-			// Hop Limitが1のパケットは黙って破棄(これ以上転送できない為)
-			DEBUG_LOG("drop packet so that hop limit is 1.\n");
+		if (p_ip6->ip6_hlim <= 1) {
+			// Hop Limitが1以下のパケットは黙って破棄(これ以上転送できない為)
+			DEBUG_LOG("drop packet so that hop limit is %d.\n", p_ip6->ip6_hlim);
 			STAT_PR_ERR_HOPLIMIT;
+			mx6e_drop_capture(&handler->drop_pr, MX6E_DROP_HOPLIMIT, recv_buffer, recv_len);
 			return;
 		}
 #if 0	// 2016/07/22 nextヘッダを判断して検索テーブルを別けるのはやめる暫定対処。
@@ -481,25 +694,21 @@ void tunnel_forward_pr2fp_packet(mx6e_handler_t * handler, char *recv_buffer, ss
 			int m46e_entry_flg = 0;		// 2016/07/22 nextヘッダを判断して検索テーブルを別けるのはやめる暫定対処。
 			// エントリ検索
 			if (NULL != (entry = mx6e_match_config_table(DOMAIN_PR, &handler->conf.m46e_conf_table, &p_ip6->ip6_dst))) {
+				MX6E_PROBE3(lookup_hit, DOMAIN_PR, entry, &p_ip6->ip6_dst);
+				// 宛先/64別負荷集計(置換前の宛先で計数)
+				mx6e_topk_update(&handler->topk_pr, &p_ip6->ip6_dst, recv_len);
+
 				// ヘッダ置換
 				mx6e_replace_address(entry, p_ip6);
+				MX6E_PROBE4(rewrite, DOMAIN_PR, entry, &p_ip6->ip6_src, &p_ip6->ip6_dst);
 
 				////////////////////////////////////////////////////////////////////////
 				// 送信
 				////////////////////////////////////////////////////////////////////////
-				if (dev_dst->fd) {
-					if (0 > (send_len = send_buf_msg(dev_dst->fd, recv_buffer, recv_len))) {
-						char                            mes2[1024];
-						snprintf(mes2, sizeof(mes2), "fail to send IPPROTO_IPIP packet (%s)\n", strerror(errno)); 
-						mx6e_logging(LOG_ERR, mes2);
-
-						STAT_PR_M46E_SEND_ERR;
-					} else {
-						DEBUG_LOG("forward %ld bytes to IPPROTO_IPIP\n", (unsigned long int) send_len);
-						STAT_PR_M46E_SEND_SUCCESS;
-					}
+				if (tx->ops != NULL) {
+					tunnel_enqueue_pr2fp(handler, recv_buffer, recv_len, CONFIG_TYPE_M46E);
 				} else {
-					// 送信デバイスfdが0の場合はデバッグダンプ
+					// 送信側パケットI/Oが未オープンの場合はデバッグダンプ
 					_D_( {
 						for (int i = 0; i < recv_len; i++) {
 						if (0 == (i % 16)) {
@@ -523,25 +732,21 @@ void tunnel_forward_pr2fp_packet(mx6e_handler_t * handler, char *recv_buffer, ss
 			// ME6E IPv6
 			// エントリ検索
 			if (NULL != (entry = mx6e_match_config_table(DOMAIN_PR, &handler->conf.me6e_conf_table, &p_ip6->ip6_dst))) {
+				MX6E_PROBE3(lookup_hit, DOMAIN_PR, entry, &p_ip6->ip6_dst);
+				// 宛先/64別負荷集計(置換前の宛先で計数)
+				mx6e_topk_update(&handler->topk_pr, &p_ip6->ip6_dst, recv_len);
+
 				// ヘッダ置換
 				mx6e_replace_address(entry, p_ip6);
+				MX6E_PROBE4(rewrite, DOMAIN_PR, entry, &p_ip6->ip6_src, &p_ip6->ip6_dst);
 
 				////////////////////////////////////////////////////////////////////////
 				// 送信
 				////////////////////////////////////////////////////////////////////////
-				if (dev_dst->fd) {
-					if (0 > (send_len = send_buf_msg(dev_dst->fd, recv_buffer, recv_len))) {
-						char                            mes2[1024];
-						snprintf(mes2, sizeof(mes2), "fail to send ME6E_IPPROTO_ETHERIP packet (%s)\n", strerror(errno)); 
-						mx6e_logging(LOG_ERR, mes2);
-
-						STAT_PR_ME6E_SEND_ERR;
-					} else {
-						DEBUG_LOG("forward %ld bytes to ME6E_IPPROTO_ETHERIP\n", (unsigned long int) send_len);
-						STAT_PR_ME6E_SEND_SUCCESS;
-					}
+				if (tx->ops != NULL) {
+					tunnel_enqueue_pr2fp(handler, recv_buffer, recv_len, CONFIG_TYPE_ME6E);
 				} else {
-					// 送信デバイスfdが0の場合はデバッグダンプ
+					// 送信側パケットI/Oが未オープンの場合はデバッグダンプ
 					_D_( {
 						for (int i = 0; i < recv_len; i++) {
 						if (0 == (i % 16)) {
@@ -553,6 +758,9 @@ void tunnel_forward_pr2fp_packet(mx6e_handler_t * handler, char *recv_buffer, ss
 			} else {
 				DEBUG_LOG("fail to match ME6E_IPPROTO_ETHERIP packet\n");
 				STAT_PR_ME6E_SEND_ERR;
+				mx6e_drop_capture(&handler->drop_pr, MX6E_DROP_NO_ENTRY, recv_buffer, recv_len);
+				MX6E_PROBE2(lookup_miss, DOMAIN_PR, &p_ip6->ip6_dst);
+				mx6e_miss_record(&handler->miss_pr, &p_ip6->ip6_dst);
 			}
 		}
 #if 0	// 2016/07/22 nextヘッダを判断して検索テーブルを別けるのはやめる暫定対処。
@@ -569,6 +777,7 @@ void tunnel_forward_pr2fp_packet(mx6e_handler_t * handler, char *recv_buffer, ss
 		// IPv6以外のパケットは、黙って破棄。
 		DEBUG_LOG("Drop IPv6 Packet Ether Type : %d\n", ntohs(p_ether->h_proto));
 		STAT_PR_ERR_OTHER_PROTO;
+		mx6e_drop_capture(&handler->drop_pr, MX6E_DROP_OTHER_PROTO, recv_buffer, recv_len);
 	}
 
 	return;
@@ -585,7 +794,6 @@ void tunnel_forward_pr2fp_packet(mx6e_handler_t * handler, char *recv_buffer, ss
 //! @param [in,out] handler     MX6Eハンドラ
 //! @param [in]     recv_buffer 受信パケットデータ
 //! @param [in]     recv_len    受信パケット長
-//! @param [in]     send_fd     パケットを転送するファイルディスクリプタ
 //!
 //! @return なし
 ///////////////////////////////////////////////////////////////////////////////
@@ -593,22 +801,24 @@ void tunnel_forward_fp2pr_packet(mx6e_handler_t * handler, char *recv_buffer, ss
 {
 	mx6e_device_t *dev_src = &handler->conf.devices.tunnel_fp;
 	mx6e_device_t *dev_dst = &handler->conf.devices.tunnel_pr;
+	mx6e_io_t *tx = &handler->io_fp2pr.tx;
 
 	struct ethhdr                  *p_ether;
 	struct ip6_hdr                 *p_ip6;
 	mx6e_config_entry_t            *entry;
-	ssize_t                         send_len;
 
 	// ローカル変数初期化
 	p_ether = (struct ethhdr *) recv_buffer;
 
 	// 統計情報
 	STAT_FP_RECIEVE;
+	STAT_FP_RECIEVE_BYTES(recv_len);
 
 	if (mx6e_util_is_broadcast_mac(&p_ether->h_dest[0])) {
 		// ブロードキャストパケットは黙って破棄
 		DEBUG_LOG("drop packet so that recv packet is broadcast\n");
 		STAT_FP_ERR_BROADCAST;
+		mx6e_drop_capture(&handler->drop_fp, MX6E_DROP_BROADCAST, recv_buffer, recv_len);
 		return;
 	}
 
@@ -643,10 +853,11 @@ void tunnel_forward_fp2pr_packet(mx6e_handler_t * handler, char *recv_buffer, ss
 		// 送信先はルーティングテーブルにお任せ
 		p_ip6 = (struct ip6_hdr *) (recv_buffer + sizeof(struct ethhdr));
 
-		if (p_ip6->ip6_hlim == 1) {
-			// Hop Limitが1のパケットは黙って破棄(これ以上転送できない為)
-			DEBUG_LOG("drop packet so that hop limit is 1.\n");
+		if (p_ip6->ip6_hlim <= 1) {
+			// Hop Limitが1以下のパケットは黙って破棄(これ以上転送できない為)
+			DEBUG_LOG("drop packet so that hop limit is %d.\n", p_ip6->ip6_hlim);
 			STAT_FP_ERR_HOPLIMIT;
+			mx6e_drop_capture(&handler->drop_fp, MX6E_DROP_HOPLIMIT, recv_buffer, recv_len);
 			return;
 		}
 #if 0	// 2016/07/22 nextヘッダを判断して検索テーブルを別けるのはやめる暫定対処。
@@ -659,25 +870,21 @@ void tunnel_forward_fp2pr_packet(mx6e_handler_t * handler, char *recv_buffer, ss
 			int m46e_entry_flg = 0;		// 2016/07/22 nextヘッダを判断して検索テーブルを別けるのはやめる暫定対処。
 			// エントリ検索
 			if (NULL != (entry = mx6e_match_config_table(DOMAIN_FP, &handler->conf.m46e_conf_table, &p_ip6->ip6_dst))) {
+				MX6E_PROBE3(lookup_hit, DOMAIN_FP, entry, &p_ip6->ip6_dst);
+				// 宛先/64別負荷集計(置換前の宛先で計数)
+				mx6e_topk_update(&handler->topk_fp, &p_ip6->ip6_dst, recv_len);
+
 				// ヘッダ置換
 				mx6e_replace_address(entry, p_ip6);
+				MX6E_PROBE4(rewrite, DOMAIN_FP, entry, &p_ip6->ip6_src, &p_ip6->ip6_dst);
 
 				////////////////////////////////////////////////////////////////////////
 				// 送信
 				////////////////////////////////////////////////////////////////////////
-				if (dev_dst->fd) {
-					if (0 > (send_len = send_buf_msg(dev_dst->fd, recv_buffer, recv_len))) {
-						char                            mes2[1024];
-						snprintf(mes2, sizeof(mes2), "fail to send IPPROTO_IPIP packet (%s)\n", strerror(errno)); 
-						mx6e_logging(LOG_ERR, mes2);
-
-						STAT_FP_M46E_SEND_ERR;
-					} else {
-						DEBUG_LOG("forward %ld bytes to IPPROTO_IPIP\n", (unsigned long int) send_len);
-						STAT_FP_M46E_SEND_SUCCESS;
-					}
+				if (tx->ops != NULL) {
+					tunnel_enqueue_fp2pr(handler, recv_buffer, recv_len, CONFIG_TYPE_M46E);
 				} else {
-					// 送信デバイスfdがNULLの場合はデバッグダンプ
+					// 送信側パケットI/Oが未オープンの場合はデバッグダンプ
 					_D_(STAT_FP_ME6E_SEND_SUCCESS;	// とりあえず送信に計上
 						{
 						for (int i = 0; i < recv_len; i++) {
@@ -702,25 +909,21 @@ void tunnel_forward_fp2pr_packet(mx6e_handler_t * handler, char *recv_buffer, ss
 		if ( m46e_entry_flg == 0 ){	// 2016/07/22 nextヘッダを判断して検索テーブルを別けるのはやめる暫定対処。
 			// エントリ検索
 			if (NULL != (entry = mx6e_match_config_table(DOMAIN_FP, &handler->conf.me6e_conf_table, &p_ip6->ip6_dst))) {
+				MX6E_PROBE3(lookup_hit, DOMAIN_FP, entry, &p_ip6->ip6_dst);
+				// 宛先/64別負荷集計(置換前の宛先で計数)
+				mx6e_topk_update(&handler->topk_fp, &p_ip6->ip6_dst, recv_len);
+
 				// ヘッダ置換
 				mx6e_replace_address(entry, p_ip6);
+				MX6E_PROBE4(rewrite, DOMAIN_FP, entry, &p_ip6->ip6_src, &p_ip6->ip6_dst);
 
 				////////////////////////////////////////////////////////////////////////
 				// 送信
 				////////////////////////////////////////////////////////////////////////
-				if (dev_dst->fd) {
-					if (0 > (send_len = send_buf_msg(dev_dst->fd, recv_buffer, recv_len))) {
-						char                            mes2[1024];
-						snprintf(mes2, sizeof(mes2), "fail to send ME6E_IPPROTO_ETHERIP packet (%s)\n", strerror(errno)); 
-						mx6e_logging(LOG_ERR, mes2);
-
-						STAT_FP_ME6E_SEND_ERR;
-					} else {
-						DEBUG_LOG("forward %ld bytes to ME6E_IPPROTO_ETHERIP\n", (unsigned long int) send_len);
-						STAT_FP_ME6E_SEND_SUCCESS;
-					}
+				if (tx->ops != NULL) {
+					tunnel_enqueue_fp2pr(handler, recv_buffer, recv_len, CONFIG_TYPE_ME6E);
 				} else {
-					// 送信デバイスfdがNULLの場合はデバッグダンプ
+					// 送信側パケットI/Oが未オープンの場合はデバッグダンプ
 					_D_(STAT_FP_ME6E_SEND_SUCCESS;	// とりあえず送信に計上
 						{
 						for (int i = 0; i < recv_len; i++) {
@@ -733,6 +936,9 @@ void tunnel_forward_fp2pr_packet(mx6e_handler_t * handler, char *recv_buffer, ss
 			} else {
 				DEBUG_LOG("fail to match ME6E_IPPROTO_ETHERIP packet\n");
 				STAT_FP_ME6E_SEND_ERR;
+				mx6e_drop_capture(&handler->drop_fp, MX6E_DROP_NO_ENTRY, recv_buffer, recv_len);
+				MX6E_PROBE2(lookup_miss, DOMAIN_FP, &p_ip6->ip6_dst);
+				mx6e_miss_record(&handler->miss_fp, &p_ip6->ip6_dst);
 
 			}
 		}
@@ -750,6 +956,7 @@ void tunnel_forward_fp2pr_packet(mx6e_handler_t * handler, char *recv_buffer, ss
 		// IPv6以外のパケットは、黙って破棄。
 		DEBUG_LOG("Drop IPv6 Packet Ether Type : %d\n", ntohs(p_ether->h_proto));
 		STAT_FP_ERR_OTHER_PROTO;
+		mx6e_drop_capture(&handler->drop_fp, MX6E_DROP_OTHER_PROTO, recv_buffer, recv_len);
 	}
 
 
@@ -15,7 +15,12 @@
 ////////////////////////////////////////////////////////////////////////////////
 void                           *mx6e_tunnel_pr_thread(void *arg);
 void                           *mx6e_tunnel_fp_thread(void *arg);
+void                            mx6e_tunnel_io_init(mx6e_handler_t * handler);
+bool                            mx6e_tunnel_io_open(mx6e_handler_t * handler);
+void                            mx6e_tunnel_io_release(mx6e_handler_t * handler);
 void                            tunnel_forward_fp2pr_packet(mx6e_handler_t * handler, char *recv_buffer, ssize_t recv_len);
 void                            tunnel_forward_pr2fp_packet(mx6e_handler_t * handler, char *recv_buffer, ssize_t recv_len);
+void                            tunnel_flush_fp2pr_packet(mx6e_handler_t * handler);
+void                            tunnel_flush_pr2fp_packet(mx6e_handler_t * handler);
 
 #endif												// __MX6EAPP_TUNNEL_H__
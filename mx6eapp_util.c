@@ -689,6 +689,17 @@ const char                     *get_command_name(mx6e_command_code_t code)
 		{MX6E_LOAD_COMMAND,					"MX6E_LOAD_COMMAND",				"M46E/ME6E-Commandファイル読み込み"},
 		{MX6E_SET_DEBUG_LOG,				"MX6E_SET_DEBUG_LOG",				"動的定義変更 デバッグログ出力設定"},
 		{MX6E_SET_DEBUG_LOG_END,			"MX6E_SET_DEBUG_LOG_END",			"動的定義変更 デバッグログ出力設定完了"},
+		{MX6E_SHOW_RATE,					"MX6E_SHOW_RATE",					"レート履歴表示"},
+		{MX6E_DUMP_DROPS,					"MX6E_DUMP_DROPS",					"破棄パケット出力"},
+		{MX6E_SHOW_TOP,						"MX6E_SHOW_TOP",					"宛先/64別負荷上位表示"},
+		{MX6E_SHOW_MISSES,					"MX6E_SHOW_MISSES",					"エントリ未登録宛先表示"},
+		{MX6E_LOAD_BATCH,					"MX6E_LOAD_BATCH",					"M46E/ME6E ENTRY 一括読み込み"},
+		{MX6E_SYNC_M46E_ENTRY,				"MX6E_SYNC_M46E_ENTRY",				"M46E ENTRY 同期(差分反映)"},
+		{MX6E_SYNC_ME6E_ENTRY,				"MX6E_SYNC_ME6E_ENTRY",				"ME6E ENTRY 同期(差分反映)"},
+		{MX6E_SHOW_M46E_VERSION,			"MX6E_SHOW_M46E_VERSION",			"M46E テーブル版数表示"},
+		{MX6E_SHOW_ME6E_VERSION,			"MX6E_SHOW_ME6E_VERSION",			"ME6E テーブル版数表示"},
+		{MX6E_HANDOVER,						"MX6E_HANDOVER",					"ホットリスタート引き継ぎ要求"},
+		{MX6E_RELOAD_CONFIG,				"MX6E_RELOAD_CONFIG",				"設定ファイル再読み込み"},
 		{MX6E_COMMAND_MAX,					"MX6E_COMMAND_MAX",					"終端"},
 	};
 	// *INDENT-ON*
@@ -1068,11 +1079,11 @@ bool make_config_entry(mx6e_config_entry_t * entry, table_type_t type, mx6e_conf
 		modbitmask = MODBITMASK;
 		_D_(printf("あまりbit:%d, 0x%02x\n", modbit, modbitmask));
 		if (0 < modbit) {
-			entry->des.dst_addr.s6_addr[i] |= modbitmask;
-			entry->des.dst_addr.s6_addr[i] &= (modbitmask & entry->des.prefix.s6_addr[i]);
+			entry->des.dst_addr.s6_addr[i] &= (~modbitmask);
+			entry->des.dst_addr.s6_addr[i] |= (modbitmask & entry->des.prefix.s6_addr[i]);
 
-			entry->des.src_addr.s6_addr[i] |= modbitmask;
-			entry->des.src_addr.s6_addr[i] &= (modbitmask & entry->des.prefix.s6_addr[i]);
+			entry->des.src_addr.s6_addr[i] &= (~modbitmask);
+			entry->des.src_addr.s6_addr[i] |= (modbitmask & entry->des.prefix.s6_addr[i]);
 		}
 
 		// FPドメインから受信した場合、PRドメインのソースアドレスはPRのプレフィックスを設定
@@ -1084,8 +1095,8 @@ bool make_config_entry(mx6e_config_entry_t * entry, table_type_t type, mx6e_conf
 			modbit = devices->tunnel_pr.ipv6_netmask - ((devices->tunnel_pr.ipv6_netmask / 8) * 8);
 			modbitmask = MODBITMASK;
 			if (0 < modbit) {
-				entry->des.src_addr.s6_addr[i] |= modbitmask;
-				entry->des.src_addr.s6_addr[i] &= (modbitmask & devices->tunnel_pr.ipv6_address.s6_addr[i]);
+				entry->des.src_addr.s6_addr[i] &= (~modbitmask);
+				entry->des.src_addr.s6_addr[i] |= (modbitmask & devices->tunnel_pr.ipv6_address.s6_addr[i]);
 			}
 		}
 #endif
@@ -1132,11 +1143,11 @@ bool make_config_entry(mx6e_config_entry_t * entry, table_type_t type, mx6e_conf
 		modbitmask = MODBITMASK;
 		_D_(printf("あまりbit:%d, 0x%02x\n", modbit, modbitmask));
 		if (0 < modbit) {
-			entry->des.dst_addr.s6_addr[i] |= modbitmask;
-			entry->des.dst_addr.s6_addr[i] &= (modbitmask & entry->des.prefix.s6_addr[i]);
+			entry->des.dst_addr.s6_addr[i] &= (~modbitmask);
+			entry->des.dst_addr.s6_addr[i] |= (modbitmask & entry->des.prefix.s6_addr[i]);
 
-			entry->des.src_addr.s6_addr[i] |= modbitmask;
-			entry->des.src_addr.s6_addr[i] &= (modbitmask & entry->des.prefix.s6_addr[i]);
+			entry->des.src_addr.s6_addr[i] &= (~modbitmask);
+			entry->des.src_addr.s6_addr[i] |= (modbitmask & entry->des.prefix.s6_addr[i]);
 		}
 		/// マルチプレーン対応 2016/07/27 add start
 		// FPドメインから受信した場合、PRドメインのソースアドレスはPRのプレフィックスを設定
@@ -1148,8 +1159,8 @@ bool make_config_entry(mx6e_config_entry_t * entry, table_type_t type, mx6e_conf
 			modbit = devices->tunnel_pr.ipv6_netmask - ((devices->tunnel_pr.ipv6_netmask / 8) * 8);
 			modbitmask = MODBITMASK;
 			if (0 < modbit) {
-				entry->des.src_addr.s6_addr[i] |= modbitmask;
-				entry->des.src_addr.s6_addr[i] &= (modbitmask & devices->tunnel_pr.ipv6_address.s6_addr[i]);
+				entry->des.src_addr.s6_addr[i] &= (~modbitmask);
+				entry->des.src_addr.s6_addr[i] |= (modbitmask & devices->tunnel_pr.ipv6_address.s6_addr[i]);
 			}
 		}
 		/// マルチプレーン対応 2016/07/27 add end
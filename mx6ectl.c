@@ -33,6 +33,8 @@
 //! コマンドオプション構造体
 static const struct option      options[] = {
 	{"name", required_argument, 0, 'n'},
+	{"since", required_argument, 0, 's'},
+	{"perf", no_argument, 0, 'p'},
 	{"help", no_argument, 0, 'h'},
 	{"usage", no_argument, 0, 'h'},
 	{0, 0, 0, 0}
@@ -50,6 +52,10 @@ struct command_arg {
 static const struct command_arg command_args[] = {
 	{"show",		"stat",		MX6E_SHOW_STATISTIC},
 	{"show",		"conf",		MX6E_SHOW_CONF},
+	{"show",		"rate",		MX6E_SHOW_RATE},
+	{"dump",		"drops",	MX6E_DUMP_DROPS},
+	{"show",		"top",		MX6E_SHOW_TOP},
+	{"show",		"misses",	MX6E_SHOW_MISSES},
 	{"set",			"debug",	MX6E_SET_DEBUG_LOG},
 
 	{"add",			"m46e",		MX6E_ADD_M46E_ENTRY},			///< M46E ENTRY 追加
@@ -68,9 +74,14 @@ static const struct command_arg command_args[] = {
 
 	{"load",		"m46e",		MX6E_LOAD_COMMAND},				///< M46E/ME6E-Commandファイル読み込み
 	{"load",		"me6e",		MX6E_LOAD_COMMAND},				///< M46E/ME6E-Commandファイル読み込み
+	{"sync",		"m46e",		MX6E_SYNC_M46E_ENTRY},			///< M46E ENTRY 同期
+	{"sync",		"me6e",		MX6E_SYNC_ME6E_ENTRY},			///< ME6E ENTRY 同期
+	{"version",		"m46e",		MX6E_SHOW_M46E_VERSION},		///< M46E テーブル版数表示
+	{"version",		"me6e",		MX6E_SHOW_ME6E_VERSION},		///< ME6E テーブル版数表示
 
 	{"shutdown",	"",			MX6E_SHUTDOWN},
 	{"restart",		"",			MX6E_RESTART},
+	{"reload",		"",			MX6E_RELOAD_CONFIG},			///< 設定ファイル再読み込み
 	{NULL,			NULL,		MX6E_COMMAND_MAX}
 };
 // *INDENT-ON*
@@ -92,13 +103,20 @@ static void usage(void)
 			"       mx6ectl { -h | --help | --usage }\n"
 			"\n"
 			"where  COMMAND := { exec shell  | exec inet    | show stat   | show conf |\n"
+			"                    show rate   | show top     | show misses | dump drops |\n"
 			"                    set debug   | set defgw    |\n"
 			"                    add m46e    | del m46e     | delall m46e |\n"
 			"                    enable m46e | disable m46e | show m46e   | load m46e |\n"
+			"                    sync m46e   | version m46e |\n"
 			"                    add me6e    | del me6e     | delall me6e |\n"
 			"                    enable me6e | disable me6e | show me6e   | load me6e |\n"
-			"                    shutdown    | restart }\n"
+			"                    sync me6e   | version me6e |\n"
+			"                    shutdown    | restart      | reload }\n"
 			"where  OPTIONS :=\n"
+			"       show stat  :  [--perf]\n"
+			"       show rate  :  [--since N[s|m|h|d]]\n"
+			"       show top   :  [num]\n"
+			"       dump drops :  file_name\n"
 			"       set debug  :  on/off\n"
 			"       add     m46e pr -  [in_plane_id] [in_prefix_len] [ipv4_network_address/prefix_len] [ipv6_network_address/prefix_len] [out_plane_id] [enable|disable]\n"
 			"       add     m46e fp [section_device_ipv6_network_address/prefix_len] [in_plane_id] [in_prefix_len] [ipv4_network_address/prefix_len] [ipv6_network_address/prefix_len] [out_plane_id] [enable|disable]\n"
@@ -109,8 +127,10 @@ static void usage(void)
 			"       enable  m46e fp [section_device_ipv6_network_address/prefix_len] [in_plane_id] [in_prefix_len] [ipv4_network_address/prefix_len]\n"
 			"       disable m46e pr - [in_plane_id] [in_prefix_len] [ipv4_network_address/prefix_len]\n"
 			"       disable m46e fp [section_device_ipv6_network_address/prefix_len] [in_plane_id] [in_prefix_len] [ipv4_network_address/prefix_len]\n"
-			"       show    m46e\n"
+			"       show    m46e [domain=pr|fp] [plane=plane_id] [prefix=address/prefix_len] [state=enable|disable] [offset=N] [limit=N] [format=table|json]\n"
 			"       load    m46e file_name\n"
+			"       sync    m46e file_name\n"
+			"       version m46e\n"
 			"\n"
 			"       add     me6e pr - [in_plane_id] [in_prefix_len] [hwaddr] [ipv6_network_address/prefix_len] [out_plane_id] [enable|disable]\n"
 			"       add     me6e fp [section_device_ipv6_network_address/prefix_len] [in_plane_id] [in_prefix_len] [hwaddr] [ipv6_network_address/prefix_len] [out_plane_id] [enable|disable]\n"
@@ -121,11 +141,18 @@ static void usage(void)
 			"       enable  me6e fp [section_device_ipv6_network_address/prefix_len] [in_plane_id] [in_prefix_len] [hwaddr]\n"
 			"       disable me6e pr - [in_plane_id] [in_prefix_len] [hwaddr]\n"
 			"       disable me6e fp [section_device_ipv6_network_address/prefix_len] [in_plane_id] [in_prefix_len] [hwaddr]\n"
-			"       show    me6e\n"
-			"       load    me6e file_name\n" "\n"
+			"       show    me6e [domain=pr|fp] [plane=plane_id] [prefix=address/prefix_len] [state=enable|disable] [offset=N] [limit=N] [format=table|json]\n"
+			"       load    me6e file_name\n"
+			"       sync    me6e file_name\n"
+			"       version me6e\n" "\n"
 			"// mx6ectl command explanations // \n"
 			"  show stat         : Show the statistics information in specified PLANE_NAME\n"
+			"                      (--perf : with per-packet hardware counters and packet I/O statistics of forwarding threads)\n"
 			"  show conf         : Show the configuration in specified PLANE_NAME\n"
+			"  show rate         : Show the pps/bps history in specified PLANE_NAME\n"
+			"  show top          : Show the busiest destination /64 prefixes in specified PLANE_NAME\n"
+			"  show misses       : Show the destination prefixes without matching entry in specified PLANE_NAME\n"
+			"  dump drops        : Write the recently dropped packets as pcapng in specified PLANE_NAME\n"
 			"  set debug         : Set the debug log printing mode specified PROCESS_NAME\n"
 			"  add m46e|me6e     : Add the M46E/ME6E Entry to M46E/ME6E Table specified PLANE_NAME\n"
 			"  del m46e|me6e     : Delete the M46E/ME6E Entry from M46E/ME6E Table specified PLANE_NAME\n"
@@ -134,8 +161,14 @@ static void usage(void)
 			"  disable m46e|me6e : Disable the M46E/ME6E Entry at M46E/ME6E Table specified PLANE_NAME\n"
 			"  show m46e|me6e    : Show the M46E/ME6E Table specified PLANE_NAME\n"
 			"  load m46e|me6e    : Load M46E/ME6E Command file specified PLANE_NAME\n"
+			"  sync m46e|me6e    : Make M46E/ME6E Table specified PLANE_NAME match the add lines of Command file\n"
+			"                      (only the differences are applied, entries not in the file are deleted)\n"
+			"  version m46e|me6e : Show the version, content hash and entry count of M46E/ME6E Table specified PLANE_NAME\n"
 			"  shutdown          : Shutting down the application specified PLANE_NAME\n"
 			"  restart           : Restart the application specified PLANE_NAME\n"
+			"                      (the new process takes over the tunnel devices, tables and routes without interruption)\n"
+			"  reload            : Reload the config file of the application specified PLANE_NAME\n"
+			"                      (only debug_log, startup_script, miss_prefix_len and snapshot_* are applied, other changes need restart)\n"
 		);
 // *INDENT-ON*
 
@@ -170,7 +203,8 @@ static void usage_func(mx6e_command_code_t code)
 		fprintf(stderr, "Usage: mx6ectl -n PROCESS_NAME disable m46e pr|fp plane_id_in prefix_len_in ipv4_network_address/prefix_len\n");
 		break;
 	case MX6E_SHOW_M46E_ENTRY:
-		fprintf(stderr, "Usage: mx6ectl -n PROCESS_NAME show    m46e\n");
+		fprintf(stderr, "Usage: mx6ectl -n PROCESS_NAME show    m46e [domain=pr|fp] [plane=plane_id] [prefix=address/prefix_len]\n"
+				"                                         [state=enable|disable] [offset=N] [limit=N] [format=table|json]\n");
 		break;
 
 	case MX6E_ADD_ME6E_ENTRY:
@@ -189,19 +223,46 @@ static void usage_func(mx6e_command_code_t code)
 		fprintf(stderr, "Usage: mx6ectl -n PROCESS_NAME disable me6e pr|fp plane_id_in prefix_len_in hwaddr\n");
 		break;
 	case MX6E_SHOW_ME6E_ENTRY:
-		fprintf(stderr, "Usage: mx6ectl -n PROCESS_NAME show    me6e\n");
+		fprintf(stderr, "Usage: mx6ectl -n PROCESS_NAME show    me6e [domain=pr|fp] [plane=plane_id] [prefix=address/prefix_len]\n"
+				"                                         [state=enable|disable] [offset=N] [limit=N] [format=table|json]\n");
 		break;
 
 	case MX6E_LOAD_COMMAND:
 		fprintf(stderr, "Usage: mx6ectl -n PROCESS_NAME load    m46e|me6e file_name\n");
 		break;
 
+	case MX6E_SYNC_M46E_ENTRY:
+	case MX6E_SYNC_ME6E_ENTRY:
+		fprintf(stderr, "Usage: mx6ectl -n PROCESS_NAME sync    m46e|me6e file_name\n");
+		break;
+
+	case MX6E_SHOW_M46E_VERSION:
+	case MX6E_SHOW_ME6E_VERSION:
+		fprintf(stderr, "Usage: mx6ectl -n PROCESS_NAME version m46e|me6e\n");
+		break;
+
 	case MX6E_SHOW_CONF:
 		fprintf(stderr, "Usage: mx6ectl -n PROCESS_NAME show conf\n");
 		break;
 
 	case MX6E_SHOW_STATISTIC:
-		fprintf(stderr, "Usage: mx6ectl -n PROCESS_NAME show stat\n");
+		fprintf(stderr, "Usage: mx6ectl -n PROCESS_NAME show stat [--perf]\n");
+		break;
+
+	case MX6E_SHOW_RATE:
+		fprintf(stderr, "Usage: mx6ectl -n PROCESS_NAME show rate [--since N[s|m|h|d]]\n");
+		break;
+
+	case MX6E_DUMP_DROPS:
+		fprintf(stderr, "Usage: mx6ectl -n PROCESS_NAME dump drops file_name\n");
+		break;
+
+	case MX6E_SHOW_TOP:
+		fprintf(stderr, "Usage: mx6ectl -n PROCESS_NAME show top [num]\n");
+		break;
+
+	case MX6E_SHOW_MISSES:
+		fprintf(stderr, "Usage: mx6ectl -n PROCESS_NAME show misses\n");
 		break;
 
 	case MX6E_SET_DEBUG_LOG:
@@ -224,6 +285,8 @@ static void usage_func(mx6e_command_code_t code)
 int main(int argc, char *argv[])
 {
 	char                           *name = NULL;
+	char                           *since = NULL;
+	bool                            perf = false;
 	int                             option_index = 0;
 
 	// 引数チェック
@@ -238,6 +301,14 @@ int main(int argc, char *argv[])
 			name = optarg;
 			break;
 
+		case 's':
+			since = optarg;
+			break;
+
+		case 'p':
+			perf = true;
+			break;
+
 		case 'h':
 			usage();
 			exit(EXIT_SUCCESS);
@@ -319,10 +390,18 @@ int main(int argc, char *argv[])
 
 		{MX6E_SET_DEBUG_LOG,		DYNAMIC_OPE_DBGLOG_ARGS,	DYNAMIC_OPE_DBGLOG_ARGS,	{mx6e_command_dbglog_set_option}},
 		{MX6E_SHOW_CONF,			SHOW_CONF_OPE_ARGS,			SHOW_CONF_OPE_ARGS,			{NULL}},
-		{MX6E_SHOW_STATISTIC,		SHOW_STAT_OPE_ARGS,			SHOW_STAT_OPE_ARGS,			{NULL}},
-		{MX6E_SHOW_M46E_ENTRY,		SHOW_M46E_OPE_ARGS,			SHOW_M46E_OPE_ARGS,			{NULL}},
-		{MX6E_SHOW_ME6E_ENTRY,		SHOW_ME6E_OPE_ARGS,			SHOW_ME6E_OPE_ARGS,			{NULL}},
+		{MX6E_SHOW_STATISTIC,		SHOW_STAT_OPE_MIN_ARGS,		SHOW_STAT_OPE_MAX_ARGS,		{NULL}},
+		{MX6E_SHOW_RATE,			SHOW_RATE_OPE_MIN_ARGS,		SHOW_RATE_OPE_MAX_ARGS,		{NULL}},
+		{MX6E_DUMP_DROPS,			DUMP_DROPS_OPE_ARGS,		DUMP_DROPS_OPE_ARGS,		{NULL}},
+		{MX6E_SHOW_TOP,				SHOW_TOP_OPE_MIN_ARGS,		SHOW_TOP_OPE_MAX_ARGS,		{mx6e_command_top_set_option}},
+		{MX6E_SHOW_MISSES,			SHOW_MISSES_OPE_ARGS,		SHOW_MISSES_OPE_ARGS,		{NULL}},
+		{MX6E_SHOW_M46E_ENTRY,		SHOW_M46E_OPE_MIN_ARGS,		SHOW_M46E_OPE_MAX_ARGS,		{mx6e_command_show_entry_option}},
+		{MX6E_SHOW_ME6E_ENTRY,		SHOW_ME6E_OPE_MIN_ARGS,		SHOW_ME6E_OPE_MAX_ARGS,		{mx6e_command_show_entry_option}},
 		{MX6E_LOAD_COMMAND,			OPE_NUM_LOAD,				OPE_NUM_LOAD,				{NULL, mx6e_command_load}},
+		{MX6E_SYNC_M46E_ENTRY,		OPE_NUM_SYNC,				OPE_NUM_SYNC,				{NULL, mx6e_command_sync}},
+		{MX6E_SYNC_ME6E_ENTRY,		OPE_NUM_SYNC,				OPE_NUM_SYNC,				{NULL, mx6e_command_sync}},
+		{MX6E_SHOW_M46E_VERSION,	SHOW_VERSION_OPE_ARGS,		SHOW_VERSION_OPE_ARGS,		{NULL}},
+		{MX6E_SHOW_ME6E_VERSION,	SHOW_VERSION_OPE_ARGS,		SHOW_VERSION_OPE_ARGS,		{NULL}},
 		{MX6E_COMMAND_MAX,			0,							0,							{NULL}},
 	};
 	// *INDENT-ON*
@@ -353,6 +432,35 @@ int main(int argc, char *argv[])
 	}
 
 
+	// --since はレート履歴表示のみ有効
+	if (command.code == MX6E_SHOW_RATE) {
+		if (!mx6e_command_rate_set_option(since, &command)) {
+			usage_func(command.code);
+			exit(EINVAL);
+		}
+	} else if (since != NULL) {
+		usage_func(command.code);
+		exit(EINVAL);
+	}
+
+	// --perf は統計情報表示のみ有効
+	if (command.code == MX6E_SHOW_STATISTIC) {
+		command.req.stat.perf = perf;
+	} else if (perf) {
+		usage_func(command.code);
+		exit(EINVAL);
+	}
+
+	// 破棄パケット出力先ファイルは接続前に作成しておく
+	int                             out_fd = STDOUT_FILENO;
+	if (command.code == MX6E_DUMP_DROPS) {
+		out_fd = open(cmd_opt[0], O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (out_fd < 0) {
+			printf("fail to open %s : %s\n", cmd_opt[0], strerror(errno));
+			return -1;
+		}
+	}
+
 	int                             fd;
 	char                            path[sizeof(((struct sockaddr_un *) 0)->sun_path)] = { 0 };
 	char                           *offset = &path[1];
@@ -402,7 +510,11 @@ int main(int argc, char *argv[])
 
 	switch (command.code) {
 	case MX6E_SHOW_STATISTIC:
+	case MX6E_SHOW_RATE:
+	case MX6E_SHOW_TOP:
+	case MX6E_SHOW_MISSES:
 	case MX6E_SHOW_CONF:
+	case MX6E_RELOAD_CONFIG:
 	case MX6E_SET_DEBUG_LOG:
 	case MX6E_ADD_M46E_ENTRY:						///< M46E ENTRY 追加
 	case MX6E_DEL_M46E_ENTRY:						///< M46E ENTRY 削除
@@ -417,6 +529,8 @@ int main(int argc, char *argv[])
 	case MX6E_ENABLE_ME6E_ENTRY:					///< ME6E ENTRY 活性化
 	case MX6E_DISABLE_ME6E_ENTRY:					///< ME6E ENTRY 非活性化
 	case MX6E_SHOW_ME6E_ENTRY:						///< ME6E ENTRY 表示
+	case MX6E_SHOW_M46E_VERSION:					///< M46E テーブル版数表示
+	case MX6E_SHOW_ME6E_VERSION:					///< ME6E テーブル版数表示
 
 	case MX6E_LOAD_COMMAND:							///< M46E/ME6E-Commandファイル読み込み
 
@@ -432,6 +546,23 @@ int main(int argc, char *argv[])
 		close(fd);
 		break;
 
+	case MX6E_DUMP_DROPS:
+		// pcapngのブロック単位で送信されてくるので、ブロックが切り詰められないサイズで受信する
+		{
+			char                            block[4096];
+			while (1) {
+				ret = read(fd, block, sizeof(block));
+				if (ret > 0) {
+					ret = write(out_fd, block, ret);
+				} else {
+					break;
+				}
+			}
+		}
+		close(out_fd);
+		close(fd);
+		break;
+
 	case MX6E_SHUTDOWN:
 	case MX6E_RESTART:
 		close(fd);
@@ -0,0 +1,719 @@
+/******************************************************************************/
+/* ファイル名 : mx6ectl_bench.c                                               */
+/* 機能概要   : 外部コマンド(制御系) 性能測定                                 */
+/* 修正履歴   : 2016.06.10 S.Anai 新規作成                                    */
+/*                                                                            */
+/* ALL RIGHTS RESERVED, COPYRIGHT(C) FUJITSU LIMITED 2016                     */
+/******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <getopt.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "mx6eapp_command_data.h"
+#include "mx6eapp_socket.h"
+#include "mx6ectl_command.h"
+#include "mx6eapp_util.h"
+#include "mx6eapp_log.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部マクロ定義
+////////////////////////////////////////////////////////////////////////////////
+//! 既定のテーブルサイズ一覧
+#define CTLBENCH_DEFAULT_SIZES  "1000,10000"
+//! テーブルサイズ指定の最大数
+#define CTLBENCH_SIZES_MAX      16
+//! テーブルサイズの最大
+#define CTLBENCH_SIZE_MAX       (1 << 24)
+//! 版数問い合わせの測定回数
+#define CTLBENCH_VERSION_OPS    100
+//! 経路設定完了待ちの確認周期[us]
+#define CTLBENCH_SETTLE_POLL    10000
+//! 経路設定完了待ちの上限[秒]
+#define CTLBENCH_SETTLE_TIMEOUT 600
+//! 経路設定待ちの目印(show の JSON 出力)
+#define CTLBENCH_PENDING        "\"route\":\"pending\""
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部構造体定義
+////////////////////////////////////////////////////////////////////////////////
+//! 測定項目
+typedef enum {
+	CTLBENCH_OP_ADD,
+	CTLBENCH_OP_SHOW,
+	CTLBENCH_OP_VERSION,
+	CTLBENCH_OP_DISABLE,
+	CTLBENCH_OP_ENABLE,
+	CTLBENCH_OP_DEL,
+	CTLBENCH_OP_LOAD,
+	CTLBENCH_OP_DELALL,
+	CTLBENCH_OP_MAX,
+} ctlbench_op_t;
+
+//! 出力形式
+typedef enum {
+	CTLBENCH_FORMAT_JSON,
+	CTLBENCH_FORMAT_CSV,
+} ctlbench_format_t;
+
+//! 測定条件
+typedef struct {
+	char                           *name;			///< 測定対象のプロセス名
+	int                             sizes[CTLBENCH_SIZES_MAX];	///< テーブルサイズ一覧
+	int                             size_num;		///< テーブルサイズ数
+	bool                            me6e;			///< ME6Eテーブルを測定する
+	bool                            op[CTLBENCH_OP_MAX];	///< 測定する項目
+	bool                            settle;			///< 経路設定の完了まで測定する
+	ctlbench_format_t               format;			///< 出力形式
+} ctlbench_option_t;
+
+//! 測定結果
+typedef struct {
+	ctlbench_op_t                   op;				///< 測定項目
+	int                             entries;		///< テーブルサイズ
+	long                            ops;			///< 要求数
+	long                            errors;			///< 異常応答数
+	double                          total;			///< 全要求の所要時間[ns]
+	double                         *lat;			///< 要求毎の所要時間[ns](要求数分)
+	long                            bytes;			///< 受信した出力の合計バイト数
+	double                          settle;			///< 要求完了から経路設定完了までの時間[ns](未測定は負値)
+} ctlbench_result_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// 内部変数
+////////////////////////////////////////////////////////////////////////////////
+//! 測定項目名
+static const char              *op_name[CTLBENCH_OP_MAX] = { "add", "show", "version", "disable", "enable", "del", "load", "delall" };
+
+//! コマンドオプション構造体
+// *INDENT-OFF*
+static const struct option      options[] = {
+	{"name",	required_argument,	NULL, 'n'},
+	{"sizes",	required_argument,	NULL, 's'},
+	{"type",	required_argument,	NULL, 't'},
+	{"ops",		required_argument,	NULL, 'o'},
+	{"settle",	no_argument,		NULL, 'w'},
+	{"csv",		no_argument,		NULL, 'c'},
+	{"help",	no_argument,		NULL, 'h'},
+	{0, 0, 0, 0}
+};
+// *INDENT-ON*
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief コマンド凡例表示関数
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void usage(void)
+{
+	fprintf(stderr, "Usage: mx6ectl_bench -n PROCESS_NAME [ -s SIZE[,SIZE...] ] [ -t m46e|me6e ] [ -o OP[,OP...] ] [ -w ] [ -c ]\n" "\n"
+			"  -n, --name   : process name of the running mx6eapp to measure\n"
+			"  -s, --sizes  : table sizes (default %s)\n"
+			"  -t, --type   : table type (default m46e)\n"
+			"  -o, --ops    : add,show,version,disable,enable,del,load,delall (default all)\n"
+			"  -w, --settle : also measure the time until the kernel routes are programmed\n"
+			"  -c, --csv    : output CSV instead of JSON lines\n" "\n"
+			"  The table of the target process is cleared (delall) before each size.\n"
+			"  Sizes above PT_MAX_ENTRY_NUM of the target need mx6eapp rebuilt with a larger value,\n"
+			"  and route_install = no in its config file measures without kernel route programming.\n" "\n",
+			CTLBENCH_DEFAULT_SIZES);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 時刻取得関数
+//!
+//! @return CLOCK_MONOTONICの現在時刻[ns]
+///////////////////////////////////////////////////////////////////////////////
+static inline double ctlbench_now(void)
+{
+	struct timespec                 ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 要求送信関数
+//!
+//! mx6ectl と同じ手順で接続/要求送信/応答受信をおこない、
+//! 一括読み込みレコードがあれば続けて送信し、出力を切断まで読み捨てる。
+//!
+//! @param [in]  name    プロセス名
+//! @param [in]  command コマンド(codeとreqを設定済み)
+//! @param [in]  record  一括読み込みレコード(無い場合はNULL)
+//! @param [in]  num     レコード数
+//! @param [out] out     出力の格納先(不要な場合はNULL、NUL終端する)
+//! @param [in]  out_max 出力の格納先のサイズ
+//!
+//! @retval 0以上 受信した出力のバイト数
+//! @retval -1    異常終了
+///////////////////////////////////////////////////////////////////////////////
+static long ctlbench_request(char *name, mx6e_command_t * command, mx6e_load_batch_record_t * record, int num, char **out, size_t * out_max)
+{
+	struct sockaddr_un              addr = { 0 };
+	char                            buf[4096];
+	long                            total = 0;
+	int                             fd;
+	int                             ret;
+	int                             pty;
+
+	addr.sun_family = AF_UNIX;
+	snprintf(&addr.sun_path[1], sizeof(addr.sun_path) - 1, MX6E_COMMAND_SOCK_NAME, name);
+
+	if (0 > (fd = socket(PF_UNIX, SOCK_SEQPACKET, 0))) {
+		return -1;
+	}
+	if (connect(fd, (struct sockaddr *) &addr, sizeof(addr))) {
+		close(fd);
+		return -1;
+	}
+
+	ret = mx6e_socket_send_cred(fd, command->code, &command->req, sizeof(command->req));
+	if (ret > 0) {
+		ret = mx6e_socket_recv(fd, &command->code, &command->res, sizeof(command->res), &pty);
+	}
+	if ((ret <= 0) || (command->res.result != 0)) {
+		close(fd);
+		return -1;
+	}
+
+	for (int i = 0; i < num; i += LOAD_BATCH_RECORD_NUM) {
+		int                             cnt = min(num - i, LOAD_BATCH_RECORD_NUM);
+		if (send(fd, &record[i], sizeof(mx6e_load_batch_record_t) * cnt, 0) < 0) {
+			close(fd);
+			return -1;
+		}
+	}
+
+	while (0 < (ret = read(fd, buf, sizeof(buf)))) {
+		if (out != NULL) {
+			if (total + ret + 1 > (long) *out_max) {
+				size_t                          max = (*out_max == 0) ? sizeof(buf) * 16 : *out_max * 2;
+				char                           *tmp;
+				while (total + ret + 1 > (long) max) {
+					max *= 2;
+				}
+				if (NULL == (tmp = realloc(*out, max))) {
+					close(fd);
+					return -1;
+				}
+				*out = tmp;
+				*out_max = max;
+			}
+			memcpy(*out + total, buf, ret);
+			(*out)[total + ret] = '\0';
+		}
+		total += ret;
+	}
+	close(fd);
+
+	return total;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief エントリ要求生成関数
+//!
+//! k番目のエントリの追加/削除/活性化/非活性化要求を、
+//! mx6ectl と同じオプション解析関数で生成する。
+//!
+//! m46e : pr - 0:1 64 <10.0.0.0 + k>/32 2001:db8:ff46::/48 0:0:1 enable
+//! me6e : pr - 1 64 02:00:<k> 2001:db8:ffe6::/48 1 enable
+//!
+//! @param [in]  opt     測定条件
+//! @param [in]  code    コマンドコード(M46E)
+//! @param [in]  k       エントリ番号
+//! @param [out] command 生成した要求の格納先
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static bool ctlbench_entry_command(const ctlbench_option_t * opt, mx6e_command_code_t code, int k, mx6e_command_t * command)
+{
+	char                            key[32];
+	char                           *args[8];
+	uint32_t                        v4 = 0x0a000000U + k;
+
+	memset(command, 0, sizeof(*command));
+	if (opt->me6e) {
+		// M46E/ME6Eのコマンドコードは同じ並び
+		code += MX6E_ADD_ME6E_ENTRY - MX6E_ADD_M46E_ENTRY;
+		snprintf(key, sizeof(key), "02:00:%02x:%02x:%02x:%02x", (k >> 24) & 0xff, (k >> 16) & 0xff, (k >> 8) & 0xff, k & 0xff);
+	} else {
+		snprintf(key, sizeof(key), "%u.%u.%u.%u/32", v4 >> 24, (v4 >> 16) & 0xff, (v4 >> 8) & 0xff, v4 & 0xff);
+	}
+	command->code = code;
+
+	args[0] = "pr";
+	args[1] = "-";
+	args[2] = opt->me6e ? "1" : "0:1";
+	args[3] = "64";
+	args[4] = key;
+	args[5] = opt->me6e ? "2001:db8:ffe6::/48" : "2001:db8:ff46::/48";
+	args[6] = opt->me6e ? "1" : "0:0:1";
+	args[7] = "enable";
+
+	switch (code) {
+	case MX6E_ADD_M46E_ENTRY:
+	case MX6E_ADD_ME6E_ENTRY:
+		return mx6e_command_add_entry_option(8, args, command);
+	case MX6E_DEL_M46E_ENTRY:
+	case MX6E_DEL_ME6E_ENTRY:
+		return mx6e_command_del_entry_option(5, args, command);
+	case MX6E_ENABLE_M46E_ENTRY:
+	case MX6E_ENABLE_ME6E_ENTRY:
+		return mx6e_command_enable_entry_option(5, args, command);
+	case MX6E_DISABLE_M46E_ENTRY:
+	case MX6E_DISABLE_ME6E_ENTRY:
+		return mx6e_command_disable_entry_option(5, args, command);
+	default:
+		return false;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 表示要求生成関数
+//!
+//! @param [in]  opt     測定条件
+//! @param [in]  json    JSON形式で表示するかどうか
+//! @param [out] command 生成した要求の格納先
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void ctlbench_show_command(const ctlbench_option_t * opt, bool json, mx6e_command_t * command)
+{
+	char                            format[] = "format=json";
+	char                           *args[1] = { format };
+
+	memset(command, 0, sizeof(*command));
+	command->code = opt->me6e ? MX6E_SHOW_ME6E_ENTRY : MX6E_SHOW_M46E_ENTRY;
+	if (json) {
+		mx6e_command_show_entry_option(1, args, command);
+	}
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 経路設定完了待ち関数
+//!
+//! テーブル表示(JSON)に経路設定待ちのエントリが無くなるまで待つ。
+//! 分解能は表示要求1回分の所要時間となる。
+//!
+//! @param [in] opt 測定条件
+//!
+//! @retval 0以上 待ち時間[ns]
+//! @retval 負値  異常終了(タイムアウト含む)
+///////////////////////////////////////////////////////////////////////////////
+static double ctlbench_settle(const ctlbench_option_t * opt)
+{
+	static char                    *out;
+	static size_t                   out_max;
+	mx6e_command_t                  command;
+	double                          start = ctlbench_now();
+
+	while (ctlbench_now() - start < CTLBENCH_SETTLE_TIMEOUT * 1e9) {
+		// 表示自体の所要時間を含めないよう、待ちが無くなった表示要求の開始時刻までとする
+		double                          poll = ctlbench_now();
+		ctlbench_show_command(opt, true, &command);
+		long                            len = ctlbench_request(opt->name, &command, NULL, 0, &out, &out_max);
+		if (len < 0) {
+			return -1;
+		}
+		if ((len == 0) || (strstr(out, CTLBENCH_PENDING) == NULL)) {
+			return poll - start;
+		}
+		usleep(CTLBENCH_SETTLE_POLL);
+	}
+
+	return -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 比較関数(qsort用)
+//!
+//! @param [in] p1 比較対象1
+//! @param [in] p2 比較対象2
+//!
+//! @retval 負値 p1 < p2
+//! @retval 0    p1 = p2
+//! @retval 正値 p1 > p2
+///////////////////////////////////////////////////////////////////////////////
+static int ctlbench_compare(const void *p1, const void *p2)
+{
+	double                          d1 = *(const double *) p1;
+	double                          d2 = *(const double *) p2;
+
+	return (d1 > d2) - (d1 < d2);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 測定結果出力関数
+//!
+//! @param [in]     opt    測定条件
+//! @param [in,out] result 測定結果(要求毎の所要時間は並び替える)
+//!
+//! @return なし
+///////////////////////////////////////////////////////////////////////////////
+static void ctlbench_print(const ctlbench_option_t * opt, ctlbench_result_t * result)
+{
+	double                          p50 = 0;
+	double                          p99 = 0;
+	double                          max = 0;
+
+	if (result->ops > 0) {
+		qsort(result->lat, result->ops, sizeof(double), ctlbench_compare);
+		p50 = result->lat[(long) (result->ops * 0.50)];
+		p99 = result->lat[(long) (result->ops * 0.99)];
+		max = result->lat[result->ops - 1];
+	}
+
+	double                          avg = result->ops ? result->total / result->ops : 0;
+	double                          ops_per_sec = (result->total > 0) ? result->ops * 1e9 / result->total : 0;
+	double                          settle = (result->settle < 0) ? -1 : result->settle / 1e6;
+
+	if (opt->format == CTLBENCH_FORMAT_CSV) {
+		printf("%s,%d,%s,%ld,%ld,%.3f,%.0f,%.1f,%.1f,%.1f,%.1f,%ld,%.3f\n",
+			   opt->me6e ? "me6e" : "m46e", result->entries, op_name[result->op], result->ops, result->errors,
+			   result->total / 1e6, ops_per_sec, avg / 1e3, p50 / 1e3, p99 / 1e3, max / 1e3, result->bytes, settle);
+	} else {
+		printf("{\"type\":\"%s\",\"entries\":%d,\"op\":\"%s\",\"ops\":%ld,\"errors\":%ld,\"total_ms\":%.3f,\"ops_per_sec\":%.0f,"
+			   "\"lat_us\":{\"avg\":%.1f,\"p50\":%.1f,\"p99\":%.1f,\"max\":%.1f},\"bytes\":%ld,\"settle_ms\":%.3f}\n",
+			   opt->me6e ? "me6e" : "m46e", result->entries, op_name[result->op], result->ops, result->errors,
+			   result->total / 1e6, ops_per_sec, avg / 1e3, p50 / 1e3, p99 / 1e3, max / 1e3, result->bytes, settle);
+	}
+	fflush(stdout);
+
+	return;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 1項目測定関数
+//!
+//! @param [in]     opt     測定条件
+//! @param [in]     op      測定項目
+//! @param [in]     entries テーブルサイズ
+//! @param [in,out] result  測定結果(latは要求数分確保済み)
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static bool ctlbench_run(const ctlbench_option_t * opt, ctlbench_op_t op, int entries, ctlbench_result_t * result)
+{
+	static const mx6e_command_code_t entry_code[CTLBENCH_OP_MAX] = {
+		[CTLBENCH_OP_ADD] = MX6E_ADD_M46E_ENTRY,
+		[CTLBENCH_OP_DISABLE] = MX6E_DISABLE_M46E_ENTRY,
+		[CTLBENCH_OP_ENABLE] = MX6E_ENABLE_M46E_ENTRY,
+		[CTLBENCH_OP_DEL] = MX6E_DEL_M46E_ENTRY,
+	};
+	mx6e_command_t                  command;
+	mx6e_load_batch_record_t       *record = NULL;
+	double                          start;
+	double                          t;
+	long                            len;
+
+	result->op = op;
+	result->entries = entries;
+	result->ops = 0;
+	result->errors = 0;
+	result->bytes = 0;
+	result->settle = -1;
+
+	switch (op) {
+	case CTLBENCH_OP_ADD:
+	case CTLBENCH_OP_DISABLE:
+	case CTLBENCH_OP_ENABLE:
+	case CTLBENCH_OP_DEL:
+		// 1要求1エントリ(mx6ectl を1回実行する場合と同じ)
+		start = ctlbench_now();
+		for (int k = 0; k < entries; k++) {
+			if (!ctlbench_entry_command(opt, entry_code[op], k, &command)) {
+				return false;
+			}
+			t = ctlbench_now();
+			len = ctlbench_request(opt->name, &command, NULL, 0, NULL, NULL);
+			result->lat[result->ops++] = ctlbench_now() - t;
+			if (len < 0) {
+				result->errors++;
+			} else {
+				result->bytes += len;
+			}
+		}
+		result->total = ctlbench_now() - start;
+		break;
+
+	case CTLBENCH_OP_SHOW:
+	case CTLBENCH_OP_VERSION:
+		// 全件表示は1回、版数問い合わせは複数回
+		for (int i = 0; i < ((op == CTLBENCH_OP_SHOW) ? 1 : CTLBENCH_VERSION_OPS); i++) {
+			if (op == CTLBENCH_OP_SHOW) {
+				ctlbench_show_command(opt, false, &command);
+			} else {
+				memset(&command, 0, sizeof(command));
+				command.code = opt->me6e ? MX6E_SHOW_ME6E_VERSION : MX6E_SHOW_M46E_VERSION;
+			}
+			t = ctlbench_now();
+			len = ctlbench_request(opt->name, &command, NULL, 0, NULL, NULL);
+			result->lat[result->ops++] = ctlbench_now() - t;
+			if (len < 0) {
+				result->errors++;
+			} else {
+				result->bytes += len;
+			}
+		}
+		result->total = 0;
+		for (int i = 0; i < result->ops; i++) {
+			result->total += result->lat[i];
+		}
+		break;
+
+	case CTLBENCH_OP_LOAD:
+		// 全エントリを1回の一括読み込みで追加(レコード生成は測定に含めない)
+		if (NULL == (record = calloc(entries, sizeof(mx6e_load_batch_record_t)))) {
+			fprintf(stderr, "ctlbench: out of memory (%d records)\n", entries);
+			return false;
+		}
+		for (int k = 0; k < entries; k++) {
+			if (!ctlbench_entry_command(opt, MX6E_ADD_M46E_ENTRY, k, &command)) {
+				free(record);
+				return false;
+			}
+			record[k].line = k + 1;
+			record[k].code = command.code;
+			record[k].entry = command.req.mx6e_data.entry;
+		}
+		// 前の測定項目の残りがあれば登録済みエラーになるので消しておく(測定に含めない)
+		memset(&command, 0, sizeof(command));
+		command.code = opt->me6e ? MX6E_DELALL_ME6E_ENTRY : MX6E_DELALL_M46E_ENTRY;
+		ctlbench_request(opt->name, &command, NULL, 0, NULL, NULL);
+		if (opt->settle) {
+			ctlbench_settle(opt);
+		}
+		memset(&command, 0, sizeof(command));
+		command.code = MX6E_LOAD_BATCH;
+		command.req.batch.num = entries;
+		t = ctlbench_now();
+		len = ctlbench_request(opt->name, &command, record, entries, NULL, NULL);
+		result->lat[result->ops++] = result->total = ctlbench_now() - t;
+		if (len < 0) {
+			result->errors++;
+		} else {
+			result->bytes = len;
+		}
+		free(record);
+		break;
+
+	case CTLBENCH_OP_DELALL:
+		memset(&command, 0, sizeof(command));
+		command.code = opt->me6e ? MX6E_DELALL_ME6E_ENTRY : MX6E_DELALL_M46E_ENTRY;
+		t = ctlbench_now();
+		len = ctlbench_request(opt->name, &command, NULL, 0, NULL, NULL);
+		result->lat[result->ops++] = result->total = ctlbench_now() - t;
+		if (len < 0) {
+			result->errors++;
+		}
+		break;
+
+	default:
+		return false;
+	}
+
+	// 表示/問い合わせ以外は経路設定の完了まで待つ
+	if (opt->settle && (op != CTLBENCH_OP_SHOW) && (op != CTLBENCH_OP_VERSION)) {
+		result->settle = ctlbench_settle(opt);
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief テーブルサイズ一覧解析関数
+//!
+//! "1000,10K,1M" 形式のテーブルサイズ一覧を解析する。
+//!
+//! @param [in]  arg オプション文字列
+//! @param [out] opt 測定条件
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static bool ctlbench_parse_sizes(const char *arg, ctlbench_option_t * opt)
+{
+	char                            buf[256];
+	char                           *save = NULL;
+
+	snprintf(buf, sizeof(buf), "%s", arg);
+	opt->size_num = 0;
+	for (char *p = strtok_r(buf, ",", &save); p != NULL; p = strtok_r(NULL, ",", &save)) {
+		char                           *end;
+		long                            n = strtol(p, &end, 10);
+
+		if ((*end == 'k') || (*end == 'K')) {
+			n *= 1000;
+			end++;
+		} else if ((*end == 'm') || (*end == 'M')) {
+			n *= 1000000;
+			end++;
+		}
+		if ((end == p) || (*end != '\0') || (n < 1) || (n > CTLBENCH_SIZE_MAX) || (opt->size_num >= CTLBENCH_SIZES_MAX)) {
+			return false;
+		}
+		opt->sizes[opt->size_num++] = n;
+	}
+
+	return opt->size_num > 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 測定項目一覧解析関数
+//!
+//! @param [in]  arg オプション文字列
+//! @param [out] opt 測定条件
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+static bool ctlbench_parse_ops(const char *arg, ctlbench_option_t * opt)
+{
+	char                            buf[256];
+	char                           *save = NULL;
+
+	snprintf(buf, sizeof(buf), "%s", arg);
+	memset(opt->op, 0, sizeof(opt->op));
+	for (char *p = strtok_r(buf, ",", &save); p != NULL; p = strtok_r(NULL, ",", &save)) {
+		int                             i;
+		for (i = 0; i < CTLBENCH_OP_MAX; i++) {
+			if (!strcmp(p, op_name[i])) {
+				opt->op[i] = true;
+				break;
+			}
+		}
+		if (i == CTLBENCH_OP_MAX) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 制御系性能測定メイン関数
+//!
+//! 稼働中の MX6E アプリケーションに対して、mx6ectl と同じUNIXソケット経由で
+//! テーブルサイズ毎に 追加→全件表示→版数問い合わせ→非活性化→活性化→削除
+//! →一括読み込み→全削除 の順で要求を送信し、所要時間を測定する。
+//!
+//! @param [in] argc 引数の数
+//! @param [in] argv 引数
+//!
+//! @retval EXIT_SUCCESS 正常終了
+//! @retval EXIT_FAILURE 異常終了
+///////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+	ctlbench_option_t               opt = { 0 };
+	ctlbench_result_t               result = { 0 };
+	mx6e_command_t                  command;
+	int                             max = 0;
+	int                             c;
+
+	ctlbench_parse_sizes(CTLBENCH_DEFAULT_SIZES, &opt);
+	for (int i = 0; i < CTLBENCH_OP_MAX; i++) {
+		opt.op[i] = true;
+	}
+
+	while ((c = getopt_long(argc, argv, "n:s:t:o:wch", options, NULL)) != -1) {
+		switch (c) {
+		case 'n':
+			opt.name = optarg;
+			break;
+		case 's':
+			if (!ctlbench_parse_sizes(optarg, &opt)) {
+				fprintf(stderr, "invalid sizes : %s (1 - %d)\n", optarg, CTLBENCH_SIZE_MAX);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 't':
+			if (!strcmp(optarg, "m46e")) {
+				opt.me6e = false;
+			} else if (!strcmp(optarg, "me6e")) {
+				opt.me6e = true;
+			} else {
+				fprintf(stderr, "invalid type : %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'o':
+			if (!ctlbench_parse_ops(optarg, &opt)) {
+				fprintf(stderr, "invalid ops : %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'w':
+			opt.settle = true;
+			break;
+		case 'c':
+			opt.format = CTLBENCH_FORMAT_CSV;
+			break;
+		default:
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
+	if (opt.name == NULL) {
+		usage();
+		return EXIT_FAILURE;
+	}
+
+	for (int i = 0; i < opt.size_num; i++) {
+		max = (max > opt.sizes[i]) ? max : opt.sizes[i];
+	}
+	max = (max > CTLBENCH_VERSION_OPS) ? max : CTLBENCH_VERSION_OPS;
+	if (NULL == (result.lat = malloc(sizeof(double) * max))) {
+		fprintf(stderr, "ctlbench: out of memory (%d entries)\n", max);
+		return EXIT_FAILURE;
+	}
+
+	if (opt.format == CTLBENCH_FORMAT_CSV) {
+		printf("type,entries,op,ops,errors,total_ms,ops_per_sec,avg_us,p50_us,p99_us,max_us,bytes,settle_ms\n");
+	}
+
+	for (int i = 0; i < opt.size_num; i++) {
+		// 前のサイズの残りを消してから測定する
+		memset(&command, 0, sizeof(command));
+		command.code = opt.me6e ? MX6E_DELALL_ME6E_ENTRY : MX6E_DELALL_M46E_ENTRY;
+		if (0 > ctlbench_request(opt.name, &command, NULL, 0, NULL, NULL)) {
+			fprintf(stderr, "fail to connect MX6E application(%s)\n", opt.name);
+			free(result.lat);
+			return EXIT_FAILURE;
+		}
+		if (opt.settle) {
+			ctlbench_settle(&opt);
+		}
+
+		for (int op = 0; op < CTLBENCH_OP_MAX; op++) {
+			if (!opt.op[op]) {
+				continue;
+			}
+			if (!ctlbench_run(&opt, op, opt.sizes[i], &result)) {
+				fprintf(stderr, "ctlbench: fail to run %s\n", op_name[op]);
+				free(result.lat);
+				return EXIT_FAILURE;
+			}
+			ctlbench_print(&opt, &result);
+		}
+	}
+
+	free(result.lat);
+
+	return EXIT_SUCCESS;
+}
@@ -15,6 +15,7 @@
 #include <netinet/ether.h>
 #include <arpa/inet.h>
 #include <limits.h>
+#include <inttypes.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <limits.h>
@@ -26,6 +27,8 @@
 #include "mx6eapp_socket.h"
 #include "mx6eapp_pt.h"
 #include "mx6eapp_util.h"
+#include "mx6eapp_rate.h"
+#include "mx6eapp_topk.h"
 
 //! オプション引数構造体定義
 struct opt_arg {
@@ -119,6 +122,193 @@ bool mx6e_command_dbglog_set_option(int num, char *opt[], mx6e_command_t * comma
 
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//! @brief レート履歴表示コマンドオプション設定処理関数
+//!
+//! --since の値(数値 + 単位 s/m/h/d、単位省略時は秒)を解析し、
+//! 表示対象期間[sec]をコマンド構造体に設定する。
+//!
+//! @param [in]  since      --since の値(NULLの場合はデフォルト)
+//! @param [out] command    コマンド構造体
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+bool mx6e_command_rate_set_option(char *since, mx6e_command_t * command)
+{
+	char                           *endptr;
+	long                            value;
+	int                             unit = 1;
+
+	// 引数チェック
+	if (command == NULL) {
+		return false;
+	}
+
+	if (since == NULL) {
+		command->req.rate.since = RATE_SINCE_DEFAULT;
+		return true;
+	}
+
+	errno = 0;
+	value = strtol(since, &endptr, 10);
+	if ((errno != 0) || (endptr == since) || (value <= 0)) {
+		return false;
+	}
+
+	switch (*endptr) {
+	case '\0':
+	case 's':
+		unit = 1;
+		break;
+	case 'm':
+		unit = RATE_SEC_PER_MIN;
+		break;
+	case 'h':
+		unit = RATE_SEC_PER_MIN * 60;
+		break;
+	case 'd':
+		unit = RATE_SEC_PER_MIN * 60 * 24;
+		break;
+	default:
+		return false;
+	}
+	if ((*endptr != '\0') && (*(endptr + 1) != '\0')) {
+		return false;
+	}
+
+	if (value > (RATE_SINCE_MAX / unit)) {
+		return false;
+	}
+	command->req.rate.since = value * unit;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief 宛先/64別負荷上位表示コマンドオプション設定処理関数
+//!
+//! 表示件数(省略時はデフォルト)をコマンド構造体に設定する。
+//!
+//! @param [in]  num        オプションの数
+//! @param [in]  opt[]      オプションの配列
+//! @param [out] command    コマンド構造体
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+bool mx6e_command_top_set_option(int num, char *opt[], mx6e_command_t * command)
+{
+	// 引数チェック
+	if ((opt == NULL) || (command == NULL)) {
+		return false;
+	}
+
+	if (num <= 0) {
+		command->req.top.num = TOPK_SHOW_DEFAULT;
+		return true;
+	}
+
+	return parse_int(opt[0], &command->req.top.num, 1, TOPK_COUNTER_NUM * 2);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief MX6E-PR Entry表示コマンドオプション設定処理関数
+//!
+//! key=value 形式のフィルタ、表示範囲、表示形式を解析する。
+//!
+//! @param [in]  num        オプションの数
+//! @param [in]  opt[]      オプションの配列
+//! @param [out] command    コマンド構造体
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+//
+// mx6ectl -n PLANE_NAME show m46e [domain=pr|fp] [plane=plane_id] [prefix=address/prefix_len]
+//                                 [state=enable|disable] [offset=N] [limit=N] [format=table|json]
+///////////////////////////////////////////////////////////////////////////////
+bool mx6e_command_show_entry_option(int num, char *opt[], mx6e_command_t * command)
+{
+	mx6e_show_table_t              *show;
+
+	// 引数チェック
+	if ((opt == NULL) || (command == NULL)) {
+		return false;
+	}
+	show = &command->req.mx6e_show;
+
+	for (int i = 0; i < num; i++) {
+		char                           *value = strchr(opt[i], '=');
+		bool                            result = true;
+
+		if (value == NULL) {
+			printf("fail to parse parameters '%s'\n", opt[i]);
+			return false;
+		}
+		*value++ = '\0';
+
+		if (!strcasecmp(opt[i], "domain")) {
+			show->filter |= SHOW_TABLE_FILTER_DOMAIN;
+			if (!strcasecmp(SECTION_DOMAIN_FP, value)) {
+				show->domain = DOMAIN_FP;
+			} else if (!strcasecmp(SECTION_DOMAIN_PR, value)) {
+				show->domain = DOMAIN_PR;
+			} else {
+				result = false;
+			}
+		} else if (!strcasecmp(opt[i], "plane")) {
+			show->filter |= SHOW_TABLE_FILTER_PLANE;
+			snprintf(show->plane_id, sizeof(show->plane_id), "%s", value);
+		} else if (!strcasecmp(opt[i], "prefix")) {
+			show->filter |= SHOW_TABLE_FILTER_PREFIX;
+			if (strchr(value, ':') != NULL) {
+				show->family = AF_INET6;
+				result = parse_ipv6address(value, &show->prefix.v6, &show->prefix_len);
+				if (strchr(value, '/') == NULL) {
+					// プレフィックス長省略時はホストアドレス扱い
+					show->prefix_len = CONFIG_IPV6_PREFIX_MAX;
+				}
+			} else {
+				show->family = AF_INET;
+				result = parse_ipv4address(value, &show->prefix.v4, &show->prefix_len);
+				if (strchr(value, '/') == NULL) {
+					// プレフィックス長省略時はホストアドレス扱い
+					show->prefix_len = CONFIG_IPV4_NETMASK_MAX;
+				}
+			}
+		} else if (!strcasecmp(opt[i], "state")) {
+			show->filter |= SHOW_TABLE_FILTER_STATE;
+			if (!strcasecmp(value, "enable")) {
+				show->enable = true;
+			} else if (!strcasecmp(value, "disable")) {
+				show->enable = false;
+			} else {
+				result = false;
+			}
+		} else if (!strcasecmp(opt[i], "offset")) {
+			result = parse_int(value, &show->offset, 0, INT_MAX);
+		} else if (!strcasecmp(opt[i], "limit")) {
+			result = parse_int(value, &show->limit, 1, INT_MAX);
+		} else if (!strcasecmp(opt[i], "format")) {
+			if (!strcasecmp(value, "table")) {
+				show->format = SHOW_TABLE_FORMAT_TABLE;
+			} else if (!strcasecmp(value, "json")) {
+				show->format = SHOW_TABLE_FORMAT_JSON;
+			} else {
+				result = false;
+			}
+		} else {
+			result = false;
+		}
+
+		if (!result) {
+			printf("fail to parse parameters '%s=%s'\n", opt[i], value);
+			return false;
+		}
+	}
+
+	return true;
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 //! @brief MX6E-PR Entry追加コマンドオプション設定処理関数
@@ -461,18 +651,22 @@ bool mx6e_command_disable_entry_option(int num, char *opt[], mx6e_command_t * co
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-//! @brief MX6E-PR Commandの読み込み処理関数
+//! @brief MX6E-PR Commandファイル解析関数
 //!
-//! MX6E-PR ファイル内のCommand行の読み込み処理を行う。
+//! MX6E-PR ファイル内のCommand行を解析し、一括送信用レコードに格納する。
+//! 行エラーは中断せず次の行を処理する(戻り値で通知する)。
 //!
 //! @param [in]  filename   Commandファイル名
-//! @param [in]  command    コマンド構造体
-//! @param [in]  name       Plane Name
+//! @param [in]  command    コマンド構造体(解析作業用)
+//! @param [in]  add_code   受け付けるENTRY 追加コマンドコード
+//!                         (MX6E_COMMAND_MAX:全てのENTRY 操作コマンドを受け付ける)
+//! @param [out] record_out 一括送信用レコード(呼び出し元で解放すること)
+//! @param [out] num_out    レコード数
 //!
 //! @retval true  正常終了
-//! @retval false 異常終了
+//! @retval false 異常終了(エラー行あり)
 ///////////////////////////////////////////////////////////////////////////////
-bool mx6e_command_load(char *filename, mx6e_command_t * command, char *name)
+bool mx6e_command_file_read(char *filename, mx6e_command_t * command, mx6e_command_code_t add_code, mx6e_load_batch_record_t ** record_out, int *num_out)
 {
 	FILE                           *fp = NULL;
 	char                            line[OPT_LINE_MAX] = { 0 };
@@ -480,10 +674,16 @@ bool mx6e_command_load(char *filename, mx6e_command_t * command, char *name)
 	bool                            result = true;
 	char                           *cmd_opt[DYNAMIC_OPE_ARGS_NUM_MAX] = { "" };
 	int                             cmd_num = 0;
+	int                             cmd_line_num = 0;
+	mx6e_load_batch_record_t       *record = NULL;
+	int                             record_num = 0;
+	int                             record_max = 0;
 
+	*record_out = NULL;
+	*num_out = 0;
 
 	// 引数チェック
-	if ((filename == NULL) || (strlen(filename) == 0) || (command == NULL) || (name == NULL)) {
+	if ((filename == NULL) || (strlen(filename) == 0) || (command == NULL)) {
 		printf("internal error\n");
 		return false;
 	}
@@ -526,6 +726,7 @@ bool mx6e_command_load(char *filename, mx6e_command_t * command, char *name)
 			_D_(printf("スペースとタブからなる行のためスキップ\n"));
 			continue;
 		}
+		cmd_line_num++;
 
 		/* コマンドのパラメータチェック */
 		command->code = MX6E_COMMAND_MAX;
@@ -538,6 +739,13 @@ bool mx6e_command_load(char *filename, mx6e_command_t * command, char *name)
 
 		_D_(printf("command->code:%d : %s\n", command->code, get_command_name(command->code)));
 
+		// 同期では対象テーブルのENTRY 追加行のみ受け付ける
+		if ((add_code != MX6E_COMMAND_MAX) && (command->code != MX6E_COMMAND_MAX) && (command->code != add_code)) {
+			printf("Line%d : %s %s is not allowed in sync file\n", line_cnt, cmd_opt[0], cmd_opt[1]);
+			result = false;
+			continue;
+		}
+
 		// 行エラーは中断せず次の行を処理する
 		switch (command->code) {
 
@@ -680,17 +888,144 @@ bool mx6e_command_load(char *filename, mx6e_command_t * command, char *name)
 			continue;
 		}
 
-		/* コマンド送信 */
-		result = mx6e_command_send(command, name);
-		if (!result) {
-			result = false;
-			// 送信失敗は、次の行を読まずに処理を中断する
-			break;
+		/* 一括送信用レコードに追加 */
+		if (record_num == record_max) {
+			int                             max = (record_max == 0) ? LOAD_BATCH_RECORD_NUM : record_max * 2;
+			mx6e_load_batch_record_t       *tmp = realloc(record, sizeof(mx6e_load_batch_record_t) * max);
+			if (tmp == NULL) {
+				printf("memory allocation failed\n");
+				result = false;
+				// 確保失敗は、次の行を読まずに処理を中断する
+				break;
+			}
+			record = tmp;
+			record_max = max;
 		}
+		record[record_num].line = line_cnt;
+		record[record_num].code = command->code;
+		record[record_num].entry = command->req.mx6e_data.entry;
+		record_num++;
 	}
 
 	fclose(fp);
 
+	// 同期では全てのコマンド行がレコードになっていること
+	if ((add_code != MX6E_COMMAND_MAX) && (record_num != cmd_line_num)) {
+		result = false;
+	}
+
+	*record_out = record;
+	*num_out = record_num;
+
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief MX6E-PR Commandの読み込み処理関数
+//!
+//! MX6E-PR ファイル内のCommand行の読み込み処理を行う。
+//!
+//! @param [in]  filename   Commandファイル名
+//! @param [in]  command    コマンド構造体
+//! @param [in]  name       Plane Name
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+bool mx6e_command_load(char *filename, mx6e_command_t * command, char *name)
+{
+	mx6e_load_batch_record_t       *record = NULL;
+	int                             record_num = 0;
+	bool                            result;
+
+	// 引数チェック
+	if (name == NULL) {
+		printf("internal error\n");
+		return false;
+	}
+
+	result = mx6e_command_file_read(filename, command, MX6E_COMMAND_MAX, &record, &record_num);
+
+	/* コマンド一括送信 */
+	if (record_num > 0) {
+		if (!mx6e_command_send_batch(MX6E_LOAD_BATCH, record, record_num, name)) {
+			result = false;
+		}
+	}
+	free(record);
+
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief MX6E-PR Table 同期処理関数
+//!
+//! MX6E-PR ファイル内のENTRY 追加行をあるべきテーブル内容として読み込み、
+//! 差分の反映を要求する。ファイルに記載の無いエントリは削除される。
+//! 誤ったファイルで全エントリを削除してしまわないよう、エラー行がある場合は要求しない。
+//! 要求前にテーブル内容のハッシュ値を問い合わせ、一致する場合は要求しない。
+//!
+//! @param [in]  filename   Commandファイル名
+//! @param [in]  command    コマンド構造体
+//! @param [in]  name       Plane Name
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+bool mx6e_command_sync(char *filename, mx6e_command_t * command, char *name)
+{
+	mx6e_command_code_t             code;
+	mx6e_command_code_t             add_code;
+	mx6e_command_code_t             version_code;
+	table_type_t                    type;
+	mx6e_load_batch_record_t       *record = NULL;
+	int                             record_num = 0;
+	bool                            result;
+
+	// 引数チェック
+	if ((command == NULL) || (name == NULL)) {
+		printf("internal error\n");
+		return false;
+	}
+
+	code = command->code;
+	if (code == MX6E_SYNC_M46E_ENTRY) {
+		type = CONFIG_TYPE_M46E;
+		add_code = MX6E_ADD_M46E_ENTRY;
+		version_code = MX6E_SHOW_M46E_VERSION;
+	} else if (code == MX6E_SYNC_ME6E_ENTRY) {
+		type = CONFIG_TYPE_ME6E;
+		add_code = MX6E_ADD_ME6E_ENTRY;
+		version_code = MX6E_SHOW_ME6E_VERSION;
+	} else {
+		printf("internal error\n");
+		return false;
+	}
+
+	result = mx6e_command_file_read(filename, command, add_code, &record, &record_num);
+	if (!result) {
+		printf("sync is not requested\n");
+		free(record);
+		return false;
+	}
+
+	// あるべきテーブル内容のハッシュ値が現在のテーブルと一致する場合は何もしない
+	uint64_t                        hash = 0;
+	uint64_t                        version;
+	uint64_t                        cur_hash;
+	int                             cur_num;
+	for (int i = 0; i < record_num; i++) {
+		hash += m46e_pt_config_entry_hash(type, &record[i].entry);
+	}
+	if (mx6e_command_query_version(version_code, name, &version, &cur_hash, &cur_num) && (cur_hash == hash) && (cur_num == record_num)) {
+		printf("sync : already up to date\n");
+		printf("version=%" PRIu64 " hash=%016" PRIx64 " entries=%d\n", version, cur_hash, cur_num);
+	} else {
+		/* コマンド一括送信 */
+		result = mx6e_command_send_batch(code, record, record_num, name);
+	}
+	free(record);
+
 	return result;
 }
 
@@ -737,33 +1072,24 @@ bool mx6e_command_parse_file(char *line, int *num, char *cmd_opt[])
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-//! @brief MX6E-PR Commandファイル読み込み用コマンド送信処理関数
-//!
-//! MX6E-PR Commandファイルから読込んだコマンド行（1行単位）を送信する。
+//! @brief MX6Eアプリケーション接続関数
 //!
-//! @param [in]  command    コマンド構造体
 //! @param [in]  name       Plane Name
 //!
-//! @retval true  正常終了
-//! @retval false 異常終了
+//! @return 接続したソケットのディスクリプタ(-1:接続失敗)
 ///////////////////////////////////////////////////////////////////////////////
-bool mx6e_command_send(mx6e_command_t * command, char *name)
+static int command_connect(char *name)
 {
 	int                             fd = -1;
 	char                            path[sizeof(((struct sockaddr_un *) 0)->sun_path)] = { 0 };
 	char                           *offset = &path[1];
 
-	// 引数チェック
-	if ((command == NULL) || (name == NULL)) {
-		return false;
-	}
-
 	sprintf(offset, MX6E_COMMAND_SOCK_NAME, name);
 
 	fd = socket(PF_UNIX, SOCK_SEQPACKET, 0);
 	if (fd < 0) {
 		printf("fail to open socket : %s\n", strerror(errno));
-		return false;
+		return -1;
 	}
 
 	struct sockaddr_un              addr;
@@ -775,6 +1101,96 @@ bool mx6e_command_send(mx6e_command_t * command, char *name)
 	if (connect(fd, (struct sockaddr *) &addr, sizeof(addr))) {
 		printf("fail to connect MX6E application(%s) : %s\n", name, strerror(errno));
 		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief MX6E-PR Table 版数問い合わせ関数
+//!
+//! @param [in]  code       コマンドコード(MX6E_SHOW_M46E_VERSION/MX6E_SHOW_ME6E_VERSION)
+//! @param [in]  name       Plane Name
+//! @param [out] version    テーブル版数
+//! @param [out] hash       テーブル内容のハッシュ値
+//! @param [out] num        エントリ数
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+bool mx6e_command_query_version(mx6e_command_code_t code, char *name, uint64_t * version, uint64_t * hash, int *num)
+{
+	int                             fd;
+	int                             ret;
+	int                             pty;
+	int                             len = 0;
+	char                            buf[256];
+	mx6e_command_t                  command = { 0 };
+
+	// 引数チェック
+	if ((name == NULL) || (version == NULL) || (hash == NULL) || (num == NULL)) {
+		return false;
+	}
+
+	fd = command_connect(name);
+	if (fd < 0) {
+		return false;
+	}
+
+	command.code = code;
+	ret = mx6e_socket_send_cred(fd, command.code, &command.req, sizeof(command.req));
+	if (ret > 0) {
+		ret = mx6e_socket_recv(fd, &command.code, &command.res, sizeof(command.res), &pty);
+	}
+	if ((ret <= 0) || (command.res.result != 0)) {
+		close(fd);
+		return false;
+	}
+
+	while (len < (int) sizeof(buf) - 1) {
+		ret = read(fd, &buf[len], sizeof(buf) - 1 - len);
+		if (ret <= 0) {
+			break;
+		}
+		len += ret;
+	}
+	buf[len] = '\0';
+	close(fd);
+
+	if (3 != sscanf(buf, "version=%" SCNu64 " hash=%" SCNx64 " entries=%d", version, hash, num)) {
+		return false;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! @brief MX6E-PR Commandファイル読み込み用コマンド一括送信処理関数
+//!
+//! MX6E-PR Commandファイルから読込んだコマンド行を、1回の接続で
+//! LOAD_BATCH_RECORD_NUM 行単位にまとめて送信し、処理結果を表示する。
+//!
+//! @param [in]  code       コマンドコード(MX6E_LOAD_BATCH/MX6E_SYNC_M46E_ENTRY/MX6E_SYNC_ME6E_ENTRY)
+//! @param [in]  record     一括読み込みレコード
+//! @param [in]  num        レコード数
+//! @param [in]  name       Plane Name
+//!
+//! @retval true  正常終了
+//! @retval false 異常終了
+///////////////////////////////////////////////////////////////////////////////
+bool mx6e_command_send_batch(mx6e_command_code_t code, mx6e_load_batch_record_t * record, int num, char *name)
+{
+	int                             fd = -1;
+	mx6e_command_t                  command = { 0 };
+
+	// 引数チェック
+	if (((record == NULL) && (num > 0)) || (name == NULL)) {
+		return false;
+	}
+
+	fd = command_connect(name);
+	if (fd < 0) {
 		return false;
 	}
 
@@ -782,53 +1198,48 @@ bool mx6e_command_send(mx6e_command_t * command, char *name)
 	int                             pty;
 	char                            buf[256];
 
-	ret = mx6e_socket_send_cred(fd, command->code, &command->req, sizeof(command->req));
+	command.code = code;
+	command.req.batch.num = num;
+
+	ret = mx6e_socket_send_cred(fd, command.code, &command.req, sizeof(command.req));
 	if (ret <= 0) {
 		printf("fail to send command : %s\n", strerror(-ret));
 		close(fd);
 		return false;
 	}
 
-	ret = mx6e_socket_recv(fd, &command->code, &command->res, sizeof(command->res), &pty);
+	ret = mx6e_socket_recv(fd, &command.code, &command.res, sizeof(command.res), &pty);
 	if (ret <= 0) {
 		printf("fail to receive response : %s\n", strerror(-ret));
 		close(fd);
 		return false;
 	}
-	if (command->res.result != 0) {
-		printf("receive error response : %s\n", strerror(command->res.result));
+	if (command.res.result != 0) {
+		printf("receive error response : %s\n", strerror(command.res.result));
 		close(fd);
 		return false;
 	}
 
-	switch (command->code) {
-	case MX6E_ADD_M46E_ENTRY:						///< M46E ENTRY 追加
-	case MX6E_DEL_M46E_ENTRY:						///< M46E ENTRY 削除
-	case MX6E_DELALL_M46E_ENTRY:					///< M46E ENTRY 全削除
-	case MX6E_ENABLE_M46E_ENTRY:					///< M46E ENTRY 活性化
-	case MX6E_DISABLE_M46E_ENTRY:					///< M46E ENTRY 非活性化
-	case MX6E_ADD_ME6E_ENTRY:						///< ME6E ENTRY 追加
-	case MX6E_DEL_ME6E_ENTRY:						///< ME6E ENTRY 削除
-	case MX6E_DELALL_ME6E_ENTRY:					///< ME6E ENTRY 全削除
-	case MX6E_ENABLE_ME6E_ENTRY:					///< ME6E ENTRY 活性化
-	case MX6E_DISABLE_ME6E_ENTRY:					///< ME6E ENTRY 非活性化
-		// 出力結果がソケット経由で送信されてくるので、そのまま標準出力に書き込む
-		while (1) {
-			ret = read(fd, buf, sizeof(buf));
-			if (ret > 0) {
-				ret = write(STDOUT_FILENO, buf, ret);
-			} else {
-				break;
-			}
+	// レコード送信
+	for (int i = 0; i < num; i += LOAD_BATCH_RECORD_NUM) {
+		int                             cnt = min(num - i, LOAD_BATCH_RECORD_NUM);
+		if (send(fd, &record[i], sizeof(mx6e_load_batch_record_t) * cnt, 0) < 0) {
+			printf("fail to send command : %s\n", strerror(errno));
+			close(fd);
+			return false;
 		}
-		close(fd);
-		break;
+	}
 
-	default:
-		// ありえない
-		close(fd);
-		break;
+	// 出力結果がソケット経由で送信されてくるので、そのまま標準出力に書き込む
+	while (1) {
+		ret = read(fd, buf, sizeof(buf));
+		if (ret > 0) {
+			ret = write(STDOUT_FILENO, buf, ret);
+		} else {
+			break;
+		}
 	}
+	close(fd);
 
 	return true;
 }
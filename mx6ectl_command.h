@@ -9,6 +9,7 @@
 #   define __MX6ECTL_COMMAND_H__
 
 #   include <stdbool.h>
+#   include <stdint.h>
 #   include "mx6eapp_command_data.h"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -53,19 +54,42 @@
 #   define DISABLE_M46E_OPE_ARGS 10
 #   define DISABLE_ME6E_OPE_ARGS 10
 
-//! M46E-PT Entry表示コマンド引数
-#   define SHOW_M46E_OPE_ARGS 5
-#   define SHOW_ME6E_OPE_ARGS 5
+//! M46E-PT Entry表示コマンド引数(フィルタ、表示範囲、表示形式は key=value 形式)
+#   define SHOW_M46E_OPE_MIN_ARGS 5
+#   define SHOW_M46E_OPE_MAX_ARGS 12
+#   define SHOW_ME6E_OPE_MIN_ARGS 5
+#   define SHOW_ME6E_OPE_MAX_ARGS 12
 
 //! Config情報表示コマンド引数
 #   define SHOW_CONF_OPE_ARGS 5
 
 //! 統計情報表示コマンド引数
-#   define SHOW_STAT_OPE_ARGS 5
+#   define SHOW_STAT_OPE_MIN_ARGS 5
+#   define SHOW_STAT_OPE_MAX_ARGS 6
+
+//! 宛先/64別負荷上位表示コマンド引数
+#   define SHOW_TOP_OPE_MIN_ARGS 5
+#   define SHOW_TOP_OPE_MAX_ARGS 6
+
+//! エントリ未登録宛先表示コマンド引数
+#   define SHOW_MISSES_OPE_ARGS 5
+
+//! 破棄パケット出力コマンド引数
+#   define DUMP_DROPS_OPE_ARGS 6
+
+//! レート履歴表示コマンド引数
+#   define SHOW_RATE_OPE_MIN_ARGS 5
+#   define SHOW_RATE_OPE_MAX_ARGS 7
 
 //! MX6E-PR Entry一括設定ファイル読込コマンド引数
 #   define OPE_NUM_LOAD 6
 
+//! MX6E-PR Table 同期コマンド引数
+#   define OPE_NUM_SYNC 6
+
+//! MX6E-PR Table 版数表示コマンド引数
+#   define SHOW_VERSION_OPE_ARGS 5
+
 //! 区切り文字(strtok用)
 #   define DELIMITER   " \t"
 
@@ -83,12 +107,18 @@ typedef struct _opt_keyvalue_t {
 ////////////////////////////////////////////////////////////////////////////////
 bool                            mx6e_command_device_set_option(int num, char *opt[], mx6e_command_t * command);
 bool                            mx6e_command_dbglog_set_option(int num, char *opt[], mx6e_command_t * command);
+bool                            mx6e_command_rate_set_option(char *since, mx6e_command_t * command);
+bool                            mx6e_command_top_set_option(int num, char *opt[], mx6e_command_t * command);
+bool                            mx6e_command_show_entry_option(int num, char *opt[], mx6e_command_t * command);
 bool                            mx6e_command_add_entry_option(int num, char *opt[], mx6e_command_t * command);
 bool                            mx6e_command_del_entry_option(int num, char *opt[], mx6e_command_t * command);
 bool                            mx6e_command_enable_entry_option(int num, char *opt[], mx6e_command_t * command);
 bool                            mx6e_command_disable_entry_option(int num, char *opt[], mx6e_command_t * command);
+bool                            mx6e_command_file_read(char *filename, mx6e_command_t * command, mx6e_command_code_t add_code, mx6e_load_batch_record_t ** record_out, int *num_out);
 bool                            mx6e_command_load(char *filename, mx6e_command_t * command, char *name);
-bool                            mx6e_command_send(mx6e_command_t * command, char *name);
+bool                            mx6e_command_sync(char *filename, mx6e_command_t * command, char *name);
+bool                            mx6e_command_query_version(mx6e_command_code_t code, char *name, uint64_t * version, uint64_t * hash, int *num);
+bool                            mx6e_command_send_batch(mx6e_command_code_t code, mx6e_load_batch_record_t * record, int num, char *name);
 bool                            mx6e_command_parse_file(char *line, int *num, char *cmd_opt[]);
 
 #endif												// __MX6ECTL_COMMAND_H__